@@ -0,0 +1,90 @@
+#include "bc_encoder.h"
+#include "image_util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Encodes a procedural lightmap with every format, kernel and a range of thread counts,
+// reporting throughput, PSNR against the source image and whether the SIMD output matches
+// the scalar reference bit for bit
+int main(int argc, char *argv[])
+{
+    uint32_t size = 2048;
+    int iterations = 5;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            size = uint32_t(atoi(argv[++i]));
+        }
+        else if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+    }
+
+    const std::vector<uint8_t> source = generateLightmap(size, size, 1);
+    std::vector<uint8_t> decoded(source.size());
+
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = { 1 };
+    for (unsigned threads = 2; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    if (hardwareThreads > 1)
+    {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    std::cout << "image " << size << "x" << size << ", best of " << iterations << ", cpu supports " << simdLevelName(detectSimdLevel()) << std::endl;
+    std::cout << std::left << std::setw(8) << "format" << std::setw(10) << "kernel" << std::setw(10) << "threads" << std::right
+              << std::setw(12) << "MPix/s" << std::setw(12) << "PSNR dB" << std::setw(14) << "vs scalar" << std::endl;
+
+    bool allMatch = true;
+    for (BcFormat format : { BcFormat::BC1, BcFormat::BC3, BcFormat::BC7 })
+    {
+        std::vector<uint8_t> reference(bcImageBytes(format, size, size));
+        encodeBc(format, source.data(), size, size, reference.data(), SimdLevel::Scalar);
+
+        for (SimdLevel simd : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 })
+        {
+            if (simd > detectSimdLevel() || (BcFormat::BC7 == format && SimdLevel::Scalar != simd))
+            {
+                continue;
+            }
+
+            for (unsigned threads : threadCounts)
+            {
+                JobSystem jobs(threads - 1);
+                std::vector<uint8_t> blocks(reference.size());
+                double bestSeconds = 1e30;
+                for (int i = 0; i < iterations; ++i)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    encodeBc(format, source.data(), size, size, blocks.data(), simd, &jobs);
+                    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                    bestSeconds = std::min(bestSeconds, elapsed.count());
+                }
+
+                decodeBc(format, blocks.data(), size, size, decoded.data());
+                const double quality = psnr(source.data(), decoded.data(), size, size, (BcFormat::BC1 == format) ? 3 : 4);
+                const bool matches = blocks == reference;
+                allMatch = allMatch && matches;
+
+                std::cout << std::left << std::setw(8) << bcFormatName(format) << std::setw(10) << simdLevelName(simd) << std::setw(10)
+                          << threads << std::right << std::fixed << std::setprecision(1) << std::setw(12)
+                          << double(size) * size / bestSeconds / 1e6 << std::setw(12) << std::setprecision(2) << quality << std::setw(14)
+                          << (matches ? "identical" : "DIFFERS") << std::endl;
+            }
+        }
+    }
+
+    return allMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
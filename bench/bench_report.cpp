@@ -0,0 +1,108 @@
+#include "bench_report.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+static std::string escapeJson(const std::string &text)
+{
+    std::string escaped;
+    for (const char c : text)
+    {
+        if ('"' == c || '\\' == c)
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", unsigned(c));
+            escaped += code;
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void BenchReport::setProperty(const std::string &key, const std::string &value)
+{
+    properties.emplace_back(key, value);
+}
+
+void BenchReport::add(const std::string &name, std::vector<double> samples, const char *unit)
+{
+    if (samples.empty())
+    {
+        skip(name, "no samples");
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.unit = unit;
+    result.median = samples[samples.size() / 2];
+    result.min = samples.front();
+    result.p90 = samples[std::min(samples.size() - 1, samples.size() * 9 / 10)];
+    result.samples = samples.size();
+    results.push_back(result);
+}
+
+void BenchReport::skip(const std::string &name, const std::string &reason)
+{
+    BenchResult result = {};
+    result.name = name;
+    result.skipped = reason;
+    results.push_back(result);
+}
+
+void BenchReport::writeJson(std::ostream &stream) const
+{
+    stream << std::setprecision(6) << "{\n  \"properties\": {";
+    for (size_t i = 0; i < properties.size(); ++i)
+    {
+        stream << (0 == i ? "\n" : ",\n") << "    \"" << escapeJson(properties[i].first) << "\": \"" << escapeJson(properties[i].second) << "\"";
+    }
+    stream << "\n  },\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &result = results[i];
+        stream << (0 == i ? "\n" : ",\n") << "    {\"name\": \"" << escapeJson(result.name) << "\"";
+        if (result.skipped.empty())
+        {
+            stream << ", \"unit\": \"" << result.unit << "\", \"median\": " << result.median << ", \"min\": " << result.min << ", \"p90\": " << result.p90
+                   << ", \"samples\": " << result.samples << "}";
+        }
+        else
+        {
+            stream << ", \"skipped\": \"" << escapeJson(result.skipped) << "\"}";
+        }
+    }
+    stream << "\n  ]\n}\n";
+}
+
+void BenchReport::printSummary(std::ostream &stream) const
+{
+    for (const auto &[key, value] : properties)
+    {
+        stream << key << ": " << value << "\n";
+    }
+    for (const BenchResult &result : results)
+    {
+        stream << std::left << std::setw(40) << result.name << std::right;
+        if (result.skipped.empty())
+        {
+            stream << std::fixed << std::setprecision(1) << " median " << std::setw(12) << result.median << result.unit << "  min " << std::setw(12)
+                   << result.min << result.unit << "  p90 " << std::setw(12) << result.p90 << result.unit << "\n";
+        }
+        else
+        {
+            stream << " skipped: " << result.skipped << "\n";
+        }
+    }
+    stream << std::defaultfloat << std::flush;
+}
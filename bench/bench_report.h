@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One microbenchmark's samples, each already divided down to a single operation
+struct BenchResult
+{
+    std::string name;
+    std::string unit;
+    double median;
+    double min;
+    double p90;
+    size_t samples;
+    std::string skipped; // reason the benchmark didn't run, empty when it did
+};
+
+// Results and the environment they were measured in, written as JSON for compare_bench.py
+class BenchReport
+{
+public:
+    void setProperty(const std::string &key, const std::string &value);
+
+    void add(const std::string &name, std::vector<double> samples, const char *unit = "ns");
+
+    void skip(const std::string &name, const std::string &reason);
+
+    void writeJson(std::ostream &stream) const;
+
+    void printSummary(std::ostream &stream) const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> properties;
+    std::vector<BenchResult> results;
+};
+
+inline double elapsedNanoseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Times function once per sample after a few warm up calls, dividing each sample by the
+// operations a call performs
+template <typename Function>
+std::vector<double> sampleNanoseconds(int samples, int operationsPerCall, Function function)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        function();
+    }
+    std::vector<double> nanoseconds;
+    nanoseconds.reserve(size_t(samples));
+    for (int i = 0; i < samples; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        nanoseconds.push_back(elapsedNanoseconds(start, std::chrono::steady_clock::now()) / double(operationsPerCall));
+    }
+    return nanoseconds;
+}
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Compares two graphics_ditties_bench JSON reports and fails if any benchmark regressed.
+
+A benchmark regresses when its median is more than the threshold slower than the baseline's.
+Benchmarks missing from either report, or skipped in either, are listed but never fail the run.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    with open(path) as f:
+        report = json.load(f)
+    return report.get("properties", {}), {r["name"]: r for r in report["results"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="stored report to compare against")
+    parser.add_argument("current", help="report from this run")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed fractional slowdown of the median (default 0.10)")
+    args = parser.parse_args()
+
+    baseline_properties, baseline = load_results(args.baseline)
+    current_properties, current = load_results(args.current)
+
+    for key in ("vk_device", "gl_renderer"):
+        if baseline_properties.get(key) != current_properties.get(key):
+            print(f"warning: {key} differs: {baseline_properties.get(key)!r} -> {current_properties.get(key)!r}")
+
+    regressions = 0
+    print(f"{'benchmark':40} {'baseline':>12} {'current':>12} {'change':>8}")
+    for name in sorted(set(baseline) | set(current)):
+        before = baseline.get(name)
+        after = current.get(name)
+        if before is None or after is None:
+            print(f"{name:40} {'only in ' + ('current' if before is None else 'baseline'):>34}")
+            continue
+        if "skipped" in before or "skipped" in after:
+            print(f"{name:40} {'skipped':>34}")
+            continue
+
+        change = after["median"] / before["median"] - 1.0 if before["median"] > 0 else 0.0
+        status = ""
+        if change > args.threshold:
+            status = "REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            status = "improved"
+        print(f"{name:40} {before['median']:12.1f} {after['median']:12.1f} {change:+8.1%} {status}")
+
+    if regressions:
+        print(f"{regressions} benchmark(s) regressed by more than {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
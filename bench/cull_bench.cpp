@@ -0,0 +1,147 @@
+#include "frustum_cull.h"
+#include "transform_math.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// the layout culling starts from: one struct per object, tested one at a time
+struct AosSphere
+{
+    float centre[3];
+    float radius;
+};
+
+static size_t cullAos(const std::vector<AosSphere> &spheres, const float planes[6][4], uint8_t *visible)
+{
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < spheres.size(); ++i)
+    {
+        const AosSphere &sphere = spheres[i];
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p)
+        {
+            inside = planes[p][0] * sphere.centre[0] + planes[p][1] * sphere.centre[1] + planes[p][2] * sphere.centre[2] + planes[p][3] > -sphere.radius;
+        }
+        visible[i] = inside ? 1 : 0;
+        visibleCount += inside ? 1 : 0;
+    }
+    return visibleCount;
+}
+
+template <typename Function>
+static double bestSeconds(int iterations, Function function)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Culls a cube of randomly placed spheres against a camera at its centre, comparing an AoS scalar
+// loop with the SoA kernels at each SIMD level and thread count
+int main(int argc, char *argv[])
+{
+    size_t objectCount = 1000000;
+    int iterations = 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--objects") && i + 1 < argc)
+        {
+            objectCount = size_t(std::max(1, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+    }
+
+    const float halfExtent = 100.0f;
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<float> position(-halfExtent, halfExtent);
+    std::uniform_real_distribution<float> radius(0.5f, 2.0f);
+
+    std::vector<AosSphere> aos(objectCount);
+    SphereBounds soa;
+    resizeSphereBounds(soa, objectCount);
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+        const float sphere[4] = { position(engine), position(engine), position(engine), radius(engine) };
+        aos[i] = { { sphere[0], sphere[1], sphere[2] }, sphere[3] };
+        setSphereBounds(soa, i, sphere);
+    }
+
+    const float eye[3] = { 0.0f, 0.0f, 0.0f };
+    const float target[3] = { 1.0f, 0.1f, 0.3f };
+    const float up[3] = { 0.0f, 1.0f, 0.0f };
+    float planes[6][4];
+    frustumPlanes(multiply(perspectiveVulkan(1.0f, 16.0f / 9.0f, 0.1f, 2.0f * halfExtent), lookAt(eye, target, up)), planes);
+
+    std::vector<uint8_t> reference(objectCount);
+    std::vector<uint8_t> visible(soa.x.size());
+    size_t referenceCount = 0;
+    const double aosSeconds = bestSeconds(iterations, [&]()
+    {
+        referenceCount = cullAos(aos, planes, reference.data());
+    });
+
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = { 1 };
+    for (unsigned threads = 2; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    if (hardwareThreads > 1)
+    {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    std::cout << objectCount << " spheres, " << referenceCount << " visible, best of " << iterations << ", cpu supports " << simdLevelName(detectSimdLevel()) << std::endl;
+    std::cout << std::left << std::setw(10) << "layout" << std::setw(10) << "kernel" << std::setw(10) << "threads" << std::right
+              << std::setw(12) << "ms" << std::setw(16) << "Mobj/s/core" << std::setw(12) << "speedup" << std::setw(14) << "vs AoS" << std::endl;
+
+    auto printRow = [&](const char *layout, const char *kernel, unsigned threads, double seconds, bool matches)
+    {
+        std::cout << std::left << std::setw(10) << layout << std::setw(10) << kernel << std::setw(10) << threads << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << seconds * 1e3 << std::setprecision(1) << std::setw(16)
+                  << double(objectCount) / seconds / threads / 1e6 << std::setprecision(2) << std::setw(11) << aosSeconds / seconds << "x"
+                  << std::setw(14) << (matches ? "identical" : "DIFFERS") << std::endl;
+    };
+    printRow("AoS", "scalar", 1, aosSeconds, true);
+
+    bool allMatch = true;
+    for (SimdLevel simd : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 })
+    {
+        if (simd > detectSimdLevel())
+        {
+            continue;
+        }
+
+        for (unsigned threads : threadCounts)
+        {
+            JobSystem jobs(threads - 1);
+            size_t count = 0;
+            const double seconds = bestSeconds(iterations, [&]()
+            {
+                count = cullSpheres(soa, planes, visible.data(), simd, &jobs);
+            });
+
+            const bool matches = count == referenceCount && std::equal(reference.begin(), reference.end(), visible.begin());
+            allMatch = allMatch && matches;
+            printRow("SoA", simdLevelName(simd), threads, seconds, matches);
+        }
+    }
+
+    return allMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
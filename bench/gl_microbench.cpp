@@ -0,0 +1,207 @@
+#include "gl_microbench.h"
+
+#include "gl_functions.h"
+#include "gl_program.h"
+#include "sprite_renderer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// a triangle a few pixels across, so the draws measure submission rather than fill
+static const char *vertexShaderSource = R"(#version 330 core
+void main()
+{
+    vec2 position = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 0.02 - 0.99;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+static const char *fragmentShaderSources[] = {
+    R"(#version 330 core
+uniform sampler2D image;
+uniform vec4 tint;
+out vec4 color;
+void main()
+{
+    color = texture(image, vec2(0.5)) * tint;
+}
+)",
+    R"(#version 330 core
+uniform sampler2D image;
+uniform vec4 tint;
+out vec4 color;
+void main()
+{
+    color = texture(image, vec2(0.5)) + tint;
+}
+)"};
+
+struct DrawState
+{
+    GLuint programs[2];
+    GLuint textures[2];
+    GLuint vertexArrays[2];
+    GLint tintLocation;
+};
+
+static DrawState createDrawState()
+{
+    DrawState state;
+    for (int i = 0; i < 2; ++i)
+    {
+        state.programs[i] = createGlProgram(vertexShaderSource, fragmentShaderSources[i]);
+    }
+    state.tintLocation = gl::GetUniformLocation(state.programs[0], "tint");
+
+    const uint32_t texels[2] = {0xFF0000FFu, 0xFF00FF00u};
+    gl::GenTextures(2, state.textures);
+    for (int i = 0; i < 2; ++i)
+    {
+        gl::BindTexture(GL_TEXTURE_2D, state.textures[i]);
+        gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl::TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texels[i]);
+    }
+    gl::GenVertexArrays(2, state.vertexArrays);
+
+    return state;
+}
+
+static void destroyDrawState(const DrawState &state)
+{
+    gl::DeleteVertexArrays(2, state.vertexArrays);
+    gl::DeleteTextures(2, state.textures);
+    for (GLuint program : state.programs)
+    {
+        gl::DeleteProgram(program);
+    }
+}
+
+static void bindBaseState(const DrawState &state)
+{
+    gl::UseProgram(state.programs[0]);
+    gl::BindTexture(GL_TEXTURE_2D, state.textures[0]);
+    gl::BindVertexArray(state.vertexArrays[0]);
+    gl::Disable(GL_BLEND);
+    gl::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl::Uniform4f(state.tintLocation, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+// Per draw cost with a state change before every draw, alternating between two values so none
+// is redundant; the finish keeps deferred validation inside the sample
+template <typename Change>
+static void benchStateChange(BenchReport &report, const DrawState &state, int samples, const char *name, Change change)
+{
+    constexpr int draws = 1000;
+    bindBaseState(state);
+    report.add(name, sampleNanoseconds(samples, draws, [&]()
+    {
+        for (int i = 0; i < draws; ++i)
+        {
+            change(i & 1);
+            gl::DrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        gl::Finish();
+    }));
+}
+
+// A field of sprites over 8 pages, every blend and 16 layers drawn batched and then one draw per
+// sprite; samples are per sprite, sorting and the finish included. The draw calls per frame and
+// the median sprites per millisecond go in the report's properties.
+static void benchSprites(BenchReport &report, int samples, int width, int height)
+{
+    constexpr uint32_t spriteCount = 20000;
+    constexpr uint16_t pageCount = 8;
+    SpriteRenderer renderer = createSpriteRenderer(spriteCount);
+    const std::vector<GLuint> pages = createSpritePages(pageCount, 32);
+    SpriteBatcher batcher;
+    addSpriteField(batcher, spriteCount, pageCount, float(width), float(height), 0.0);
+
+    for (const bool batched : { true, false })
+    {
+        const std::string name = batched ? "gl.sprites.batched" : "gl.sprites.immediate";
+        const uint64_t frames = renderer.frames;
+        const uint64_t drawCalls = renderer.drawCalls;
+        std::vector<double> nanoseconds = sampleNanoseconds(samples, int(spriteCount), [&]()
+        {
+            if (batched)
+            {
+                drawSprites(renderer, batcher, pages.data(), width, height);
+            }
+            else
+            {
+                drawSpritesImmediate(renderer, batcher, pages.data(), width, height);
+            }
+            gl::Finish();
+        });
+        std::vector<double> sorted = nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+        report.setProperty(name + ".sprites_per_ms", std::to_string(1e6 / sorted[sorted.size() / 2]));
+        report.setProperty(name + ".draw_calls_per_frame", std::to_string(double(renderer.drawCalls - drawCalls) / double(renderer.frames - frames)));
+        report.add(name, std::move(nanoseconds));
+    }
+
+    gl::DeleteTextures(GLsizei(pages.size()), pages.data());
+    destroySpriteRenderer(renderer);
+}
+
+void runGlBenchmarks(BenchReport &report, GLFWwindow *window, int samples)
+{
+    loadGlFunctions();
+    report.setProperty("gl_renderer", reinterpret_cast<const char *>(gl::GetString(GL_RENDERER)));
+    report.setProperty("gl_version", reinterpret_cast<const char *>(gl::GetString(GL_VERSION)));
+
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    gl::Viewport(0, 0, width, height);
+    gl::ClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+
+    // vsync would measure the display rather than the driver
+    glfwSwapInterval(0);
+    report.add("gl.clear_swap", sampleNanoseconds(samples, 1, [&]()
+    {
+        gl::Clear(GL_COLOR_BUFFER_BIT);
+        glfwSwapBuffers(window);
+    }));
+    report.add("gl.clear_finish", sampleNanoseconds(samples, 1, []()
+    {
+        gl::Clear(GL_COLOR_BUFFER_BIT);
+        gl::Finish();
+    }));
+
+    const DrawState state = createDrawState();
+    benchStateChange(report, state, samples, "gl.draw.no_change", [](int) {});
+    benchStateChange(report, state, samples, "gl.draw.program_switch", [&](int i)
+    {
+        gl::UseProgram(state.programs[i]);
+    });
+    benchStateChange(report, state, samples, "gl.draw.texture_switch", [&](int i)
+    {
+        gl::BindTexture(GL_TEXTURE_2D, state.textures[i]);
+    });
+    benchStateChange(report, state, samples, "gl.draw.vertex_array_switch", [&](int i)
+    {
+        gl::BindVertexArray(state.vertexArrays[i]);
+    });
+    benchStateChange(report, state, samples, "gl.draw.blend_toggle", [](int i)
+    {
+        if (0 != i)
+        {
+            gl::Enable(GL_BLEND);
+        }
+        else
+        {
+            gl::Disable(GL_BLEND);
+        }
+    });
+    benchStateChange(report, state, samples, "gl.draw.uniform_update", [&](int i)
+    {
+        gl::Uniform4f(state.tintLocation, 1.0f, float(i), 1.0f, 1.0f);
+    });
+    destroyDrawState(state);
+
+    benchSprites(report, samples, width, height);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "bench_report.h"
+
+struct GLFWwindow;
+
+// Driver overhead of clearing and swapping, of the common state changes between draws, and of
+// sprites drawn batched against one draw per sprite
+// window's OpenGL 3.3 core context must be current on the calling thread
+void runGlBenchmarks(BenchReport &report, GLFWwindow *window, int samples);
@@ -0,0 +1,127 @@
+#include "bench_report.h"
+#include "gl_microbench.h"
+#include "vulkan_microbench.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+static void errorCallback(int code, const char *description)
+{
+    std::cerr << "GLFW error " << code << ": " << description << std::endl;
+}
+
+// hidden, so the suite runs unattended; without a display GLFW fails to initialise and
+// only the Vulkan benchmarks that need no surface run
+static GLFWwindow *createHiddenWindow(bool openGl)
+{
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    if (openGl)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+    }
+    else
+    {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    }
+    return glfwCreateWindow(256, 256, "graphics_ditties_bench", nullptr, nullptr);
+}
+
+// Microbenchmarks of graphics API driver overhead, written as JSON for compare_bench.py
+// Intended to run on software drivers (lavapipe, llvmpipe) in CI, under Xvfb for the window system parts.
+int main(int argc, char *argv[])
+{
+    std::string api = "all";
+    std::string jsonPath = "graphics_ditties_bench.json";
+    int samples = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--api") && i + 1 < argc)
+        {
+            api = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--json") && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--samples") && i + 1 < argc)
+        {
+            samples = std::max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--api all|vulkan|gl] [--json path] [--samples count]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    const bool runVulkan = "all" == api || "vulkan" == api;
+    const bool runGl = "all" == api || "gl" == api;
+
+    glfwSetErrorCallback(errorCallback);
+    const bool windowSystem = GLFW_TRUE == glfwInit();
+
+    BenchReport report;
+    report.setProperty("samples", std::to_string(samples));
+    try
+    {
+        if (runVulkan)
+        {
+            GLFWwindow *window = windowSystem && glfwVulkanSupported() ? createHiddenWindow(false) : nullptr;
+            runVulkanBenchmarks(report, window, samples);
+            if (nullptr != window)
+            {
+                glfwDestroyWindow(window);
+            }
+        }
+        if (runGl)
+        {
+            GLFWwindow *window = windowSystem ? createHiddenWindow(true) : nullptr;
+            if (nullptr != window)
+            {
+                glfwMakeContextCurrent(window);
+                runGlBenchmarks(report, window, samples);
+                glfwDestroyWindow(window);
+            }
+            else
+            {
+                report.skip("gl", "no OpenGL 3.3 context");
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        if (windowSystem)
+        {
+            glfwTerminate();
+        }
+        return EXIT_FAILURE;
+    }
+    if (windowSystem)
+    {
+        glfwTerminate();
+    }
+
+    report.printSummary(std::cout);
+    std::ofstream json(jsonPath);
+    if (!json)
+    {
+        std::cerr << "Failed to open " << jsonPath << std::endl;
+        return EXIT_FAILURE;
+    }
+    report.writeJson(json);
+    std::cout << "Wrote " << jsonPath << std::endl;
+
+    return EXIT_SUCCESS;
+}
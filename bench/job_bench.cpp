@@ -0,0 +1,154 @@
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+template <typename Function>
+static double bestSeconds(int iterations, Function function)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// enough arithmetic per element that scaling is limited by the scheduler rather than memory
+static float work(size_t i)
+{
+    float x = float(i & 1023) * 0.001f;
+    for (int k = 0; k < 16; ++k)
+    {
+        x = std::sqrt(x * x + 1.0f);
+    }
+    return x;
+}
+
+// Measures the job system's per-job scheduling overhead for independent jobs, dependency
+// chains and parallelFor pieces, then how a compute bound parallelFor scales with threads
+int main(int argc, char *argv[])
+{
+    int iterations = 10;
+    size_t jobCount = 100000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+        else if (0 == strcmp(argv[i], "--jobs") && i + 1 < argc)
+        {
+            jobCount = size_t(std::max(1, atoi(argv[++i])));
+        }
+    }
+
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = { 1 };
+    for (unsigned threads = 2; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    if (hardwareThreads > 1)
+    {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    std::cout << "scheduling overhead, " << jobCount << " empty jobs, best of " << iterations << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(14) << "run ns/job" << std::setw(16) << "chain ns/job"
+              << std::setw(18) << "parallelFor ns" << std::endl;
+    for (unsigned threads : threadCounts)
+    {
+        JobSystem jobs(threads - 1);
+        std::atomic<size_t> executed{0};
+
+        const double runSeconds = bestSeconds(iterations, [&]()
+        {
+            JobCounter counter;
+            for (size_t i = 0; i < jobCount; ++i)
+            {
+                jobs.run(counter, [&executed]()
+                {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            jobs.wait(counter);
+        });
+
+        // each job only released once the one before it has finished
+        const size_t chainLength = std::min<size_t>(jobCount, 10000);
+        const double chainSeconds = bestSeconds(iterations, [&]()
+        {
+            std::vector<JobCounter> counters(chainLength);
+            jobs.run(counters[0], [&executed]()
+            {
+                executed.fetch_add(1, std::memory_order_relaxed);
+            });
+            for (size_t i = 1; i < chainLength; ++i)
+            {
+                jobs.runAfter(counters[i - 1], counters[i], [&executed]()
+                {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            jobs.wait(counters[chainLength - 1]);
+        });
+
+        const double forSeconds = bestSeconds(iterations, [&]()
+        {
+            jobs.parallelFor(0, jobCount, 1, [&executed](size_t, size_t)
+            {
+                executed.fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+
+        std::cout << std::left << std::setw(10) << threads << std::right << std::fixed << std::setprecision(1) << std::setw(14)
+                  << runSeconds / jobCount * 1e9 << std::setw(16) << chainSeconds / chainLength * 1e9 << std::setw(18) << forSeconds / jobCount * 1e9
+                  << std::endl;
+    }
+
+    const size_t elementCount = size_t(1) << 22;
+    std::vector<float> results(elementCount);
+    auto compute = [&results](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            results[i] = work(i);
+        }
+    };
+    const double serialSeconds = bestSeconds(iterations, [&]()
+    {
+        compute(0, elementCount);
+    });
+
+    std::cout << std::endl << "scaling, parallelFor over " << elementCount << " elements" << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(10) << "grain" << std::right << std::setw(12) << "ms" << std::setw(12)
+              << "speedup" << std::setw(14) << "efficiency" << std::endl;
+    for (unsigned threads : threadCounts)
+    {
+        JobSystem jobs(threads - 1);
+        for (size_t grain : { size_t(256), size_t(4096), size_t(65536) })
+        {
+            const double seconds = bestSeconds(iterations, [&]()
+            {
+                jobs.parallelFor(0, elementCount, grain, compute);
+            });
+            std::cout << std::left << std::setw(10) << threads << std::setw(10) << grain << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(12) << seconds * 1e3 << std::setprecision(2) << std::setw(11) << serialSeconds / seconds << "x" << std::setw(13)
+                      << 100.0 * serialSeconds / seconds / threads << "%" << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
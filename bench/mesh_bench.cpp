@@ -0,0 +1,120 @@
+#include "mapped_file.h"
+#include "mesh_data.h"
+#include "mesh_format.h"
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+template <typename Function>
+static double bestMilliseconds(int iterations, Function function)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Compares loading a mesh by parsing OBJ text against mapping the ingested binary file, and
+// reports the vertex cache efficiency of the index order before and after optimisation
+int main(int argc, char *argv[])
+{
+    std::string objPath;
+    int iterations = 3;
+    uint32_t sphereSegments = 512;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--obj") && i + 1 < argc)
+        {
+            objPath = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+        else if (0 == strcmp(argv[i], "--segments") && i + 1 < argc)
+        {
+            sphereSegments = uint32_t(std::max(3, atoi(argv[++i])));
+        }
+    }
+
+    const std::filesystem::path tempDirectory = std::filesystem::temp_directory_path();
+    const bool generated = objPath.empty();
+    if (generated)
+    {
+        // a tessellated sphere with its triangles shuffled, as exported meshes often arrive
+        MeshData sphere = generateSphere(sphereSegments, sphereSegments / 2);
+        shuffleTriangles(sphere, 1);
+        objPath = (tempDirectory / "mesh_bench.obj").string();
+        writeObj(objPath.c_str(), sphere);
+    }
+    const std::string meshPath = (tempDirectory / "mesh_bench.dmesh").string();
+
+    MeshData mesh;
+    const double parseMs = bestMilliseconds(iterations, [&]()
+    {
+        mesh = parseObj(objPath.c_str());
+    });
+    const uint32_t vertexCount = meshVertexCount(mesh);
+
+    const double acmrBefore16 = averageCacheMissRatio(mesh.indices, vertexCount, 16);
+    const double acmrBefore32 = averageCacheMissRatio(mesh.indices, vertexCount, 32);
+
+    const auto optimizeStart = std::chrono::steady_clock::now();
+    optimizeVertexCache(mesh.indices, vertexCount);
+    optimizeVertexFetch(mesh);
+    const std::chrono::duration<double, std::milli> optimizeMs = std::chrono::steady_clock::now() - optimizeStart;
+
+    const double acmrAfter16 = averageCacheMissRatio(mesh.indices, meshVertexCount(mesh), 16);
+    const double acmrAfter32 = averageCacheMissRatio(mesh.indices, meshVertexCount(mesh), 32);
+
+    const size_t meshBytes = writeMeshFile(meshPath.c_str(), mesh);
+
+    // the mapping alone, then with every byte read once, which is when pages actually come in
+    uint32_t checksum = 0;
+    const double mapMs = bestMilliseconds(iterations, [&]()
+    {
+        MappedFile file(meshPath.c_str());
+        const MeshView view = viewMesh(file.data(), file.size());
+        checksum += view.header->indexCount;
+    });
+    const double mapAndReadMs = bestMilliseconds(iterations, [&]()
+    {
+        MappedFile file(meshPath.c_str());
+        const MeshView view = viewMesh(file.data(), file.size());
+        for (uint32_t i = 0; i < view.header->indexCount; ++i)
+        {
+            checksum += meshIndex(view, i);
+        }
+        for (uint32_t v = 0; v < view.header->vertexCount; ++v)
+        {
+            checksum += view.vertices[v].position[0];
+        }
+    });
+
+    std::cout << "Mesh: " << vertexCount << " vertices, " << mesh.indices.size() / 3 << " triangles" << std::endl;
+    std::cout << "ACMR 16 entry FIFO: " << acmrBefore16 << " -> " << acmrAfter16 << std::endl;
+    std::cout << "ACMR 32 entry FIFO: " << acmrBefore32 << " -> " << acmrAfter32 << std::endl;
+    std::cout << "Optimisation: " << optimizeMs.count() << "ms" << std::endl;
+    std::cout << "File size: OBJ " << std::filesystem::file_size(objPath) << " bytes, mesh " << meshBytes << " bytes" << std::endl;
+    std::cout << "Load: OBJ parse " << parseMs << "ms, mesh map " << mapMs << "ms, map and read " << mapAndReadMs << "ms (best of " << iterations
+              << ", checksum " << checksum << ")" << std::endl;
+
+    std::filesystem::remove(meshPath);
+    if (generated)
+    {
+        std::filesystem::remove(objPath);
+    }
+
+    return EXIT_SUCCESS;
+}
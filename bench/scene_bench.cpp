@@ -0,0 +1,169 @@
+#include "scene_graph.h"
+#include "transform_math.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+template <typename Function>
+static double bestSeconds(int iterations, Function function)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// 16 roots, then levels that grow 8 times until the nodes run out, each node's parent picked at
+// random from the level above; ids are shuffled so the graph has to do the sorting
+static SceneGraph generateHierarchy(size_t nodeCount, std::vector<uint32_t> &roots, std::vector<uint32_t> &subtrees)
+{
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<float> offset(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28318f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+    std::vector<uint32_t> ids(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        ids[i] = i;
+    }
+    std::shuffle(ids.begin(), ids.end(), engine);
+
+    std::vector<uint32_t> parents(nodeCount);
+    std::vector<Mat4> locals(nodeCount);
+    size_t aboveBegin = 0;
+    size_t levelBegin = 0;
+    size_t levelEnd = std::min<size_t>(16, nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i)
+    {
+        if (i == levelEnd)
+        {
+            const size_t levelSize = levelEnd - levelBegin;
+            aboveBegin = levelBegin;
+            levelBegin = levelEnd;
+            levelEnd = std::min(nodeCount, levelEnd + levelSize * 8);
+        }
+        if (0 == levelBegin)
+        {
+            parents[ids[i]] = sceneNoParent;
+            roots.push_back(ids[i]);
+        }
+        else
+        {
+            parents[ids[i]] = ids[std::uniform_int_distribution<size_t>(aboveBegin, levelBegin - 1)(engine)];
+        }
+        if (16 <= i && i < 16 + 128)
+        {
+            subtrees.push_back(ids[i]);
+        }
+        locals[ids[i]] = multiply(multiply(translation(offset(engine), offset(engine), offset(engine)), rotationY(angle(engine))), uniformScale(scale(engine)));
+    }
+    return createSceneGraph(parents, locals);
+}
+
+// Updates hierarchies of 1k to 1M nodes with each SIMD level and thread count, once with every
+// node dirty and once with a few subtrees touched, reporting nodes updated per millisecond
+int main(int argc, char *argv[])
+{
+    size_t maxNodes = 1000000;
+    int iterations = 10;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--max-nodes") && i + 1 < argc)
+        {
+            maxNodes = size_t(std::max(1000, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+    }
+
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = { 1 };
+    for (unsigned threads = 2; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    if (hardwareThreads > 1)
+    {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    std::cout << "best of " << iterations << ", cpu supports " << simdLevelName(detectSimdLevel()) << std::endl;
+    std::cout << std::left << std::setw(10) << "nodes" << std::setw(8) << "levels" << std::setw(10) << "dirty" << std::setw(10) << "kernel" << std::setw(10)
+              << "threads" << std::right << std::setw(12) << "updated" << std::setw(12) << "ms" << std::setw(16) << "nodes/ms" << std::setw(14) << "vs scalar" << std::endl;
+
+    bool allMatch = true;
+    for (size_t nodeCount = 1000; nodeCount <= maxNodes; nodeCount *= 10)
+    {
+        std::vector<uint32_t> roots;
+        std::vector<uint32_t> subtrees;
+        SceneGraph graph = generateHierarchy(nodeCount, roots, subtrees);
+        const uint32_t levels = uint32_t(graph.levelStart.size()) - 1;
+
+        // full updates touch every root, partial ones a few of the second level's subtrees
+        auto touch = [&](bool full)
+        {
+            const std::vector<uint32_t> &nodes = full ? roots : subtrees;
+            for (size_t i = 0; i < nodes.size(); i += full ? 1 : 16)
+            {
+                setLocalTransform(graph, nodes[i], graph.local[graph.sortedIndex[nodes[i]]]);
+            }
+        };
+
+        for (bool full : { true, false })
+        {
+            updateWorldTransforms(graph, SimdLevel::Scalar);
+            touch(full);
+            const size_t referenceUpdated = updateWorldTransforms(graph, SimdLevel::Scalar);
+            const std::vector<Mat4> reference = graph.world;
+
+            double scalarSeconds = 0.0;
+            for (SimdLevel simd : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 })
+            {
+                if (simd > detectSimdLevel())
+                {
+                    continue;
+                }
+
+                for (unsigned threads : threadCounts)
+                {
+                    JobSystem jobs(threads - 1);
+                    size_t updated = 0;
+                    // the touch is part of the timing, as it is in a frame, but small beside the update
+                    const double seconds = bestSeconds(iterations, [&]()
+                    {
+                        touch(full);
+                        updated = updateWorldTransforms(graph, simd, &jobs);
+                    });
+                    if (SimdLevel::Scalar == simd && 1 == threads)
+                    {
+                        scalarSeconds = seconds;
+                    }
+
+                    const bool matches = updated == referenceUpdated && 0 == memcmp(reference.data(), graph.world.data(), reference.size() * sizeof(Mat4));
+                    allMatch = allMatch && matches;
+                    std::cout << std::left << std::setw(10) << nodeCount << std::setw(8) << levels << std::setw(10) << (full ? "all" : "some") << std::setw(10)
+                              << simdLevelName(simd) << std::setw(10) << threads << std::right << std::setw(12) << updated << std::fixed << std::setprecision(3)
+                              << std::setw(12) << seconds * 1e3 << std::setprecision(0) << std::setw(16) << double(updated) / (seconds * 1e3)
+                              << std::setprecision(2) << std::setw(13) << scalarSeconds / seconds << "x" << (matches ? "" : "  DIFFERS") << std::endl;
+                }
+            }
+        }
+    }
+
+    return allMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
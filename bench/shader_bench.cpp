@@ -0,0 +1,64 @@
+#include "job_system.h"
+#include "shader_library.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times building a few hundred shader variants with an empty cache and again with it warm, with
+// the compiles spread over the job system and on a single thread
+static double buildMilliseconds(const std::vector<ShaderVariant> &variants, const std::filesystem::path &cacheDirectory, JobSystem *jobs, bool cold)
+{
+    if (cold)
+    {
+        std::filesystem::remove_all(cacheDirectory);
+    }
+    ShaderLibrary library(DITTY_SHADER_DIRECTORY, cacheDirectory);
+    library.build(variants, jobs);
+    if ((cold && 0 != library.cacheHits) || (!cold && 0 != library.compiled))
+    {
+        std::cerr << "Unexpected cache use: " << library.cacheHits << " hits, " << library.compiled << " compiled" << std::endl;
+    }
+    return library.buildMilliseconds;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t variantCount = 256;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--variants") && i + 1 < argc)
+        {
+            variantCount = uint32_t(std::max(1, atoi(argv[++i])));
+        }
+    }
+
+    // the ditty's files compiled under distinct defines, which give each variant its own cache entry
+    const std::vector<ShaderVariant> files = dittyShaderVariants();
+    std::vector<ShaderVariant> variants;
+    for (uint32_t i = 0; i < variantCount; ++i)
+    {
+        const ShaderVariant &file = files[i % files.size()];
+        variants.push_back({ file.name + "#" + std::to_string(i), file.file, { "VARIANT=" + std::to_string(i) } });
+    }
+
+    const std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path() / "shader_bench_cache";
+    JobSystem jobs;
+
+    const double coldParallelMs = buildMilliseconds(variants, cacheDirectory, &jobs, true);
+    const double warmParallelMs = buildMilliseconds(variants, cacheDirectory, &jobs, false);
+    const double coldSerialMs = buildMilliseconds(variants, cacheDirectory, nullptr, true);
+    const double warmSerialMs = buildMilliseconds(variants, cacheDirectory, nullptr, false);
+
+    std::cout << "Shaders: " << variantCount << " variants of " << files.size() << " files" << std::endl;
+    std::cout << "Cold: " << coldParallelMs << "ms on " << jobs.threadCount() << " threads, " << coldSerialMs << "ms on 1 thread" << std::endl;
+    std::cout << "Warm: " << warmParallelMs << "ms on " << jobs.threadCount() << " threads, " << warmSerialMs << "ms on 1 thread" << std::endl;
+
+    std::filesystem::remove_all(cacheDirectory);
+
+    return EXIT_SUCCESS;
+}
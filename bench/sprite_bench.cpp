@@ -0,0 +1,90 @@
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+template <typename Function>
+static double bestSeconds(int iterations, Function function)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// The CPU side of sprite batching: the radix sort against std::stable_sort on the same keys, and
+// sorting plus vertex writing per frame, for fields of increasing size. The GL submission is
+// measured by graphics_ditties_bench.
+int main(int argc, char *argv[])
+{
+    uint16_t pages = 8;
+    int iterations = 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--pages") && i + 1 < argc)
+        {
+            pages = uint16_t(std::min(int(spriteMaxPages), std::max(1, atoi(argv[++i]))));
+        }
+        else if (0 == strcmp(argv[i], "--iterations") && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+    }
+
+    std::cout << pages << " pages, 3 blends, 16 layers, best of " << iterations << std::endl;
+    std::cout << std::setw(10) << "sprites" << std::setw(10) << "batches" << std::setw(8) << "passes" << std::setw(14) << "radix ms"
+              << std::setw(14) << "stable ms" << std::setw(16) << "sprites/ms" << std::setw(12) << "order" << std::endl;
+
+    bool allMatch = true;
+    for (uint32_t count : { 1000u, 10000u, 50000u, 200000u })
+    {
+        SpriteBatcher batcher;
+        addSpriteField(batcher, count, pages, 1920.0f, 1080.0f, 1.0);
+
+        std::vector<uint64_t> keys(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            keys[i] = uint64_t(spriteSortKey(batcher.sprites[i])) << 32 | i;
+        }
+        std::vector<uint64_t> radix;
+        std::vector<uint64_t> scratch;
+        uint32_t passes = 0;
+        const double radixSeconds = bestSeconds(iterations, [&]()
+        {
+            radix = keys;
+            passes = radixSortKeys(radix, scratch);
+        });
+        std::vector<uint64_t> stable;
+        const double stableSeconds = bestSeconds(iterations, [&]()
+        {
+            stable = keys;
+            std::stable_sort(stable.begin(), stable.end(), [](uint64_t a, uint64_t b) { return (a >> 32) < (b >> 32); });
+        });
+        const bool matches = radix == stable;
+        allMatch = allMatch && matches;
+
+        // what the renderer does every frame before its draw calls
+        std::vector<SpriteVertex> vertices(size_t(count) * 4);
+        const double frameSeconds = bestSeconds(iterations, [&]()
+        {
+            sortSprites(batcher);
+            writeSpriteVertices(batcher, 0, count, vertices.data());
+        });
+
+        std::cout << std::setw(10) << count << std::setw(10) << batcher.batches.size() << std::setw(8) << passes << std::fixed << std::setprecision(3)
+                  << std::setw(14) << radixSeconds * 1e3 << std::setw(14) << stableSeconds * 1e3 << std::setprecision(0) << std::setw(16)
+                  << double(count) / (frameSeconds * 1e3) << std::setw(12) << (matches ? "identical" : "DIFFERS") << std::endl;
+    }
+
+    return allMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
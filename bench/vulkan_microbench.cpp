@@ -0,0 +1,871 @@
+#include "vulkan_microbench.h"
+
+#include "device_functions.h"
+#include "memory_util.h"
+#include "post_process.h"
+#include "render_targets.h"
+#include "shader_library.h"
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct VulkanContext
+{
+    VkInstance instance;
+    VkSurfaceKHR surface;
+    VkPhysicalDevice physicalDevice;
+    uint32_t queueFamily;
+    VkDevice device;
+    VkQueue queue;
+    VkCommandPool commandPool;
+    VkFence fence;
+};
+
+static void check(VkResult result, const char *what)
+{
+    if (VK_SUCCESS != result)
+    {
+        throw std::runtime_error(std::string("Failed to ") + what + " (" + std::to_string(int(result)) + ")");
+    }
+}
+
+static VkInstance createInstance(bool presentable)
+{
+    VkApplicationInfo appInfo{};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "graphics_ditties_bench";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "No Engine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    VkInstanceCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    if (presentable)
+    {
+        createInfo.ppEnabledExtensionNames = glfwGetRequiredInstanceExtensions(&createInfo.enabledExtensionCount);
+    }
+
+    VkInstance instance;
+    check(vkCreateInstance(&createInfo, nullptr, &instance), "create instance");
+    return instance;
+}
+
+// first device with a graphics queue family, which can also present when there's a surface
+static std::tuple<VkPhysicalDevice, uint32_t> choosePhysicalDevice(VkInstance instance, VkSurfaceKHR surface)
+{
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+    for (VkPhysicalDevice physicalDevice : devices)
+    {
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+        for (uint32_t i = 0; i < familyCount; ++i)
+        {
+            VkBool32 present = VK_TRUE;
+            if (VK_NULL_HANDLE != surface)
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &present);
+            }
+            if (0 != (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && VK_TRUE == present)
+            {
+                return std::make_tuple(physicalDevice, i);
+            }
+        }
+    }
+    throw std::runtime_error("No Vulkan device with a suitable graphics queue");
+}
+
+static VulkanContext createContext(GLFWwindow *window)
+{
+    VulkanContext context{};
+    context.instance = createInstance(nullptr != window);
+    if (nullptr != window)
+    {
+        check(glfwCreateWindowSurface(context.instance, window, nullptr, &context.surface), "create surface");
+    }
+    std::tie(context.physicalDevice, context.queueFamily) = choosePhysicalDevice(context.instance, context.surface);
+
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo{};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = context.queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    const char *swapChainExtension = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    VkDeviceCreateInfo deviceInfo{};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    if (VK_NULL_HANDLE != context.surface)
+    {
+        deviceInfo.enabledExtensionCount = 1;
+        deviceInfo.ppEnabledExtensionNames = &swapChainExtension;
+    }
+    check(vkCreateDevice(context.physicalDevice, &deviceInfo, nullptr, &context.device), "create device");
+    vkGetDeviceQueue(context.device, context.queueFamily, 0, &context.queue);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = context.queueFamily;
+    check(vkCreateCommandPool(context.device, &poolInfo, nullptr, &context.commandPool), "create command pool");
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    check(vkCreateFence(context.device, &fenceInfo, nullptr, &context.fence), "create fence");
+
+    return context;
+}
+
+static void destroyContext(const VulkanContext &context)
+{
+    vkDestroyFence(context.device, context.fence, nullptr);
+    vkDestroyCommandPool(context.device, context.commandPool, nullptr);
+    vkDestroyDevice(context.device, nullptr);
+    if (VK_NULL_HANDLE != context.surface)
+    {
+        vkDestroySurfaceKHR(context.instance, context.surface, nullptr);
+    }
+    vkDestroyInstance(context.instance, nullptr);
+}
+
+static std::vector<VkCommandBuffer> allocateCommandBuffers(const VulkanContext &context, VkCommandPool pool, uint32_t count)
+{
+    VkCommandBufferAllocateInfo allocateInfo{};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = pool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = count;
+    std::vector<VkCommandBuffer> commandBuffers(count);
+    check(vkAllocateCommandBuffers(context.device, &allocateInfo, commandBuffers.data()), "allocate command buffers");
+    return commandBuffers;
+}
+
+static void beginCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = flags;
+    check(vkBeginCommandBuffer(commandBuffer, &beginInfo), "begin command buffer");
+}
+
+static void submitAndWait(const VulkanContext &context, const VkCommandBuffer *commandBuffers, uint32_t count)
+{
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = count;
+    submitInfo.pCommandBuffers = commandBuffers;
+    check(vkQueueSubmit(context.queue, 1, &submitInfo, context.fence), "submit");
+    vkWaitForFences(context.device, 1, &context.fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(context.device, 1, &context.fence);
+}
+
+static void benchCommandBuffers(BenchReport &report, const VulkanContext &context, int samples)
+{
+    constexpr int recordings = 100;
+    const VkCommandBuffer commandBuffer = allocateCommandBuffers(context, context.commandPool, 1)[0];
+
+    report.add("vk.command_buffer.reset_begin_end", sampleNanoseconds(samples, recordings, [&]()
+    {
+        for (int i = 0; i < recordings; ++i)
+        {
+            vkResetCommandBuffer(commandBuffer, 0);
+            beginCommandBuffer(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            vkEndCommandBuffer(commandBuffer);
+        }
+    }));
+    vkFreeCommandBuffers(context.device, context.commandPool, 1, &commandBuffer);
+
+    // the same with a transient pool reset as a whole, which is how per-frame pools are used
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = context.queueFamily;
+    VkCommandPool pool;
+    check(vkCreateCommandPool(context.device, &poolInfo, nullptr, &pool), "create command pool");
+    const VkCommandBuffer pooledBuffer = allocateCommandBuffers(context, pool, 1)[0];
+
+    report.add("vk.command_pool.reset_begin_end", sampleNanoseconds(samples, recordings, [&]()
+    {
+        for (int i = 0; i < recordings; ++i)
+        {
+            vkResetCommandPool(context.device, pool, 0);
+            beginCommandBuffer(pooledBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            vkEndCommandBuffer(pooledBuffer);
+        }
+    }));
+    vkDestroyCommandPool(context.device, pool, nullptr);
+}
+
+// Only the vkQueueSubmit call is timed; the wait for the fence is reported separately as a round trip
+static void benchSubmit(BenchReport &report, const VulkanContext &context, int samples)
+{
+    const uint32_t maxBatch = 64;
+    std::vector<VkCommandBuffer> commandBuffers = allocateCommandBuffers(context, context.commandPool, maxBatch);
+    for (VkCommandBuffer commandBuffer : commandBuffers)
+    {
+        beginCommandBuffer(commandBuffer, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+        vkEndCommandBuffer(commandBuffer);
+    }
+
+    for (uint32_t batch = 1; batch <= maxBatch; batch *= 4)
+    {
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = batch;
+        submitInfo.pCommandBuffers = commandBuffers.data();
+
+        std::vector<double> submitNanoseconds;
+        for (int i = 0; i < samples + 3; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            check(vkQueueSubmit(context.queue, 1, &submitInfo, context.fence), "submit");
+            const auto end = std::chrono::steady_clock::now();
+            vkWaitForFences(context.device, 1, &context.fence, VK_TRUE, UINT64_MAX);
+            vkResetFences(context.device, 1, &context.fence);
+            if (i >= 3)
+            {
+                submitNanoseconds.push_back(elapsedNanoseconds(start, end));
+            }
+        }
+        report.add("vk.queue_submit.batch_" + std::to_string(batch), submitNanoseconds);
+    }
+
+    report.add("vk.queue_submit.round_trip", sampleNanoseconds(samples, 1, [&]()
+    {
+        submitAndWait(context, commandBuffers.data(), 1);
+    }));
+
+    vkFreeCommandBuffers(context.device, context.commandPool, maxBatch, commandBuffers.data());
+}
+
+// Recording and executing runs of barriers, with the cost of an empty submission subtracted from execution
+static void benchBarriers(BenchReport &report, const VulkanContext &context, int samples)
+{
+    constexpr uint32_t barrierCount = 256;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = {256, 256, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage image;
+    check(vkCreateImage(context.device, &imageInfo, nullptr, &image), "create image");
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(context.device, image, &requirements);
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = findMemoryType(context.physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDeviceMemory memory;
+    check(vkAllocateMemory(context.device, &allocateInfo, nullptr, &memory), "allocate image memory");
+    vkBindImageMemory(context.device, image, memory, 0);
+
+    const std::vector<VkCommandBuffer> commandBuffers = allocateCommandBuffers(context, context.commandPool, 3);
+    const VkCommandBuffer imageBarriers = commandBuffers[0];
+    const VkCommandBuffer memoryBarriers = commandBuffers[1];
+    const VkCommandBuffer empty = commandBuffers[2];
+
+    // alternating layouts so no barrier is redundant; each execution starts from undefined
+    const auto recordImageBarriers = [&]()
+    {
+        vkResetCommandBuffer(imageBarriers, 0);
+        beginCommandBuffer(imageBarriers, 0);
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        for (uint32_t i = 0; i < barrierCount; ++i)
+        {
+            const bool even = 0 == (i & 1);
+            barrier.oldLayout = 0 == i ? VK_IMAGE_LAYOUT_UNDEFINED : even ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = even ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcAccessMask = even ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = even ? VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_WRITE_BIT;
+            const VkPipelineStageFlags sourceStage = even ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
+            const VkPipelineStageFlags destinationStage = even ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            vkCmdPipelineBarrier(imageBarriers, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+        vkEndCommandBuffer(imageBarriers);
+    };
+    const auto recordMemoryBarriers = [&]()
+    {
+        vkResetCommandBuffer(memoryBarriers, 0);
+        beginCommandBuffer(memoryBarriers, 0);
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        for (uint32_t i = 0; i < barrierCount; ++i)
+        {
+            vkCmdPipelineBarrier(memoryBarriers, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+        vkEndCommandBuffer(memoryBarriers);
+    };
+
+    report.add("vk.barrier.image.record", sampleNanoseconds(samples, barrierCount, recordImageBarriers));
+    report.add("vk.barrier.memory.record", sampleNanoseconds(samples, barrierCount, recordMemoryBarriers));
+
+    beginCommandBuffer(empty, 0);
+    vkEndCommandBuffer(empty);
+    std::vector<double> emptyNanoseconds = sampleNanoseconds(samples, 1, [&]()
+    {
+        submitAndWait(context, &empty, 1);
+    });
+    std::sort(emptyNanoseconds.begin(), emptyNanoseconds.end());
+    const double emptyMedian = emptyNanoseconds[emptyNanoseconds.size() / 2];
+
+    for (const auto &[name, commandBuffer] : {std::make_tuple("vk.barrier.image.execute", imageBarriers), std::make_tuple("vk.barrier.memory.execute", memoryBarriers)})
+    {
+        std::vector<double> executeNanoseconds = sampleNanoseconds(samples, 1, [&, commandBuffer = commandBuffer]()
+        {
+            submitAndWait(context, &commandBuffer, 1);
+        });
+        for (double &nanoseconds : executeNanoseconds)
+        {
+            nanoseconds = std::max(0.0, nanoseconds - emptyMedian) / double(barrierCount);
+        }
+        report.add(name, executeNanoseconds);
+    }
+
+    vkFreeCommandBuffers(context.device, context.commandPool, uint32_t(commandBuffers.size()), commandBuffers.data());
+    vkDestroyImage(context.device, image, nullptr);
+    vkFreeMemory(context.device, memory, nullptr);
+}
+
+// The same calls through the loader's exports and through the table from vkGetDeviceProcAddr,
+// which skips the loader's trampoline
+template <typename PipelineBarrier, typename QueueSubmit>
+static void benchDispatchPath(BenchReport &report, const VulkanContext &context, int samples, const char *path, PipelineBarrier pipelineBarrier, QueueSubmit queueSubmit)
+{
+    constexpr int calls = 1000;
+    const std::vector<VkCommandBuffer> commandBuffers = allocateCommandBuffers(context, context.commandPool, 2);
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    report.add(std::string("vk.dispatch.") + path + ".cmd_pipeline_barrier", sampleNanoseconds(samples, calls, [&]()
+    {
+        vkResetCommandBuffer(commandBuffers[0], 0);
+        beginCommandBuffer(commandBuffers[0], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        for (int i = 0; i < calls; ++i)
+        {
+            pipelineBarrier(commandBuffers[0], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+        vkEndCommandBuffer(commandBuffers[0]);
+    }));
+
+    // empty submissions without a fence, waited for outside the timed loop
+    constexpr int submits = 100;
+    beginCommandBuffer(commandBuffers[1], VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+    vkEndCommandBuffer(commandBuffers[1]);
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffers[1];
+    std::vector<double> submitNanoseconds;
+    for (int i = 0; i < samples + 3; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int j = 0; j < submits; ++j)
+        {
+            check(queueSubmit(context.queue, 1, &submitInfo, VK_NULL_HANDLE), "submit");
+        }
+        const auto end = std::chrono::steady_clock::now();
+        vkQueueWaitIdle(context.queue);
+        if (i >= 3)
+        {
+            submitNanoseconds.push_back(elapsedNanoseconds(start, end) / double(submits));
+        }
+    }
+    report.add(std::string("vk.dispatch.") + path + ".queue_submit", submitNanoseconds);
+
+    vkFreeCommandBuffers(context.device, context.commandPool, uint32_t(commandBuffers.size()), commandBuffers.data());
+}
+
+static void benchDispatch(BenchReport &report, const VulkanContext &context, int samples)
+{
+    loadDeviceFunctions(context.device);
+    benchDispatchPath(report, context, samples, "loader", vkCmdPipelineBarrier, vkQueueSubmit);
+    benchDispatchPath(report, context, samples, "direct", vkd::CmdPipelineBarrier, vkd::QueueSubmit);
+}
+
+// GPU time of each post-processing pass from timestamps, over a synthetic HDR image cleared above
+// the bloom threshold, along with the bytes each pass fetches and writes
+static void benchPostProcess(BenchReport &report, const VulkanContext &context, int samples)
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.physicalDevice, &familyCount, families.data());
+    if (0 == families[context.queueFamily].timestampValidBits)
+    {
+        report.skip("vk.post", "queue family has no timestamps");
+        return;
+    }
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+
+    loadDeviceFunctions(context.device);
+
+    constexpr uint32_t queryCount = PostProcess::PassCount + 1;
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = queryCount;
+    VkQueryPool queryPool;
+    check(vkCreateQueryPool(context.device, &queryPoolInfo, nullptr, &queryPool), "create query pool");
+
+    ShaderLibrary shaders(DITTY_SHADER_DIRECTORY, defaultShaderCacheDirectory());
+    shaders.build(dittyShaderVariants(), nullptr);
+
+    const VkExtent2D resolutions[] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+    for (PostProcessMode mode : { PostProcessMode::Compute, PostProcessMode::Fragment })
+    {
+        for (VkExtent2D extent : resolutions)
+        {
+            const std::unique_ptr<PostProcess> post = createPostProcess(context.physicalDevice, context.device, extent, mode, shaders);
+            const VkCommandBuffer commandBuffer = allocateCommandBuffers(context, context.commandPool, 1)[0];
+            beginCommandBuffer(commandBuffer, 0);
+            vkCmdResetQueryPool(commandBuffer, queryPool, 0, queryCount);
+
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = post->hdr.image;
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+            const VkClearColorValue hdrColor = { { 1.5f, 1.2f, 0.8f, 1.0f } };
+            vkCmdClearColorImage(commandBuffer, post->hdr.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &hdrColor, 1, &barrier.subresourceRange);
+            // recordPostProcess makes the clear visible to the first pass
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            recordPostProcess(commandBuffer, *post, queryPool, 0);
+            check(vkEndCommandBuffer(commandBuffer), "end command buffer");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                submitAndWait(context, &commandBuffer, 1);
+            }
+            std::vector<double> passNanoseconds[PostProcess::PassCount];
+            for (int sample = 0; sample < samples; ++sample)
+            {
+                submitAndWait(context, &commandBuffer, 1);
+                uint64_t timestamps[queryCount];
+                check(vkGetQueryPoolResults(context.device, queryPool, 0, queryCount, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT), "get timestamps");
+                for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+                {
+                    passNanoseconds[pass].push_back(double(timestamps[pass + 1] - timestamps[pass]) * properties.limits.timestampPeriod);
+                }
+            }
+
+            const std::string prefix = std::string("vk.post.") + postProcessModeName(mode) + "." + std::to_string(extent.width) + "x" + std::to_string(extent.height) + ".";
+            for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+            {
+                report.add(prefix + postProcessPassNames[pass], std::move(passNanoseconds[pass]));
+                report.add(prefix + postProcessPassNames[pass] + ".bytes", { double(postProcessPassBytes(*post, pass)) }, "bytes");
+            }
+
+            vkFreeCommandBuffers(context.device, context.commandPool, 1, &commandBuffer);
+            destroyPostProcess(context.device, *post);
+        }
+    }
+
+    shaders.destroyModules(context.device);
+    vkDestroyQueryPool(context.device, queryPool, nullptr);
+}
+
+// The scene's pass without its draws: clear the attachments and, multisampled, resolve into the target
+static VkRenderPass createClearResolvePass(VkDevice device, VkFormat format, const RenderTargets &targets)
+{
+    const bool multisampled = VK_SAMPLE_COUNT_1_BIT != targets.samples;
+    VkAttachmentDescription attachments[3]{};
+    attachments[0].format = format;
+    attachments[0].samples = targets.samples;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[1] = attachments[0];
+    attachments[1].format = targets.depthFormat;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    attachments[2] = attachments[0];
+    attachments[2].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+    const VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    const VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    const VkAttachmentReference resolveReference = { 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    subpass.pResolveAttachments = multisampled ? &resolveReference : nullptr;
+    subpass.pDepthStencilAttachment = &depthReference;
+
+    VkRenderPassCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.attachmentCount = multisampled ? 3 : 2;
+    createInfo.pAttachments = attachments;
+    createInfo.subpassCount = 1;
+    createInfo.pSubpasses = &subpass;
+    VkRenderPass renderPass;
+    check(vkCreateRenderPass(device, &createInfo, nullptr, &renderPass), "create render pass");
+    return renderPass;
+}
+
+// GPU time and memory of the scene's attachments at 1x, 4x and 8x, transient in lazily allocated
+// memory where the device has it against regular device local images
+static void benchRenderTargets(BenchReport &report, const VulkanContext &context, int samples)
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.physicalDevice, &familyCount, families.data());
+    if (0 == families[context.queueFamily].timestampValidBits)
+    {
+        report.skip("vk.msaa", "queue family has no timestamps");
+        return;
+    }
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2;
+    VkQueryPool queryPool;
+    check(vkCreateQueryPool(context.device, &queryPoolInfo, nullptr, &queryPool), "create query pool");
+
+    // the resolve target, or at 1x the colour attachment itself
+    const VkExtent2D extent = { 1920, 1080 };
+    const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage target;
+    check(vkCreateImage(context.device, &imageInfo, nullptr, &target), "create resolve target");
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(context.device, target, &requirements);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(context.physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDeviceMemory targetMemory;
+    check(vkAllocateMemory(context.device, &allocInfo, nullptr, &targetMemory), "allocate resolve target");
+    check(vkBindImageMemory(context.device, target, targetMemory, 0), "bind resolve target");
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = target;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    VkImageView targetView;
+    check(vkCreateImageView(context.device, &viewInfo, nullptr, &targetView), "create resolve target view");
+
+    for (uint32_t sampleCount : { 1u, 4u, 8u })
+    {
+        const VkSampleCountFlagBits sampleBits = chooseSampleCount(context.physicalDevice, sampleCount);
+        for (bool transient : { true, false })
+        {
+            const std::string name = std::string("vk.msaa.") + std::to_string(sampleCount) + "x." + (transient ? "transient" : "regular");
+            if (sampleBits != VkSampleCountFlagBits(sampleCount))
+            {
+                report.skip(name, "sample count not supported");
+                continue;
+            }
+
+            const RenderTargets targets = createRenderTargets(context.physicalDevice, context.device, format, extent, sampleBits, transient);
+            const VkRenderPass renderPass = createClearResolvePass(context.device, format, targets);
+            const bool multisampled = VK_NULL_HANDLE != targets.colorView;
+            const VkImageView attachments[3] = { multisampled ? targets.colorView : targetView, targets.depthView, targetView };
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = multisampled ? 3 : 2;
+            framebufferInfo.pAttachments = attachments;
+            framebufferInfo.width = extent.width;
+            framebufferInfo.height = extent.height;
+            framebufferInfo.layers = 1;
+            VkFramebuffer framebuffer;
+            check(vkCreateFramebuffer(context.device, &framebufferInfo, nullptr, &framebuffer), "create framebuffer");
+
+            const VkCommandBuffer commandBuffer = allocateCommandBuffers(context, context.commandPool, 1)[0];
+            beginCommandBuffer(commandBuffer, 0);
+            vkCmdResetQueryPool(commandBuffer, queryPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+            VkClearValue clearValues[2]{};
+            clearValues[0].color = { { 0.05f, 0.05f, 0.08f, 1.0f } };
+            clearValues[1].depthStencil = { 1.0f, 0 };
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = renderPass;
+            renderPassInfo.framebuffer = framebuffer;
+            renderPassInfo.renderArea = { { 0, 0 }, extent };
+            renderPassInfo.clearValueCount = 2;
+            renderPassInfo.pClearValues = clearValues;
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdEndRenderPass(commandBuffer);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+            check(vkEndCommandBuffer(commandBuffer), "end command buffer");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                submitAndWait(context, &commandBuffer, 1);
+            }
+            std::vector<double> nanoseconds;
+            for (int sample = 0; sample < samples; ++sample)
+            {
+                submitAndWait(context, &commandBuffer, 1);
+                uint64_t timestamps[2];
+                check(vkGetQueryPoolResults(context.device, queryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT), "get timestamps");
+                nanoseconds.push_back(double(timestamps[1] - timestamps[0]) * properties.limits.timestampPeriod);
+            }
+
+            report.add(name, std::move(nanoseconds));
+            report.add(name + ".bytes", { double(targets.colorBytes + targets.depthBytes) }, "bytes");
+            report.add(name + ".committed", { double(renderTargetsCommittedBytes(context.device, targets)) }, "bytes");
+
+            vkFreeCommandBuffers(context.device, context.commandPool, 1, &commandBuffer);
+            vkDestroyFramebuffer(context.device, framebuffer, nullptr);
+            vkDestroyRenderPass(context.device, renderPass, nullptr);
+            destroyRenderTargets(context.device, targets);
+        }
+    }
+
+    vkDestroyImageView(context.device, targetView, nullptr);
+    vkDestroyImage(context.device, target, nullptr);
+    vkFreeMemory(context.device, targetMemory, nullptr);
+    vkDestroyQueryPool(context.device, queryPool, nullptr);
+}
+
+static VkPresentModeKHR choosePresentMode(const VulkanContext &context)
+{
+    uint32_t modeCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(context.physicalDevice, context.surface, &modeCount, nullptr);
+    std::vector<VkPresentModeKHR> modes(modeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(context.physicalDevice, context.surface, &modeCount, modes.data());
+
+    // vsync would measure the display rather than the driver
+    for (VkPresentModeKHR preferred : {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR})
+    {
+        if (modes.end() != std::find(modes.begin(), modes.end(), preferred))
+        {
+            return preferred;
+        }
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+static const char *presentModeName(VkPresentModeKHR mode)
+{
+    switch (mode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "mailbox";
+    default:
+        return "fifo";
+    }
+}
+
+// Acquire, a submission that only transitions the image for present, and present, timed per call
+static void benchPresent(BenchReport &report, const VulkanContext &context, int samples)
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    check(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(context.physicalDevice, context.surface, &capabilities), "get surface capabilities");
+    uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(context.physicalDevice, context.surface, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(context.physicalDevice, context.surface, &formatCount, formats.data());
+    if (formats.empty())
+    {
+        report.skip("vk.present", "surface has no formats");
+        return;
+    }
+
+    const VkPresentModeKHR presentMode = choosePresentMode(context);
+    report.setProperty("vk_present_mode", presentModeName(presentMode));
+
+    VkSwapchainCreateInfoKHR swapChainInfo{};
+    swapChainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapChainInfo.surface = context.surface;
+    swapChainInfo.minImageCount = std::max(capabilities.minImageCount, 2u);
+    if (0 != capabilities.maxImageCount)
+    {
+        swapChainInfo.minImageCount = std::min(swapChainInfo.minImageCount, capabilities.maxImageCount);
+    }
+    swapChainInfo.imageFormat = formats[0].format;
+    swapChainInfo.imageColorSpace = formats[0].colorSpace;
+    swapChainInfo.imageExtent = 0xFFFFFFFF == capabilities.currentExtent.width ? VkExtent2D{256, 256} : capabilities.currentExtent;
+    swapChainInfo.imageArrayLayers = 1;
+    swapChainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swapChainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    swapChainInfo.preTransform = capabilities.currentTransform;
+    swapChainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    swapChainInfo.presentMode = presentMode;
+    swapChainInfo.clipped = VK_TRUE;
+    VkSwapchainKHR swapChain;
+    check(vkCreateSwapchainKHR(context.device, &swapChainInfo, nullptr, &swapChain), "create swap chain");
+
+    uint32_t imageCount = 0;
+    vkGetSwapchainImagesKHR(context.device, swapChain, &imageCount, nullptr);
+    std::vector<VkImage> images(imageCount);
+    vkGetSwapchainImagesKHR(context.device, swapChain, &imageCount, images.data());
+
+    std::vector<VkCommandBuffer> commandBuffers = allocateCommandBuffers(context, context.commandPool, imageCount);
+    for (uint32_t i = 0; i < imageCount; ++i)
+    {
+        beginCommandBuffer(commandBuffers[i], VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = images[i];
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        vkCmdPipelineBarrier(commandBuffers[i], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        vkEndCommandBuffer(commandBuffers[i]);
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkSemaphore acquired;
+    VkSemaphore rendered;
+    check(vkCreateSemaphore(context.device, &semaphoreInfo, nullptr, &acquired), "create semaphore");
+    check(vkCreateSemaphore(context.device, &semaphoreInfo, nullptr, &rendered), "create semaphore");
+
+    std::vector<double> acquireNanoseconds;
+    std::vector<double> presentNanoseconds;
+    std::vector<double> roundTripNanoseconds;
+    for (int i = 0; i < samples + 3; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        uint32_t imageIndex = 0;
+        const VkResult acquireResult = vkAcquireNextImageKHR(context.device, swapChain, UINT64_MAX, acquired, VK_NULL_HANDLE, &imageIndex);
+        if (VK_SUCCESS != acquireResult && VK_SUBOPTIMAL_KHR != acquireResult)
+        {
+            check(acquireResult, "acquire swap chain image");
+        }
+        const auto acquiredTime = std::chrono::steady_clock::now();
+
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &acquired;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &rendered;
+        check(vkQueueSubmit(context.queue, 1, &submitInfo, context.fence), "submit");
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &rendered;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &swapChain;
+        presentInfo.pImageIndices = &imageIndex;
+        const auto presentStart = std::chrono::steady_clock::now();
+        vkQueuePresentKHR(context.queue, &presentInfo);
+        const auto presented = std::chrono::steady_clock::now();
+
+        // the semaphores are only reused once the submission that used them has completed
+        vkWaitForFences(context.device, 1, &context.fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(context.device, 1, &context.fence);
+        if (i >= 3)
+        {
+            acquireNanoseconds.push_back(elapsedNanoseconds(start, acquiredTime));
+            presentNanoseconds.push_back(elapsedNanoseconds(presentStart, presented));
+            roundTripNanoseconds.push_back(elapsedNanoseconds(start, std::chrono::steady_clock::now()));
+        }
+        glfwPollEvents();
+    }
+    report.add("vk.acquire", acquireNanoseconds);
+    report.add("vk.present", presentNanoseconds);
+    report.add("vk.acquire_present.round_trip", roundTripNanoseconds);
+
+    vkQueueWaitIdle(context.queue);
+    vkDestroySemaphore(context.device, rendered, nullptr);
+    vkDestroySemaphore(context.device, acquired, nullptr);
+    vkFreeCommandBuffers(context.device, context.commandPool, imageCount, commandBuffers.data());
+    vkDestroySwapchainKHR(context.device, swapChain, nullptr);
+}
+
+void runVulkanBenchmarks(BenchReport &report, GLFWwindow *window, int samples)
+{
+    const VulkanContext context = createContext(window);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+    report.setProperty("vk_device", properties.deviceName);
+    report.setProperty("vk_driver_version", std::to_string(properties.driverVersion));
+
+    benchCommandBuffers(report, context, samples);
+    benchSubmit(report, context, samples);
+    benchBarriers(report, context, samples);
+    benchDispatch(report, context, samples);
+    benchPostProcess(report, context, samples);
+    benchRenderTargets(report, context, samples);
+    if (VK_NULL_HANDLE != context.surface)
+    {
+        benchPresent(report, context, samples);
+    }
+    else
+    {
+        report.skip("vk.acquire_present.round_trip", "no window surface");
+    }
+
+    destroyContext(context);
+}
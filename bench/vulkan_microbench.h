@@ -0,0 +1,10 @@
+#pragma once
+
+#include "bench_report.h"
+
+struct GLFWwindow;
+
+// Driver overhead of command buffer recording, queue submission, barriers and presentation, and
+// what calling through a device dispatch table saves over the loader's trampolines
+// window is a hidden GLFW_NO_API window to present to, or null to skip the swap chain benchmarks
+void runVulkanBenchmarks(BenchReport &report, GLFWwindow *window, int samples);
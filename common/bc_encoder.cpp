@@ -0,0 +1,468 @@
+#include "bc_encoder.h"
+#include "bc_encoder_internal.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace bc
+{
+    void encodeBc1BlockScalar(const uint8_t block[64], uint8_t out[8])
+    {
+        uint8_t minColor[3] = { 255, 255, 255 };
+        uint8_t maxColor[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                minColor[c] = std::min(minColor[c], block[4 * i + c]);
+                maxColor[c] = std::max(maxColor[c], block[4 * i + c]);
+            }
+        }
+
+        const ColorEndpoints endpoints = colorEndpoints(minColor, maxColor);
+
+        // nearest palette entry by sum of absolute differences, ties to the lower index
+        uint32_t indices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestIndex = 0;
+            int bestDistance = 0x7fffffff;
+            for (int p = 0; p < 4; ++p)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    distance += abs(int(block[4 * i + c]) - int(endpoints.palette[p][c]));
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= uint32_t(bestIndex) << (2 * i);
+        }
+
+        writeColorBlock(endpoints.color0, endpoints.color1, indices, out);
+    }
+
+    void encodeBc3BlockScalar(const uint8_t block[64], uint8_t out[16])
+    {
+        uint8_t minAlpha = 255;
+        uint8_t maxAlpha = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            minAlpha = std::min(minAlpha, block[4 * i + 3]);
+            maxAlpha = std::max(maxAlpha, block[4 * i + 3]);
+        }
+
+        const AlphaEndpoints endpoints = alphaEndpoints(minAlpha, maxAlpha);
+        uint8_t indices[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            int position = 0;
+            for (int k = 0; k < 7; ++k)
+            {
+                position += (block[4 * i + 3] < endpoints.thresholds[k]) ? 1 : 0;
+            }
+            indices[i] = alphaIndexForPosition[position];
+        }
+
+        writeAlphaBlock(endpoints.alpha0, endpoints.alpha1, indices, out);
+        encodeBc1BlockScalar(block, out + 8);
+    }
+
+    static const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    static int bc7Interpolate(int e0, int e1, int weight)
+    {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    }
+
+    // LSB first bit writer for the 128 bit BC7 block
+    struct BitWriter
+    {
+        uint8_t *out;
+        int position = 0;
+
+        void write(uint32_t value, int bits)
+        {
+            for (int i = 0; i < bits; ++i, ++position)
+            {
+                if (value & (1u << i))
+                {
+                    out[position >> 3] |= uint8_t(1u << (position & 7));
+                }
+            }
+        }
+    };
+
+    // mode 6: one subset, RGBA endpoints of 7 bits plus a unique p-bit each, 4 bit indices
+    void encodeBc7BlockScalar(const uint8_t block[64], uint8_t out[16])
+    {
+        uint8_t minColor[4] = { 255, 255, 255, 255 };
+        uint8_t maxColor[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                minColor[c] = std::min(minColor[c], block[4 * i + c]);
+                maxColor[c] = std::max(maxColor[c], block[4 * i + c]);
+            }
+        }
+
+        // quantise an endpoint to 7 bits per channel with the p-bit that fits it best
+        auto quantise = [](const uint8_t color[4], uint8_t quantised[4], uint8_t &pBit)
+        {
+            int bestError = 0x7fffffff;
+            for (int p = 0; p < 2; ++p)
+            {
+                uint8_t candidate[4];
+                int error = 0;
+                for (int c = 0; c < 4; ++c)
+                {
+                    candidate[c] = uint8_t(std::min(127, std::max(0, (color[c] - p + 1) >> 1)));
+                    error += abs(((candidate[c] << 1) | p) - color[c]);
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pBit = uint8_t(p);
+                    memcpy(quantised, candidate, 4);
+                }
+            }
+        };
+
+        uint8_t low[4], high[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            const int inset = (maxColor[c] - minColor[c]) >> 4;
+            low[c] = uint8_t(minColor[c] + inset);
+            high[c] = uint8_t(maxColor[c] - inset);
+        }
+
+        uint8_t q[2][4];
+        uint8_t pBits[2] = { 0, 0 };
+        quantise(low, q[0], pBits[0]);
+        quantise(high, q[1], pBits[1]);
+
+        int endpoints[2][4];
+        for (int e = 0; e < 2; ++e)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                endpoints[e][c] = (q[e][c] << 1) | pBits[e];
+            }
+        }
+
+        uint8_t indices[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestError = 0x7fffffff;
+            for (int w = 0; w < 16; ++w)
+            {
+                int error = 0;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const int difference = bc7Interpolate(endpoints[0][c], endpoints[1][c], bc7Weights4[w]) - block[4 * i + c];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    indices[i] = uint8_t(w);
+                }
+            }
+        }
+
+        // the anchor index is stored with its top bit implied zero
+        if (indices[0] & 8)
+        {
+            std::swap(q[0], q[1]);
+            std::swap(pBits[0], pBits[1]);
+            for (uint8_t &index : indices)
+            {
+                index = uint8_t(15 - index);
+            }
+        }
+
+        memset(out, 0, 16);
+        BitWriter writer{out};
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write(q[0][c], 7);
+            writer.write(q[1][c], 7);
+        }
+        writer.write(pBits[0], 1);
+        writer.write(pBits[1], 1);
+        writer.write(indices[0], 3);
+        for (int i = 1; i < 16; ++i)
+        {
+            writer.write(indices[i], 4);
+        }
+    }
+
+    static void decodeColorBlock(const uint8_t in[8], bool alwaysFourColors, uint8_t pixels[64])
+    {
+        const uint16_t color0 = uint16_t(in[0] | (in[1] << 8));
+        const uint16_t color1 = uint16_t(in[2] | (in[3] << 8));
+        uint32_t indices;
+        memcpy(&indices, in + 4, 4);
+
+        uint8_t palette[4][4] = {};
+        from565(color0, palette[0]);
+        from565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+        if (alwaysFourColors || color0 > color1)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = uint8_t((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = uint8_t((palette[0][c] + 2 * palette[1][c]) / 3);
+            }
+            palette[3][3] = 255;
+        }
+        else
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = uint8_t((palette[0][c] + palette[1][c]) / 2);
+            }
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            memcpy(pixels + 4 * i, palette[(indices >> (2 * i)) & 3], 4);
+        }
+    }
+
+    static void decodeAlphaBlock(const uint8_t in[8], uint8_t pixels[64])
+    {
+        const int alpha0 = in[0];
+        const int alpha1 = in[1];
+        uint8_t palette[8];
+        palette[0] = uint8_t(alpha0);
+        palette[1] = uint8_t(alpha1);
+        if (alpha0 > alpha1)
+        {
+            for (int k = 1; k < 7; ++k)
+            {
+                palette[k + 1] = uint8_t(((7 - k) * alpha0 + k * alpha1) / 7);
+            }
+        }
+        else
+        {
+            for (int k = 1; k < 5; ++k)
+            {
+                palette[k + 1] = uint8_t(((5 - k) * alpha0 + k * alpha1) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; ++i)
+        {
+            bits |= uint64_t(in[2 + i]) << (8 * i);
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            pixels[4 * i + 3] = palette[(bits >> (3 * i)) & 7];
+        }
+    }
+
+    static void decodeBc7Block(const uint8_t in[16], uint8_t pixels[64])
+    {
+        int position = 0;
+        auto read = [&](int bits)
+        {
+            uint32_t value = 0;
+            for (int i = 0; i < bits; ++i, ++position)
+            {
+                value |= uint32_t((in[position >> 3] >> (position & 7)) & 1) << i;
+            }
+            return value;
+        };
+
+        if (read(7) != (1u << 6))
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                pixels[4 * i + 0] = 255;
+                pixels[4 * i + 1] = 0;
+                pixels[4 * i + 2] = 255;
+                pixels[4 * i + 3] = 255;
+            }
+            return;
+        }
+
+        int endpoints[2][4];
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = int(read(7));
+            endpoints[1][c] = int(read(7));
+        }
+        const int pBits[2] = { int(read(1)), int(read(1)) };
+        for (int e = 0; e < 2; ++e)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+            }
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            const int weight = bc7Weights4[read(0 == i ? 3 : 4)];
+            for (int c = 0; c < 4; ++c)
+            {
+                pixels[4 * i + c] = uint8_t(bc7Interpolate(endpoints[0][c], endpoints[1][c], weight));
+            }
+        }
+    }
+}
+
+using BlockEncoder = void (*)(const uint8_t block[64], uint8_t *out);
+
+static BlockEncoder selectEncoder(BcFormat format, SimdLevel simd)
+{
+    simd = std::min(simd, detectSimdLevel());
+    switch (format)
+    {
+    case BcFormat::BC1:
+#ifdef DITTY_X86
+        if (SimdLevel::AVX2 == simd)
+        {
+            return bc::encodeBc1BlockAvx2;
+        }
+        if (SimdLevel::SSE41 == simd)
+        {
+            return bc::encodeBc1BlockSse41;
+        }
+#endif
+        return bc::encodeBc1BlockScalar;
+    case BcFormat::BC3:
+#ifdef DITTY_X86
+        if (SimdLevel::AVX2 == simd)
+        {
+            return bc::encodeBc3BlockAvx2;
+        }
+        if (SimdLevel::SSE41 == simd)
+        {
+            return bc::encodeBc3BlockSse41;
+        }
+#endif
+        return bc::encodeBc3BlockScalar;
+    default:
+        return bc::encodeBc7BlockScalar;
+    }
+}
+
+const char *bcFormatName(BcFormat format)
+{
+    switch (format)
+    {
+    case BcFormat::BC1:
+        return "BC1";
+    case BcFormat::BC3:
+        return "BC3";
+    default:
+        return "BC7";
+    }
+}
+
+size_t bcBlockBytes(BcFormat format)
+{
+    return (BcFormat::BC1 == format) ? 8 : 16;
+}
+
+size_t bcImageBytes(BcFormat format, uint32_t width, uint32_t height)
+{
+    return size_t((width + 3) / 4) * size_t((height + 3) / 4) * bcBlockBytes(format);
+}
+
+static void loadBlock(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[64])
+{
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+            const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+            memcpy(block + 4 * (y * 4 + x), rgba + 4 * (size_t(sourceY) * width + sourceX), 4);
+        }
+    }
+}
+
+void encodeBc(BcFormat format, const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *blocks, SimdLevel simd, JobSystem *jobs)
+{
+    TRACE_FUNCTION();
+    const BlockEncoder encoder = selectEncoder(format, simd);
+    const size_t blockBytes = bcBlockBytes(format);
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+
+    auto encodeRows = [=](size_t firstRow, size_t lastRow)
+    {
+        TRACE_ZONE("encode rows");
+        uint8_t block[64];
+        for (uint32_t blockY = uint32_t(firstRow); blockY < lastRow; ++blockY)
+        {
+            uint8_t *out = blocks + size_t(blockY) * blocksX * blockBytes;
+            for (uint32_t blockX = 0; blockX < blocksX; ++blockX, out += blockBytes)
+            {
+                loadBlock(rgba, width, height, blockX, blockY, block);
+                encoder(block, out);
+            }
+        }
+    };
+
+    if (nullptr == jobs)
+    {
+        encodeRows(0, blocksY);
+        return;
+    }
+
+    // a row of blocks is already thousands of pixels, so each can be its own job
+    jobs->parallelFor(0, blocksY, 1, encodeRows);
+}
+
+void decodeBc(BcFormat format, const uint8_t *blocks, uint32_t width, uint32_t height, uint8_t *rgba)
+{
+    const size_t blockBytes = bcBlockBytes(format);
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+
+    uint8_t pixels[64];
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+        {
+            const uint8_t *in = blocks + (size_t(blockY) * blocksX + blockX) * blockBytes;
+            switch (format)
+            {
+            case BcFormat::BC1:
+                bc::decodeColorBlock(in, false, pixels);
+                break;
+            case BcFormat::BC3:
+                bc::decodeColorBlock(in + 8, true, pixels);
+                bc::decodeAlphaBlock(in, pixels);
+                break;
+            default:
+                bc::decodeBc7Block(in, pixels);
+                break;
+            }
+
+            for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y)
+            {
+                for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x)
+                {
+                    memcpy(rgba + 4 * (size_t(blockY * 4 + y) * width + blockX * 4 + x), pixels + 4 * (y * 4 + x), 4);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU block compression of RGBA8 images for runtime generated textures
+// BC1 and BC3 have scalar, SSE4.1 and AVX2 kernels that produce bit identical output, so the
+// scalar kernel doubles as the reference. BC7 uses a fast single-subset (mode 6) scalar encoder.
+enum class BcFormat
+{
+    BC1,
+    BC3,
+    BC7
+};
+
+const char *bcFormatName(BcFormat format);
+
+// bytes per 4x4 block
+size_t bcBlockBytes(BcFormat format);
+
+size_t bcImageBytes(BcFormat format, uint32_t width, uint32_t height);
+
+// Encodes width x height tightly packed RGBA8 pixels into row-major blocks
+// Partial blocks at the right and bottom edges repeat the last column/row. The requested SIMD
+// level is clamped to what the CPU supports. Block rows are spread over jobs when given a job
+// system, otherwise everything runs on the calling thread.
+void encodeBc(BcFormat format, const uint8_t *rgba, uint32_t width, uint32_t height, uint8_t *blocks, SimdLevel simd, JobSystem *jobs = nullptr);
+
+// Decodes blocks back to RGBA8, for measuring quality
+// Only BC7 mode 6 blocks are decoded; other BC7 modes come out magenta.
+void decodeBc(BcFormat format, const uint8_t *blocks, uint32_t width, uint32_t height, uint8_t *rgba);
@@ -0,0 +1,85 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+
+#include "bc_encoder_simd.h"
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace bc
+{
+    // eight pixels per register, so the whole block is two registers
+    static void encodeColorBlockAvx2(const __m256i pixels[2], uint8_t out[8])
+    {
+        const __m256i minPixels = _mm256_min_epu8(pixels[0], pixels[1]);
+        const __m256i maxPixels = _mm256_max_epu8(pixels[0], pixels[1]);
+        uint8_t minColor[4], maxColor[4];
+        reduceMinMax(_mm_min_epu8(_mm256_castsi256_si128(minPixels), _mm256_extracti128_si256(minPixels, 1)),
+                     _mm_max_epu8(_mm256_castsi256_si128(maxPixels), _mm256_extracti128_si256(maxPixels, 1)),
+                     minColor, maxColor);
+
+        const ColorEndpoints endpoints = colorEndpoints(minColor, maxColor);
+
+        const __m256i rgbMask = _mm256_set1_epi32(0x00ffffff);
+        const __m256i ones8 = _mm256_set1_epi8(1);
+        const __m256i ones16 = _mm256_set1_epi16(1);
+        __m256i palette[4];
+        for (int p = 0; p < 4; ++p)
+        {
+            uint32_t color;
+            memcpy(&color, endpoints.palette[p], 4);
+            palette[p] = _mm256_set1_epi32(int(color));
+        }
+
+        __m256i packed = _mm256_setzero_si256();
+        for (int r = 0; r < 2; ++r)
+        {
+            const __m256i rgb = _mm256_and_si256(pixels[r], rgbMask);
+            __m256i bestDistance = _mm256_set1_epi32(0x7fffffff);
+            __m256i bestIndex = _mm256_setzero_si256();
+            for (int p = 0; p < 4; ++p)
+            {
+                const __m256i difference = _mm256_or_si256(_mm256_subs_epu8(rgb, palette[p]), _mm256_subs_epu8(palette[p], rgb));
+                const __m256i distance = _mm256_madd_epi16(_mm256_maddubs_epi16(difference, ones8), ones16);
+                const __m256i closer = _mm256_cmpgt_epi32(bestDistance, distance);
+                bestDistance = _mm256_min_epi32(distance, bestDistance);
+                bestIndex = _mm256_blendv_epi8(bestIndex, _mm256_set1_epi32(p), closer);
+            }
+            const int base = 16 * r;
+            const __m256i shift = _mm256_setr_epi32(base, base + 2, base + 4, base + 6, base + 8, base + 10, base + 12, base + 14);
+            packed = _mm256_or_si256(packed, _mm256_sllv_epi32(bestIndex, shift));
+        }
+        __m128i folded = _mm_or_si128(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+        folded = _mm_or_si128(folded, _mm_shuffle_epi32(folded, _MM_SHUFFLE(1, 0, 3, 2)));
+        folded = _mm_or_si128(folded, _mm_shuffle_epi32(folded, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        writeColorBlock(endpoints.color0, endpoints.color1, uint32_t(_mm_cvtsi128_si32(folded)), out);
+    }
+
+    static void loadPixels(const uint8_t block[64], __m256i pixels[2])
+    {
+        pixels[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        pixels[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    }
+
+    void encodeBc1BlockAvx2(const uint8_t block[64], uint8_t out[8])
+    {
+        __m256i pixels[2];
+        loadPixels(block, pixels);
+        encodeColorBlockAvx2(pixels, out);
+    }
+
+    void encodeBc3BlockAvx2(const uint8_t block[64], uint8_t out[16])
+    {
+        __m256i pixels[2];
+        loadPixels(block, pixels);
+        const __m128i quarters[4] = {
+            _mm256_castsi256_si128(pixels[0]), _mm256_extracti128_si256(pixels[0], 1),
+            _mm256_castsi256_si128(pixels[1]), _mm256_extracti128_si256(pixels[1], 1)};
+        encodeAlphaBlockSimd(quarters, out);
+        encodeColorBlockAvx2(pixels, out + 8);
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+// shared between the scalar and SIMD kernels, which must agree bit for bit
+
+#include "cpu_features.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace bc
+{
+    inline uint16_t to565(const uint8_t color[3])
+    {
+        return uint16_t(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    inline void from565(uint16_t value, uint8_t color[3])
+    {
+        const uint8_t r = uint8_t((value >> 11) & 31);
+        const uint8_t g = uint8_t((value >> 5) & 63);
+        const uint8_t b = uint8_t(value & 31);
+        color[0] = uint8_t((r << 3) | (r >> 2));
+        color[1] = uint8_t((g << 2) | (g >> 4));
+        color[2] = uint8_t((b << 3) | (b >> 2));
+    }
+
+    // bounding box endpoints inset by 1/16 of the range, and the 4 colour palette they produce
+    // palette entries are RGBA with alpha zeroed so they can be compared against masked pixels
+    struct ColorEndpoints
+    {
+        uint16_t color0;
+        uint16_t color1;
+        uint8_t palette[4][4];
+    };
+
+    inline ColorEndpoints colorEndpoints(const uint8_t minColor[3], const uint8_t maxColor[3])
+    {
+        uint8_t low[3], high[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            const int inset = (maxColor[c] - minColor[c]) >> 4;
+            low[c] = uint8_t(minColor[c] + inset);
+            high[c] = uint8_t(maxColor[c] - inset);
+        }
+
+        ColorEndpoints endpoints = {};
+        // high >= low in every channel, so color0 >= color1 and the block decodes in 4 colour mode
+        // (or 3 colour mode with every index 0 when they are equal)
+        endpoints.color0 = to565(high);
+        endpoints.color1 = to565(low);
+        from565(endpoints.color0, endpoints.palette[0]);
+        from565(endpoints.color1, endpoints.palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            endpoints.palette[2][c] = uint8_t((2 * endpoints.palette[0][c] + endpoints.palette[1][c]) / 3);
+            endpoints.palette[3][c] = uint8_t((endpoints.palette[0][c] + 2 * endpoints.palette[1][c]) / 3);
+        }
+        return endpoints;
+    }
+
+    inline void writeColorBlock(uint16_t color0, uint16_t color1, uint32_t indices, uint8_t out[8])
+    {
+        out[0] = uint8_t(color0);
+        out[1] = uint8_t(color0 >> 8);
+        out[2] = uint8_t(color1);
+        out[3] = uint8_t(color1 >> 8);
+        memcpy(out + 4, &indices, 4);
+    }
+
+    // alpha0 = max, alpha1 = min; a pixel's palette position k (0 = alpha0 .. 7 = alpha1) is the
+    // number of thresholds it lies below, with exact ties going to the higher alpha
+    struct AlphaEndpoints
+    {
+        uint8_t alpha0;
+        uint8_t alpha1;
+        uint8_t thresholds[7];
+    };
+
+    inline AlphaEndpoints alphaEndpoints(uint8_t minAlpha, uint8_t maxAlpha)
+    {
+        AlphaEndpoints endpoints;
+        endpoints.alpha0 = maxAlpha;
+        endpoints.alpha1 = minAlpha;
+        int previous = maxAlpha;
+        for (int k = 1; k < 8; ++k)
+        {
+            const int value = ((7 - k) * maxAlpha + k * minAlpha) / 7;
+            endpoints.thresholds[k - 1] = uint8_t((previous + value + 1) >> 1);
+            previous = value;
+        }
+        return endpoints;
+    }
+
+    // palette position to BC3 alpha index (alpha0, alpha1, then the six interpolated values)
+    static const uint8_t alphaIndexForPosition[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+    inline void writeAlphaBlock(uint8_t alpha0, uint8_t alpha1, const uint8_t indices[16], uint8_t out[8])
+    {
+        out[0] = alpha0;
+        out[1] = alpha1;
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            bits |= uint64_t(indices[i]) << (3 * i);
+        }
+        for (int i = 0; i < 6; ++i)
+        {
+            out[2 + i] = uint8_t(bits >> (8 * i));
+        }
+    }
+
+    // block is 16 RGBA8 pixels, row-major
+    void encodeBc1BlockScalar(const uint8_t block[64], uint8_t out[8]);
+    void encodeBc3BlockScalar(const uint8_t block[64], uint8_t out[16]);
+    void encodeBc7BlockScalar(const uint8_t block[64], uint8_t out[16]);
+#ifdef DITTY_X86
+    void encodeBc1BlockSse41(const uint8_t block[64], uint8_t out[8]);
+    void encodeBc3BlockSse41(const uint8_t block[64], uint8_t out[16]);
+    void encodeBc1BlockAvx2(const uint8_t block[64], uint8_t out[8]);
+    void encodeBc3BlockAvx2(const uint8_t block[64], uint8_t out[16]);
+#endif
+}
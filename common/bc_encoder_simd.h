@@ -0,0 +1,73 @@
+#pragma once
+
+// SSE helpers shared by the SSE4.1 and AVX2 kernels
+// Everything here is static inline so each translation unit gets a copy built with its own flags.
+
+#include "bc_encoder_internal.h"
+
+#include <smmintrin.h>
+
+namespace bc
+{
+    static inline __m128i absDifferenceU8(__m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    }
+
+    // reduces four RGBA pixels per register to the per-channel minimum and maximum
+    static inline void reduceMinMax(__m128i minPixels, __m128i maxPixels, uint8_t minColor[4], uint8_t maxColor[4])
+    {
+        minPixels = _mm_min_epu8(minPixels, _mm_shuffle_epi32(minPixels, _MM_SHUFFLE(1, 0, 3, 2)));
+        minPixels = _mm_min_epu8(minPixels, _mm_shuffle_epi32(minPixels, _MM_SHUFFLE(2, 3, 0, 1)));
+        maxPixels = _mm_max_epu8(maxPixels, _mm_shuffle_epi32(maxPixels, _MM_SHUFFLE(1, 0, 3, 2)));
+        maxPixels = _mm_max_epu8(maxPixels, _mm_shuffle_epi32(maxPixels, _MM_SHUFFLE(2, 3, 0, 1)));
+        const uint32_t minValue = uint32_t(_mm_cvtsi128_si32(minPixels));
+        const uint32_t maxValue = uint32_t(_mm_cvtsi128_si32(maxPixels));
+        memcpy(minColor, &minValue, 4);
+        memcpy(maxColor, &maxValue, 4);
+    }
+
+    static inline __m128i reduceMin(__m128i values)
+    {
+        values = _mm_min_epu8(values, _mm_srli_si128(values, 8));
+        values = _mm_min_epu8(values, _mm_srli_si128(values, 4));
+        values = _mm_min_epu8(values, _mm_srli_si128(values, 2));
+        return _mm_min_epu8(values, _mm_srli_si128(values, 1));
+    }
+
+    static inline __m128i reduceMax(__m128i values)
+    {
+        values = _mm_max_epu8(values, _mm_srli_si128(values, 8));
+        values = _mm_max_epu8(values, _mm_srli_si128(values, 4));
+        values = _mm_max_epu8(values, _mm_srli_si128(values, 2));
+        return _mm_max_epu8(values, _mm_srli_si128(values, 1));
+    }
+
+    // the BC3 alpha half; all 16 alphas fit one register so both kernels use it as is
+    static inline void encodeAlphaBlockSimd(const __m128i pixels[4], uint8_t out[8])
+    {
+        const __m128i gatherAlpha = _mm_setr_epi8(3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i alpha = _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(pixels[0], gatherAlpha), _mm_slli_si128(_mm_shuffle_epi8(pixels[1], gatherAlpha), 4)),
+            _mm_or_si128(_mm_slli_si128(_mm_shuffle_epi8(pixels[2], gatherAlpha), 8), _mm_slli_si128(_mm_shuffle_epi8(pixels[3], gatherAlpha), 12)));
+
+        const uint8_t minAlpha = uint8_t(_mm_cvtsi128_si32(reduceMin(alpha)));
+        const uint8_t maxAlpha = uint8_t(_mm_cvtsi128_si32(reduceMax(alpha)));
+        const AlphaEndpoints endpoints = alphaEndpoints(minAlpha, maxAlpha);
+
+        // subtracting the all-ones compare masks counts the thresholds each alpha lies below
+        __m128i position = _mm_setzero_si128();
+        for (int k = 0; k < 7; ++k)
+        {
+            const __m128i threshold = _mm_set1_epi8(char(endpoints.thresholds[k]));
+            const __m128i notAbove = _mm_cmpeq_epi8(_mm_max_epu8(alpha, threshold), threshold);
+            const __m128i below = _mm_andnot_si128(_mm_cmpeq_epi8(alpha, threshold), notAbove);
+            position = _mm_sub_epi8(position, below);
+        }
+
+        const __m128i indexLut = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(alphaIndexForPosition));
+        alignas(16) uint8_t indices[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(indices), _mm_shuffle_epi8(indexLut, position));
+        writeAlphaBlock(endpoints.alpha0, endpoints.alpha1, indices, out);
+    }
+}
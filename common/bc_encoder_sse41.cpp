@@ -0,0 +1,79 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+
+#include "bc_encoder_simd.h"
+
+#include <cstring>
+
+namespace bc
+{
+    static void encodeColorBlockSse41(const __m128i pixels[4], uint8_t out[8])
+    {
+        const __m128i minPixels = _mm_min_epu8(_mm_min_epu8(pixels[0], pixels[1]), _mm_min_epu8(pixels[2], pixels[3]));
+        const __m128i maxPixels = _mm_max_epu8(_mm_max_epu8(pixels[0], pixels[1]), _mm_max_epu8(pixels[2], pixels[3]));
+        uint8_t minColor[4], maxColor[4];
+        reduceMinMax(minPixels, maxPixels, minColor, maxColor);
+
+        const ColorEndpoints endpoints = colorEndpoints(minColor, maxColor);
+
+        const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+        const __m128i ones8 = _mm_set1_epi8(1);
+        const __m128i ones16 = _mm_set1_epi16(1);
+        __m128i palette[4];
+        for (int p = 0; p < 4; ++p)
+        {
+            uint32_t color;
+            memcpy(&color, endpoints.palette[p], 4);
+            palette[p] = _mm_set1_epi32(int(color));
+        }
+
+        // pixel i lands at bit 2i, so register r lane j is scaled by 4^(4r + j)
+        __m128i packed = _mm_setzero_si128();
+        for (int r = 0; r < 4; ++r)
+        {
+            const __m128i rgb = _mm_and_si128(pixels[r], rgbMask);
+            __m128i bestDistance = _mm_set1_epi32(0x7fffffff);
+            __m128i bestIndex = _mm_setzero_si128();
+            for (int p = 0; p < 4; ++p)
+            {
+                // |difference| summed over the bytes of each pixel: u8 pairs to i16, then i16 pairs to i32
+                const __m128i distance = _mm_madd_epi16(_mm_maddubs_epi16(absDifferenceU8(rgb, palette[p]), ones8), ones16);
+                const __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+                bestDistance = _mm_min_epi32(distance, bestDistance);
+                bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi32(p), closer);
+            }
+            const __m128i scale = _mm_setr_epi32(1 << (8 * r), 1 << (8 * r + 2), 1 << (8 * r + 4), 1 << (8 * r + 6));
+            packed = _mm_or_si128(packed, _mm_mullo_epi32(bestIndex, scale));
+        }
+        packed = _mm_or_si128(packed, _mm_shuffle_epi32(packed, _MM_SHUFFLE(1, 0, 3, 2)));
+        packed = _mm_or_si128(packed, _mm_shuffle_epi32(packed, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        writeColorBlock(endpoints.color0, endpoints.color1, uint32_t(_mm_cvtsi128_si32(packed)), out);
+    }
+
+    static void loadPixels(const uint8_t block[64], __m128i pixels[4])
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            pixels[r] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * r));
+        }
+    }
+
+    void encodeBc1BlockSse41(const uint8_t block[64], uint8_t out[8])
+    {
+        __m128i pixels[4];
+        loadPixels(block, pixels);
+        encodeColorBlockSse41(pixels, out);
+    }
+
+    void encodeBc3BlockSse41(const uint8_t block[64], uint8_t out[16])
+    {
+        __m128i pixels[4];
+        loadPixels(block, pixels);
+        encodeAlphaBlockSimd(pixels, out);
+        encodeColorBlockSse41(pixels, out + 8);
+    }
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef DITTY_X86
+static void cpuid(int leaf, int subleaf, unsigned registers[4])
+{
+#ifdef _MSC_VER
+    int values[4];
+    __cpuidex(values, leaf, subleaf);
+    for (int i = 0; i < 4; ++i)
+    {
+        registers[i] = unsigned(values[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// XCR0, to see whether the OS saves the YMM registers
+static unsigned long long readXcr0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+SimdLevel detectSimdLevel()
+{
+#ifdef DITTY_X86
+    static const SimdLevel level = []()
+    {
+        unsigned registers[4];
+        cpuid(0, 0, registers);
+        const unsigned maxLeaf = registers[0];
+
+        cpuid(1, 0, registers);
+        const bool sse41 = registers[2] & (1u << 19);
+        const bool osxsave = registers[2] & (1u << 27);
+        const bool avx = registers[2] & (1u << 28);
+        if (!sse41)
+        {
+            return SimdLevel::Scalar;
+        }
+        if (!osxsave || !avx || maxLeaf < 7 || (readXcr0() & 0x6) != 0x6)
+        {
+            return SimdLevel::SSE41;
+        }
+
+        cpuid(7, 0, registers);
+        const bool avx2 = registers[1] & (1u << 5);
+        return avx2 ? SimdLevel::AVX2 : SimdLevel::SSE41;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE41:
+        return "SSE4.1";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DITTY_X86 1
+#endif
+
+// Instruction set levels the SIMD kernels in this library are written for
+enum class SimdLevel
+{
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+// highest level supported by both the processor and the operating system
+SimdLevel detectSimdLevel();
+
+const char *simdLevelName(SimdLevel level);
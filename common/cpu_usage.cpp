@@ -0,0 +1,56 @@
+#include "cpu_usage.h"
+
+#include <ostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+double processCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0.0;
+    }
+    auto toSeconds = [](const FILETIME &time)
+    {
+        ULARGE_INTEGER value;
+        value.LowPart = time.dwLowDateTime;
+        value.HighPart = time.dwHighDateTime;
+        return double(value.QuadPart) * 100e-9; // 100ns units
+    };
+    return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0.0;
+    }
+    auto toSeconds = [](const struct timeval &time)
+    {
+        return double(time.tv_sec) + double(time.tv_usec) * 1e-6;
+    };
+    return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+#endif
+}
+
+CpuUsage::CpuUsage()
+    : startWall(std::chrono::steady_clock::now())
+    , startCpuSeconds(processCpuSeconds())
+{
+}
+
+void CpuUsage::report(std::ostream &stream, const char *label) const
+{
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startWall).count();
+    const double cpuSeconds = processCpuSeconds() - startCpuSeconds;
+    const double percent = (wallSeconds > 0.0) ? (100.0 * cpuSeconds / wallSeconds) : 0.0;
+
+    stream << label << ": " << frames << " frames in " << wallSeconds << "s wall, "
+           << cpuSeconds << "s CPU (" << percent << "% of one core)" << std::endl;
+}
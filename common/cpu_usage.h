@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+// Measures how much processor time the process consumes relative to wall clock time,
+// so that idle behaviour of the ditties can be compared between render modes
+class CpuUsage
+{
+public:
+    CpuUsage();
+
+    void frameRendered() { ++frames; }
+
+    void report(std::ostream &stream, const char *label) const;
+
+private:
+    std::chrono::steady_clock::time_point startWall;
+    double startCpuSeconds;
+    uint64_t frames = 0;
+};
+
+// user + system time consumed by this process so far
+double processCpuSeconds();
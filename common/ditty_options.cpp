@@ -0,0 +1,50 @@
+#include "ditty_options.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+bool parseDittyOption(int argc, char *argv[], int &i, DittyOptions &options)
+{
+    if (0 == strcmp(argv[i], "--on-demand"))
+    {
+        options.onDemand = true;
+    }
+    else if (0 == strcmp(argv[i], "--render-thread"))
+    {
+        options.renderThread = true;
+    }
+    else if (0 == strcmp(argv[i], "--present-stall-ms") && i + 1 < argc)
+    {
+        options.presentStallMs = atoi(argv[++i]);
+    }
+    else if (0 == strcmp(argv[i], "--procedural-texture") && i + 1 < argc)
+    {
+        options.proceduralTexture = argv[++i];
+    }
+    else if (0 == strcmp(argv[i], "--procedural-size") && i + 1 < argc)
+    {
+        options.proceduralTextureSize = uint32_t(atoi(argv[++i]));
+    }
+    else if (0 == strcmp(argv[i], "--trace") && i + 1 < argc)
+    {
+        options.tracePath = argv[++i];
+    }
+    else if (0 == strcmp(argv[i], "--capture") && i + 1 < argc)
+    {
+        options.capturePath = argv[++i];
+    }
+    else if (0 == strcmp(argv[i], "--windows") && i + 1 < argc)
+    {
+        options.windowCount = uint32_t(std::max(1, atoi(argv[++i])));
+    }
+    else if (0 == strcmp(argv[i], "--hud"))
+    {
+        options.hud = true;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
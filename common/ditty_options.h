@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Command line options both ditties accept; each ditty's own Options extends this
+struct DittyOptions
+{
+    bool onDemand = false;
+    bool renderThread = false;
+    int presentStallMs = 0;
+    const char *proceduralTexture = nullptr;
+    uint32_t proceduralTextureSize = 2048;
+    const char *tracePath = nullptr;
+    const char *capturePath = nullptr;
+    uint32_t windowCount = 1;
+    bool hud = false;
+};
+
+// Parses argv[i], and its value if it takes one, advancing i past them; returns false, leaving
+// i alone, if it isn't one of the shared options so the ditty can try its own
+bool parseDittyOption(int argc, char *argv[], int &i, DittyOptions &options);
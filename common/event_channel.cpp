@@ -0,0 +1,53 @@
+#include "event_channel.h"
+
+bool EventChannel::push(const WindowEvent &event)
+{
+    if (!queue.tryPush(event))
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    wake();
+    return true;
+}
+
+void EventChannel::close()
+{
+    closed.store(true, std::memory_order_release);
+    wake();
+}
+
+void EventChannel::wake()
+{
+    // pairs with the fence in wait(): either the consumer sees the new event or
+    // closed flag before sleeping, or we see that it is waiting and notify it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_one();
+    }
+}
+
+void EventChannel::wait(double timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto ready = [this]()
+    {
+        return !queue.empty() || isClosed();
+    };
+
+    if (timeout < 0.0)
+    {
+        condition.wait(lock, ready);
+    }
+    else
+    {
+        condition.wait_for(lock, std::chrono::duration<double>(timeout), ready);
+    }
+
+    waiting.store(false, std::memory_order_relaxed);
+}
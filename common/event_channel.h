@@ -0,0 +1,64 @@
+#pragma once
+
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Window input captured by the GLFW callbacks on the event thread
+struct WindowEvent
+{
+    enum class Type
+    {
+        Key,
+        MouseButton,
+        CursorPos,
+        Scroll,
+        FramebufferSize,
+        Refresh
+    };
+
+    Type type;
+    std::chrono::steady_clock::time_point timestamp;
+    int code = 0;   // key or mouse button
+    int action = 0;
+    int mods = 0;
+    double x = 0.0; // cursor position, scroll offset or framebuffer size
+    double y = 0.0;
+};
+
+// Carries WindowEvents from the thread pumping GLFW to the thread that renders
+// Events travel through a lock-free queue; the mutex and condition variable are only
+// used to park the consumer while it has nothing to do, and the producer only touches
+// them when the consumer is actually parked.
+class EventChannel
+{
+public:
+    // producer side; returns false, and counts the event as dropped, if the queue is full
+    bool push(const WindowEvent &event);
+
+    // producer side; wakes the consumer and makes isClosed() true
+    void close();
+
+    // consumer side
+    bool tryPop(WindowEvent &event) { return queue.tryPop(event); }
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    // consumer side; block until an event arrives, the channel is closed or the timeout
+    // (in seconds, negative meaning forever) expires
+    void wait(double timeout);
+
+    size_t droppedEvents() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void wake();
+
+    SpscQueue<WindowEvent, 1024> queue;
+    std::atomic<bool> closed{false};
+    std::atomic<bool> waiting{false};
+    std::atomic<size_t> dropped{0};
+    std::mutex mutex;
+    std::condition_variable condition;
+};
@@ -0,0 +1,51 @@
+#include "frame_scheduler.h"
+
+FrameScheduler::FrameScheduler(bool onDemand, double animationInterval)
+    : onDemand(onDemand)
+    , animationInterval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(animationInterval)))
+    , lastFrame(Clock::now())
+{
+}
+
+void FrameScheduler::setAnimating(bool enable)
+{
+    if (enable && !animating)
+    {
+        // first animated frame is due immediately
+        dirty = true;
+    }
+    animating = enable;
+}
+
+bool FrameScheduler::shouldRender() const
+{
+    if (!onDemand || dirty)
+    {
+        return true;
+    }
+    return animating && (Clock::now() - lastFrame) >= animationInterval;
+}
+
+void FrameScheduler::frameRendered()
+{
+    dirty = false;
+    lastFrame = Clock::now();
+}
+
+double FrameScheduler::waitTimeout() const
+{
+    if (!onDemand || dirty)
+    {
+        return 0.0;
+    }
+    if (!animating)
+    {
+        return -1.0;
+    }
+    auto remaining = (lastFrame + animationInterval) - Clock::now();
+    if (remaining <= Clock::duration::zero())
+    {
+        return 0.0;
+    }
+    return std::chrono::duration<double>(remaining).count();
+}
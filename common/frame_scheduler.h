@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+
+// Decides when a ditty needs to draw a frame
+// In continuous mode every iteration of the main loop renders, and events are polled.
+// In on-demand mode a frame is only rendered when something invalidated the window
+// (input, resize, expose) or an animation is running, and the main loop sleeps in
+// glfwWaitEventsTimeout for waitTimeout() seconds in between.
+class FrameScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameScheduler(bool onDemand, double animationInterval = 1.0 / 60.0);
+
+    bool isOnDemand() const { return onDemand; }
+
+    // mark the window contents as stale, e.g. from a GLFW callback
+    void invalidate() { dirty = true; }
+
+    // while animating, a frame is due every animationInterval seconds
+    void setAnimating(bool enable);
+
+    bool shouldRender() const;
+    void frameRendered();
+
+    // seconds the event loop may block before the next frame is due,
+    // or a negative value to wait indefinitely for an event
+    double waitTimeout() const;
+
+private:
+    bool onDemand;
+    bool dirty = true;
+    bool animating = false;
+    Clock::duration animationInterval;
+    Clock::time_point lastFrame;
+};
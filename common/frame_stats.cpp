@@ -0,0 +1,83 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+// the lower edge of bucket 1; bucket 0 holds everything below it
+static constexpr double smallestBucketMilliseconds = 0.001;
+
+void DurationStats::add(std::chrono::steady_clock::duration sample)
+{
+    const double milliseconds = std::chrono::duration<double, std::milli>(sample).count();
+    uint32_t bucket = 0;
+    if (milliseconds >= smallestBucketMilliseconds)
+    {
+        const double position = std::log2(milliseconds / smallestBucketMilliseconds) * BucketsPerDoubling;
+        bucket = uint32_t(std::min(double(BucketCount - 1), position + 1.0));
+    }
+    ++buckets[bucket];
+
+    minMilliseconds = 0 == count ? milliseconds : std::min(minMilliseconds, milliseconds);
+    maxMilliseconds = 0 == count ? milliseconds : std::max(maxMilliseconds, milliseconds);
+    totalMilliseconds += milliseconds;
+    ++count;
+}
+
+void DurationStats::report(std::ostream &stream, const char *label) const
+{
+    if (0 == count)
+    {
+        stream << label << ": no samples" << std::endl;
+        return;
+    }
+
+    // the geometric middle of the bucket holding the p-th sample, kept within the exact extremes
+    auto percentile = [this](double p)
+    {
+        const uint64_t rank = std::min(count - 1, uint64_t(p * double(count)));
+        uint64_t seen = 0;
+        uint32_t bucket = 0;
+        while (seen + buckets[bucket] <= rank)
+        {
+            seen += buckets[bucket++];
+        }
+        const double middle = 0 == bucket ? smallestBucketMilliseconds : smallestBucketMilliseconds * std::exp2((double(bucket) - 0.5) / BucketsPerDoubling);
+        return std::min(maxMilliseconds, std::max(minMilliseconds, middle));
+    };
+
+    stream << label << ": " << count << " samples, mean " << totalMilliseconds / double(count) << "ms, p50 " << percentile(0.5)
+           << "ms, p99 " << percentile(0.99) << "ms, max " << maxMilliseconds << "ms" << std::endl;
+}
+
+void FrameStats::eventReceived(Clock::time_point timestamp)
+{
+    if (!hasPendingEvent || timestamp < oldestPendingEvent)
+    {
+        oldestPendingEvent = timestamp;
+        hasPendingEvent = true;
+    }
+}
+
+void FrameStats::framePresented()
+{
+    const auto now = Clock::now();
+    if (hasPresented)
+    {
+        frameTime.add(now - lastPresent);
+    }
+    lastPresent = now;
+    hasPresented = true;
+
+    if (hasPendingEvent)
+    {
+        inputLatency.add(now - oldestPendingEvent);
+        hasPendingEvent = false;
+    }
+}
+
+void FrameStats::report(std::ostream &stream) const
+{
+    frameTime.report(stream, "Frame time");
+    inputLatency.report(stream, "Input latency");
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+// Collects durations and summarises them as mean and percentiles
+// Samples are counted into fixed logarithmic buckets, 16 per doubling from 1us to over 100s, so
+// adding one never allocates however long the run; percentiles are within 5% of the exact
+// value, while the count, mean and max are exact.
+class DurationStats
+{
+public:
+    void add(std::chrono::steady_clock::duration sample);
+
+    void report(std::ostream &stream, const char *label) const;
+
+private:
+    static constexpr uint32_t BucketsPerDoubling = 16;
+    static constexpr uint32_t BucketCount = 27 * BucketsPerDoubling + 1;
+
+    std::array<uint32_t, BucketCount> buckets = {};
+    uint64_t count = 0;
+    double totalMilliseconds = 0.0;
+    double minMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+};
+
+// Frame-to-frame times, and the latency from an input event arriving at the event
+// thread to the end of presenting the first frame that consumed it
+class FrameStats
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void eventReceived(Clock::time_point timestamp);
+    void framePresented();
+
+    void report(std::ostream &stream) const;
+
+private:
+    DurationStats frameTime;
+    DurationStats inputLatency;
+    Clock::time_point lastPresent;
+    Clock::time_point oldestPendingEvent;
+    bool hasPresented = false;
+    bool hasPendingEvent = false;
+};
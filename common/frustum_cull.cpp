@@ -0,0 +1,88 @@
+#include "frustum_cull.h"
+#include "frustum_cull_internal.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+
+namespace cull
+{
+    size_t cullSpheresScalar(const float planes[6][4], const SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible)
+    {
+        size_t visibleCount = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const float negativeRadius = -spheres.radius[i];
+            bool inside = true;
+            for (int p = 0; p < 6; ++p)
+            {
+                const float distance = planes[p][0] * spheres.x[i] + planes[p][1] * spheres.y[i] + planes[p][2] * spheres.z[i] + planes[p][3];
+                inside = inside && distance > negativeRadius;
+            }
+            visible[i] = inside ? 1 : 0;
+            visibleCount += inside ? 1 : 0;
+        }
+        return visibleCount;
+    }
+}
+
+using CullKernel = size_t (*)(const float planes[6][4], const cull::SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible);
+
+static CullKernel selectKernel(SimdLevel simd)
+{
+    simd = std::min(simd, detectSimdLevel());
+#ifdef DITTY_X86
+    if (SimdLevel::AVX2 == simd)
+    {
+        return cull::cullSpheresAvx2;
+    }
+    if (SimdLevel::SSE41 == simd)
+    {
+        return cull::cullSpheresSse41;
+    }
+#endif
+    return cull::cullSpheresScalar;
+}
+
+void resizeSphereBounds(SphereBounds &bounds, size_t count)
+{
+    // padding has an infinitely negative radius, which fails every plane
+    const size_t padded = (count + frustumCullChunk - 1) / frustumCullChunk * frustumCullChunk;
+    bounds.count = count;
+    bounds.x.assign(padded, 0.0f);
+    bounds.y.assign(padded, 0.0f);
+    bounds.z.assign(padded, 0.0f);
+    bounds.radius.assign(padded, -FLT_MAX);
+}
+
+void setSphereBounds(SphereBounds &bounds, size_t index, const float sphere[4])
+{
+    bounds.x[index] = sphere[0];
+    bounds.y[index] = sphere[1];
+    bounds.z[index] = sphere[2];
+    bounds.radius[index] = sphere[3];
+}
+
+size_t cullSpheres(const SphereBounds &bounds, const float planes[6][4], uint8_t *visible, SimdLevel simd, JobSystem *jobs)
+{
+    TRACE_FUNCTION();
+    const CullKernel kernel = selectKernel(simd);
+    const cull::SphereArrays spheres = { bounds.x.data(), bounds.y.data(), bounds.z.data(), bounds.radius.data() };
+    const size_t chunkCount = bounds.x.size() / frustumCullChunk;
+
+    if (nullptr == jobs)
+    {
+        return kernel(planes, spheres, 0, bounds.x.size(), visible);
+    }
+
+    // a job's worth is a thousand or so spheres, a couple of microseconds with SIMD
+    const size_t chunksPerJob = 16;
+    std::atomic<size_t> visibleCount{0};
+    jobs->parallelFor(0, chunkCount, chunksPerJob, [&](size_t firstChunk, size_t lastChunk)
+    {
+        TRACE_ZONE("cull chunks");
+        visibleCount.fetch_add(kernel(planes, spheres, firstChunk * frustumCullChunk, lastChunk * frustumCullChunk, visible), std::memory_order_relaxed);
+    });
+    return visibleCount.load(std::memory_order_relaxed);
+}
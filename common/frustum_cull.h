@@ -0,0 +1,33 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "job_system.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounding spheres held as structure-of-arrays, so the SIMD kernels test 4 or 8 at once
+// The arrays are padded to whole chunks with spheres that are never visible.
+struct SphereBounds
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+    size_t count = 0;
+};
+
+// spheres per unit of work; a chunk's visibility flags fill one cache line, so threads never write to the same one
+constexpr size_t frustumCullChunk = 64;
+
+void resizeSphereBounds(SphereBounds &bounds, size_t count);
+
+void setSphereBounds(SphereBounds &bounds, size_t index, const float sphere[4]);
+
+// Sets visible[i] to 1 for each sphere that intersects the frustum and 0 otherwise, returning how many did
+// planes are as produced by frustumPlanes. visible must have room for the padded bounds.x.size()
+// entries. The scalar, SSE4.1 and AVX2 kernels give identical results; the requested SIMD level is
+// clamped to what the CPU supports. Chunks are spread over jobs when given a job system, otherwise
+// everything runs on the calling thread.
+size_t cullSpheres(const SphereBounds &bounds, const float planes[6][4], uint8_t *visible, SimdLevel simd, JobSystem *jobs = nullptr);
@@ -0,0 +1,57 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+
+#include "frustum_cull_internal.h"
+
+#include <immintrin.h>
+
+namespace cull
+{
+    size_t cullSpheresAvx2(const float planes[6][4], const SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible)
+    {
+        __m256 plane[6][4];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                plane[p][c] = _mm256_set1_ps(planes[p][c]);
+            }
+        }
+
+        const __m128i one = _mm_set1_epi8(1);
+        size_t visibleCount = 0;
+        for (size_t i = begin; i < end; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(spheres.x + i);
+            const __m256 y = _mm256_loadu_ps(spheres.y + i);
+            const __m256 z = _mm256_loadu_ps(spheres.z + i);
+            const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius + i));
+
+            // separate multiplies and adds rather than FMA, to match the other kernels exactly
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(plane[p][0], x), _mm256_mul_ps(plane[p][1], y));
+                distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(plane[p][2], z)), plane[p][3]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+            }
+
+            // lane masks narrowed to one 0 or 1 byte per sphere
+            const __m256i lanes = _mm256_castps_si256(inside);
+            const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+            const __m128i bytes = _mm_and_si128(_mm_packs_epi16(words, words), one);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(visible + i), bytes);
+
+            unsigned mask = unsigned(_mm256_movemask_ps(inside));
+            while (0 != mask)
+            {
+                mask &= mask - 1;
+                ++visibleCount;
+            }
+        }
+        return visibleCount;
+    }
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+// kernels behind cullSpheres, which must agree exactly: each tests chunk aligned ranges of
+// spheres with the same operation order, so there is no tail to handle
+
+#include "cpu_features.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cull
+{
+    struct SphereArrays
+    {
+        const float *x;
+        const float *y;
+        const float *z;
+        const float *radius;
+    };
+
+    size_t cullSpheresScalar(const float planes[6][4], const SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible);
+
+#ifdef DITTY_X86
+    size_t cullSpheresSse41(const float planes[6][4], const SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible);
+    size_t cullSpheresAvx2(const float planes[6][4], const SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible);
+#endif
+}
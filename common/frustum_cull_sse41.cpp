@@ -0,0 +1,57 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+
+#include "frustum_cull_internal.h"
+
+#include <cstring>
+#include <smmintrin.h>
+
+namespace cull
+{
+    size_t cullSpheresSse41(const float planes[6][4], const SphereArrays &spheres, size_t begin, size_t end, uint8_t *visible)
+    {
+        __m128 plane[6][4];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                plane[p][c] = _mm_set1_ps(planes[p][c]);
+            }
+        }
+
+        const __m128i one = _mm_set1_epi8(1);
+        size_t visibleCount = 0;
+        for (size_t i = begin; i < end; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(spheres.x + i);
+            const __m128 y = _mm_loadu_ps(spheres.y + i);
+            const __m128 z = _mm_loadu_ps(spheres.z + i);
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(plane[p][0], x), _mm_mul_ps(plane[p][1], y));
+                distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(plane[p][2], z)), plane[p][3]);
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+            }
+
+            // lane masks narrowed to one 0 or 1 byte per sphere
+            const __m128i words = _mm_packs_epi32(_mm_castps_si128(inside), _mm_castps_si128(inside));
+            const __m128i bytes = _mm_and_si128(_mm_packs_epi16(words, words), one);
+            const int flags = _mm_cvtsi128_si32(bytes);
+            memcpy(visible + i, &flags, 4);
+
+            unsigned mask = unsigned(_mm_movemask_ps(inside));
+            while (0 != mask)
+            {
+                mask &= mask - 1;
+                ++visibleCount;
+            }
+        }
+        return visibleCount;
+    }
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "image_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+std::vector<uint8_t> generateLightmap(uint32_t width, uint32_t height, uint32_t seed)
+{
+    struct Light
+    {
+        float x, y, radius;
+        float color[3];
+    };
+
+    std::mt19937 engine(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Light> lights(8);
+    for (Light &light : lights)
+    {
+        light.x = unit(engine);
+        light.y = unit(engine);
+        light.radius = 0.05f + 0.25f * unit(engine);
+        for (float &channel : light.color)
+        {
+            channel = 0.25f + 0.75f * unit(engine);
+        }
+    }
+
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float u = (x + 0.5f) / width;
+            const float v = (y + 0.5f) / height;
+            float color[3] = { 0.1f + 0.1f * u, 0.1f + 0.1f * v, 0.15f };
+            for (const Light &light : lights)
+            {
+                const float dx = u - light.x;
+                const float dy = v - light.y;
+                const float falloff = std::exp(-(dx * dx + dy * dy) / (light.radius * light.radius));
+                for (int c = 0; c < 3; ++c)
+                {
+                    color[c] += light.color[c] * falloff;
+                }
+            }
+
+            uint8_t *pixel = &rgba[(size_t(y) * width + x) * 4];
+            for (int c = 0; c < 3; ++c)
+            {
+                pixel[c] = uint8_t(std::min(255.0f, 255.0f * color[c]));
+            }
+            pixel[3] = uint8_t(127.5f + 127.5f * std::sin(6.2831853f * (u + 0.5f * v)));
+        }
+    }
+    return rgba;
+}
+
+std::vector<uint8_t> downsampleRgba(const std::vector<uint8_t> &rgba, uint32_t width, uint32_t height)
+{
+    const uint32_t outWidth = std::max(1u, width / 2);
+    const uint32_t outHeight = std::max(1u, height / 2);
+    std::vector<uint8_t> out(size_t(outWidth) * outHeight * 4);
+    for (uint32_t y = 0; y < outHeight; ++y)
+    {
+        const uint32_t y0 = std::min(2 * y, height - 1);
+        const uint32_t y1 = std::min(2 * y + 1, height - 1);
+        for (uint32_t x = 0; x < outWidth; ++x)
+        {
+            const uint32_t x0 = std::min(2 * x, width - 1);
+            const uint32_t x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                const int sum = rgba[(size_t(y0) * width + x0) * 4 + c] + rgba[(size_t(y0) * width + x1) * 4 + c] +
+                                rgba[(size_t(y1) * width + x0) * 4 + c] + rgba[(size_t(y1) * width + x1) * 4 + c];
+                out[(size_t(y) * outWidth + x) * 4 + c] = uint8_t((sum + 2) / 4);
+            }
+        }
+    }
+    return out;
+}
+
+double psnr(const uint8_t *reference, const uint8_t *test, uint32_t width, uint32_t height, int channels)
+{
+    double squaredError = 0.0;
+    const size_t pixels = size_t(width) * height;
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            const double difference = double(reference[4 * i + c]) - double(test[4 * i + c]);
+            squaredError += difference * difference;
+        }
+    }
+    if (0.0 == squaredError)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double meanSquaredError = squaredError / double(pixels * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
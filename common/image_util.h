@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Procedural RGBA8 lightmap-like test image: smooth gradients, soft blobs and a varying alpha
+std::vector<uint8_t> generateLightmap(uint32_t width, uint32_t height, uint32_t seed);
+
+// 2x2 box filter to the next mip level, clamping odd edges
+std::vector<uint8_t> downsampleRgba(const std::vector<uint8_t> &rgba, uint32_t width, uint32_t height);
+
+// peak signal to noise ratio in dB over the given channels (3 = RGB, 4 = RGBA)
+double psnr(const uint8_t *reference, const uint8_t *test, uint32_t width, uint32_t height, int channels);
@@ -0,0 +1,189 @@
+#include "image_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    static const auto table = []()
+    {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void appendBigEndian(std::vector<uint8_t> &bytes, uint32_t value)
+{
+    bytes.push_back(uint8_t(value >> 24));
+    bytes.push_back(uint8_t(value >> 16));
+    bytes.push_back(uint8_t(value >> 8));
+    bytes.push_back(uint8_t(value));
+}
+
+static void writeChunk(std::ofstream &stream, const char type[4], const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> header;
+    appendBigEndian(header, uint32_t(data.size()));
+    header.insert(header.end(), type, type + 4);
+    uint32_t crc = crc32(0, header.data() + 4, 4);
+    crc = crc32(crc, data.data(), data.size());
+    std::vector<uint8_t> trailer;
+    appendBigEndian(trailer, crc);
+
+    stream.write(reinterpret_cast<const char *>(header.data()), std::streamsize(header.size()));
+    stream.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+    stream.write(reinterpret_cast<const char *>(trailer.data()), std::streamsize(trailer.size()));
+}
+
+void writePng(const char *path, const PixelRows &pixels)
+{
+    // filter type 0 and RGB for each row
+    const size_t rowBytes = 1 + size_t(pixels.width) * 3;
+    std::vector<uint8_t> raw(rowBytes * pixels.height);
+    const int red = pixels.bgra ? 2 : 0;
+    const int blue = pixels.bgra ? 0 : 2;
+    for (uint32_t y = 0; y < pixels.height; ++y)
+    {
+        const uint8_t *source = pixels.data + y * pixels.stride;
+        uint8_t *row = raw.data() + y * rowBytes;
+        row[0] = 0;
+        for (uint32_t x = 0; x < pixels.width; ++x)
+        {
+            row[1 + 3 * x + 0] = source[4 * x + red];
+            row[1 + 3 * x + 1] = source[4 * x + 1];
+            row[1 + 3 * x + 2] = source[4 * x + blue];
+        }
+    }
+
+    // zlib header for no compression, stored blocks of at most 65535 bytes, then Adler-32
+    constexpr size_t MaxBlock = 65535;
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / MaxBlock * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t offset = 0;
+    do
+    {
+        const size_t blockSize = std::min(MaxBlock, raw.size() - offset);
+        const bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(uint8_t(blockSize));
+        zlib.push_back(uint8_t(blockSize >> 8));
+        zlib.push_back(uint8_t(~blockSize));
+        zlib.push_back(uint8_t(~blockSize >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size();)
+    {
+        // the largest run before b can overflow 32 bits
+        const size_t end = std::min(raw.size(), i + 5552);
+        for (; i < end; ++i)
+        {
+            a += raw[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, pixels.width);
+    appendBigEndian(header, pixels.height);
+    header.push_back(8); // bit depth
+    header.push_back(2); // truecolour
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering
+    header.push_back(0); // no interlace
+
+    std::ofstream stream(path, std::ios::binary);
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    stream.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+    writeChunk(stream, "IHDR", header);
+    writeChunk(stream, "IDAT", zlib);
+    writeChunk(stream, "IEND", {});
+    if (!stream)
+    {
+        throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+}
+
+std::string y4mHeader(uint32_t width, uint32_t height, uint32_t framesPerSecond)
+{
+    return "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) + " F" + std::to_string(framesPerSecond) + ":1 Ip A1:1 C420jpeg\n";
+}
+
+void encodeY4mFrame(const PixelRows &pixels, std::vector<uint8_t> &frame)
+{
+    static const char marker[] = "FRAME\n";
+    const size_t markerSize = sizeof(marker) - 1;
+    const uint32_t chromaWidth = (pixels.width + 1) / 2;
+    const uint32_t chromaHeight = (pixels.height + 1) / 2;
+    const size_t lumaSize = size_t(pixels.width) * pixels.height;
+    const size_t chromaSize = size_t(chromaWidth) * chromaHeight;
+    frame.resize(markerSize + lumaSize + 2 * chromaSize);
+    memcpy(frame.data(), marker, markerSize);
+    uint8_t *luma = frame.data() + markerSize;
+    uint8_t *cb = luma + lumaSize;
+    uint8_t *cr = cb + chromaSize;
+
+    const int red = pixels.bgra ? 2 : 0;
+    const int blue = pixels.bgra ? 0 : 2;
+    // coefficients scaled by 2^16
+    for (uint32_t y = 0; y < pixels.height; ++y)
+    {
+        const uint8_t *source = pixels.data + y * pixels.stride;
+        uint8_t *row = luma + size_t(y) * pixels.width;
+        for (uint32_t x = 0; x < pixels.width; ++x)
+        {
+            const int r = source[4 * x + red], g = source[4 * x + 1], b = source[4 * x + blue];
+            row[x] = uint8_t((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+        }
+    }
+    for (uint32_t cy = 0; cy < chromaHeight; ++cy)
+    {
+        const uint32_t y0 = 2 * cy;
+        const uint32_t y1 = std::min(y0 + 1, pixels.height - 1);
+        const uint8_t *rows[2] = { pixels.data + y0 * pixels.stride, pixels.data + y1 * pixels.stride };
+        for (uint32_t cx = 0; cx < chromaWidth; ++cx)
+        {
+            const uint32_t x0 = 2 * cx;
+            const uint32_t x1 = std::min(x0 + 1, pixels.width - 1);
+            int r = 0, g = 0, b = 0;
+            for (const uint8_t *row : rows)
+            {
+                for (uint32_t x : { x0, x1 })
+                {
+                    r += row[4 * x + red];
+                    g += row[4 * x + 1];
+                    b += row[4 * x + blue];
+                }
+            }
+            // sums of four samples, so a further shift of 2
+            const size_t index = size_t(cy) * chromaWidth + cx;
+            cb[index] = uint8_t(std::clamp((-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18, 0, 255));
+            cr[index] = uint8_t(std::clamp((32768 * r - 27439 * g - 5329 * b + (128 << 18) + (1 << 17)) >> 18, 0, 255));
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 8 bit RGBA or BGRA pixels, rows stride bytes apart, as read back from a swap chain image
+struct PixelRows
+{
+    const uint8_t *data;
+    uint32_t width;
+    uint32_t height;
+    size_t stride;
+    bool bgra;
+};
+
+// Writes an RGB PNG, dropping alpha; throws std::runtime_error if the file can't be written
+// The zlib stream is made of stored blocks rather than compressed ones, trading size for an
+// encode that runs at memcpy speed, as frame dumps are written faster than they're read.
+void writePng(const char *path, const PixelRows &pixels);
+
+// The YUV4MPEG2 stream header, for 4:2:0 frames that encoders such as ffmpeg read from a pipe
+std::string y4mHeader(uint32_t width, uint32_t height, uint32_t framesPerSecond);
+
+// One Y4M frame, its FRAME marker and the Y, Cb and Cr planes, converted with full range BT.601
+// and chroma averaged over each 2x2 block; frame is resized to fit
+void encodeY4mFrame(const PixelRows &pixels, std::vector<uint8_t> &frame);
@@ -0,0 +1,110 @@
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    // header, index and level index layout from the KTX 2.0 specification, all little endian
+    struct Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+    static_assert(sizeof(Header) == 80, "KTX2 header must be tightly packed");
+
+    struct LevelIndex
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+}
+
+Ktx2Image parseKtx2(const uint8_t *data, size_t size)
+{
+    Header header;
+    if (size < sizeof(header))
+    {
+        throw std::runtime_error("KTX2 file is too small");
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (0 != memcmp(header.identifier, identifier, sizeof(identifier)))
+    {
+        throw std::runtime_error("Not a KTX2 file");
+    }
+    if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+    {
+        throw std::runtime_error("Only single 2D KTX2 images are supported");
+    }
+    if (0 == header.pixelWidth || 0 == header.pixelHeight)
+    {
+        throw std::runtime_error("KTX2 image has no size");
+    }
+    if (0 != header.supercompressionScheme)
+    {
+        throw std::runtime_error("Supercompressed KTX2 files are not supported");
+    }
+
+    // a full mip chain halves the largest dimension down to a single texel
+    uint32_t maxLevelCount = 0;
+    for (uint32_t extent = std::max({ header.pixelWidth, header.pixelHeight, header.pixelDepth }); extent > 0; extent >>= 1)
+    {
+        ++maxLevelCount;
+    }
+    if (header.levelCount > maxLevelCount)
+    {
+        throw std::runtime_error("KTX2 file has more levels than a full mip chain");
+    }
+
+    // a level count of zero asks the loader to generate mips; we only use the base level then
+    const uint32_t levelCount = std::max(1u, header.levelCount);
+    if (sizeof(header) + levelCount * sizeof(LevelIndex) > size)
+    {
+        throw std::runtime_error("KTX2 level index is truncated");
+    }
+
+    Ktx2Image image;
+    image.vkFormat = header.vkFormat;
+    image.typeSize = header.typeSize;
+    image.width = header.pixelWidth;
+    image.height = header.pixelHeight;
+    image.supercompressionScheme = header.supercompressionScheme;
+    image.levels.resize(levelCount);
+
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        LevelIndex index;
+        memcpy(&index, data + sizeof(header) + i * sizeof(LevelIndex), sizeof(index));
+        if (index.byteOffset > size || index.byteLength > size - index.byteOffset)
+        {
+            throw std::runtime_error("KTX2 level data lies outside the file");
+        }
+
+        Ktx2Level &level = image.levels[i];
+        level.byteOffset = index.byteOffset;
+        level.byteLength = index.byteLength;
+        level.width = std::max(1u, header.pixelWidth >> i);
+        level.height = std::max(1u, header.pixelHeight >> i);
+    }
+
+    return image;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// View of a KTX2 container held in memory (typically a MappedFile)
+// Nothing is copied; the level descriptions point back into the container.
+struct Ktx2Level
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct Ktx2Image
+{
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t supercompressionScheme;
+    std::vector<Ktx2Level> levels; // levels[0] is the full resolution image
+};
+
+// Throws std::runtime_error for malformed containers, and for features the ditties don't
+// handle: arrays, cube maps, 3D textures and supercompression
+Ktx2Image parseKtx2(const uint8_t *data, size_t size);
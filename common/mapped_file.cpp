@@ -0,0 +1,130 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+// restrict a range to the whole pages it covers, so that advice never touches bytes outside it
+static bool pageAlignedRange(size_t offset, size_t size, size_t length, size_t &alignedOffset, size_t &alignedSize)
+{
+    static const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    const size_t end = std::min(offset + size, length);
+    alignedOffset = (offset + pageSize - 1) & ~(pageSize - 1);
+    const size_t alignedEnd = (end == length) ? end : (end & ~(pageSize - 1));
+    if (alignedEnd <= alignedOffset)
+    {
+        return false;
+    }
+    alignedSize = alignedEnd - alignedOffset;
+    return true;
+}
+#endif
+
+MappedFile::MappedFile(const char *path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+    {
+        throw std::runtime_error(std::string("Failed to open ") + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || 0 == fileSize.QuadPart)
+    {
+        CloseHandle(file);
+        throw std::runtime_error(std::string("Failed to get size of ") + path);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (nullptr == mapping)
+    {
+        CloseHandle(file);
+        throw std::runtime_error(std::string("Failed to map ") + path);
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (nullptr == view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error(std::string("Failed to map ") + path);
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    bytes = static_cast<const uint8_t *>(view);
+    length = size_t(fileSize.QuadPart);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error(std::string("Failed to open ") + path);
+    }
+    struct stat status;
+    if (0 != fstat(fd, &status) || 0 == status.st_size)
+    {
+        close(fd);
+        throw std::runtime_error(std::string("Failed to get size of ") + path);
+    }
+    void *view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive
+    close(fd);
+    if (MAP_FAILED == view)
+    {
+        throw std::runtime_error(std::string("Failed to map ") + path);
+    }
+    bytes = static_cast<const uint8_t *>(view);
+    length = size_t(status.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(bytes);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+#else
+    munmap(const_cast<uint8_t *>(bytes), length);
+#endif
+}
+
+void MappedFile::prefetch(size_t offset, size_t size) const
+{
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t *>(bytes + offset);
+    range.NumberOfBytes = std::min(size, length - offset);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // round outwards, reading a little extra is harmless
+    static const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    const size_t alignedOffset = offset & ~(pageSize - 1);
+    const size_t end = std::min(offset + size, length);
+    madvise(const_cast<uint8_t *>(bytes) + alignedOffset, end - alignedOffset, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::discard(size_t offset, size_t size) const
+{
+#ifdef _WIN32
+    // a read-only view is backed by the file, so the pages are trimmed under pressure anyway
+    (void)offset;
+    (void)size;
+#else
+    size_t alignedOffset, alignedSize;
+    if (pageAlignedRange(offset, size, length, alignedOffset, alignedSize))
+    {
+        madvise(const_cast<uint8_t *>(bytes) + alignedOffset, alignedSize, MADV_DONTNEED);
+    }
+#endif
+}
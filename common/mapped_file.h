@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+// Throws std::runtime_error if the file cannot be opened or mapped.
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+    // hint that a range is about to be read
+    void prefetch(size_t offset, size_t size) const;
+
+    // hint that a range will not be read again, so its pages can leave the resident set
+    void discard(size_t offset, size_t size) const;
+
+private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
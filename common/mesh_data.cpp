@@ -0,0 +1,280 @@
+#include "mesh_data.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    struct ObjCorner
+    {
+        int position;
+        int uv;
+        int normal;
+
+        bool operator==(const ObjCorner &other) const
+        {
+            return position == other.position && uv == other.uv && normal == other.normal;
+        }
+    };
+
+    struct ObjCornerHash
+    {
+        size_t operator()(const ObjCorner &corner) const
+        {
+            return size_t(corner.position) * 73856093u ^ size_t(corner.uv) * 19349663u ^ size_t(corner.normal) * 83492791u;
+        }
+    };
+}
+
+// OBJ indices are 1-based, or negative to count back from the latest element; 0 means absent
+static int resolveObjIndex(int index, size_t count)
+{
+    if (index < 0)
+    {
+        return int(count) + index + 1;
+    }
+    return index;
+}
+
+static ObjCorner parseObjCorner(const std::string &token, size_t positions, size_t uvs, size_t normals)
+{
+    ObjCorner corner = { 0, 0, 0 };
+    const size_t firstSlash = token.find('/');
+    corner.position = resolveObjIndex(std::stoi(token.substr(0, firstSlash)), positions);
+    if (std::string::npos != firstSlash)
+    {
+        const size_t secondSlash = token.find('/', firstSlash + 1);
+        const std::string uv = token.substr(firstSlash + 1, secondSlash - firstSlash - 1);
+        if (!uv.empty())
+        {
+            corner.uv = resolveObjIndex(std::stoi(uv), uvs);
+        }
+        if (std::string::npos != secondSlash && secondSlash + 1 < token.size())
+        {
+            corner.normal = resolveObjIndex(std::stoi(token.substr(secondSlash + 1)), normals);
+        }
+    }
+
+    if (corner.position < 1 || size_t(corner.position) > positions || corner.uv < 0 || size_t(corner.uv) > uvs || corner.normal < 0 || size_t(corner.normal) > normals)
+    {
+        throw std::runtime_error("OBJ face references a missing vertex: " + token);
+    }
+    return corner;
+}
+
+static void computeSmoothNormals(MeshData &mesh)
+{
+    mesh.normals.assign(mesh.positions.size(), 0.0f);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const float *p0 = &mesh.positions[3 * mesh.indices[i]];
+        const float *p1 = &mesh.positions[3 * mesh.indices[i + 1]];
+        const float *p2 = &mesh.positions[3 * mesh.indices[i + 2]];
+        const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        // area weighted, as the cross product isn't normalised
+        const float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                mesh.normals[3 * mesh.indices[i + corner] + c] += normal[c];
+            }
+        }
+    }
+    for (size_t v = 0; v < mesh.normals.size(); v += 3)
+    {
+        const float length = std::sqrt(mesh.normals[v] * mesh.normals[v] + mesh.normals[v + 1] * mesh.normals[v + 1] + mesh.normals[v + 2] * mesh.normals[v + 2]);
+        for (int c = 0; c < 3; ++c)
+        {
+            mesh.normals[v + c] = (length > 0.0f) ? mesh.normals[v + c] / length : (2 == c ? 1.0f : 0.0f);
+        }
+    }
+}
+
+MeshData parseObj(const char *path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error(std::string("Failed to open ") + path);
+    }
+
+    std::vector<float> positions, uvs, normals;
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> vertexForCorner;
+    MeshData mesh;
+    bool hasNormals = false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream record(line);
+        std::string type;
+        record >> type;
+        if ("v" == type)
+        {
+            float x = 0, y = 0, z = 0;
+            record >> x >> y >> z;
+            positions.insert(positions.end(), { x, y, z });
+        }
+        else if ("vt" == type)
+        {
+            float u = 0, v = 0;
+            record >> u >> v;
+            uvs.insert(uvs.end(), { u, v });
+        }
+        else if ("vn" == type)
+        {
+            float x = 0, y = 0, z = 0;
+            record >> x >> y >> z;
+            normals.insert(normals.end(), { x, y, z });
+        }
+        else if ("f" == type)
+        {
+            std::vector<uint32_t> polygon;
+            std::string token;
+            while (record >> token)
+            {
+                const ObjCorner corner = parseObjCorner(token, positions.size() / 3, uvs.size() / 2, normals.size() / 3);
+                auto [found, inserted] = vertexForCorner.emplace(corner, meshVertexCount(mesh));
+                if (inserted)
+                {
+                    const float *position = &positions[3 * (corner.position - 1)];
+                    mesh.positions.insert(mesh.positions.end(), position, position + 3);
+                    if (corner.uv > 0)
+                    {
+                        const float *uv = &uvs[2 * (corner.uv - 1)];
+                        mesh.uvs.insert(mesh.uvs.end(), uv, uv + 2);
+                    }
+                    else
+                    {
+                        mesh.uvs.insert(mesh.uvs.end(), { 0.0f, 0.0f });
+                    }
+                    if (corner.normal > 0)
+                    {
+                        const float *normal = &normals[3 * (corner.normal - 1)];
+                        mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+                        hasNormals = true;
+                    }
+                    else
+                    {
+                        mesh.normals.insert(mesh.normals.end(), { 0.0f, 0.0f, 0.0f });
+                    }
+                }
+                polygon.push_back(found->second);
+            }
+
+            for (size_t i = 2; i < polygon.size(); ++i)
+            {
+                mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i - 1], polygon[i] });
+            }
+        }
+    }
+
+    if (mesh.indices.empty())
+    {
+        throw std::runtime_error(std::string("No faces in ") + path);
+    }
+    if (!hasNormals)
+    {
+        computeSmoothNormals(mesh);
+    }
+
+    return mesh;
+}
+
+void writeObj(const char *path, const MeshData &mesh)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error(std::string("Failed to create ") + path);
+    }
+
+    const uint32_t vertexCount = meshVertexCount(mesh);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        file << "v " << mesh.positions[3 * v] << " " << mesh.positions[3 * v + 1] << " " << mesh.positions[3 * v + 2] << "\n";
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        file << "vt " << mesh.uvs[2 * v] << " " << mesh.uvs[2 * v + 1] << "\n";
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        file << "vn " << mesh.normals[3 * v] << " " << mesh.normals[3 * v + 1] << " " << mesh.normals[3 * v + 2] << "\n";
+    }
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        file << "f";
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            const uint32_t index = mesh.indices[i + corner] + 1;
+            file << " " << index << "/" << index << "/" << index;
+        }
+        file << "\n";
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+}
+
+MeshData generateSphere(uint32_t segments, uint32_t rings)
+{
+    const float pi = 3.14159265358979f;
+
+    MeshData mesh;
+    for (uint32_t ring = 0; ring <= rings; ++ring)
+    {
+        const float v = float(ring) / float(rings);
+        const float polar = v * pi;
+        for (uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            const float u = float(segment) / float(segments);
+            const float azimuth = u * 2.0f * pi;
+            const float normal[3] = { std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth) };
+            mesh.positions.insert(mesh.positions.end(), normal, normal + 3);
+            mesh.normals.insert(mesh.normals.end(), normal, normal + 3);
+            mesh.uvs.insert(mesh.uvs.end(), { u, v });
+        }
+    }
+
+    const uint32_t rowLength = segments + 1;
+    for (uint32_t ring = 0; ring < rings; ++ring)
+    {
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            const uint32_t a = ring * rowLength + segment;
+            const uint32_t b = a + rowLength;
+            mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+
+    return mesh;
+}
+
+void shuffleTriangles(MeshData &mesh, uint32_t seed)
+{
+    const size_t triangleCount = mesh.indices.size() / 3;
+    std::vector<uint32_t> order(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        order[i] = uint32_t(i);
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+
+    std::vector<uint32_t> shuffled(mesh.indices.size());
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        std::copy_n(&mesh.indices[3 * order[i]], 3, &shuffled[3 * i]);
+    }
+    mesh.indices.swap(shuffled);
+}
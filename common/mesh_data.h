@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Unpacked triangle mesh, as imported before optimisation and quantisation
+struct MeshData
+{
+    std::vector<float> positions; // xyz per vertex
+    std::vector<float> normals;   // xyz per vertex
+    std::vector<float> uvs;       // uv per vertex
+    std::vector<uint32_t> indices;
+};
+
+inline uint32_t meshVertexCount(const MeshData &mesh)
+{
+    return uint32_t(mesh.positions.size() / 3);
+}
+
+// Deliberately simple Wavefront OBJ reader: v, vt, vn and polygonal f records, with
+// polygons fan-triangulated and each distinct position/uv/normal corner made a vertex.
+// Meshes without normals get smooth normals. Throws std::runtime_error on failure.
+MeshData parseObj(const char *path);
+
+void writeObj(const char *path, const MeshData &mesh);
+
+// UV sphere, with its triangles in row order
+MeshData generateSphere(uint32_t segments, uint32_t rings);
+
+// Shuffles triangle order, to stand in for meshes straight out of a DCC tool
+void shuffleTriangles(MeshData &mesh, uint32_t seed);
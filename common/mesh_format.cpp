@@ -0,0 +1,222 @@
+#include "mesh_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+static const char meshMagic[4] = { 'D', 'M', 'S', 'H' };
+static const uint32_t meshVersion = 1;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+MeshView viewMesh(const uint8_t *data, size_t size)
+{
+    if (size < sizeof(MeshHeader))
+    {
+        throw std::runtime_error("Mesh file is too small");
+    }
+
+    // the data is expected to be at least 16 byte aligned, as mappings and allocations are
+    const MeshHeader *header = reinterpret_cast<const MeshHeader *>(data);
+    if (0 != memcmp(header->magic, meshMagic, sizeof(meshMagic)))
+    {
+        throw std::runtime_error("Not a mesh file");
+    }
+    if (meshVersion != header->version || sizeof(MeshVertex) != header->vertexStride)
+    {
+        throw std::runtime_error("Unsupported mesh file version");
+    }
+    if (2 != header->indexSize && 4 != header->indexSize)
+    {
+        throw std::runtime_error("Mesh file has an invalid index size");
+    }
+    if (0 != header->vertexOffset % 16 || 0 != header->indexOffset % 16)
+    {
+        throw std::runtime_error("Mesh file arrays are misaligned");
+    }
+
+    const uint64_t vertexBytes = uint64_t(header->vertexCount) * header->vertexStride;
+    const uint64_t indexBytes = uint64_t(header->indexCount) * header->indexSize;
+    if (header->vertexOffset > size || vertexBytes > size - header->vertexOffset || header->indexOffset > size || indexBytes > size - header->indexOffset)
+    {
+        throw std::runtime_error("Mesh file is truncated");
+    }
+
+    if (0 != header->indexCount % 3)
+    {
+        throw std::runtime_error("Mesh file has a partial triangle");
+    }
+
+    MeshView view;
+    view.header = header;
+    view.vertices = reinterpret_cast<const MeshVertex *>(data + header->vertexOffset);
+    view.indices = data + header->indexOffset;
+
+    // the indices are drawn straight from the file, without robust buffer access to catch one
+    // past the vertices
+    uint32_t maxIndex = 0;
+    for (uint32_t i = 0; i < header->indexCount; ++i)
+    {
+        maxIndex = std::max(maxIndex, meshIndex(view, i));
+    }
+    if (header->indexCount > 0 && maxIndex >= header->vertexCount)
+    {
+        throw std::runtime_error("Mesh file has an index past its vertices");
+    }
+    return view;
+}
+
+static uint16_t quantiseUnorm16(float value, float minimum, float extent)
+{
+    const float normalised = (extent > 0.0f) ? (value - minimum) / extent : 0.0f;
+    return uint16_t(std::lround(std::min(1.0f, std::max(0.0f, normalised)) * 65535.0f));
+}
+
+static int16_t quantiseSnorm16(float value)
+{
+    return int16_t(std::lround(std::min(1.0f, std::max(-1.0f, value)) * 32767.0f));
+}
+
+// octahedral encoding: project onto the |x|+|y|+|z| = 1 octahedron and fold the lower half out
+static void encodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+    const float sum = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    float x = (sum > 0.0f) ? normal[0] / sum : 0.0f;
+    float y = (sum > 0.0f) ? normal[1] / sum : 0.0f;
+    if (normal[2] < 0.0f)
+    {
+        const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = quantiseSnorm16(x);
+    encoded[1] = quantiseSnorm16(y);
+}
+
+std::vector<uint8_t> encodeMesh(const MeshData &mesh)
+{
+    const uint32_t vertexCount = meshVertexCount(mesh);
+
+    MeshHeader header = {};
+    memcpy(header.magic, meshMagic, sizeof(meshMagic));
+    header.version = meshVersion;
+    header.vertexCount = vertexCount;
+    header.indexCount = uint32_t(mesh.indices.size());
+    header.indexSize = (vertexCount <= 65536) ? 2 : 4;
+    header.vertexStride = sizeof(MeshVertex);
+    header.vertexOffset = alignUp(sizeof(MeshHeader), 16);
+    header.indexOffset = alignUp(header.vertexOffset + uint64_t(vertexCount) * sizeof(MeshVertex), 16);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        float minimum = 0.0f, maximum = 0.0f;
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            const float value = mesh.positions[3 * v + c];
+            minimum = (0 == v) ? value : std::min(minimum, value);
+            maximum = (0 == v) ? value : std::max(maximum, value);
+        }
+        header.positionMin[c] = minimum;
+        header.positionExtent[c] = maximum - minimum;
+    }
+    for (int c = 0; c < 2; ++c)
+    {
+        float minimum = 0.0f, maximum = 0.0f;
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            const float value = mesh.uvs[2 * v + c];
+            minimum = (0 == v) ? value : std::min(minimum, value);
+            maximum = (0 == v) ? value : std::max(maximum, value);
+        }
+        header.uvMin[c] = minimum;
+        header.uvExtent[c] = maximum - minimum;
+    }
+
+    std::vector<uint8_t> bytes(size_t(header.indexOffset + uint64_t(header.indexCount) * header.indexSize), 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        MeshVertex vertex = {};
+        for (int c = 0; c < 3; ++c)
+        {
+            vertex.position[c] = quantiseUnorm16(mesh.positions[3 * v + c], header.positionMin[c], header.positionExtent[c]);
+        }
+        encodeOctahedral(&mesh.normals[3 * v], vertex.normal);
+        for (int c = 0; c < 2; ++c)
+        {
+            vertex.uv[c] = quantiseUnorm16(mesh.uvs[2 * v + c], header.uvMin[c], header.uvExtent[c]);
+        }
+        memcpy(bytes.data() + header.vertexOffset + v * sizeof(MeshVertex), &vertex, sizeof(vertex));
+    }
+
+    uint8_t *indices = bytes.data() + header.indexOffset;
+    for (size_t i = 0; i < mesh.indices.size(); ++i)
+    {
+        if (2 == header.indexSize)
+        {
+            const uint16_t index = uint16_t(mesh.indices[i]);
+            memcpy(indices + 2 * i, &index, 2);
+        }
+        else
+        {
+            memcpy(indices + 4 * i, &mesh.indices[i], 4);
+        }
+    }
+
+    return bytes;
+}
+
+size_t writeMeshFile(const char *path, const MeshData &mesh)
+{
+    const std::vector<uint8_t> bytes = encodeMesh(mesh);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+    if (!file)
+    {
+        throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+    return bytes.size();
+}
+
+void decodePosition(const MeshHeader &header, const MeshVertex &vertex, float position[3])
+{
+    for (int c = 0; c < 3; ++c)
+    {
+        position[c] = header.positionMin[c] + header.positionExtent[c] * (float(vertex.position[c]) / 65535.0f);
+    }
+}
+
+void decodeNormal(const MeshVertex &vertex, float normal[3])
+{
+    float x = std::max(-1.0f, float(vertex.normal[0]) / 32767.0f);
+    float y = std::max(-1.0f, float(vertex.normal[1]) / 32767.0f);
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f)
+    {
+        const float unfoldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float unfoldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    const float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+uint32_t meshIndex(const MeshView &mesh, uint32_t i)
+{
+    if (2 == mesh.header->indexSize)
+    {
+        return static_cast<const uint16_t *>(mesh.indices)[i];
+    }
+    return static_cast<const uint32_t *>(mesh.indices)[i];
+}
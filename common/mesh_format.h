@@ -0,0 +1,61 @@
+#pragma once
+
+#include "mesh_data.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Runtime mesh format, designed to be memory-mapped and used in place
+// A header, then the vertices, then the indices, each 16 byte aligned and little endian.
+// Positions are 16 bit unorm within the mesh bounds, normals octahedral 16 bit snorm and UVs
+// 16 bit unorm within the UV bounds, so a vertex is 16 bytes and maps straight onto the
+// R16G16B16A16_UNORM, R16G16_SNORM and R16G16_UNORM vertex formats.
+struct MeshVertex
+{
+    uint16_t position[4]; // w is unused
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+static_assert(sizeof(MeshVertex) == 16, "MeshVertex must be tightly packed");
+
+struct MeshHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize; // 2 or 4 bytes, 2 whenever the vertex count allows
+    uint32_t vertexStride;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    float positionMin[3];
+    float positionExtent[3];
+    float uvMin[2];
+    float uvExtent[2];
+};
+static_assert(sizeof(MeshHeader) == 80, "MeshHeader must be tightly packed");
+
+// Pointers into a mesh file held in memory (typically a MappedFile); nothing is copied
+struct MeshView
+{
+    const MeshHeader *header;
+    const MeshVertex *vertices;
+    const void *indices;
+};
+
+// Checks the header, that the arrays lie within the data and that the indices form whole
+// triangles of existing vertices; throws std::runtime_error otherwise
+MeshView viewMesh(const uint8_t *data, size_t size);
+
+// Quantises a mesh into the file format
+std::vector<uint8_t> encodeMesh(const MeshData &mesh);
+
+// Encodes and writes a mesh file, returning its size
+size_t writeMeshFile(const char *path, const MeshData &mesh);
+
+void decodePosition(const MeshHeader &header, const MeshVertex &vertex, float position[3]);
+
+void decodeNormal(const MeshVertex &vertex, float normal[3]);
+
+uint32_t meshIndex(const MeshView &mesh, uint32_t i);
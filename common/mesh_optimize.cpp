@@ -0,0 +1,230 @@
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int ScoredCacheSize = 32;
+
+    // scores for a vertex's position in the simulated LRU cache and for how few
+    // triangles it has left, so that lone vertices get finished off
+    struct VertexScoreTable
+    {
+        float cache[ScoredCacheSize];
+        float valence[64];
+
+        VertexScoreTable()
+        {
+            for (int position = 0; position < ScoredCacheSize; ++position)
+            {
+                // the most recent triangle's vertices are scored flat, so the order within it doesn't matter
+                cache[position] = (position < 3) ? 0.75f : std::pow(1.0f - float(position - 3) / float(ScoredCacheSize - 3), 1.5f);
+            }
+            valence[0] = 0.0f;
+            for (int remaining = 1; remaining < 64; ++remaining)
+            {
+                valence[remaining] = 2.0f / std::sqrt(float(remaining));
+            }
+        }
+
+        float score(int cachePosition, uint32_t remaining) const
+        {
+            if (0 == remaining)
+            {
+                return -1.0f;
+            }
+            const float cacheScore = (cachePosition < 0) ? 0.0f : cache[cachePosition];
+            return cacheScore + valence[std::min(remaining, 63u)];
+        }
+    };
+}
+
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount)
+{
+    static const VertexScoreTable scoreTable;
+
+    const uint32_t triangleCount = uint32_t(indices.size() / 3);
+    if (0 == triangleCount)
+    {
+        return;
+    }
+
+    // vertex to triangle adjacency, as offsets into one flat array
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        ++remaining[index];
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (uint32_t i = 0; i < indices.size(); ++i)
+        {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScore[v] = scoreTable.score(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    // the cache has room for the scored entries plus the three just pushed in
+    uint32_t cache[ScoredCacheSize + 3];
+    uint32_t cacheCount = 0;
+
+    uint32_t bestTriangle = 0;
+    float bestScore = triangleScore[0];
+    for (uint32_t t = 1; t < triangleCount; ++t)
+    {
+        if (triangleScore[t] > bestScore)
+        {
+            bestScore = triangleScore[t];
+            bestTriangle = t;
+        }
+    }
+
+    // fallback for when nothing adjacent to the cache is left; emitted triangles only sit before it
+    uint32_t nextUnemitted = 0;
+
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        const uint32_t *triangle = &indices[3 * bestTriangle];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = true;
+
+        // push the triangle's vertices to the front of the LRU cache, and take the triangle
+        // out of their adjacency
+        uint32_t newCache[ScoredCacheSize + 3];
+        uint32_t newCount = 0;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const uint32_t v = triangle[corner];
+            newCache[newCount++] = v;
+
+            uint32_t *begin = &adjacency[adjacencyOffset[v]];
+            uint32_t *end = begin + remaining[v];
+            std::swap(*std::find(begin, end, bestTriangle), *(end - 1));
+            --remaining[v];
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i)
+        {
+            const uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // rescore everything in the cache, and anything that just fell out of it
+        for (uint32_t i = 0; i < newCount; ++i)
+        {
+            const uint32_t v = newCache[i];
+            cachePosition[v] = (i < ScoredCacheSize) ? int(i) : -1;
+            const float score = scoreTable.score(cachePosition[v], remaining[v]);
+            const float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t a = 0; a < remaining[v]; ++a)
+            {
+                triangleScore[adjacency[adjacencyOffset[v] + a]] += delta;
+            }
+        }
+        cacheCount = std::min<uint32_t>(newCount, ScoredCacheSize);
+        std::copy_n(newCache, cacheCount, cache);
+
+        // the best next triangle is almost always one touching the cache
+        bestScore = -1e30f;
+        bool found = false;
+        for (uint32_t i = 0; i < cacheCount; ++i)
+        {
+            const uint32_t v = cache[i];
+            for (uint32_t a = 0; a < remaining[v]; ++a)
+            {
+                const uint32_t t = adjacency[adjacencyOffset[v] + a];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                    found = true;
+                }
+            }
+        }
+        if (!found)
+        {
+            while (nextUnemitted < triangleCount && emitted[nextUnemitted])
+            {
+                ++nextUnemitted;
+            }
+            bestTriangle = nextUnemitted;
+        }
+    }
+
+    indices.swap(output);
+}
+
+void optimizeVertexFetch(MeshData &mesh)
+{
+    const uint32_t unassigned = ~0u;
+    std::vector<uint32_t> remap(meshVertexCount(mesh), unassigned);
+    uint32_t nextVertex = 0;
+    for (uint32_t &index : mesh.indices)
+    {
+        if (unassigned == remap[index])
+        {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    MeshData reordered;
+    reordered.positions.resize(size_t(nextVertex) * 3);
+    reordered.normals.resize(size_t(nextVertex) * 3);
+    reordered.uvs.resize(size_t(nextVertex) * 2);
+    for (uint32_t v = 0; v < remap.size(); ++v)
+    {
+        if (unassigned != remap[v])
+        {
+            std::copy_n(&mesh.positions[3 * v], 3, &reordered.positions[3 * remap[v]]);
+            std::copy_n(&mesh.normals[3 * v], 3, &reordered.normals[3 * remap[v]]);
+            std::copy_n(&mesh.uvs[2 * v], 2, &reordered.uvs[2 * remap[v]]);
+        }
+    }
+
+    mesh.positions.swap(reordered.positions);
+    mesh.normals.swap(reordered.normals);
+    mesh.uvs.swap(reordered.uvs);
+}
+
+double averageCacheMissRatio(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    // a vertex is in the FIFO if it was pushed within the last cacheSize misses
+    std::vector<uint64_t> pushedAt(vertexCount, 0);
+    uint64_t misses = 0;
+    for (uint32_t index : indices)
+    {
+        if (0 == pushedAt[index] || misses + 1 - pushedAt[index] > cacheSize)
+        {
+            ++misses;
+            pushedAt[index] = misses;
+        }
+    }
+    return indices.empty() ? 0.0 : double(misses) / double(indices.size() / 3);
+}
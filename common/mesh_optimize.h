@@ -0,0 +1,18 @@
+#pragma once
+
+#include "mesh_data.h"
+
+#include <cstdint>
+#include <vector>
+
+// Reorders triangles for post-transform vertex cache hits (Forsyth's linear-speed algorithm,
+// scoring against a 32 entry LRU cache), keeping each triangle's winding
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+// Reorders vertices into first-use order of the index buffer, for vertex fetch locality, and
+// drops any vertex no triangle references
+void optimizeVertexFetch(MeshData &mesh);
+
+// Average cache miss ratio, transformed vertices per triangle, through a FIFO cache of the
+// given size like most hardware uses; 0.5 is the limit for large regular meshes, 3 the worst
+double averageCacheMissRatio(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize);
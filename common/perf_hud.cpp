@@ -0,0 +1,255 @@
+#include "perf_hud.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+struct HudGlyph
+{
+    char character;
+    uint8_t rows[7]; // top down, bit 4 is the leftmost column
+};
+
+static const HudGlyph hudGlyphs[] = {
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { 'A', { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 } },
+    { 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+    { 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+    { 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+    { 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+    { 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+    { 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+    { 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+    { 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+    { 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+    { 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+    { 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+    { 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+    { 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+    { 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+    { 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+    { 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+    { 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+    { 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+    { 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+    { '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+    { ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+    { '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+    { '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+    { '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+    { '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+    { ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+};
+
+static constexpr uint32_t hudCell = 8;
+static constexpr uint32_t hudSolidCharacter = 127;
+
+std::vector<uint8_t> bakeHudAtlas()
+{
+    std::vector<uint8_t> texels(size_t(hudAtlasWidth) * hudAtlasHeight, 0);
+    const auto cellOrigin = [](uint32_t character)
+    {
+        const uint32_t cell = character - 32;
+        return size_t(cell / 16 * hudCell) * hudAtlasWidth + cell % 16 * hudCell;
+    };
+    for (const HudGlyph &glyph : hudGlyphs)
+    {
+        const size_t origin = cellOrigin(uint32_t(glyph.character));
+        for (uint32_t y = 0; y < 7; ++y)
+        {
+            for (uint32_t x = 0; x < 5; ++x)
+            {
+                texels[origin + y * hudAtlasWidth + x] = (glyph.rows[y] >> (4 - x)) & 1 ? 255 : 0;
+            }
+        }
+    }
+    const size_t solid = cellOrigin(hudSolidCharacter);
+    for (uint32_t y = 0; y < hudCell; ++y)
+    {
+        memset(&texels[solid + y * hudAtlasWidth], 255, hudCell);
+    }
+    return texels;
+}
+
+void addHudCpuFrame(PerfHudStats &stats, float frameMs, float cpuMs)
+{
+    const uint32_t index = stats.cpuFrames % PerfHudStats::History;
+    stats.frameMs[index] = frameMs;
+    stats.cpuMs[index] = cpuMs;
+    ++stats.cpuFrames;
+}
+
+void addHudGpuFrame(PerfHudStats &stats, float gpuMs, float hudMs)
+{
+    stats.gpuMs[stats.gpuFrames % PerfHudStats::History] = gpuMs;
+    ++stats.gpuFrames;
+    stats.hudGpuMs = hudMs;
+}
+
+static float meanMs(const float *history, uint32_t frames)
+{
+    const uint32_t count = std::min(frames, PerfHudStats::History);
+    if (0 == count)
+    {
+        return 0.0f;
+    }
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        sum += history[i];
+    }
+    return sum / float(count);
+}
+
+static constexpr uint32_t hudColor(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+{
+    return red | green << 8 | blue << 16 | alpha << 24;
+}
+
+struct HudWriter
+{
+    SpriteVertex *vertices;
+    uint32_t quads = 0;
+};
+
+static void addHudQuad(HudWriter &writer, float x, float y, float width, float height, float u0, float v0, float u1, float v1, uint32_t color)
+{
+    if (writer.quads == hudMaxQuads)
+    {
+        return;
+    }
+    const SpriteVertex quad[4] = {
+        { x, y, u0, v0, color },
+        { x + width, y, u1, v0, color },
+        { x + width, y + height, u1, v1, color },
+        { x, y + height, u0, v1, color },
+    };
+    memcpy(writer.vertices + 4 * writer.quads, quad, sizeof(quad));
+    ++writer.quads;
+}
+
+// samples the middle of the solid cell, so neither filtering nor rounding reaches a glyph
+static void addHudRect(HudWriter &writer, float x, float y, float width, float height, uint32_t color)
+{
+    const uint32_t cell = hudSolidCharacter - 32;
+    const float u = (float(cell % 16 * hudCell) + 0.5f * hudCell) / float(hudAtlasWidth);
+    const float v = (float(cell / 16 * hudCell) + 0.5f * hudCell) / float(hudAtlasHeight);
+    addHudQuad(writer, x, y, width, height, u, v, u, v, color);
+}
+
+static constexpr float hudTextScale = 2.0f;
+static constexpr float hudAdvance = 6.0f * hudTextScale;
+static constexpr float hudLineHeight = 9.0f * hudTextScale;
+
+static void addHudText(HudWriter &writer, float x, float y, const char *text, uint32_t color)
+{
+    for (; '\0' != *text; ++text, x += hudAdvance)
+    {
+        uint32_t character = uint8_t(*text);
+        if (character >= 'a' && character <= 'z')
+        {
+            character -= 'a' - 'A';
+        }
+        if (character <= 32 || character >= hudSolidCharacter)
+        {
+            continue;
+        }
+        const uint32_t cell = character - 32;
+        const float u = float(cell % 16 * hudCell) / float(hudAtlasWidth);
+        const float v = float(cell / 16 * hudCell) / float(hudAtlasHeight);
+        addHudQuad(writer, x, y, 5.0f * hudTextScale, 7.0f * hudTextScale, u, v, u + 5.0f / float(hudAtlasWidth), v + 7.0f / float(hudAtlasHeight), color);
+    }
+}
+
+// two pixel columns per frame, the oldest on the left, 33 ms to the full height
+static constexpr float hudGraphColumn = 2.0f;
+static constexpr float hudGraphHeight = 64.0f;
+static constexpr float hudGraphMs = 100.0f / 3.0f;
+
+static float hudBarHeight(float ms)
+{
+    return std::min(hudGraphHeight, std::max(0.0f, ms) * (hudGraphHeight / hudGraphMs));
+}
+
+uint32_t layoutPerfHud(const PerfHudStats &stats, SpriteVertex *vertices)
+{
+    constexpr uint32_t white = hudColor(255, 255, 255, 255);
+    constexpr uint32_t frameColor = hudColor(150, 150, 150, 255);
+    constexpr uint32_t cpuColor = hudColor(90, 170, 255, 255);
+    constexpr uint32_t gpuColor = hudColor(255, 160, 60, 255);
+
+    constexpr uint32_t lineCount = 6;
+    char lines[lineCount][64];
+    snprintf(lines[0], sizeof(lines[0]), "FRAME %6.2f MS", meanMs(stats.frameMs, stats.cpuFrames));
+    snprintf(lines[1], sizeof(lines[1]), "CPU   %6.2f MS", meanMs(stats.cpuMs, stats.cpuFrames));
+    snprintf(lines[2], sizeof(lines[2]), "GPU   %6.2f MS", meanMs(stats.gpuMs, stats.gpuFrames));
+    snprintf(lines[3], sizeof(lines[3]), "HUD GPU %.3f MS", stats.hudGpuMs);
+    snprintf(lines[4], sizeof(lines[4]), "%s  %u IMAGES", stats.presentMode, stats.swapChainImages);
+    if (stats.gpuBudgetBytes > 0)
+    {
+        snprintf(lines[5], sizeof(lines[5]), "RSS %u MB  GPU %u/%u MB", uint32_t(stats.residentBytes >> 20), uint32_t(stats.gpuMemoryBytes >> 20), uint32_t(stats.gpuBudgetBytes >> 20));
+    }
+    else
+    {
+        snprintf(lines[5], sizeof(lines[5]), "RSS %u MB", uint32_t(stats.residentBytes >> 20));
+    }
+    const uint32_t lineColors[lineCount] = { frameColor, cpuColor, gpuColor, white, white, white };
+
+    constexpr float graphWidth = hudGraphColumn * PerfHudStats::History;
+    constexpr float margin = 8.0f;
+    constexpr float padding = 8.0f;
+
+    size_t longestLine = 0;
+    for (const char *line : lines)
+    {
+        longestLine = std::max(longestLine, strlen(line));
+    }
+    const float contentWidth = std::max(graphWidth, float(longestLine) * hudAdvance);
+    const float textHeight = float(lineCount) * hudLineHeight;
+
+    HudWriter writer = { vertices };
+    addHudRect(writer, margin, margin, contentWidth + 2.0f * padding, textHeight + hudGraphHeight + 3.0f * padding, hudColor(16, 16, 16, 176));
+
+    const float left = margin + padding;
+    for (uint32_t line = 0; line < lineCount; ++line)
+    {
+        addHudText(writer, left, margin + padding + float(line) * hudLineHeight, lines[line], lineColors[line]);
+    }
+
+    const float graphBottom = margin + 2.0f * padding + textHeight + hudGraphHeight;
+    for (uint32_t column = 0; column < PerfHudStats::History; ++column)
+    {
+        const float x = left + float(column) * hudGraphColumn;
+        if (stats.cpuFrames + column >= PerfHudStats::History)
+        {
+            const uint32_t index = (stats.cpuFrames + column) % PerfHudStats::History;
+            const float frameHeight = hudBarHeight(stats.frameMs[index]);
+            const float cpuHeight = hudBarHeight(stats.cpuMs[index]);
+            addHudRect(writer, x, graphBottom - frameHeight, hudGraphColumn, frameHeight, frameColor);
+            addHudRect(writer, x, graphBottom - cpuHeight, 1.0f, cpuHeight, cpuColor);
+        }
+        if (stats.gpuFrames + column >= PerfHudStats::History)
+        {
+            const float gpuHeight = hudBarHeight(stats.gpuMs[(stats.gpuFrames + column) % PerfHudStats::History]);
+            addHudRect(writer, x + 1.0f, graphBottom - gpuHeight, 1.0f, gpuHeight, gpuColor);
+        }
+    }
+    // the 60 Hz frame budget
+    addHudRect(writer, left, graphBottom - hudBarHeight(1000.0f / 60.0f), graphWidth, 1.0f, hudColor(255, 255, 255, 96));
+    return writer.quads;
+}
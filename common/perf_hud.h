@@ -0,0 +1,46 @@
+#pragma once
+
+#include "sprite_batch.h"
+
+#include <cstdint>
+#include <vector>
+
+// The HUD's baked font: 5x7 glyphs for space, digits, capitals and . : / - % ( ) in 8x8 cells of
+// a single channel coverage atlas, 16 cells to a row from ASCII 32. Lower case letters draw as
+// capitals and other characters as blanks. The cell of code 127 is solid, for panels and bars.
+constexpr uint32_t hudAtlasWidth = 128;
+constexpr uint32_t hudAtlasHeight = 48;
+
+// hudAtlasWidth * hudAtlasHeight bytes of coverage, rows top down
+std::vector<uint8_t> bakeHudAtlas();
+
+// What the HUD shows; the ditty's renderers fill it in every frame
+// CPU and GPU times arrive separately, since GPU times are only read back frames later.
+struct PerfHudStats
+{
+    static constexpr uint32_t History = 120;
+
+    float frameMs[History] = {};
+    float cpuMs[History] = {};
+    float gpuMs[History] = {};
+    // frames recorded, the next is written at % History
+    uint32_t cpuFrames = 0;
+    uint32_t gpuFrames = 0;
+    float hudGpuMs = 0.0f; // the HUD's own draw, last measured
+    const char *presentMode = "";
+    uint32_t swapChainImages = 0;
+    uint64_t residentBytes = 0;
+    uint64_t gpuMemoryBytes = 0; // 0 when the driver doesn't say
+    uint64_t gpuBudgetBytes = 0;
+};
+
+void addHudCpuFrame(PerfHudStats &stats, float frameMs, float cpuMs);
+
+void addHudGpuFrame(PerfHudStats &stats, float gpuMs, float hudMs);
+
+constexpr uint32_t hudMaxQuads = 1024;
+
+// Writes the HUD as quads in draw order at the top left of the framebuffer, y down, 4 vertices
+// each in writeSpriteQuad's order; vertices must hold hudMaxQuads quads and may be write-combined
+// memory. Returns the number of quads written.
+uint32_t layoutPerfHud(const PerfHudStats &stats, SpriteVertex *vertices);
@@ -0,0 +1,128 @@
+#include "procedural_texture.h"
+#include "bc_encoder.h"
+#include "image_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// VkFormat values, as stored in KTX2 containers
+static const uint32_t VkFormatR8G8B8A8Unorm = 37;
+static const uint32_t VkFormatBc1RgbaUnormBlock = 133;
+static const uint32_t VkFormatBc3UnormBlock = 137;
+static const uint32_t VkFormatBc7UnormBlock = 145;
+
+TextureEncoding textureEncodingFromName(const char *name)
+{
+    if (0 == strcmp(name, "rgba"))
+    {
+        return TextureEncoding::RGBA8;
+    }
+    if (0 == strcmp(name, "bc1"))
+    {
+        return TextureEncoding::BC1;
+    }
+    if (0 == strcmp(name, "bc3"))
+    {
+        return TextureEncoding::BC3;
+    }
+    if (0 == strcmp(name, "bc7"))
+    {
+        return TextureEncoding::BC7;
+    }
+    throw std::runtime_error(std::string("Unknown texture encoding ") + name);
+}
+
+static BcFormat bcFormatForEncoding(TextureEncoding encoding)
+{
+    switch (encoding)
+    {
+    case TextureEncoding::BC1:
+        return BcFormat::BC1;
+    case TextureEncoding::BC3:
+        return BcFormat::BC3;
+    default:
+        return BcFormat::BC7;
+    }
+}
+
+ProceduralTexture generateProceduralTexture(uint32_t size, TextureEncoding encoding, JobSystem *jobs)
+{
+    TRACE_FUNCTION();
+    ProceduralTexture texture;
+    texture.encoding = encoding;
+    texture.image.typeSize = 1;
+    texture.image.width = size;
+    texture.image.height = size;
+    texture.image.supercompressionScheme = 0;
+    switch (encoding)
+    {
+    case TextureEncoding::RGBA8:
+        texture.image.vkFormat = VkFormatR8G8B8A8Unorm;
+        break;
+    case TextureEncoding::BC1:
+        texture.image.vkFormat = VkFormatBc1RgbaUnormBlock;
+        break;
+    case TextureEncoding::BC3:
+        texture.image.vkFormat = VkFormatBc3UnormBlock;
+        break;
+    case TextureEncoding::BC7:
+        texture.image.vkFormat = VkFormatBc7UnormBlock;
+        break;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration encodeTime{};
+
+    std::vector<uint8_t> rgba = generateLightmap(size, size, 1);
+    uint32_t width = size;
+    uint32_t height = size;
+    while (true)
+    {
+        Ktx2Level level;
+        level.byteOffset = texture.data.size();
+        level.width = width;
+        level.height = height;
+
+        if (TextureEncoding::RGBA8 == encoding)
+        {
+            level.byteLength = rgba.size();
+            texture.data.insert(texture.data.end(), rgba.begin(), rgba.end());
+        }
+        else
+        {
+            const BcFormat format = bcFormatForEncoding(encoding);
+            level.byteLength = bcImageBytes(format, width, height);
+            texture.data.resize(texture.data.size() + size_t(level.byteLength));
+
+            const auto encodeStart = std::chrono::steady_clock::now();
+            encodeBc(format, rgba.data(), width, height, texture.data.data() + level.byteOffset, detectSimdLevel(), jobs);
+            encodeTime += std::chrono::steady_clock::now() - encodeStart;
+        }
+        texture.image.levels.push_back(level);
+
+        if (1 == width && 1 == height)
+        {
+            break;
+        }
+        rgba = downsampleRgba(rgba, width, height);
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+
+    const std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - start;
+    std::cout << "Generated " << size << "x" << size << " procedural texture with " << texture.image.levels.size() << " levels, "
+              << texture.data.size() << " bytes, in " << total.count() << "ms";
+    if (TextureEncoding::RGBA8 != encoding)
+    {
+        std::cout << " (" << std::chrono::duration<double, std::milli>(encodeTime).count() << "ms encoding "
+                  << bcFormatName(bcFormatForEncoding(encoding)) << " with " << simdLevelName(detectSimdLevel()) << ")";
+    }
+    std::cout << std::endl;
+
+    return texture;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "job_system.h"
+#include "ktx2.h"
+
+#include <cstdint>
+#include <vector>
+
+// How a runtime generated texture is stored for upload
+enum class TextureEncoding
+{
+    RGBA8,
+    BC1,
+    BC3,
+    BC7
+};
+
+// "rgba", "bc1", "bc3" or "bc7"; throws std::runtime_error for anything else
+TextureEncoding textureEncodingFromName(const char *name);
+
+// A full mip chain generated and encoded on the CPU, laid out like a KTX2 container's levels
+// so it can go through the same upload paths as a file
+struct ProceduralTexture
+{
+    TextureEncoding encoding;
+    Ktx2Image image;
+    std::vector<uint8_t> data;
+};
+
+// BC encoding is spread over jobs when given a job system
+ProceduralTexture generateProceduralTexture(uint32_t size, TextureEncoding encoding, JobSystem *jobs = nullptr);
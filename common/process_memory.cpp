@@ -0,0 +1,75 @@
+#include "process_memory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
+#elif !defined(_WIN32)
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+size_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss);
+#else
+    // kilobytes everywhere else
+    return size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+size_t currentResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (KERN_SUCCESS != task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count))
+    {
+        return 0;
+    }
+    return size_t(info.resident_size);
+#else
+    // the second field of statm is the resident set in pages
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (nullptr == statm)
+    {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int fields = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+    if (2 != fields)
+    {
+        return 0;
+    }
+    return size_t(resident) * size_t(sysconf(_SC_PAGESIZE));
+#endif
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+// high water mark of the resident set (working set on Windows) in bytes
+size_t peakResidentBytes();
+
+// the resident set (working set on Windows) now, in bytes; 0 where it can't be read
+size_t currentResidentBytes();
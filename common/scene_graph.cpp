@@ -0,0 +1,179 @@
+#include "scene_graph.h"
+#include "scene_graph_internal.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+namespace scene
+{
+    size_t updateWorldScalar(const NodeArrays &nodes, size_t begin, size_t end)
+    {
+        size_t updated = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const uint32_t parent = nodes.parent[i];
+            if (sceneNoParent != parent)
+            {
+                nodes.dirty[i] |= nodes.dirty[parent];
+            }
+            if (0 == nodes.dirty[i])
+            {
+                continue;
+            }
+            nodes.world[i] = sceneNoParent == parent ? nodes.local[i] : multiply(nodes.world[parent], nodes.local[i]);
+            ++updated;
+        }
+        return updated;
+    }
+}
+
+using UpdateKernel = size_t (*)(const scene::NodeArrays &nodes, size_t begin, size_t end);
+
+static UpdateKernel selectKernel(SimdLevel simd)
+{
+    simd = std::min(simd, detectSimdLevel());
+#ifdef DITTY_X86
+    if (SimdLevel::AVX2 == simd)
+    {
+        return scene::updateWorldAvx2;
+    }
+    if (SimdLevel::SSE41 == simd)
+    {
+        return scene::updateWorldSse41;
+    }
+#endif
+    return scene::updateWorldScalar;
+}
+
+SceneGraph createSceneGraph(const std::vector<uint32_t> &parents, const std::vector<Mat4> &locals)
+{
+    TRACE_FUNCTION();
+    const size_t count = parents.size();
+    if (locals.size() != count || count >= sceneNoParent)
+    {
+        throw std::runtime_error("Scene graph needs one local transform per node");
+    }
+
+    // children grouped by parent, so a breadth first walk from the roots visits each level in turn
+    std::vector<uint32_t> childStart(count + 1, 0);
+    for (uint32_t parent : parents)
+    {
+        if (sceneNoParent != parent)
+        {
+            if (parent >= count)
+            {
+                throw std::runtime_error("Scene graph node has an out of range parent");
+            }
+            ++childStart[parent + 1];
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        childStart[i + 1] += childStart[i];
+    }
+    std::vector<uint32_t> children(childStart[count]);
+    std::vector<uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+
+    SceneGraph graph;
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (sceneNoParent == parents[i])
+        {
+            order.push_back(i);
+        }
+        else
+        {
+            children[cursor[parents[i]]++] = i;
+        }
+    }
+
+    graph.levelStart.push_back(0);
+    for (size_t levelBegin = 0; levelBegin < order.size();)
+    {
+        const size_t levelEnd = order.size();
+        for (size_t i = levelBegin; i < levelEnd; ++i)
+        {
+            order.insert(order.end(), children.begin() + childStart[order[i]], children.begin() + childStart[order[i] + 1]);
+        }
+        graph.levelStart.push_back(uint32_t(levelEnd));
+        levelBegin = levelEnd;
+    }
+    // nodes on a cycle are never reached from a root
+    if (order.size() != count)
+    {
+        throw std::runtime_error("Scene graph parents form a cycle");
+    }
+
+    graph.sortedIndex.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        graph.sortedIndex[order[i]] = i;
+    }
+    graph.parent.resize(count);
+    graph.local.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t node = order[i];
+        graph.parent[i] = sceneNoParent == parents[node] ? sceneNoParent : graph.sortedIndex[parents[node]];
+        graph.local[i] = locals[node];
+    }
+    graph.world = graph.local;
+    graph.dirty.assign(count, 1);
+    return graph;
+}
+
+void setLocalTransform(SceneGraph &graph, uint32_t node, const Mat4 &local)
+{
+    const uint32_t index = graph.sortedIndex[node];
+    graph.local[index] = local;
+    graph.dirty[index] = 1;
+    const uint32_t level = uint32_t(std::upper_bound(graph.levelStart.begin(), graph.levelStart.end(), index) - graph.levelStart.begin()) - 1;
+    graph.firstDirtyLevel = std::min(graph.firstDirtyLevel, level);
+}
+
+size_t updateWorldTransforms(SceneGraph &graph, SimdLevel simd, JobSystem *jobs)
+{
+    TRACE_FUNCTION();
+    const UpdateKernel kernel = selectKernel(simd);
+    const scene::NodeArrays nodes = { graph.parent.data(), graph.local.data(), graph.world.data(), graph.dirty.data() };
+    const uint32_t levelCount = uint32_t(graph.levelStart.size()) - 1;
+
+    // a job's worth is a thousand or so nodes, several microseconds of matrix products
+    const size_t chunksPerJob = 16;
+    size_t updated = 0;
+    for (uint32_t level = graph.firstDirtyLevel; level < levelCount; ++level)
+    {
+        const size_t begin = graph.levelStart[level];
+        const size_t end = graph.levelStart[level + 1];
+        if (nullptr == jobs || end - begin <= chunksPerJob * sceneGraphChunk)
+        {
+            updated += kernel(nodes, begin, end);
+            continue;
+        }
+
+        // chunks are aligned to node indices rather than the level, the level's ends clip them
+        std::atomic<size_t> levelUpdated{0};
+        jobs->parallelFor(begin / sceneGraphChunk, (end + sceneGraphChunk - 1) / sceneGraphChunk, chunksPerJob, [&](size_t firstChunk, size_t lastChunk)
+        {
+            TRACE_ZONE("scene graph chunks");
+            const size_t first = std::max(begin, firstChunk * sceneGraphChunk);
+            const size_t last = std::min(end, lastChunk * sceneGraphChunk);
+            levelUpdated.fetch_add(kernel(nodes, first, last), std::memory_order_relaxed);
+        });
+        updated += levelUpdated.load(std::memory_order_relaxed);
+    }
+
+    // children read their parents' flags, so they're only cleared once every level is done
+    if (graph.firstDirtyLevel < levelCount)
+    {
+        const size_t first = graph.levelStart[graph.firstDirtyLevel];
+        memset(graph.dirty.data() + first, 0, graph.dirty.size() - first);
+    }
+    graph.firstDirtyLevel = levelCount;
+    return updated;
+}
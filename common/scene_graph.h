@@ -0,0 +1,50 @@
+#pragma once
+
+#include "cpu_features.h"
+#include "job_system.h"
+#include "transform_math.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr uint32_t sceneNoParent = UINT32_MAX;
+
+// nodes per unit of work; a chunk's dirty flags fill one cache line, so threads never write to the same one
+constexpr size_t sceneGraphChunk = 64;
+
+// A transform hierarchy held as structure-of-arrays, sorted breadth first from the roots
+// Every parent precedes its children, siblings are contiguous and each depth is one contiguous
+// level, so an update walks the arrays front to back and a level's nodes can be spread over
+// threads once the level above is done. Nodes are addressed by the ids they were created with.
+struct SceneGraph
+{
+    // indexed by sorted position
+    std::vector<uint32_t> parent; // sorted position, sceneNoParent for a root
+    std::vector<Mat4> local;
+    std::vector<Mat4> world;
+    // set when a local transform changes and, during an update, inherited from the parent
+    std::vector<uint8_t> dirty;
+
+    std::vector<uint32_t> levelStart; // one past the last level holds the node count
+    std::vector<uint32_t> sortedIndex; // node id to sorted position
+    // no level above this one has a dirty node
+    uint32_t firstDirtyLevel = 0;
+};
+
+// parents[i] is node i's parent id or sceneNoParent; throws if a parent is out of range or the
+// parents form a cycle. Every node starts dirty.
+SceneGraph createSceneGraph(const std::vector<uint32_t> &parents, const std::vector<Mat4> &locals);
+
+void setLocalTransform(SceneGraph &graph, uint32_t node, const Mat4 &local);
+
+// Recomputes the world transforms of dirty nodes and their descendants, returning how many
+// The scalar, SSE4.1 and AVX2 kernels give identical results; the requested SIMD level is clamped
+// to what the CPU supports. Levels with enough nodes are spread over jobs when given a job system,
+// otherwise everything runs on the calling thread.
+size_t updateWorldTransforms(SceneGraph &graph, SimdLevel simd, JobSystem *jobs = nullptr);
+
+inline const Mat4 &worldTransform(const SceneGraph &graph, uint32_t node)
+{
+    return graph.world[graph.sortedIndex[node]];
+}
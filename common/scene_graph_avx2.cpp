@@ -0,0 +1,58 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+
+#include "scene_graph.h"
+#include "scene_graph_internal.h"
+
+#include <immintrin.h>
+
+namespace scene
+{
+    // two result columns at once: each 128-bit lane broadcasts its own local column's element
+    static void multiplyAvx2(const Mat4 &a, const Mat4 &b, Mat4 &result)
+    {
+        const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m));
+        const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m + 4));
+        const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m + 8));
+        const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(a.m + 12));
+        for (int column = 0; column < 4; column += 2)
+        {
+            const __m256 b01 = _mm256_loadu_ps(b.m + column * 4);
+            __m256 sum = _mm256_mul_ps(a0, _mm256_permute_ps(b01, _MM_SHUFFLE(0, 0, 0, 0)));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, _mm256_permute_ps(b01, _MM_SHUFFLE(1, 1, 1, 1))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, _mm256_permute_ps(b01, _MM_SHUFFLE(2, 2, 2, 2))));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(a3, _mm256_permute_ps(b01, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm256_storeu_ps(result.m + column * 4, sum);
+        }
+    }
+
+    size_t updateWorldAvx2(const NodeArrays &nodes, size_t begin, size_t end)
+    {
+        size_t updated = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const uint32_t parent = nodes.parent[i];
+            if (sceneNoParent != parent)
+            {
+                nodes.dirty[i] |= nodes.dirty[parent];
+            }
+            if (0 == nodes.dirty[i])
+            {
+                continue;
+            }
+            if (sceneNoParent == parent)
+            {
+                nodes.world[i] = nodes.local[i];
+            }
+            else
+            {
+                multiplyAvx2(nodes.world[parent], nodes.local[i], nodes.world[i]);
+            }
+            ++updated;
+        }
+        return updated;
+    }
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// kernels behind updateWorldTransforms, which must agree exactly: each multiplies with the same
+// operation order as multiply in transform_math.h
+
+#include "cpu_features.h"
+#include "transform_math.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scene
+{
+    struct NodeArrays
+    {
+        const uint32_t *parent;
+        const Mat4 *local;
+        Mat4 *world;
+        uint8_t *dirty;
+    };
+
+    size_t updateWorldScalar(const NodeArrays &nodes, size_t begin, size_t end);
+
+#ifdef DITTY_X86
+    size_t updateWorldSse41(const NodeArrays &nodes, size_t begin, size_t end);
+    size_t updateWorldAvx2(const NodeArrays &nodes, size_t begin, size_t end);
+#endif
+}
@@ -0,0 +1,58 @@
+#include "cpu_features.h"
+
+#ifdef DITTY_X86
+
+#include "scene_graph.h"
+#include "scene_graph_internal.h"
+
+#include <smmintrin.h>
+
+namespace scene
+{
+    // a result column is the parent's columns weighted by the local column's elements, summed in order
+    static void multiplySse41(const Mat4 &a, const Mat4 &b, Mat4 &result)
+    {
+        const __m128 a0 = _mm_loadu_ps(a.m);
+        const __m128 a1 = _mm_loadu_ps(a.m + 4);
+        const __m128 a2 = _mm_loadu_ps(a.m + 8);
+        const __m128 a3 = _mm_loadu_ps(a.m + 12);
+        for (int column = 0; column < 4; ++column)
+        {
+            const float *b0 = b.m + column * 4;
+            __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(b0[0]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(b0[1])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(b0[2])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(b0[3])));
+            _mm_storeu_ps(result.m + column * 4, sum);
+        }
+    }
+
+    size_t updateWorldSse41(const NodeArrays &nodes, size_t begin, size_t end)
+    {
+        size_t updated = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const uint32_t parent = nodes.parent[i];
+            if (sceneNoParent != parent)
+            {
+                nodes.dirty[i] |= nodes.dirty[parent];
+            }
+            if (0 == nodes.dirty[i])
+            {
+                continue;
+            }
+            if (sceneNoParent == parent)
+            {
+                nodes.world[i] = nodes.local[i];
+            }
+            else
+            {
+                multiplySse41(nodes.world[parent], nodes.local[i], nodes.world[i]);
+            }
+            ++updated;
+        }
+        return updated;
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "sprite_batch.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+uint32_t spriteSortKey(const Sprite &sprite)
+{
+    if (sprite.page >= spriteMaxPages)
+    {
+        throw std::runtime_error("Sprite page " + std::to_string(sprite.page) + " is out of range");
+    }
+    return uint32_t(sprite.layer) << 16 | uint32_t(sprite.blend) << 14 | sprite.page;
+}
+
+uint32_t radixSortKeys(std::vector<uint64_t> &order, std::vector<uint64_t> &scratch)
+{
+    const size_t count = order.size();
+    scratch.resize(count);
+
+    // every pass's histogram from one read of the keys
+    uint32_t histograms[4][256] = {};
+    for (uint64_t entry : order)
+    {
+        const uint32_t key = uint32_t(entry >> 32);
+        ++histograms[0][key & 0xFF];
+        ++histograms[1][(key >> 8) & 0xFF];
+        ++histograms[2][(key >> 16) & 0xFF];
+        ++histograms[3][key >> 24];
+    }
+
+    uint32_t passes = 0;
+    for (uint32_t pass = 0; pass < 4; ++pass)
+    {
+        const uint32_t shift = 32 + 8 * pass;
+        uint32_t *histogram = histograms[pass];
+        if (count == 0 || histogram[(order[0] >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < 256; ++digit)
+        {
+            const uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (uint64_t entry : order)
+        {
+            scratch[histogram[(entry >> shift) & 0xFF]++] = entry;
+        }
+        order.swap(scratch);
+        ++passes;
+    }
+    return passes;
+}
+
+void sortSprites(SpriteBatcher &batcher)
+{
+    const size_t count = batcher.sprites.size();
+    if (count > UINT32_MAX)
+    {
+        throw std::runtime_error("Too many sprites to sort");
+    }
+    batcher.order.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        batcher.order[i] = uint64_t(spriteSortKey(batcher.sprites[i])) << 32 | i;
+    }
+    batcher.sortPasses = radixSortKeys(batcher.order, batcher.scratch);
+
+    // the layer is the top half of the key, so a run only breaks where page or blend change
+    batcher.batches.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Sprite &sprite = batcher.sprites[uint32_t(batcher.order[i])];
+        if (batcher.batches.empty() || batcher.batches.back().page != sprite.page || batcher.batches.back().blend != sprite.blend)
+        {
+            batcher.batches.push_back({ uint32_t(i), 0, sprite.page, sprite.blend });
+        }
+        ++batcher.batches.back().spriteCount;
+    }
+}
+
+void writeSpriteQuad(const Sprite &sprite, SpriteVertex *vertices)
+{
+    const float right = sprite.x + sprite.width;
+    const float bottom = sprite.y + sprite.height;
+    const SpriteVertex quad[4] = {
+        { sprite.x, sprite.y, sprite.u0, sprite.v0, sprite.color },
+        { right, sprite.y, sprite.u1, sprite.v0, sprite.color },
+        { right, bottom, sprite.u1, sprite.v1, sprite.color },
+        { sprite.x, bottom, sprite.u0, sprite.v1, sprite.color },
+    };
+    memcpy(vertices, quad, sizeof(quad));
+}
+
+void writeSpriteVertices(const SpriteBatcher &batcher, size_t begin, size_t end, SpriteVertex *vertices)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        writeSpriteQuad(batcher.sprites[uint32_t(batcher.order[i])], vertices);
+        vertices += 4;
+    }
+}
+
+void addSpriteField(SpriteBatcher &batcher, uint32_t count, uint16_t pages, float width, float height, double seconds)
+{
+    if (0 == pages)
+    {
+        throw std::runtime_error("A sprite field needs at least one page");
+    }
+    batcher.sprites.reserve(batcher.sprites.size() + count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // a cheap integer hash per sprite, so the field needs no stored state
+        uint32_t hash = i * 0x9E3779B1u;
+        hash ^= hash >> 15;
+        hash *= 0x85EBCA77u;
+        hash ^= hash >> 13;
+
+        const float size = 8.0f + float(hash & 31);
+        const float speed = 20.0f + float((hash >> 5) & 63);
+        const float angle = float(hash >> 11) * (6.2831853f / 2097152.0f);
+        const float travel = float(fmod(seconds * speed, double(width + height)));
+        const float x = fmodf(float((hash >> 3) % 4096) + travel * cosf(angle), width + size);
+        const float y = fmodf(float((hash >> 7) % 4096) + travel * sinf(angle), height + size);
+
+        Sprite sprite;
+        sprite.x = (x < 0.0f ? x + width + size : x) - size;
+        sprite.y = (y < 0.0f ? y + height + size : y) - size;
+        sprite.width = size;
+        sprite.height = size;
+        sprite.u0 = 0.0f;
+        sprite.v0 = 0.0f;
+        sprite.u1 = 1.0f;
+        sprite.v1 = 1.0f;
+        sprite.color = 0xFF000000u | (hash & 0x00FFFFFFu) | 0x00404040u;
+        sprite.layer = uint16_t((hash >> 24) & 15);
+        sprite.page = uint16_t(hash % pages);
+        sprite.blend = SpriteBlend((hash >> 20) % 3);
+        addSprite(batcher, sprite);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SpriteBlend : uint8_t
+{
+    Opaque,
+    Alpha,    // premultiplied
+    Additive,
+};
+
+// A textured quad in framebuffer pixels, y down, with its texture coordinates in its page
+struct Sprite
+{
+    float x, y, width, height;
+    float u0, v0, u1, v1;
+    uint32_t color; // RGBA8 with red in the low byte, multiplies the texel
+    uint16_t layer; // lower layers are drawn first
+    uint16_t page;  // which texture or atlas page, below spriteMaxPages
+    SpriteBlend blend;
+};
+
+constexpr uint32_t spriteMaxPages = 1u << 14;
+
+struct SpriteVertex
+{
+    float x, y;
+    float u, v;
+    uint32_t color;
+};
+
+// A run of sorted sprites sharing a page and blend state, drawn with one call
+struct SpriteBatch
+{
+    uint32_t firstSprite;
+    uint32_t spriteCount;
+    uint16_t page;
+    SpriteBlend blend;
+};
+
+// Sprites gathered over a frame, then sorted into the fewest runs of identical state
+// Sprites are ordered by layer, then blend, then page, so within a layer only sprites sharing a
+// page and blend keep their submission order; sprites whose overlap must be drawn in order need
+// different layers. Adjacent runs with the same state merge across layers. The arrays are kept
+// between frames, so a steady sprite count never allocates.
+struct SpriteBatcher
+{
+    std::vector<Sprite> sprites;
+    // sort key in the high half, sprite index in the low half
+    std::vector<uint64_t> order;
+    std::vector<uint64_t> scratch;
+    std::vector<SpriteBatch> batches;
+    uint32_t sortPasses = 0; // radix passes the last sort needed, of the 4 a 32 bit key can take
+};
+
+inline void clearSprites(SpriteBatcher &batcher)
+{
+    batcher.sprites.clear();
+}
+
+inline void addSprite(SpriteBatcher &batcher, const Sprite &sprite)
+{
+    batcher.sprites.push_back(sprite);
+}
+
+uint32_t spriteSortKey(const Sprite &sprite);
+
+// Stable LSD radix sort of the order entries on their high 32 bits, a byte per pass; passes in
+// which every key has the same byte are skipped, so keys spread over few layers, blends and pages
+// sort in one or two passes. Returns the number of passes taken.
+uint32_t radixSortKeys(std::vector<uint64_t> &order, std::vector<uint64_t> &scratch);
+
+// Sorts the sprites and fills batches
+void sortSprites(SpriteBatcher &batcher);
+
+// Writes a sprite's 4 vertices: top left, top right, bottom right, bottom left
+void writeSpriteQuad(const Sprite &sprite, SpriteVertex *vertices);
+
+// Writes the quads of sorted sprites [begin, end); vertices may be write-combined memory, it is
+// only written forwards
+void writeSpriteVertices(const SpriteBatcher &batcher, size_t begin, size_t end, SpriteVertex *vertices);
+
+// Appends a deterministic field of count sprites drifting over a width by height framebuffer at
+// time seconds, spread over pages, every blend and 16 layers; the workload of the ditty's
+// --sprites mode and the sprite benchmarks
+void addSpriteField(SpriteBatcher &batcher, uint32_t count, uint16_t pages, float width, float height, double seconds);
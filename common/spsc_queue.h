@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer single-consumer ring buffer
+// tryPush may only be called from one thread and tryPop from one (other) thread.
+// Each side caches the other side's index so that the shared cache lines are only
+// touched when the queue looks full or empty.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && 0 == (Capacity & (Capacity - 1)), "Capacity must be a power of two");
+
+public:
+    bool tryPush(const T &value)
+    {
+        const size_t tail = producerTail.load(std::memory_order_relaxed);
+        if (tail - cachedHead == Capacity)
+        {
+            cachedHead = consumerHead.load(std::memory_order_acquire);
+            if (tail - cachedHead == Capacity)
+            {
+                return false;
+            }
+        }
+        slots[tail & (Capacity - 1)] = value;
+        producerTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &value)
+    {
+        const size_t head = consumerHead.load(std::memory_order_relaxed);
+        if (head == cachedTail)
+        {
+            cachedTail = producerTail.load(std::memory_order_acquire);
+            if (head == cachedTail)
+            {
+                return false;
+            }
+        }
+        value = slots[head & (Capacity - 1)];
+        consumerHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // only a hint when called from the producer
+    bool empty() const
+    {
+        return consumerHead.load(std::memory_order_acquire) == producerTail.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    alignas(CacheLine) std::atomic<size_t> producerTail{0};
+    size_t cachedHead = 0;
+
+    alignas(CacheLine) std::atomic<size_t> consumerHead{0};
+    size_t cachedTail = 0;
+
+    alignas(CacheLine) T slots[Capacity];
+};
@@ -0,0 +1,78 @@
+#include "startup_timeline.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+StartupTimeline::StartupTimeline(Clock::time_point processStart)
+    : processStart(processStart)
+    , mainThread(std::this_thread::get_id())
+{
+}
+
+void StartupTimeline::record(const char *name, Clock::time_point begin, Clock::time_point end)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.push_back({ name, begin, end, std::this_thread::get_id() });
+}
+
+void StartupTimeline::firstFramePresented()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasFirstFrame)
+    {
+        firstFrame = Clock::now();
+        hasFirstFrame = true;
+    }
+}
+
+void StartupTimeline::report(std::ostream &stream) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Phase> sorted(phases);
+    std::sort(sorted.begin(), sorted.end(), [](const Phase &a, const Phase &b) { return a.begin < b.begin; });
+
+    const auto milliseconds = [](Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    // other threads are numbered in the order their first phase started
+    std::vector<std::thread::id> workers;
+    double phaseMs = 0.0;
+    Clock::time_point lastEnd = processStart;
+    stream << "Startup phases:" << std::endl;
+    for (const Phase &phase : sorted)
+    {
+        std::string thread = "main";
+        if (phase.thread != mainThread)
+        {
+            auto found = std::find(workers.begin(), workers.end(), phase.thread);
+            if (found == workers.end())
+            {
+                found = workers.insert(workers.end(), phase.thread);
+            }
+            thread = "worker " + std::to_string(found - workers.begin() + 1);
+        }
+        stream << "  " << std::left << std::setw(20) << phase.name << std::right << std::fixed << std::setprecision(2)
+               << " at " << std::setw(8) << milliseconds(phase.begin - processStart) << "ms, took " << std::setw(8)
+               << milliseconds(phase.end - phase.begin) << "ms on " << thread << std::endl;
+        phaseMs += milliseconds(phase.end - phase.begin);
+        lastEnd = std::max(lastEnd, phase.end);
+    }
+    stream.unsetf(std::ios::floatfield);
+    stream << std::setprecision(6);
+
+    const double wallMs = milliseconds(lastEnd - processStart);
+    stream << "Startup: " << phaseMs << "ms of phases in " << wallMs << "ms";
+    if (wallMs > 0.0)
+    {
+        stream << " (" << phaseMs / wallMs << "x overlap)";
+    }
+    stream << std::endl;
+    if (hasFirstFrame)
+    {
+        stream << "First frame presented " << milliseconds(firstFrame - processStart) << "ms after start" << std::endl;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "trace.h"
+
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// When each startup phase ran and on which thread, measured from the process start, and the
+// time until the first frame was presented
+// Phases may be recorded from any thread; the thread that constructs the timeline is reported
+// as the main thread.
+class StartupTimeline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StartupTimeline(Clock::time_point processStart);
+
+    // name must outlive the timeline, typically a string literal
+    void record(const char *name, Clock::time_point begin, Clock::time_point end);
+
+    // only the first call counts
+    void firstFramePresented();
+
+    void report(std::ostream &stream) const;
+
+private:
+    struct Phase
+    {
+        const char *name;
+        Clock::time_point begin;
+        Clock::time_point end;
+        std::thread::id thread;
+    };
+
+    Clock::time_point processStart;
+    std::thread::id mainThread;
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+    Clock::time_point firstFrame;
+    bool hasFirstFrame = false;
+};
+
+// Records the enclosing scope as a phase, and as a trace zone when tracing
+class StartupPhase
+{
+public:
+    StartupPhase(StartupTimeline &timeline, const char *name)
+        : timeline(timeline)
+        , name(name)
+        , begin(StartupTimeline::Clock::now())
+        , zone(name)
+    {
+    }
+
+    ~StartupPhase()
+    {
+        timeline.record(name, begin, StartupTimeline::Clock::now());
+    }
+
+    StartupPhase(const StartupPhase &) = delete;
+    StartupPhase &operator=(const StartupPhase &) = delete;
+
+private:
+    StartupTimeline &timeline;
+    const char *name;
+    StartupTimeline::Clock::time_point begin;
+    TraceScope zone;
+};
+
+// Calls function with args as a phase, returning its result
+template <typename Function, typename... Args>
+auto timePhase(StartupTimeline &timeline, const char *name, Function &&function, Args &&...args)
+{
+    StartupPhase phase(timeline, name);
+    return function(std::forward<Args>(args)...);
+}
@@ -0,0 +1,189 @@
+#include "trace.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::atomic<bool> traceEnabled{false};
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // only the owning thread appends; count and next are published for the writer
+    struct TraceChunk
+    {
+        static constexpr uint32_t capacity = 4096;
+
+        TraceEvent events[capacity];
+        std::atomic<uint32_t> count{0};
+        std::atomic<TraceChunk *> next{nullptr};
+    };
+
+    struct TraceThread
+    {
+        uint32_t id;
+        std::atomic<const char *> name{nullptr};
+        TraceChunk first;
+        TraceChunk *current = &first;
+    };
+
+    struct TraceState
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<TraceThread>> threads;
+        std::vector<TraceEvent> gpuEvents;
+        uint64_t startTime = 0;
+        uint64_t startTicks = 0;
+    };
+
+    TraceState &traceState()
+    {
+        // never destroyed, so threads that outlive main can still close their zones
+        static TraceState *state = new TraceState;
+        return *state;
+    }
+
+    thread_local TraceThread *currentThread = nullptr;
+}
+
+// registration is the only locked step, once per thread
+static TraceThread &threadBuffer()
+{
+    if (nullptr == currentThread)
+    {
+        TraceState &state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.threads.push_back(std::make_unique<TraceThread>());
+        currentThread = state.threads.back().get();
+        currentThread->id = uint32_t(state.threads.size());
+    }
+    return *currentThread;
+}
+
+bool startTrace()
+{
+#ifdef DITTY_TRACE
+    TraceState &state = traceState();
+    state.startTime = traceNow();
+    state.startTicks = traceTicks();
+    traceEnabled.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void traceZone(const char *name, uint64_t start, uint64_t end)
+{
+    TraceThread &thread = threadBuffer();
+    TraceChunk *chunk = thread.current;
+    uint32_t count = chunk->count.load(std::memory_order_relaxed);
+    if (TraceChunk::capacity == count)
+    {
+        TraceChunk *next = new TraceChunk;
+        chunk->next.store(next, std::memory_order_release);
+        thread.current = chunk = next;
+        count = 0;
+    }
+    chunk->events[count] = {name, start, end};
+    chunk->count.store(count + 1, std::memory_order_release);
+}
+
+void traceThreadName(const char *name)
+{
+    threadBuffer().name.store(name, std::memory_order_release);
+}
+
+void traceGpuZone(const char *name, uint64_t start, uint64_t end)
+{
+    TraceState &state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.gpuEvents.push_back({name, start, end});
+}
+
+// maps a clock onto nanoseconds since the trace started
+struct TraceTimeBase
+{
+    uint64_t origin;
+    double nanosecondsPerTick;
+};
+
+static void writeEvent(std::ostream &stream, const TraceEvent &event, uint32_t threadId, TraceTimeBase base, bool &first)
+{
+    // timestamps are microseconds; events from before the trace started are clamped to it
+    const uint64_t start = event.start > base.origin ? uint64_t(double(event.start - base.origin) * base.nanosecondsPerTick) : 0;
+    const uint64_t end = event.end > base.origin ? uint64_t(double(event.end - base.origin) * base.nanosecondsPerTick) : 0;
+    stream << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId << ",\"ts\":" << double(start) / 1000.0
+           << ",\"dur\":" << double(end > start ? end - start : 0) / 1000.0 << "}";
+    first = false;
+}
+
+static void writeThreadName(std::ostream &stream, uint32_t threadId, const std::string &name, bool &first)
+{
+    stream << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":\"" << name << "\"}}";
+    first = false;
+}
+
+void writeTrace(const char *path)
+{
+    traceEnabled.store(false, std::memory_order_relaxed);
+
+    std::ofstream stream(path);
+    if (!stream)
+    {
+        throw std::runtime_error(std::string("Failed to open trace file ") + path);
+    }
+    stream.setf(std::ios::fixed);
+    stream.precision(3);
+
+    TraceState &state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    // the tick rate over the whole recording, with traceNow read either side of the ticks
+    const uint64_t endTimeBefore = traceNow();
+    const uint64_t endTicks = traceTicks();
+    const uint64_t endTime = endTimeBefore + (traceNow() - endTimeBefore) / 2;
+    const TraceTimeBase tickBase = { state.startTicks, endTicks > state.startTicks ? double(endTime - state.startTime) / double(endTicks - state.startTicks) : 1.0 };
+    const TraceTimeBase timeBase = { state.startTime, 1.0 };
+
+    bool first = true;
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (const std::unique_ptr<TraceThread> &thread : state.threads)
+    {
+        const char *name = thread->name.load(std::memory_order_acquire);
+        writeThreadName(stream, thread->id, nullptr != name ? name : "thread " + std::to_string(thread->id), first);
+        for (const TraceChunk *chunk = &thread->first; nullptr != chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            const uint32_t count = chunk->count.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                writeEvent(stream, chunk->events[i], thread->id, tickBase, first);
+            }
+        }
+    }
+
+    // after every CPU thread's id
+    const uint32_t gpuThreadId = 1000000;
+    if (!state.gpuEvents.empty())
+    {
+        writeThreadName(stream, gpuThreadId, "GPU", first);
+    }
+    for (const TraceEvent &event : state.gpuEvents)
+    {
+        writeEvent(stream, event, gpuThreadId, timeBase, first);
+    }
+    stream << "\n]}\n";
+    if (!stream)
+    {
+        throw std::runtime_error(std::string("Failed to write trace file ") + path);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "cpu_features.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#if defined(DITTY_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Timeline of CPU zones from every thread, and GPU zones converted to the same clock, written as
+// Chrome trace-event JSON that opens in Perfetto (ui.perfetto.dev) or chrome://tracing
+// The TRACE_ macros only record when the build defines DITTY_TRACE (-DDITTY_TRACE=ON), otherwise
+// they expand to nothing. Each thread appends to its own buffer without locking; a zone costs
+// two timestamp counter reads and a store.
+
+// Nanoseconds on the clock every zone is recorded against
+inline uint64_t traceNow()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Zone timestamps: the processor's timestamp counter where there is one, as it reads in a few
+// nanoseconds, otherwise traceNow. Converted to traceNow's clock when the trace is written.
+inline uint64_t traceTicks()
+{
+#if defined(DITTY_X86) && defined(_MSC_VER)
+    return __rdtsc();
+#elif defined(DITTY_X86)
+    return __builtin_ia32_rdtsc();
+#else
+    return traceNow();
+#endif
+}
+
+// Starts recording; returns false, recording nothing, when tracing is compiled out
+bool startTrace();
+
+extern std::atomic<bool> traceEnabled;
+
+inline bool traceRecording()
+{
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+// Stops recording and writes everything recorded so far; throws std::runtime_error if the
+// file can't be written. The buffers are kept, as other threads may still be closing zones.
+void writeTrace(const char *path);
+
+// start and end are traceTicks; name must outlive the trace, typically a string literal or __func__
+void traceZone(const char *name, uint64_t start, uint64_t end);
+
+// Names the calling thread's track; unnamed threads are numbered
+void traceThreadName(const char *name);
+
+// GPU work on its own track; start and end already converted to traceNow's clock
+void traceGpuZone(const char *name, uint64_t start, uint64_t end);
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : name(traceRecording() ? name : nullptr)
+        , start(nullptr != this->name ? traceTicks() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (nullptr != name)
+        {
+            traceZone(name, start, traceTicks());
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#define DITTY_TRACE_JOIN_(a, b) a##b
+#define DITTY_TRACE_JOIN(a, b) DITTY_TRACE_JOIN_(a, b)
+
+#ifdef DITTY_TRACE
+#define TRACE_ZONE(name) TraceScope DITTY_TRACE_JOIN(traceScope, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_ZONE(__func__)
+#define TRACE_THREAD(name) traceThreadName(name)
+#else
+#define TRACE_ZONE(name)
+#define TRACE_FUNCTION()
+#define TRACE_THREAD(name)
+#endif
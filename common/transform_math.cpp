@@ -0,0 +1,97 @@
+#include "transform_math.h"
+
+#include <cmath>
+
+static_assert(multiply(translation(1.0f, 2.0f, 3.0f), uniformScale(2.0f)).m[13] == 2.0f, "matrix helpers must stay usable in constant expressions");
+
+Mat4 rotationY(float radians)
+{
+    const float c = std::cos(radians);
+    const float s = std::sin(radians);
+    Mat4 result = identityMatrix();
+    result.m[0] = c;
+    result.m[2] = -s;
+    result.m[8] = s;
+    result.m[10] = c;
+    return result;
+}
+
+static void normalize3(float v[3])
+{
+    const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    for (int i = 0; i < 3; ++i)
+    {
+        v[i] /= length;
+    }
+}
+
+static void cross3(const float a[3], const float b[3], float result[3])
+{
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+Mat4 lookAt(const float eye[3], const float target[3], const float up[3])
+{
+    float forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+    normalize3(forward);
+    float side[3];
+    cross3(forward, up, side);
+    normalize3(side);
+    float realUp[3];
+    cross3(side, forward, realUp);
+
+    Mat4 view = {};
+    for (int i = 0; i < 3; ++i)
+    {
+        view.m[i * 4 + 0] = side[i];
+        view.m[i * 4 + 1] = realUp[i];
+        view.m[i * 4 + 2] = -forward[i];
+    }
+    view.m[12] = -(side[0] * eye[0] + side[1] * eye[1] + side[2] * eye[2]);
+    view.m[13] = -(realUp[0] * eye[0] + realUp[1] * eye[1] + realUp[2] * eye[2]);
+    view.m[14] = forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2];
+    view.m[15] = 1.0f;
+    return view;
+}
+
+Mat4 perspectiveVulkan(float verticalFov, float aspect, float nearPlane, float farPlane)
+{
+    const float focal = 1.0f / std::tan(verticalFov * 0.5f);
+
+    Mat4 projection = {};
+    projection.m[0] = focal / aspect;
+    projection.m[5] = -focal;
+    projection.m[10] = farPlane / (nearPlane - farPlane);
+    projection.m[11] = -1.0f;
+    projection.m[14] = nearPlane * farPlane / (nearPlane - farPlane);
+    return projection;
+}
+
+void frustumPlanes(const Mat4 &viewProjection, float planes[6][4])
+{
+    auto row = [&viewProjection](int r, int c)
+    {
+        return viewProjection.m[c * 4 + r];
+    };
+
+    for (int c = 0; c < 4; ++c)
+    {
+        planes[0][c] = row(3, c) + row(0, c); // left
+        planes[1][c] = row(3, c) - row(0, c); // right
+        planes[2][c] = row(3, c) + row(1, c); // top or bottom, as y is flipped
+        planes[3][c] = row(3, c) - row(1, c);
+        planes[4][c] = row(2, c);             // near
+        planes[5][c] = row(3, c) - row(2, c); // far
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        const float length = std::sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+        for (int c = 0; c < 4; ++c)
+        {
+            planes[i][c] /= length;
+        }
+    }
+}
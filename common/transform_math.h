@@ -0,0 +1,71 @@
+#pragma once
+
+// Minimal column-major 4x4 matrix helpers for the scene paths, matching GLSL's layout
+// Everything that doesn't need trigonometry or a square root is constexpr, so fixed transforms
+// can be built at compile time.
+struct Mat4
+{
+    float m[16]; // m[column * 4 + row]
+};
+
+constexpr Mat4 identityMatrix()
+{
+    Mat4 result = {};
+    for (int i = 0; i < 4; ++i)
+    {
+        result.m[i * 4 + i] = 1.0f;
+    }
+    return result;
+}
+
+constexpr Mat4 translation(float x, float y, float z)
+{
+    Mat4 result = identityMatrix();
+    result.m[12] = x;
+    result.m[13] = y;
+    result.m[14] = z;
+    return result;
+}
+
+constexpr Mat4 uniformScale(float scale)
+{
+    Mat4 result = {};
+    for (int i = 0; i < 3; ++i)
+    {
+        result.m[i * 4 + i] = scale;
+    }
+    result.m[15] = 1.0f;
+    return result;
+}
+
+// Each element sums its four products in order, starting from the first rather than from zero,
+// which the SIMD scene graph kernels reproduce exactly
+constexpr Mat4 multiply(const Mat4 &a, const Mat4 &b)
+{
+    Mat4 result = {};
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float sum = a.m[row] * b.m[column * 4];
+            for (int k = 1; k < 4; ++k)
+            {
+                sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+            }
+            result.m[column * 4 + row] = sum;
+        }
+    }
+    return result;
+}
+
+// about the y axis, counter-clockwise looking down it
+Mat4 rotationY(float radians);
+
+Mat4 lookAt(const float eye[3], const float target[3], const float up[3]);
+
+// right handed, depth 0 at near to 1 at far and y down in clip space, as Vulkan expects
+Mat4 perspectiveVulkan(float verticalFov, float aspect, float nearPlane, float farPlane);
+
+// The six clip planes of a view-projection matrix with [0, 1] depth, normalised so a point
+// p is inside plane i when dot(planes[i].xyz, p) + planes[i].w >= 0
+void frustumPlanes(const Mat4 &viewProjection, float planes[6][4]);
@@ -0,0 +1,91 @@
+#include "window_events.h"
+#include "trace.h"
+
+#include <GLFW/glfw3.h>
+
+static void forwardEvent(GLFWwindow *window, WindowEvent event)
+{
+    event.timestamp = std::chrono::steady_clock::now();
+    static_cast<EventChannel *>(glfwGetWindowUserPointer(window))->push(event);
+}
+
+void installEventCallbacks(GLFWwindow *window, EventChannel &channel)
+{
+    glfwSetWindowUserPointer(window, &channel);
+    glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int, int action, int mods)
+    {
+        WindowEvent event{WindowEvent::Type::Key};
+        event.code = key;
+        event.action = action;
+        event.mods = mods;
+        forwardEvent(window, event);
+    });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow *window, int button, int action, int mods)
+    {
+        WindowEvent event{WindowEvent::Type::MouseButton};
+        event.code = button;
+        event.action = action;
+        event.mods = mods;
+        forwardEvent(window, event);
+    });
+    glfwSetCursorPosCallback(window, [](GLFWwindow *window, double x, double y)
+    {
+        WindowEvent event{WindowEvent::Type::CursorPos};
+        event.x = x;
+        event.y = y;
+        forwardEvent(window, event);
+    });
+    glfwSetScrollCallback(window, [](GLFWwindow *window, double x, double y)
+    {
+        WindowEvent event{WindowEvent::Type::Scroll};
+        event.x = x;
+        event.y = y;
+        forwardEvent(window, event);
+    });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow *window, int width, int height)
+    {
+        WindowEvent event{WindowEvent::Type::FramebufferSize};
+        event.x = width;
+        event.y = height;
+        forwardEvent(window, event);
+    });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow *window)
+    {
+        forwardEvent(window, WindowEvent{WindowEvent::Type::Refresh});
+    });
+}
+
+void pumpEvents(const FrameScheduler &scheduler)
+{
+    TRACE_FUNCTION();
+    const double timeout = scheduler.waitTimeout();
+    if (timeout < 0.0)
+    {
+        glfwWaitEvents();
+    }
+    else if (timeout > 0.0)
+    {
+        glfwWaitEventsTimeout(timeout);
+    }
+    else
+    {
+        glfwPollEvents();
+    }
+}
+
+void drainEvents(EventChannel &channel, FrameScheduler &scheduler, FrameStats &frameStats, FramebufferSize *framebufferSize)
+{
+    WindowEvent event;
+    while (channel.tryPop(event))
+    {
+        if (WindowEvent::Type::FramebufferSize == event.type && nullptr != framebufferSize)
+        {
+            framebufferSize->width = int(event.x);
+            framebufferSize->height = int(event.y);
+        }
+
+        // every event currently invalidates the whole window
+        scheduler.invalidate();
+        frameStats.eventReceived(event.timestamp);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "event_channel.h"
+#include "frame_scheduler.h"
+#include "frame_stats.h"
+
+// GLFW event plumbing shared by the ditties; built into each ditty rather than ditty_common,
+// which doesn't link glfw
+
+struct GLFWwindow;
+
+struct FramebufferSize
+{
+    int width = 0;
+    int height = 0;
+};
+
+// Forwards the window's input, resize and refresh callbacks into channel; the callbacks run
+// on whichever thread pumps GLFW, which must be the main thread
+void installEventCallbacks(GLFWwindow *window, EventChannel &channel);
+
+// Main thread only; blocks in GLFW for as long as the scheduler allows
+void pumpEvents(const FrameScheduler &scheduler);
+
+// Consumer side of the channel, on whichever thread renders; resize events update
+// framebufferSize, as glfwGetFramebufferSize may only be called on the main thread
+void drainEvents(EventChannel &channel, FrameScheduler &scheduler, FrameStats &frameStats, FramebufferSize *framebufferSize = nullptr);
@@ -0,0 +1,365 @@
+#include "job_system.h"
+#include "work_stealing_deque.h"
+
+#include <algorithm>
+
+struct JobWorker
+{
+    JobSystem *system;
+    unsigned index;
+    WorkStealingDeque<Job, 4096> deque;
+    std::thread thread;
+    uint32_t randomState;
+
+    // jobs this thread allocated; free ones come back to the local list when freed on this
+    // thread, and through the returned stack from any other thread
+    Job *freeJobs = nullptr;
+    std::atomic<Job *> returnedJobs{nullptr};
+};
+
+static thread_local JobWorker *threadWorker = nullptr;
+
+unsigned JobSystem::defaultWorkerThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency()) - 1;
+}
+
+JobSystem::JobSystem(unsigned workerThreads) : mainThread(std::this_thread::get_id())
+{
+    for (unsigned i = 0; i <= workerThreads; ++i)
+    {
+        workers.push_back(std::make_unique<JobWorker>());
+        workers.back()->system = this;
+        workers.back()->index = i;
+        workers.back()->randomState = 0x9e3779b9u * (i + 1);
+    }
+
+    threadWorker = workers[0].get();
+    for (unsigned i = 1; i <= workerThreads; ++i)
+    {
+        JobWorker *worker = workers[i].get();
+        worker->thread = std::thread([this, worker]()
+        {
+            threadWorker = worker;
+            workerLoop(worker);
+        });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping.store(true, std::memory_order_seq_cst);
+    }
+    sleepCondition.notify_all();
+
+    for (auto &worker : workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+    if (workers[0].get() == threadWorker)
+    {
+        threadWorker = nullptr;
+    }
+
+    for (auto &worker : workers)
+    {
+        Job *job = worker->returnedJobs.exchange(nullptr, std::memory_order_acquire);
+        while (nullptr != job)
+        {
+            Job *next = job->next;
+            delete job;
+            job = next;
+        }
+        job = worker->freeJobs;
+        while (nullptr != job)
+        {
+            Job *next = job->next;
+            delete job;
+            job = next;
+        }
+    }
+}
+
+JobWorker *JobSystem::currentWorker() const
+{
+    return (nullptr != threadWorker && this == threadWorker->system) ? threadWorker : nullptr;
+}
+
+static Job *takeFreeJob(JobWorker *self)
+{
+    if (nullptr == self)
+    {
+        Job *job = new Job;
+        job->owner = nullptr;
+        return job;
+    }
+
+    if (nullptr == self->freeJobs)
+    {
+        self->freeJobs = self->returnedJobs.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    Job *job = self->freeJobs;
+    if (nullptr == job)
+    {
+        job = new Job;
+        job->owner = self;
+        return job;
+    }
+    self->freeJobs = job->next;
+    return job;
+}
+
+Job *JobSystem::allocateJob(JobCounter &counter)
+{
+    Job *job = takeFreeJob(currentWorker());
+    job->counter = &counter;
+    counter.pending.fetch_add(1);
+    return job;
+}
+
+void JobSystem::freeJob(Job *job)
+{
+    JobWorker *owner = job->owner;
+    if (nullptr == owner)
+    {
+        delete job;
+    }
+    else if (owner == currentWorker())
+    {
+        job->next = owner->freeJobs;
+        owner->freeJobs = job;
+    }
+    else
+    {
+        // pushes only, and the owner takes the whole stack at once, so there is no ABA problem
+        Job *head = owner->returnedJobs.load(std::memory_order_relaxed);
+        do
+        {
+            job->next = head;
+        } while (!owner->returnedJobs.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+
+void JobSystem::submit(Job *job)
+{
+    JobWorker *self = currentWorker();
+    if (nullptr != self)
+    {
+        if (!self->deque.push(job))
+        {
+            // the deque is full, so there is plenty for the others to steal already
+            execute(job);
+            return;
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(injectedMutex);
+        injected.push_back(job);
+        injectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeWorkers();
+}
+
+void JobSystem::submitToMainThread(Job *job)
+{
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadJobs.push_back(job);
+    mainThreadJobCount.fetch_add(1, std::memory_order_release);
+}
+
+void JobSystem::addDependent(JobCounter &counter, Job *job)
+{
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex);
+        if (0 != counter.pending.load())
+        {
+            job->next = counter.dependents;
+            counter.dependents = job;
+            return;
+        }
+    }
+    submit(job);
+}
+
+void JobSystem::execute(Job *job)
+{
+    job->invoke(*job);
+
+    JobCounter *counter = job->counter;
+    freeJob(job);
+
+    counter->finishing.fetch_add(1);
+    if (1 == counter->pending.fetch_sub(1))
+    {
+        Job *dependent = nullptr;
+        {
+            // more jobs may have been added since, in which case the last of those releases the dependents
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            if (0 == counter->pending.load())
+            {
+                dependent = counter->dependents;
+                counter->dependents = nullptr;
+            }
+        }
+        while (nullptr != dependent)
+        {
+            Job *next = dependent->next;
+            submit(dependent);
+            dependent = next;
+        }
+    }
+    counter->finishing.fetch_sub(1);
+}
+
+Job *JobSystem::findJob(JobWorker *self)
+{
+    if (nullptr != self)
+    {
+        if (Job *job = self->deque.pop())
+        {
+            return job;
+        }
+    }
+
+    if (injectedCount.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(injectedMutex);
+        if (!injected.empty())
+        {
+            Job *job = injected.front();
+            injected.pop_front();
+            injectedCount.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    // try every other deque once, starting from a random victim so thieves spread out
+    const size_t workerCount = workers.size();
+    size_t start = 0;
+    if (nullptr != self)
+    {
+        self->randomState ^= self->randomState << 13;
+        self->randomState ^= self->randomState >> 17;
+        self->randomState ^= self->randomState << 5;
+        start = self->randomState % workerCount;
+    }
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        JobWorker *victim = workers[(start + i) % workerCount].get();
+        if (victim != self)
+        {
+            if (Job *job = victim->deque.steal())
+            {
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool JobSystem::hasWork() const
+{
+    if (injectedCount.load(std::memory_order_relaxed) > 0)
+    {
+        return true;
+    }
+    for (const auto &worker : workers)
+    {
+        if (!worker->deque.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::wakeWorkers()
+{
+    // pairs with the fence in workerLoop(): either the worker sees the new job before
+    // sleeping, or we see that it is sleeping and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepCondition.notify_one();
+    }
+}
+
+void JobSystem::workerLoop(JobWorker *self)
+{
+    unsigned idleSpins = 0;
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        if (Job *job = findJob(self))
+        {
+            execute(job);
+            idleSpins = 0;
+            continue;
+        }
+
+        // spin a little first, as frames tend to submit work in bursts
+        if (++idleSpins < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!hasWork() && !stopping.load(std::memory_order_relaxed))
+        {
+            sleepCondition.wait(lock);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idleSpins = 0;
+    }
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+    JobWorker *self = currentWorker();
+    const bool isMainThread = std::this_thread::get_id() == mainThread;
+    while (!counter.done())
+    {
+        if (isMainThread)
+        {
+            runMainThreadJobs();
+        }
+
+        if (Job *job = findJob(self))
+        {
+            execute(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::runMainThreadJobs()
+{
+    while (mainThreadJobCount.load(std::memory_order_acquire) > 0)
+    {
+        Job *job;
+        {
+            std::lock_guard<std::mutex> lock(mainThreadMutex);
+            if (mainThreadJobs.empty())
+            {
+                return;
+            }
+            job = mainThreadJobs.front();
+            mainThreadJobs.pop_front();
+            mainThreadJobCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+        execute(job);
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobSystem;
+struct JobWorker;
+
+// A callable stored inline, so scheduling a job never allocates once the pools are warm
+struct Job
+{
+    static constexpr size_t StorageSize = 64;
+
+    void (*invoke)(Job &job);
+    alignas(std::max_align_t) unsigned char storage[StorageSize];
+    class JobCounter *counter;
+    JobWorker *owner; // pool the job returns to, null for jobs created outside the system's threads
+    Job *next;        // free list and dependent list link
+};
+
+// Counts unfinished jobs; wait on it, or make more jobs depend on it
+// A counter may be reused once it has been waited on, but must outlive its jobs and dependents.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    // true once every job has finished and its dependents have been released
+    bool done() const
+    {
+        return 0 == pending.load() && 0 == finishing.load();
+    }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending{0};
+    // threads between decrementing pending and their last touch of the counter, so a waiter
+    // never returns, and lets the counter go out of scope, while one is still using it
+    std::atomic<uint32_t> finishing{0};
+    std::mutex mutex;
+    Job *dependents = nullptr;
+};
+
+// Work-stealing job system
+// Each worker thread, and the thread that created the system (the main thread), owns a
+// Chase-Lev deque; jobs run from their own deque first and steal from the others when it is
+// empty. Threads outside the system can submit jobs too, through a shared queue. Jobs that must
+// run on the main thread, such as anything touching GLFW or a GL context, go in a separate queue
+// that only the main thread services, from wait() and runMainThreadJobs().
+// Jobs must not throw.
+class JobSystem
+{
+public:
+    // one worker per hardware thread besides the main thread
+    static unsigned defaultWorkerThreads();
+
+    // workerThreads in addition to the main thread, which is whichever thread constructs the system
+    explicit JobSystem(unsigned workerThreads = defaultWorkerThreads());
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // threads that run jobs, including the main thread
+    unsigned threadCount() const { return unsigned(workers.size()); }
+
+    template <typename Function>
+    void run(JobCounter &counter, Function &&function)
+    {
+        submit(createJob(counter, std::forward<Function>(function)));
+    }
+
+    // runs once every job counted by dependency has finished
+    template <typename Function>
+    void runAfter(JobCounter &dependency, JobCounter &counter, Function &&function)
+    {
+        addDependent(dependency, createJob(counter, std::forward<Function>(function)));
+    }
+
+    template <typename Function>
+    void runOnMainThread(JobCounter &counter, Function &&function)
+    {
+        submitToMainThread(createJob(counter, std::forward<Function>(function)));
+    }
+
+    // runs other jobs until the counter's jobs have finished
+    void wait(JobCounter &counter);
+
+    // main thread only; runs the main thread jobs queued so far
+    void runMainThreadJobs();
+
+    // Calls function(rangeBegin, rangeEnd) over [begin, end) in pieces of at most grain, returning when all are done
+    // The range is split in halves recursively, leaving the larger halves near the top of the
+    // deque for other threads to steal, so the scheduling cost grows with the threads involved
+    // rather than with the number of pieces.
+    template <typename Function>
+    void parallelFor(size_t begin, size_t end, size_t grain, const Function &function)
+    {
+        JobCounter counter;
+        parallelForRange(counter, begin, end, grain > 0 ? grain : 1, &function);
+        wait(counter);
+    }
+
+private:
+    template <typename Function>
+    Job *createJob(JobCounter &counter, Function &&function)
+    {
+        using Callable = std::decay_t<Function>;
+        static_assert(sizeof(Callable) <= Job::StorageSize, "job captures too much, capture a pointer instead");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "job callable is over-aligned");
+
+        Job *job = allocateJob(counter);
+        new (job->storage) Callable(std::forward<Function>(function));
+        job->invoke = [](Job &job)
+        {
+            Callable *callable = std::launder(reinterpret_cast<Callable *>(job.storage));
+            (*callable)();
+            callable->~Callable();
+        };
+        return job;
+    }
+
+    template <typename Function>
+    void parallelForRange(JobCounter &counter, size_t begin, size_t end, size_t grain, const Function *function)
+    {
+        while (end - begin > grain)
+        {
+            const size_t middle = begin + (end - begin) / 2;
+            run(counter, [this, &counter, middle, end, grain, function]()
+            {
+                parallelForRange(counter, middle, end, grain, function);
+            });
+            end = middle;
+        }
+        (*function)(begin, end);
+    }
+
+    JobWorker *currentWorker() const;
+    // a job counted by counter, with its callable still to be constructed
+    Job *allocateJob(JobCounter &counter);
+    void freeJob(Job *job);
+    void submit(Job *job);
+    void submitToMainThread(Job *job);
+    void addDependent(JobCounter &counter, Job *job);
+    void execute(Job *job);
+    Job *findJob(JobWorker *self);
+    bool hasWork() const;
+    void wakeWorkers();
+    void workerLoop(JobWorker *self);
+
+    std::vector<std::unique_ptr<JobWorker>> workers; // workers[0] is the main thread
+    std::thread::id mainThread;
+
+    // jobs from threads outside the system
+    std::mutex injectedMutex;
+    std::deque<Job *> injected;
+    std::atomic<size_t> injectedCount{0};
+
+    std::mutex mainThreadMutex;
+    std::deque<Job *> mainThreadJobs;
+    std::atomic<size_t> mainThreadJobCount{0};
+
+    // idle workers park here; submitters only touch the mutex while someone is parked
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<unsigned> sleepers{0};
+    std::atomic<bool> stopping{false};
+};
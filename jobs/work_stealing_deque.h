@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded Chase-Lev work-stealing deque of pointers
+// The owning thread pushes and pops at the bottom, LIFO, so it works on what is hot in its
+// cache; any other thread may steal from the top, FIFO, taking the oldest and typically largest
+// pieces of work. Only the last element is ever contended, and then settled by one CAS on top.
+// Memory orders follow Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models".
+template <typename T, size_t Capacity>
+class WorkStealingDeque
+{
+    static_assert(Capacity >= 2 && 0 == (Capacity & (Capacity - 1)), "Capacity must be a power of two");
+
+public:
+    // owner only; returns false if the deque is full
+    bool push(T *value)
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= int64_t(Capacity))
+        {
+            return false;
+        }
+        slots[b & (Capacity - 1)].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // owner only; null if empty
+    T *pop()
+    {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *value = slots[b & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // the last element; race any thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                value = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // any thread; null if empty or another thread won the race for the top element
+    T *steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return nullptr;
+        }
+
+        T *value = slots[t & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+        return value;
+    }
+
+    // only a hint when called from a thief
+    bool empty() const
+    {
+        return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    alignas(CacheLine) std::atomic<int64_t> top{0};
+    alignas(CacheLine) std::atomic<int64_t> bottom{0};
+    alignas(CacheLine) std::atomic<T *> slots[Capacity];
+};
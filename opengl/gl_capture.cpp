@@ -0,0 +1,690 @@
+#include "gl_capture.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// every entry point in the gl:: table, each wrapped by a capture function of the same name
+#define DITTY_GL_CAPTURED_FUNCTIONS(X) \
+    X(BindTexture)                     \
+    X(BlendFunc)                       \
+    X(Clear)                           \
+    X(ClearColor)                      \
+    X(DeleteTextures)                  \
+    X(Disable)                         \
+    X(DrawArrays)                      \
+    X(DrawElements)                    \
+    X(Enable)                          \
+    X(Finish)                          \
+    X(Flush)                           \
+    X(GenTextures)                     \
+    X(GetString)                       \
+    X(PixelStorei)                     \
+    X(TexImage2D)                      \
+    X(TexParameteri)                   \
+    X(Viewport)                        \
+    X(CompressedTexImage2D)            \
+    X(CreateShader)                    \
+    X(ShaderSource)                    \
+    X(CompileShader)                   \
+    X(GetShaderiv)                     \
+    X(GetShaderInfoLog)                \
+    X(DeleteShader)                    \
+    X(CreateProgram)                   \
+    X(AttachShader)                    \
+    X(LinkProgram)                     \
+    X(GetProgramiv)                    \
+    X(GetProgramInfoLog)               \
+    X(UseProgram)                      \
+    X(GetUniformLocation)              \
+    X(Uniform4f)                       \
+    X(DeleteProgram)                   \
+    X(GenVertexArrays)                 \
+    X(BindVertexArray)                 \
+    X(DeleteVertexArrays)              \
+    X(GenQueries)                      \
+    X(DeleteQueries)                   \
+    X(QueryCounter)                    \
+    X(GetQueryObjectiv)                \
+    X(GetQueryObjectui64v)             \
+    X(GetInteger64v)                   \
+    X(FenceSync)                       \
+    X(WaitSync)                        \
+    X(DeleteSync)                      \
+    X(ClientWaitSync)                  \
+    X(GenBuffers)                      \
+    X(DeleteBuffers)                   \
+    X(BindBuffer)                      \
+    X(BufferData)                      \
+    X(BufferSubData)                   \
+    X(MapBufferRange)                  \
+    X(UnmapBuffer)                     \
+    X(VertexAttribPointer)             \
+    X(EnableVertexAttribArray)         \
+    X(BufferStorage)
+
+// the driver's functions, as loaded before wrapping
+namespace real
+{
+#define DITTY_GL_DECLARE(name) static decltype(gl::name) name;
+    DITTY_GL_CAPTURED_FUNCTIONS(DITTY_GL_DECLARE)
+#undef DITTY_GL_DECLARE
+}
+
+namespace
+{
+    struct Blob
+    {
+        const void *data;
+        uint32_t size;
+    };
+
+    // a buffer range the ditty is writing through, recorded when it's unmapped
+    struct Mapping
+    {
+        void *data;
+        uint32_t size;
+        GLbitfield access;
+        // a persistent mapping's bytes as last recorded, empty until the first draw after mapping
+        std::vector<uint8_t> recorded;
+    };
+
+    struct Capture
+    {
+        std::string path;
+        std::ofstream stream;
+        std::vector<uint8_t> buffer;
+        std::chrono::steady_clock::time_point start;
+        GLint unpackAlignment = 4;
+        std::unordered_map<GLenum, GLuint> boundBuffers;
+        std::unordered_map<GLuint, Mapping> mappings;
+        bool recording = false;
+
+        uint64_t calls = 0;
+        uint64_t frames = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+    Capture capture;
+}
+
+// calls are batched up to this size before reaching the file
+static constexpr size_t FlushBytes = 1 << 20;
+
+static void flushCapture()
+{
+    capture.stream.write(reinterpret_cast<const char *>(capture.buffer.data()), std::streamsize(capture.buffer.size()));
+    capture.bytesWritten += capture.buffer.size();
+    capture.buffer.clear();
+}
+
+template <typename Value>
+static void append(const Value &value)
+{
+    const size_t offset = capture.buffer.size();
+    capture.buffer.resize(offset + sizeof(Value));
+    memcpy(capture.buffer.data() + offset, &value, sizeof(Value));
+}
+
+static void append(const Blob &blob)
+{
+    append(blob.size);
+    const uint8_t *bytes = static_cast<const uint8_t *>(blob.data);
+    capture.buffer.insert(capture.buffer.end(), bytes, bytes + blob.size);
+}
+
+template <typename... Args>
+static void record(GlCall call, const Args &...args)
+{
+    if (!capture.recording)
+    {
+        return;
+    }
+    append(call);
+    (append(args), ...);
+    ++capture.calls;
+    if (capture.buffer.size() >= FlushBytes)
+    {
+        flushCapture();
+    }
+}
+
+// Records what changed in each persistent mapping since the last draw, as the draw may read it
+// without an unmap in between
+static void recordPersistentWrites()
+{
+    if (!capture.recording)
+    {
+        return;
+    }
+    for (auto &[buffer, mapping] : capture.mappings)
+    {
+        if (0 == (mapping.access & GL_MAP_PERSISTENT_BIT) || 0 == (mapping.access & GL_MAP_WRITE_BIT))
+        {
+            continue;
+        }
+        const uint8_t *bytes = static_cast<const uint8_t *>(mapping.data);
+        uint32_t first = 0;
+        uint32_t last = mapping.size;
+        if (mapping.recorded.empty())
+        {
+            mapping.recorded.resize(mapping.size);
+        }
+        else
+        {
+            while (first < last && bytes[first] == mapping.recorded[first])
+            {
+                ++first;
+            }
+            while (last > first && bytes[last - 1] == mapping.recorded[last - 1])
+            {
+                --last;
+            }
+        }
+        if (first == last)
+        {
+            continue;
+        }
+        memcpy(mapping.recorded.data() + first, bytes + first, last - first);
+        record(GlCall::BufferWrite, buffer, first, Blob{ bytes + first, last - first });
+    }
+}
+
+static Blob names(GLsizei count, const GLuint *names)
+{
+    return { names, uint32_t(count) * uint32_t(sizeof(GLuint)) };
+}
+
+static uint64_t syncId(gl::GLsync sync)
+{
+    return uint64_t(reinterpret_cast<uintptr_t>(sync));
+}
+
+// a pointer argument that is an offset into a bound buffer
+static uint64_t bufferOffset(const void *pointer)
+{
+    return uint64_t(reinterpret_cast<uintptr_t>(pointer));
+}
+
+// bytes glTexImage2D reads from data, under the current unpack alignment
+static uint32_t imageBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    if (GL_UNSIGNED_BYTE != type)
+    {
+        throw std::runtime_error("GL capture only records 8 bit texture uploads");
+    }
+    uint32_t components;
+    switch (format)
+    {
+    case GL_RGBA:
+    case GL_BGRA:
+        components = 4;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+        components = 3;
+        break;
+    case GL_RED:
+    case GL_ALPHA:
+        components = 1;
+        break;
+    default:
+        throw std::runtime_error("GL capture can't size a texture upload of format " + std::to_string(format));
+    }
+    const uint32_t alignment = uint32_t(capture.unpackAlignment);
+    const uint32_t rowBytes = (uint32_t(width) * components + alignment - 1) / alignment * alignment;
+    return rowBytes * uint32_t(height);
+}
+
+namespace wrapped
+{
+    static void DITTY_GL_APIENTRY BindTexture(GLenum target, GLuint texture)
+    {
+        real::BindTexture(target, texture);
+        record(GlCall::BindTexture, target, texture);
+    }
+
+    static void DITTY_GL_APIENTRY BlendFunc(GLenum source, GLenum destination)
+    {
+        real::BlendFunc(source, destination);
+        record(GlCall::BlendFunc, source, destination);
+    }
+
+    static void DITTY_GL_APIENTRY Clear(GLbitfield mask)
+    {
+        real::Clear(mask);
+        record(GlCall::Clear, mask);
+    }
+
+    static void DITTY_GL_APIENTRY ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+    {
+        real::ClearColor(red, green, blue, alpha);
+        record(GlCall::ClearColor, red, green, blue, alpha);
+    }
+
+    static void DITTY_GL_APIENTRY DeleteTextures(GLsizei count, const GLuint *textures)
+    {
+        real::DeleteTextures(count, textures);
+        record(GlCall::DeleteTextures, names(count, textures));
+    }
+
+    static void DITTY_GL_APIENTRY Disable(GLenum capability)
+    {
+        real::Disable(capability);
+        record(GlCall::Disable, capability);
+    }
+
+    static void DITTY_GL_APIENTRY DrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        recordPersistentWrites();
+        real::DrawArrays(mode, first, count);
+        record(GlCall::DrawArrays, mode, first, count);
+    }
+
+    // indices is always an offset into the bound element buffer, the ditty never draws from
+    // client memory
+    static void DITTY_GL_APIENTRY DrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+    {
+        recordPersistentWrites();
+        real::DrawElements(mode, count, type, indices);
+        record(GlCall::DrawElements, mode, count, type, bufferOffset(indices));
+    }
+
+    static void DITTY_GL_APIENTRY Enable(GLenum capability)
+    {
+        real::Enable(capability);
+        record(GlCall::Enable, capability);
+    }
+
+    static void DITTY_GL_APIENTRY Finish()
+    {
+        real::Finish();
+        record(GlCall::Finish);
+    }
+
+    static void DITTY_GL_APIENTRY Flush()
+    {
+        real::Flush();
+        record(GlCall::Flush);
+    }
+
+    static void DITTY_GL_APIENTRY GenTextures(GLsizei count, GLuint *textures)
+    {
+        real::GenTextures(count, textures);
+        record(GlCall::GenTextures, names(count, textures));
+    }
+
+    static const GLubyte *DITTY_GL_APIENTRY GetString(GLenum name)
+    {
+        const GLubyte *string = real::GetString(name);
+        record(GlCall::GetString, name);
+        return string;
+    }
+
+    static void DITTY_GL_APIENTRY PixelStorei(GLenum name, GLint value)
+    {
+        real::PixelStorei(name, value);
+        if (GL_UNPACK_ALIGNMENT == name)
+        {
+            capture.unpackAlignment = value;
+        }
+        record(GlCall::PixelStorei, name, value);
+    }
+
+    static void DITTY_GL_APIENTRY TexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *data)
+    {
+        real::TexImage2D(target, level, internalFormat, width, height, border, format, type, data);
+        const Blob pixels = { data, nullptr != data ? imageBytes(width, height, format, type) : 0 };
+        record(GlCall::TexImage2D, target, level, internalFormat, width, height, border, format, type, pixels);
+    }
+
+    static void DITTY_GL_APIENTRY TexParameteri(GLenum target, GLenum name, GLint value)
+    {
+        real::TexParameteri(target, name, value);
+        record(GlCall::TexParameteri, target, name, value);
+    }
+
+    static void DITTY_GL_APIENTRY Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        real::Viewport(x, y, width, height);
+        record(GlCall::Viewport, x, y, width, height);
+    }
+
+    static void DITTY_GL_APIENTRY CompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data)
+    {
+        real::CompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data);
+        record(GlCall::CompressedTexImage2D, target, level, internalFormat, width, height, border, Blob{ data, uint32_t(imageSize) });
+    }
+
+    static GLuint DITTY_GL_APIENTRY CreateShader(GLenum type)
+    {
+        const GLuint shader = real::CreateShader(type);
+        record(GlCall::CreateShader, type, shader);
+        return shader;
+    }
+
+    static void DITTY_GL_APIENTRY ShaderSource(GLuint shader, GLsizei count, const gl::GLchar *const *string, const GLint *length)
+    {
+        real::ShaderSource(shader, count, string, length);
+        // joined into one string for the replay
+        std::string source;
+        for (GLsizei i = 0; i < count; ++i)
+        {
+            source.append(string[i], nullptr != length && length[i] >= 0 ? size_t(length[i]) : strlen(string[i]));
+        }
+        record(GlCall::ShaderSource, shader, Blob{ source.data(), uint32_t(source.size()) });
+    }
+
+    static void DITTY_GL_APIENTRY CompileShader(GLuint shader)
+    {
+        real::CompileShader(shader);
+        record(GlCall::CompileShader, shader);
+    }
+
+    static void DITTY_GL_APIENTRY GetShaderiv(GLuint shader, GLenum name, GLint *value)
+    {
+        real::GetShaderiv(shader, name, value);
+        record(GlCall::GetShaderiv, shader, name);
+    }
+
+    static void DITTY_GL_APIENTRY GetShaderInfoLog(GLuint shader, GLsizei bufferSize, GLsizei *length, gl::GLchar *infoLog)
+    {
+        real::GetShaderInfoLog(shader, bufferSize, length, infoLog);
+        record(GlCall::GetShaderInfoLog, shader, bufferSize);
+    }
+
+    static void DITTY_GL_APIENTRY DeleteShader(GLuint shader)
+    {
+        real::DeleteShader(shader);
+        record(GlCall::DeleteShader, shader);
+    }
+
+    static GLuint DITTY_GL_APIENTRY CreateProgram()
+    {
+        const GLuint program = real::CreateProgram();
+        record(GlCall::CreateProgram, program);
+        return program;
+    }
+
+    static void DITTY_GL_APIENTRY AttachShader(GLuint program, GLuint shader)
+    {
+        real::AttachShader(program, shader);
+        record(GlCall::AttachShader, program, shader);
+    }
+
+    static void DITTY_GL_APIENTRY LinkProgram(GLuint program)
+    {
+        real::LinkProgram(program);
+        record(GlCall::LinkProgram, program);
+    }
+
+    static void DITTY_GL_APIENTRY GetProgramiv(GLuint program, GLenum name, GLint *value)
+    {
+        real::GetProgramiv(program, name, value);
+        record(GlCall::GetProgramiv, program, name);
+    }
+
+    static void DITTY_GL_APIENTRY GetProgramInfoLog(GLuint program, GLsizei bufferSize, GLsizei *length, gl::GLchar *infoLog)
+    {
+        real::GetProgramInfoLog(program, bufferSize, length, infoLog);
+        record(GlCall::GetProgramInfoLog, program, bufferSize);
+    }
+
+    static void DITTY_GL_APIENTRY UseProgram(GLuint program)
+    {
+        real::UseProgram(program);
+        record(GlCall::UseProgram, program);
+    }
+
+    static GLint DITTY_GL_APIENTRY GetUniformLocation(GLuint program, const gl::GLchar *name)
+    {
+        const GLint location = real::GetUniformLocation(program, name);
+        record(GlCall::GetUniformLocation, program, location, Blob{ name, uint32_t(strlen(name) + 1) });
+        return location;
+    }
+
+    static void DITTY_GL_APIENTRY Uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+    {
+        real::Uniform4f(location, x, y, z, w);
+        record(GlCall::Uniform4f, location, x, y, z, w);
+    }
+
+    static void DITTY_GL_APIENTRY DeleteProgram(GLuint program)
+    {
+        real::DeleteProgram(program);
+        record(GlCall::DeleteProgram, program);
+    }
+
+    static void DITTY_GL_APIENTRY GenVertexArrays(GLsizei count, GLuint *arrays)
+    {
+        real::GenVertexArrays(count, arrays);
+        record(GlCall::GenVertexArrays, names(count, arrays));
+    }
+
+    static void DITTY_GL_APIENTRY BindVertexArray(GLuint array)
+    {
+        real::BindVertexArray(array);
+        record(GlCall::BindVertexArray, array);
+    }
+
+    static void DITTY_GL_APIENTRY DeleteVertexArrays(GLsizei count, const GLuint *arrays)
+    {
+        real::DeleteVertexArrays(count, arrays);
+        record(GlCall::DeleteVertexArrays, names(count, arrays));
+    }
+
+    static void DITTY_GL_APIENTRY GenQueries(GLsizei count, GLuint *queries)
+    {
+        real::GenQueries(count, queries);
+        record(GlCall::GenQueries, names(count, queries));
+    }
+
+    static void DITTY_GL_APIENTRY DeleteQueries(GLsizei count, const GLuint *queries)
+    {
+        real::DeleteQueries(count, queries);
+        record(GlCall::DeleteQueries, names(count, queries));
+    }
+
+    static void DITTY_GL_APIENTRY QueryCounter(GLuint query, GLenum target)
+    {
+        real::QueryCounter(query, target);
+        record(GlCall::QueryCounter, query, target);
+    }
+
+    static void DITTY_GL_APIENTRY GetQueryObjectiv(GLuint query, GLenum name, GLint *value)
+    {
+        real::GetQueryObjectiv(query, name, value);
+        record(GlCall::GetQueryObjectiv, query, name);
+    }
+
+    static void DITTY_GL_APIENTRY GetQueryObjectui64v(GLuint query, GLenum name, gl::GLuint64 *value)
+    {
+        real::GetQueryObjectui64v(query, name, value);
+        record(GlCall::GetQueryObjectui64v, query, name);
+    }
+
+    static void DITTY_GL_APIENTRY GetInteger64v(GLenum name, gl::GLint64 *value)
+    {
+        real::GetInteger64v(name, value);
+        record(GlCall::GetInteger64v, name);
+    }
+
+    static gl::GLsync DITTY_GL_APIENTRY FenceSync(GLenum condition, GLbitfield flags)
+    {
+        const gl::GLsync sync = real::FenceSync(condition, flags);
+        record(GlCall::FenceSync, condition, flags, syncId(sync));
+        return sync;
+    }
+
+    static void DITTY_GL_APIENTRY WaitSync(gl::GLsync sync, GLbitfield flags, gl::GLuint64 timeout)
+    {
+        real::WaitSync(sync, flags, timeout);
+        record(GlCall::WaitSync, syncId(sync), flags, timeout);
+    }
+
+    static void DITTY_GL_APIENTRY DeleteSync(gl::GLsync sync)
+    {
+        real::DeleteSync(sync);
+        record(GlCall::DeleteSync, syncId(sync));
+    }
+
+    static GLenum DITTY_GL_APIENTRY ClientWaitSync(gl::GLsync sync, GLbitfield flags, gl::GLuint64 timeout)
+    {
+        const GLenum result = real::ClientWaitSync(sync, flags, timeout);
+        record(GlCall::ClientWaitSync, syncId(sync), flags, timeout);
+        return result;
+    }
+
+    static void DITTY_GL_APIENTRY GenBuffers(GLsizei count, GLuint *buffers)
+    {
+        real::GenBuffers(count, buffers);
+        record(GlCall::GenBuffers, names(count, buffers));
+    }
+
+    static void DITTY_GL_APIENTRY DeleteBuffers(GLsizei count, const GLuint *buffers)
+    {
+        real::DeleteBuffers(count, buffers);
+        // deleting a buffer unmaps it
+        for (GLsizei i = 0; i < count; ++i)
+        {
+            capture.mappings.erase(buffers[i]);
+        }
+        record(GlCall::DeleteBuffers, names(count, buffers));
+    }
+
+    static void DITTY_GL_APIENTRY BindBuffer(GLenum target, GLuint buffer)
+    {
+        real::BindBuffer(target, buffer);
+        capture.boundBuffers[target] = buffer;
+        record(GlCall::BindBuffer, target, buffer);
+    }
+
+    static void DITTY_GL_APIENTRY BufferData(GLenum target, gl::GLsizeiptr size, const void *data, GLenum usage)
+    {
+        real::BufferData(target, size, data, usage);
+        record(GlCall::BufferData, target, size, Blob{ data, nullptr != data ? uint32_t(size) : 0 }, usage);
+    }
+
+    static void DITTY_GL_APIENTRY BufferSubData(GLenum target, gl::GLintptr offset, gl::GLsizeiptr size, const void *data)
+    {
+        real::BufferSubData(target, offset, size, data);
+        record(GlCall::BufferSubData, target, offset, Blob{ data, uint32_t(size) });
+    }
+
+    static void *DITTY_GL_APIENTRY MapBufferRange(GLenum target, gl::GLintptr offset, gl::GLsizeiptr length, GLbitfield access)
+    {
+        // persistent mappings are read back at each draw, BufferStorage allowed for that
+        const GLbitfield readBack = 0 != (access & GL_MAP_PERSISTENT_BIT) ? GL_MAP_READ_BIT : 0;
+        void *data = real::MapBufferRange(target, offset, length, access | readBack);
+        const GLuint buffer = capture.boundBuffers[target];
+        if (nullptr != data)
+        {
+            capture.mappings[buffer] = { data, uint32_t(length), access };
+        }
+        record(GlCall::MapBufferRange, target, buffer, offset, length, access);
+        return data;
+    }
+
+    static GLboolean DITTY_GL_APIENTRY UnmapBuffer(GLenum target)
+    {
+        // the range's bytes are recorded before unmapping takes the pointer away
+        const GLuint buffer = capture.boundBuffers[target];
+        const auto found = capture.mappings.find(buffer);
+        Blob written = { nullptr, 0 };
+        if (capture.mappings.end() != found && 0 != (found->second.access & GL_MAP_WRITE_BIT))
+        {
+            written = { found->second.data, found->second.size };
+        }
+        record(GlCall::UnmapBuffer, target, buffer, written);
+        if (capture.mappings.end() != found)
+        {
+            capture.mappings.erase(found);
+        }
+        return real::UnmapBuffer(target);
+    }
+
+    // pointer is always an offset into the bound array buffer
+    static void DITTY_GL_APIENTRY VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
+    {
+        real::VertexAttribPointer(index, size, type, normalized, stride, pointer);
+        record(GlCall::VertexAttribPointer, index, size, type, normalized, stride, bufferOffset(pointer));
+    }
+
+    static void DITTY_GL_APIENTRY EnableVertexAttribArray(GLuint index)
+    {
+        real::EnableVertexAttribArray(index);
+        record(GlCall::EnableVertexAttribArray, index);
+    }
+
+    static void DITTY_GL_APIENTRY BufferStorage(GLenum target, gl::GLsizeiptr size, const void *data, GLbitfield flags)
+    {
+        // the capture reads persistent mappings back, which the storage has to allow; the
+        // ditty's own flags are what's recorded
+        const GLbitfield readBack = 0 != (flags & GL_MAP_PERSISTENT_BIT) ? GL_MAP_READ_BIT : 0;
+        real::BufferStorage(target, size, data, flags | readBack);
+        record(GlCall::BufferStorage, target, size, Blob{ data, nullptr != data ? uint32_t(size) : 0 }, flags);
+    }
+}
+
+static void wrapGlFunctions()
+{
+// optional entry points the driver lacks stay null
+#define DITTY_GL_WRAP(name) \
+    real::name = gl::name;  \
+    gl::name = nullptr != real::name ? wrapped::name : nullptr;
+    DITTY_GL_CAPTURED_FUNCTIONS(DITTY_GL_WRAP)
+#undef DITTY_GL_WRAP
+}
+
+void startGlCapture(const char *path, int framebufferWidth, int framebufferHeight)
+{
+    capture.path = path;
+    capture.stream.open(path, std::ios::binary);
+    if (!capture.stream)
+    {
+        throw std::runtime_error(std::string("Failed to create GL capture ") + path);
+    }
+
+    GlCaptureHeader header;
+    memcpy(header.magic, GlCaptureMagic, sizeof(header.magic));
+    header.version = GlCaptureVersion;
+    header.framebufferWidth = uint32_t(framebufferWidth);
+    header.framebufferHeight = uint32_t(framebufferHeight);
+    append(header);
+
+    capture.start = std::chrono::steady_clock::now();
+    capture.recording = true;
+    glFunctionsLoadedHook = wrapGlFunctions;
+}
+
+void captureGlPresent()
+{
+    if (!capture.recording)
+    {
+        return;
+    }
+    const auto sinceStart = std::chrono::steady_clock::now() - capture.start;
+    record(GlCall::Present, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceStart).count()));
+    ++capture.frames;
+}
+
+void stopGlCapture(std::ostream &stream)
+{
+    if (!capture.recording)
+    {
+        return;
+    }
+    capture.recording = false;
+    flushCapture();
+    capture.stream.close();
+    if (!capture.stream)
+    {
+        std::cerr << "Failed to write GL capture " << capture.path << std::endl;
+    }
+    stream << "GL capture: " << capture.calls << " calls over " << capture.frames << " frames, " << (capture.bytesWritten + 1023) / 1024 << "KB written to " << capture.path << std::endl;
+}
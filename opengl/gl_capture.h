@@ -0,0 +1,102 @@
+#pragma once
+
+#include "gl_functions.h"
+
+#include <cstdint>
+#include <iosfwd>
+
+// Every call made through the gl:: table recorded into a binary file that gl_replay reissues,
+// so driver updates can be compared on a frozen workload without the ditty's own CPU work
+// The file starts with a GlCaptureHeader, then each call as its GlCall, its arguments in host
+// byte order and any data it reads as a 32 bit length followed by the bytes. Object names are
+// recorded as the driver returned them and remapped on replay. Bytes written through a mapped
+// buffer range are recorded with the UnmapBuffer that publishes them, or for a persistent
+// mapping as a BufferWrite before the next draw, and buffer offsets passed as pointers are
+// recorded as 64 bit offsets. Only one context, current on one thread at a
+// time, can be captured.
+enum class GlCall : uint16_t
+{
+    BindTexture,
+    BlendFunc,
+    Clear,
+    ClearColor,
+    DeleteTextures,
+    Disable,
+    DrawArrays,
+    DrawElements,
+    Enable,
+    Finish,
+    Flush,
+    GenTextures,
+    GetString,
+    PixelStorei,
+    TexImage2D,
+    TexParameteri,
+    Viewport,
+    CompressedTexImage2D,
+    CreateShader,
+    ShaderSource,
+    CompileShader,
+    GetShaderiv,
+    GetShaderInfoLog,
+    DeleteShader,
+    CreateProgram,
+    AttachShader,
+    LinkProgram,
+    GetProgramiv,
+    GetProgramInfoLog,
+    UseProgram,
+    GetUniformLocation,
+    Uniform4f,
+    DeleteProgram,
+    GenVertexArrays,
+    BindVertexArray,
+    DeleteVertexArrays,
+    GenQueries,
+    DeleteQueries,
+    QueryCounter,
+    GetQueryObjectiv,
+    GetQueryObjectui64v,
+    GetInteger64v,
+    FenceSync,
+    WaitSync,
+    DeleteSync,
+    ClientWaitSync,
+    GenBuffers,
+    DeleteBuffers,
+    BindBuffer,
+    BufferData,
+    BufferSubData,
+    MapBufferRange,
+    UnmapBuffer,
+    VertexAttribPointer,
+    EnableVertexAttribArray,
+    BufferStorage,
+    // bytes that changed in a persistent mapping since the last draw: the buffer, their offset
+    // into the mapping as a uint32_t and the bytes
+    BufferWrite,
+    // the end of a frame: nanoseconds since the capture started, as a uint64_t
+    Present,
+    Count
+};
+
+struct GlCaptureHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t framebufferWidth;
+    uint32_t framebufferHeight;
+};
+
+constexpr char GlCaptureMagic[4] = { 'D', 'G', 'L', 'C' };
+constexpr uint32_t GlCaptureVersion = 4;
+
+// Before the first loadGlFunctions, which wraps the table from then on; throws
+// std::runtime_error if the file can't be created
+void startGlCapture(const char *path, int framebufferWidth, int framebufferHeight);
+
+// After each swap
+void captureGlPresent();
+
+// Writes out the rest of the capture; later calls still reach the driver, unrecorded
+void stopGlCapture(std::ostream &stream);
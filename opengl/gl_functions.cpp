@@ -0,0 +1,145 @@
+#include "gl_functions.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace gl
+{
+    void(DITTY_GL_APIENTRY *BindTexture)(GLenum, GLuint);
+    void(DITTY_GL_APIENTRY *BlendFunc)(GLenum, GLenum);
+    void(DITTY_GL_APIENTRY *Clear)(GLbitfield);
+    void(DITTY_GL_APIENTRY *ClearColor)(GLfloat, GLfloat, GLfloat, GLfloat);
+    void(DITTY_GL_APIENTRY *DeleteTextures)(GLsizei, const GLuint *);
+    void(DITTY_GL_APIENTRY *Disable)(GLenum);
+    void(DITTY_GL_APIENTRY *DrawArrays)(GLenum, GLint, GLsizei);
+    void(DITTY_GL_APIENTRY *DrawElements)(GLenum, GLsizei, GLenum, const void *);
+    void(DITTY_GL_APIENTRY *Enable)(GLenum);
+    void(DITTY_GL_APIENTRY *Finish)();
+    void(DITTY_GL_APIENTRY *Flush)();
+    void(DITTY_GL_APIENTRY *GenTextures)(GLsizei, GLuint *);
+    const GLubyte *(DITTY_GL_APIENTRY *GetString)(GLenum);
+    void(DITTY_GL_APIENTRY *PixelStorei)(GLenum, GLint);
+    void(DITTY_GL_APIENTRY *TexImage2D)(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void *);
+    void(DITTY_GL_APIENTRY *TexParameteri)(GLenum, GLenum, GLint);
+    void(DITTY_GL_APIENTRY *Viewport)(GLint, GLint, GLsizei, GLsizei);
+    void(DITTY_GL_APIENTRY *CompressedTexImage2D)(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei, const void *);
+    GLuint(DITTY_GL_APIENTRY *CreateShader)(GLenum);
+    void(DITTY_GL_APIENTRY *ShaderSource)(GLuint, GLsizei, const GLchar *const *, const GLint *);
+    void(DITTY_GL_APIENTRY *CompileShader)(GLuint);
+    void(DITTY_GL_APIENTRY *GetShaderiv)(GLuint, GLenum, GLint *);
+    void(DITTY_GL_APIENTRY *GetShaderInfoLog)(GLuint, GLsizei, GLsizei *, GLchar *);
+    void(DITTY_GL_APIENTRY *DeleteShader)(GLuint);
+    GLuint(DITTY_GL_APIENTRY *CreateProgram)();
+    void(DITTY_GL_APIENTRY *AttachShader)(GLuint, GLuint);
+    void(DITTY_GL_APIENTRY *LinkProgram)(GLuint);
+    void(DITTY_GL_APIENTRY *GetProgramiv)(GLuint, GLenum, GLint *);
+    void(DITTY_GL_APIENTRY *GetProgramInfoLog)(GLuint, GLsizei, GLsizei *, GLchar *);
+    void(DITTY_GL_APIENTRY *UseProgram)(GLuint);
+    GLint(DITTY_GL_APIENTRY *GetUniformLocation)(GLuint, const GLchar *);
+    void(DITTY_GL_APIENTRY *Uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
+    void(DITTY_GL_APIENTRY *DeleteProgram)(GLuint);
+    void(DITTY_GL_APIENTRY *GenVertexArrays)(GLsizei, GLuint *);
+    void(DITTY_GL_APIENTRY *BindVertexArray)(GLuint);
+    void(DITTY_GL_APIENTRY *DeleteVertexArrays)(GLsizei, const GLuint *);
+    void(DITTY_GL_APIENTRY *GenQueries)(GLsizei, GLuint *);
+    void(DITTY_GL_APIENTRY *DeleteQueries)(GLsizei, const GLuint *);
+    void(DITTY_GL_APIENTRY *QueryCounter)(GLuint, GLenum);
+    void(DITTY_GL_APIENTRY *GetQueryObjectiv)(GLuint, GLenum, GLint *);
+    void(DITTY_GL_APIENTRY *GetQueryObjectui64v)(GLuint, GLenum, GLuint64 *);
+    void(DITTY_GL_APIENTRY *GetInteger64v)(GLenum, GLint64 *);
+    GLsync(DITTY_GL_APIENTRY *FenceSync)(GLenum, GLbitfield);
+    void(DITTY_GL_APIENTRY *WaitSync)(GLsync, GLbitfield, GLuint64);
+    void(DITTY_GL_APIENTRY *DeleteSync)(GLsync);
+    GLenum(DITTY_GL_APIENTRY *ClientWaitSync)(GLsync, GLbitfield, GLuint64);
+    void(DITTY_GL_APIENTRY *GenBuffers)(GLsizei, GLuint *);
+    void(DITTY_GL_APIENTRY *DeleteBuffers)(GLsizei, const GLuint *);
+    void(DITTY_GL_APIENTRY *BindBuffer)(GLenum, GLuint);
+    void(DITTY_GL_APIENTRY *BufferData)(GLenum, GLsizeiptr, const void *, GLenum);
+    void(DITTY_GL_APIENTRY *BufferSubData)(GLenum, GLintptr, GLsizeiptr, const void *);
+    void *(DITTY_GL_APIENTRY *MapBufferRange)(GLenum, GLintptr, GLsizeiptr, GLbitfield);
+    GLboolean(DITTY_GL_APIENTRY *UnmapBuffer)(GLenum);
+    void(DITTY_GL_APIENTRY *VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void *);
+    void(DITTY_GL_APIENTRY *EnableVertexAttribArray)(GLuint);
+    void(DITTY_GL_APIENTRY *BufferStorage)(GLenum, GLsizeiptr, const void *, GLbitfield);
+}
+
+void (*glFunctionsLoadedHook)() = nullptr;
+
+template <typename Function>
+static void load(Function &function, const char *name)
+{
+    function = reinterpret_cast<Function>(glfwGetProcAddress(name));
+    if (nullptr == function)
+    {
+        throw std::runtime_error(std::string("Missing OpenGL entry point ") + name);
+    }
+}
+
+void loadGlFunctions()
+{
+    load(gl::BindTexture, "glBindTexture");
+    load(gl::BlendFunc, "glBlendFunc");
+    load(gl::Clear, "glClear");
+    load(gl::ClearColor, "glClearColor");
+    load(gl::DeleteTextures, "glDeleteTextures");
+    load(gl::Disable, "glDisable");
+    load(gl::DrawArrays, "glDrawArrays");
+    load(gl::DrawElements, "glDrawElements");
+    load(gl::Enable, "glEnable");
+    load(gl::Finish, "glFinish");
+    load(gl::Flush, "glFlush");
+    load(gl::GenTextures, "glGenTextures");
+    load(gl::GetString, "glGetString");
+    load(gl::PixelStorei, "glPixelStorei");
+    load(gl::TexImage2D, "glTexImage2D");
+    load(gl::TexParameteri, "glTexParameteri");
+    load(gl::Viewport, "glViewport");
+    load(gl::CompressedTexImage2D, "glCompressedTexImage2D");
+    load(gl::CreateShader, "glCreateShader");
+    load(gl::ShaderSource, "glShaderSource");
+    load(gl::CompileShader, "glCompileShader");
+    load(gl::GetShaderiv, "glGetShaderiv");
+    load(gl::GetShaderInfoLog, "glGetShaderInfoLog");
+    load(gl::DeleteShader, "glDeleteShader");
+    load(gl::CreateProgram, "glCreateProgram");
+    load(gl::AttachShader, "glAttachShader");
+    load(gl::LinkProgram, "glLinkProgram");
+    load(gl::GetProgramiv, "glGetProgramiv");
+    load(gl::GetProgramInfoLog, "glGetProgramInfoLog");
+    load(gl::UseProgram, "glUseProgram");
+    load(gl::GetUniformLocation, "glGetUniformLocation");
+    load(gl::Uniform4f, "glUniform4f");
+    load(gl::DeleteProgram, "glDeleteProgram");
+    load(gl::GenVertexArrays, "glGenVertexArrays");
+    load(gl::BindVertexArray, "glBindVertexArray");
+    load(gl::DeleteVertexArrays, "glDeleteVertexArrays");
+    load(gl::GenQueries, "glGenQueries");
+    load(gl::DeleteQueries, "glDeleteQueries");
+    load(gl::QueryCounter, "glQueryCounter");
+    load(gl::GetQueryObjectiv, "glGetQueryObjectiv");
+    load(gl::GetQueryObjectui64v, "glGetQueryObjectui64v");
+    load(gl::GetInteger64v, "glGetInteger64v");
+    load(gl::FenceSync, "glFenceSync");
+    load(gl::WaitSync, "glWaitSync");
+    load(gl::DeleteSync, "glDeleteSync");
+    load(gl::ClientWaitSync, "glClientWaitSync");
+    load(gl::GenBuffers, "glGenBuffers");
+    load(gl::DeleteBuffers, "glDeleteBuffers");
+    load(gl::BindBuffer, "glBindBuffer");
+    load(gl::BufferData, "glBufferData");
+    load(gl::BufferSubData, "glBufferSubData");
+    load(gl::MapBufferRange, "glMapBufferRange");
+    load(gl::UnmapBuffer, "glUnmapBuffer");
+    load(gl::VertexAttribPointer, "glVertexAttribPointer");
+    load(gl::EnableVertexAttribArray, "glEnableVertexAttribArray");
+    gl::BufferStorage = nullptr;
+    if (glfwExtensionSupported("GL_ARB_buffer_storage"))
+    {
+        load(gl::BufferStorage, "glBufferStorage");
+    }
+
+    if (nullptr != glFunctionsLoadedHook)
+    {
+        glFunctionsLoadedHook();
+    }
+}
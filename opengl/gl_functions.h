@@ -0,0 +1,194 @@
+#pragma once
+
+#include "GLFW/glfw3.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// The system GL headers only reliably declare OpenGL 1.1, so the few newer entry points the
+// ditty uses are loaded at runtime through GLFW; the 1.1 functions the ditty calls are loaded the
+// same way, so that every call goes through this one table and a capture can wrap it
+#ifdef _WIN32
+#define DITTY_GL_APIENTRY __stdcall
+#else
+#define DITTY_GL_APIENTRY
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_BGR
+#define GL_BGR 0x80E0
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_TEXTURE_BASE_LEVEL
+#define GL_TEXTURE_BASE_LEVEL 0x813C
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_LINEAR_MIPMAP_LINEAR
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED 0x911D
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_RANGE_BIT
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#endif
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+
+namespace gl
+{
+    using GLchar = char;
+    using GLint64 = int64_t;
+    using GLuint64 = uint64_t;
+    using GLsync = struct SyncObject *;
+    using GLintptr = ptrdiff_t;
+    using GLsizeiptr = ptrdiff_t;
+
+    extern void(DITTY_GL_APIENTRY *BindTexture)(GLenum target, GLuint texture);
+    extern void(DITTY_GL_APIENTRY *BlendFunc)(GLenum source, GLenum destination);
+    extern void(DITTY_GL_APIENTRY *Clear)(GLbitfield mask);
+    extern void(DITTY_GL_APIENTRY *ClearColor)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+    extern void(DITTY_GL_APIENTRY *DeleteTextures)(GLsizei count, const GLuint *textures);
+    extern void(DITTY_GL_APIENTRY *Disable)(GLenum capability);
+    extern void(DITTY_GL_APIENTRY *DrawArrays)(GLenum mode, GLint first, GLsizei count);
+    extern void(DITTY_GL_APIENTRY *DrawElements)(GLenum mode, GLsizei count, GLenum type, const void *indices);
+    extern void(DITTY_GL_APIENTRY *Enable)(GLenum capability);
+    extern void(DITTY_GL_APIENTRY *Finish)();
+    extern void(DITTY_GL_APIENTRY *Flush)();
+    extern void(DITTY_GL_APIENTRY *GenTextures)(GLsizei count, GLuint *textures);
+    extern const GLubyte *(DITTY_GL_APIENTRY *GetString)(GLenum name);
+    extern void(DITTY_GL_APIENTRY *PixelStorei)(GLenum name, GLint value);
+    extern void(DITTY_GL_APIENTRY *TexImage2D)(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *data);
+    extern void(DITTY_GL_APIENTRY *TexParameteri)(GLenum target, GLenum name, GLint value);
+    extern void(DITTY_GL_APIENTRY *Viewport)(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    extern void(DITTY_GL_APIENTRY *CompressedTexImage2D)(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data);
+    extern GLuint(DITTY_GL_APIENTRY *CreateShader)(GLenum type);
+    extern void(DITTY_GL_APIENTRY *ShaderSource)(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length);
+    extern void(DITTY_GL_APIENTRY *CompileShader)(GLuint shader);
+    extern void(DITTY_GL_APIENTRY *GetShaderiv)(GLuint shader, GLenum name, GLint *value);
+    extern void(DITTY_GL_APIENTRY *GetShaderInfoLog)(GLuint shader, GLsizei bufferSize, GLsizei *length, GLchar *infoLog);
+    extern void(DITTY_GL_APIENTRY *DeleteShader)(GLuint shader);
+    extern GLuint(DITTY_GL_APIENTRY *CreateProgram)();
+    extern void(DITTY_GL_APIENTRY *AttachShader)(GLuint program, GLuint shader);
+    extern void(DITTY_GL_APIENTRY *LinkProgram)(GLuint program);
+    extern void(DITTY_GL_APIENTRY *GetProgramiv)(GLuint program, GLenum name, GLint *value);
+    extern void(DITTY_GL_APIENTRY *GetProgramInfoLog)(GLuint program, GLsizei bufferSize, GLsizei *length, GLchar *infoLog);
+    extern void(DITTY_GL_APIENTRY *UseProgram)(GLuint program);
+    extern GLint(DITTY_GL_APIENTRY *GetUniformLocation)(GLuint program, const GLchar *name);
+    extern void(DITTY_GL_APIENTRY *Uniform4f)(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    extern void(DITTY_GL_APIENTRY *DeleteProgram)(GLuint program);
+    extern void(DITTY_GL_APIENTRY *GenVertexArrays)(GLsizei count, GLuint *arrays);
+    extern void(DITTY_GL_APIENTRY *BindVertexArray)(GLuint array);
+    extern void(DITTY_GL_APIENTRY *DeleteVertexArrays)(GLsizei count, const GLuint *arrays);
+    extern void(DITTY_GL_APIENTRY *GenQueries)(GLsizei count, GLuint *queries);
+    extern void(DITTY_GL_APIENTRY *DeleteQueries)(GLsizei count, const GLuint *queries);
+    extern void(DITTY_GL_APIENTRY *QueryCounter)(GLuint query, GLenum target);
+    extern void(DITTY_GL_APIENTRY *GetQueryObjectiv)(GLuint query, GLenum name, GLint *value);
+    extern void(DITTY_GL_APIENTRY *GetQueryObjectui64v)(GLuint query, GLenum name, GLuint64 *value);
+    extern void(DITTY_GL_APIENTRY *GetInteger64v)(GLenum name, GLint64 *value);
+    extern GLsync(DITTY_GL_APIENTRY *FenceSync)(GLenum condition, GLbitfield flags);
+    extern void(DITTY_GL_APIENTRY *WaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+    extern void(DITTY_GL_APIENTRY *DeleteSync)(GLsync sync);
+    extern GLenum(DITTY_GL_APIENTRY *ClientWaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+    extern void(DITTY_GL_APIENTRY *GenBuffers)(GLsizei count, GLuint *buffers);
+    extern void(DITTY_GL_APIENTRY *DeleteBuffers)(GLsizei count, const GLuint *buffers);
+    extern void(DITTY_GL_APIENTRY *BindBuffer)(GLenum target, GLuint buffer);
+    extern void(DITTY_GL_APIENTRY *BufferData)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+    extern void(DITTY_GL_APIENTRY *BufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
+    extern void *(DITTY_GL_APIENTRY *MapBufferRange)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    extern GLboolean(DITTY_GL_APIENTRY *UnmapBuffer)(GLenum target);
+    extern void(DITTY_GL_APIENTRY *VertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer);
+    extern void(DITTY_GL_APIENTRY *EnableVertexAttribArray)(GLuint index);
+
+    // GL 4.4 or ARB_buffer_storage, null without either
+    extern void(DITTY_GL_APIENTRY *BufferStorage)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+}
+
+// Needs a current context; throws std::runtime_error if an entry point is missing
+void loadGlFunctions();
+
+// Run at the end of every loadGlFunctions when set, to wrap the freshly loaded table
+extern void (*glFunctionsLoadedHook)();
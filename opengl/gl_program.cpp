@@ -0,0 +1,46 @@
+#include "gl_program.h"
+
+#include <stdexcept>
+#include <string>
+
+static GLuint compileShader(GLenum type, const char *source)
+{
+    const GLuint shader = gl::CreateShader(type);
+    gl::ShaderSource(shader, 1, &source, nullptr);
+    gl::CompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    gl::GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (GL_TRUE != compiled)
+    {
+        char log[1024] = {};
+        gl::GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        gl::DeleteShader(shader);
+        throw std::runtime_error(std::string("Failed to compile shader: ") + log);
+    }
+    return shader;
+}
+
+GLuint createGlProgram(const char *vertexSource, const char *fragmentSource)
+{
+    const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+    const GLuint program = gl::CreateProgram();
+    gl::AttachShader(program, vertexShader);
+    gl::AttachShader(program, fragmentShader);
+    gl::LinkProgram(program);
+    gl::DeleteShader(vertexShader);
+    gl::DeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    gl::GetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (GL_TRUE != linked)
+    {
+        char log[1024] = {};
+        gl::GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        gl::DeleteProgram(program);
+        throw std::runtime_error(std::string("Failed to link program: ") + log);
+    }
+    return program;
+}
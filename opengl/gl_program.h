@@ -0,0 +1,7 @@
+#pragma once
+
+#include "gl_functions.h"
+
+// Compiles and links a vertex and fragment shader pair; needs loadGlFunctions to have run
+// throws std::runtime_error with the info log if either stage fails
+GLuint createGlProgram(const char *vertexSource, const char *fragmentSource);
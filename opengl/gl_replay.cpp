@@ -0,0 +1,675 @@
+#include "GLFW/glfw3.h"
+#include "frame_stats.h"
+#include "gl_capture.h"
+#include "gl_functions.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reissues a capture written by the OpenGL ditty's --capture, as fast as the driver allows or
+// at the recorded frame times, in a hidden window unless --show is given
+// Headless runs on a software rasteriser need a display, e.g. under xvfb-run with
+// LIBGL_ALWAYS_SOFTWARE=1 for llvmpipe.
+
+namespace
+{
+    struct Options
+    {
+        const char *capturePath = nullptr;
+        bool recordedTiming = false;
+        bool show = false;
+    };
+
+    struct Blob
+    {
+        const uint8_t *data;
+        uint32_t size;
+    };
+
+    class CaptureReader
+    {
+    public:
+        CaptureReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+        bool finished() const { return offset == size; }
+
+        template <typename Value>
+        Value read()
+        {
+            Value value;
+            memcpy(&value, take(sizeof(Value)), sizeof(Value));
+            return value;
+        }
+
+        Blob readBlob()
+        {
+            const uint32_t length = read<uint32_t>();
+            return { take(length), length };
+        }
+
+        // names a Gen* call returned or a Delete* call was given
+        std::vector<GLuint> readNames()
+        {
+            const Blob blob = readBlob();
+            std::vector<GLuint> names(blob.size / sizeof(GLuint));
+            memcpy(names.data(), blob.data, names.size() * sizeof(GLuint));
+            return names;
+        }
+
+    private:
+        const uint8_t *take(size_t length)
+        {
+            if (length > size - offset)
+            {
+                throw std::runtime_error("GL capture is truncated");
+            }
+            const uint8_t *bytes = data + offset;
+            offset += length;
+            return bytes;
+        }
+
+        const uint8_t *data;
+        size_t size;
+        size_t offset = 0;
+    };
+
+    // captured object names to the ones the replay's driver returned
+    struct NameMaps
+    {
+        std::unordered_map<GLuint, GLuint> textures;
+        // shaders and programs share one namespace
+        std::unordered_map<GLuint, GLuint> objects;
+        std::unordered_map<GLuint, GLuint> vertexArrays;
+        std::unordered_map<GLuint, GLuint> queries;
+        std::unordered_map<GLuint, GLuint> buffers;
+        std::unordered_map<uint64_t, gl::GLsync> syncs;
+        // the replay's pointer for each captured buffer that is mapped
+        std::unordered_map<GLuint, void *> mappings;
+        std::map<std::pair<GLuint, GLint>, GLint> uniformLocations;
+        GLuint currentProgram = 0;
+    };
+}
+
+static Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--timing") && i + 1 < argc)
+        {
+            const char *timing = argv[++i];
+            if (0 == strcmp(timing, "recorded"))
+            {
+                options.recordedTiming = true;
+            }
+            else if (0 == strcmp(timing, "fast"))
+            {
+                options.recordedTiming = false;
+            }
+            else
+            {
+                std::cerr << "Ignoring unknown timing " << timing << std::endl;
+            }
+        }
+        else if (0 == strcmp(argv[i], "--show"))
+        {
+            options.show = true;
+        }
+        else if (nullptr == options.capturePath && '-' != argv[i][0])
+        {
+            options.capturePath = argv[i];
+        }
+        else
+        {
+            std::cerr << "Ignoring unknown option " << argv[i] << std::endl;
+        }
+    }
+    return options;
+}
+
+static const void *bufferOffset(uint64_t offset)
+{
+    return reinterpret_cast<const void *>(uintptr_t(offset));
+}
+
+template <typename Key, typename Value>
+static Value lookup(const std::unordered_map<Key, Value> &map, Key captured)
+{
+    if (Key() == captured)
+    {
+        return Value();
+    }
+    const auto found = map.find(captured);
+    if (map.end() == found)
+    {
+        throw std::runtime_error("GL capture uses an object it never created");
+    }
+    return found->second;
+}
+
+static void generated(std::unordered_map<GLuint, GLuint> &map, const std::vector<GLuint> &captured, const std::vector<GLuint> &created)
+{
+    for (size_t i = 0; i < captured.size(); ++i)
+    {
+        map[captured[i]] = created[i];
+    }
+}
+
+static std::vector<GLuint> deleted(std::unordered_map<GLuint, GLuint> &map, const std::vector<GLuint> &captured)
+{
+    std::vector<GLuint> names;
+    for (GLuint name : captured)
+    {
+        names.push_back(lookup(map, name));
+        map.erase(name);
+    }
+    return names;
+}
+
+static std::vector<GLuint> generate(void(DITTY_GL_APIENTRY *function)(GLsizei, GLuint *), std::unordered_map<GLuint, GLuint> &map, const std::vector<GLuint> &captured)
+{
+    std::vector<GLuint> created(captured.size());
+    function(GLsizei(created.size()), created.data());
+    generated(map, captured, created);
+    return created;
+}
+
+// Issues one call, or returns false at the end of a frame
+static bool replayCall(GlCall call, CaptureReader &reader, NameMaps &maps)
+{
+    switch (call)
+    {
+    case GlCall::BindTexture:
+    {
+        const GLenum target = reader.read<GLenum>();
+        gl::BindTexture(target, lookup(maps.textures, reader.read<GLuint>()));
+        break;
+    }
+    case GlCall::BlendFunc:
+    {
+        const GLenum source = reader.read<GLenum>();
+        gl::BlendFunc(source, reader.read<GLenum>());
+        break;
+    }
+    case GlCall::Clear:
+        gl::Clear(reader.read<GLbitfield>());
+        break;
+    case GlCall::ClearColor:
+    {
+        const GLfloat red = reader.read<GLfloat>();
+        const GLfloat green = reader.read<GLfloat>();
+        const GLfloat blue = reader.read<GLfloat>();
+        gl::ClearColor(red, green, blue, reader.read<GLfloat>());
+        break;
+    }
+    case GlCall::DeleteTextures:
+    {
+        const std::vector<GLuint> names = deleted(maps.textures, reader.readNames());
+        gl::DeleteTextures(GLsizei(names.size()), names.data());
+        break;
+    }
+    case GlCall::Disable:
+        gl::Disable(reader.read<GLenum>());
+        break;
+    case GlCall::DrawArrays:
+    {
+        const GLenum mode = reader.read<GLenum>();
+        const GLint first = reader.read<GLint>();
+        gl::DrawArrays(mode, first, reader.read<GLsizei>());
+        break;
+    }
+    case GlCall::DrawElements:
+    {
+        const GLenum mode = reader.read<GLenum>();
+        const GLsizei count = reader.read<GLsizei>();
+        const GLenum type = reader.read<GLenum>();
+        gl::DrawElements(mode, count, type, bufferOffset(reader.read<uint64_t>()));
+        break;
+    }
+    case GlCall::Enable:
+        gl::Enable(reader.read<GLenum>());
+        break;
+    case GlCall::Finish:
+        gl::Finish();
+        break;
+    case GlCall::Flush:
+        gl::Flush();
+        break;
+    case GlCall::GenTextures:
+        generate(gl::GenTextures, maps.textures, reader.readNames());
+        break;
+    case GlCall::GetString:
+        gl::GetString(reader.read<GLenum>());
+        break;
+    case GlCall::PixelStorei:
+    {
+        const GLenum name = reader.read<GLenum>();
+        gl::PixelStorei(name, reader.read<GLint>());
+        break;
+    }
+    case GlCall::TexImage2D:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const GLint level = reader.read<GLint>();
+        const GLint internalFormat = reader.read<GLint>();
+        const GLsizei width = reader.read<GLsizei>();
+        const GLsizei height = reader.read<GLsizei>();
+        const GLint border = reader.read<GLint>();
+        const GLenum format = reader.read<GLenum>();
+        const GLenum type = reader.read<GLenum>();
+        const Blob pixels = reader.readBlob();
+        gl::TexImage2D(target, level, internalFormat, width, height, border, format, type, 0 != pixels.size ? pixels.data : nullptr);
+        break;
+    }
+    case GlCall::TexParameteri:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const GLenum name = reader.read<GLenum>();
+        gl::TexParameteri(target, name, reader.read<GLint>());
+        break;
+    }
+    case GlCall::Viewport:
+    {
+        const GLint x = reader.read<GLint>();
+        const GLint y = reader.read<GLint>();
+        const GLsizei width = reader.read<GLsizei>();
+        gl::Viewport(x, y, width, reader.read<GLsizei>());
+        break;
+    }
+    case GlCall::CompressedTexImage2D:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const GLint level = reader.read<GLint>();
+        const GLenum internalFormat = reader.read<GLenum>();
+        const GLsizei width = reader.read<GLsizei>();
+        const GLsizei height = reader.read<GLsizei>();
+        const GLint border = reader.read<GLint>();
+        const Blob data = reader.readBlob();
+        gl::CompressedTexImage2D(target, level, internalFormat, width, height, border, GLsizei(data.size), data.data);
+        break;
+    }
+    case GlCall::CreateShader:
+    {
+        const GLenum type = reader.read<GLenum>();
+        maps.objects[reader.read<GLuint>()] = gl::CreateShader(type);
+        break;
+    }
+    case GlCall::ShaderSource:
+    {
+        const GLuint shader = lookup(maps.objects, reader.read<GLuint>());
+        const Blob source = reader.readBlob();
+        const gl::GLchar *string = reinterpret_cast<const gl::GLchar *>(source.data);
+        const GLint length = GLint(source.size);
+        gl::ShaderSource(shader, 1, &string, &length);
+        break;
+    }
+    case GlCall::CompileShader:
+        gl::CompileShader(lookup(maps.objects, reader.read<GLuint>()));
+        break;
+    case GlCall::GetShaderiv:
+    {
+        const GLuint shader = lookup(maps.objects, reader.read<GLuint>());
+        GLint value;
+        gl::GetShaderiv(shader, reader.read<GLenum>(), &value);
+        break;
+    }
+    case GlCall::GetShaderInfoLog:
+    {
+        const GLuint shader = lookup(maps.objects, reader.read<GLuint>());
+        std::vector<gl::GLchar> log(size_t(std::max(1, reader.read<GLsizei>())));
+        gl::GetShaderInfoLog(shader, GLsizei(log.size()), nullptr, log.data());
+        break;
+    }
+    case GlCall::DeleteShader:
+    {
+        const GLuint captured = reader.read<GLuint>();
+        gl::DeleteShader(lookup(maps.objects, captured));
+        maps.objects.erase(captured);
+        break;
+    }
+    case GlCall::CreateProgram:
+        maps.objects[reader.read<GLuint>()] = gl::CreateProgram();
+        break;
+    case GlCall::AttachShader:
+    {
+        const GLuint program = lookup(maps.objects, reader.read<GLuint>());
+        gl::AttachShader(program, lookup(maps.objects, reader.read<GLuint>()));
+        break;
+    }
+    case GlCall::LinkProgram:
+        gl::LinkProgram(lookup(maps.objects, reader.read<GLuint>()));
+        break;
+    case GlCall::GetProgramiv:
+    {
+        const GLuint program = lookup(maps.objects, reader.read<GLuint>());
+        GLint value;
+        gl::GetProgramiv(program, reader.read<GLenum>(), &value);
+        break;
+    }
+    case GlCall::GetProgramInfoLog:
+    {
+        const GLuint program = lookup(maps.objects, reader.read<GLuint>());
+        std::vector<gl::GLchar> log(size_t(std::max(1, reader.read<GLsizei>())));
+        gl::GetProgramInfoLog(program, GLsizei(log.size()), nullptr, log.data());
+        break;
+    }
+    case GlCall::UseProgram:
+        maps.currentProgram = reader.read<GLuint>();
+        gl::UseProgram(lookup(maps.objects, maps.currentProgram));
+        break;
+    case GlCall::GetUniformLocation:
+    {
+        const GLuint program = reader.read<GLuint>();
+        const GLint location = reader.read<GLint>();
+        const Blob name = reader.readBlob();
+        maps.uniformLocations[{ program, location }] = gl::GetUniformLocation(lookup(maps.objects, program), reinterpret_cast<const gl::GLchar *>(name.data));
+        break;
+    }
+    case GlCall::Uniform4f:
+    {
+        const GLint captured = reader.read<GLint>();
+        const auto found = maps.uniformLocations.find({ maps.currentProgram, captured });
+        const GLint location = maps.uniformLocations.end() != found ? found->second : -1;
+        const GLfloat x = reader.read<GLfloat>();
+        const GLfloat y = reader.read<GLfloat>();
+        const GLfloat z = reader.read<GLfloat>();
+        gl::Uniform4f(location, x, y, z, reader.read<GLfloat>());
+        break;
+    }
+    case GlCall::DeleteProgram:
+    {
+        const GLuint captured = reader.read<GLuint>();
+        gl::DeleteProgram(lookup(maps.objects, captured));
+        maps.objects.erase(captured);
+        break;
+    }
+    case GlCall::GenVertexArrays:
+        generate(gl::GenVertexArrays, maps.vertexArrays, reader.readNames());
+        break;
+    case GlCall::BindVertexArray:
+        gl::BindVertexArray(lookup(maps.vertexArrays, reader.read<GLuint>()));
+        break;
+    case GlCall::DeleteVertexArrays:
+    {
+        const std::vector<GLuint> names = deleted(maps.vertexArrays, reader.readNames());
+        gl::DeleteVertexArrays(GLsizei(names.size()), names.data());
+        break;
+    }
+    case GlCall::GenQueries:
+        generate(gl::GenQueries, maps.queries, reader.readNames());
+        break;
+    case GlCall::DeleteQueries:
+    {
+        const std::vector<GLuint> names = deleted(maps.queries, reader.readNames());
+        gl::DeleteQueries(GLsizei(names.size()), names.data());
+        break;
+    }
+    case GlCall::QueryCounter:
+    {
+        const GLuint query = lookup(maps.queries, reader.read<GLuint>());
+        gl::QueryCounter(query, reader.read<GLenum>());
+        break;
+    }
+    case GlCall::GetQueryObjectiv:
+    {
+        // results are discarded, but the reads stay as they may wait on the GPU
+        const GLuint query = lookup(maps.queries, reader.read<GLuint>());
+        GLint value;
+        gl::GetQueryObjectiv(query, reader.read<GLenum>(), &value);
+        break;
+    }
+    case GlCall::GetQueryObjectui64v:
+    {
+        const GLuint query = lookup(maps.queries, reader.read<GLuint>());
+        gl::GLuint64 value;
+        gl::GetQueryObjectui64v(query, reader.read<GLenum>(), &value);
+        break;
+    }
+    case GlCall::GetInteger64v:
+    {
+        gl::GLint64 value;
+        gl::GetInteger64v(reader.read<GLenum>(), &value);
+        break;
+    }
+    case GlCall::FenceSync:
+    {
+        const GLenum condition = reader.read<GLenum>();
+        const GLbitfield flags = reader.read<GLbitfield>();
+        maps.syncs[reader.read<uint64_t>()] = gl::FenceSync(condition, flags);
+        break;
+    }
+    case GlCall::WaitSync:
+    {
+        const gl::GLsync sync = lookup(maps.syncs, reader.read<uint64_t>());
+        const GLbitfield flags = reader.read<GLbitfield>();
+        gl::WaitSync(sync, flags, reader.read<gl::GLuint64>());
+        break;
+    }
+    case GlCall::DeleteSync:
+    {
+        const uint64_t captured = reader.read<uint64_t>();
+        gl::DeleteSync(lookup(maps.syncs, captured));
+        maps.syncs.erase(captured);
+        break;
+    }
+    case GlCall::ClientWaitSync:
+    {
+        const gl::GLsync sync = lookup(maps.syncs, reader.read<uint64_t>());
+        const GLbitfield flags = reader.read<GLbitfield>();
+        gl::ClientWaitSync(sync, flags, reader.read<gl::GLuint64>());
+        break;
+    }
+    case GlCall::GenBuffers:
+        generate(gl::GenBuffers, maps.buffers, reader.readNames());
+        break;
+    case GlCall::DeleteBuffers:
+    {
+        const std::vector<GLuint> captured = reader.readNames();
+        for (GLuint buffer : captured)
+        {
+            maps.mappings.erase(buffer);
+        }
+        const std::vector<GLuint> names = deleted(maps.buffers, captured);
+        gl::DeleteBuffers(GLsizei(names.size()), names.data());
+        break;
+    }
+    case GlCall::BindBuffer:
+    {
+        const GLenum target = reader.read<GLenum>();
+        gl::BindBuffer(target, lookup(maps.buffers, reader.read<GLuint>()));
+        break;
+    }
+    case GlCall::BufferData:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const gl::GLsizeiptr size = reader.read<gl::GLsizeiptr>();
+        const Blob data = reader.readBlob();
+        gl::BufferData(target, size, 0 != data.size ? data.data : nullptr, reader.read<GLenum>());
+        break;
+    }
+    case GlCall::BufferSubData:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const gl::GLintptr offset = reader.read<gl::GLintptr>();
+        const Blob data = reader.readBlob();
+        gl::BufferSubData(target, offset, gl::GLsizeiptr(data.size), data.data);
+        break;
+    }
+    case GlCall::MapBufferRange:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const GLuint buffer = reader.read<GLuint>();
+        const gl::GLintptr offset = reader.read<gl::GLintptr>();
+        const gl::GLsizeiptr length = reader.read<gl::GLsizeiptr>();
+        void *data = gl::MapBufferRange(target, offset, length, reader.read<GLbitfield>());
+        if (nullptr == data)
+        {
+            throw std::runtime_error("Failed to map a buffer the capture mapped");
+        }
+        maps.mappings[buffer] = data;
+        break;
+    }
+    case GlCall::UnmapBuffer:
+    {
+        const GLenum target = reader.read<GLenum>();
+        const GLuint buffer = reader.read<GLuint>();
+        const Blob written = reader.readBlob();
+        const auto found = maps.mappings.find(buffer);
+        if (maps.mappings.end() == found)
+        {
+            throw std::runtime_error("GL capture unmaps a buffer it never mapped");
+        }
+        memcpy(found->second, written.data, written.size);
+        maps.mappings.erase(found);
+        gl::UnmapBuffer(target);
+        break;
+    }
+    case GlCall::VertexAttribPointer:
+    {
+        const GLuint index = reader.read<GLuint>();
+        const GLint size = reader.read<GLint>();
+        const GLenum type = reader.read<GLenum>();
+        const GLboolean normalized = reader.read<GLboolean>();
+        const GLsizei stride = reader.read<GLsizei>();
+        gl::VertexAttribPointer(index, size, type, normalized, stride, bufferOffset(reader.read<uint64_t>()));
+        break;
+    }
+    case GlCall::EnableVertexAttribArray:
+        gl::EnableVertexAttribArray(reader.read<GLuint>());
+        break;
+    case GlCall::BufferStorage:
+    {
+        if (nullptr == gl::BufferStorage)
+        {
+            throw std::runtime_error("GL capture uses glBufferStorage, which this driver lacks");
+        }
+        const GLenum target = reader.read<GLenum>();
+        const gl::GLsizeiptr size = reader.read<gl::GLsizeiptr>();
+        const Blob data = reader.readBlob();
+        gl::BufferStorage(target, size, 0 != data.size ? data.data : nullptr, reader.read<GLbitfield>());
+        break;
+    }
+    case GlCall::BufferWrite:
+    {
+        const GLuint buffer = reader.read<GLuint>();
+        const uint32_t offset = reader.read<uint32_t>();
+        const Blob written = reader.readBlob();
+        const auto found = maps.mappings.find(buffer);
+        if (maps.mappings.end() == found)
+        {
+            throw std::runtime_error("GL capture writes through a buffer it never mapped");
+        }
+        memcpy(static_cast<uint8_t *>(found->second) + offset, written.data, written.size);
+        break;
+    }
+    case GlCall::Present:
+        return false;
+    default:
+        throw std::runtime_error("GL capture contains an unknown call " + std::to_string(int(call)));
+    }
+    return true;
+}
+
+static GLFWwindow *createWindow(const GlCaptureHeader &header, bool visible)
+{
+    // the ditty's context, falling back the same way
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(int(header.framebufferWidth), int(header.framebufferHeight), "OpenGL replay", nullptr, nullptr);
+    if (nullptr == window)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(int(header.framebufferWidth), int(header.framebufferHeight), "OpenGL replay", nullptr, nullptr);
+    }
+    if (nullptr == window)
+    {
+        throw std::runtime_error("Failed to create a window for the replay");
+    }
+    return window;
+}
+
+int main(int argc, char *argv[])
+{
+    const Options options = parseOptions(argc, argv);
+    if (nullptr == options.capturePath)
+    {
+        std::cerr << "Usage: gl_replay <capture> [--timing fast|recorded] [--show]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const MappedFile file(options.capturePath);
+    CaptureReader reader(file.data(), file.size());
+    const GlCaptureHeader header = reader.read<GlCaptureHeader>();
+    if (0 != memcmp(header.magic, GlCaptureMagic, sizeof(header.magic)) || GlCaptureVersion != header.version)
+    {
+        std::cerr << options.capturePath << " is not a version " << GlCaptureVersion << " GL capture" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!glfwInit())
+    {
+        return EXIT_FAILURE;
+    }
+    GLFWwindow *window = createWindow(header, options.show);
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    loadGlFunctions();
+    std::cout << "Replaying on " << reinterpret_cast<const char *>(gl::GetString(GL_RENDERER)) << ", " << reinterpret_cast<const char *>(gl::GetString(GL_VERSION)) << std::endl;
+
+    NameMaps maps;
+    DurationStats frameTimes;
+    uint64_t calls = 0;
+    uint64_t frames = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto frameStart = start;
+    while (!reader.finished())
+    {
+        ++calls;
+        const GlCall call = reader.read<GlCall>();
+        if (replayCall(call, reader, maps))
+        {
+            continue;
+        }
+
+        const uint64_t presentedAt = reader.read<uint64_t>();
+        if (options.recordedTiming)
+        {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(presentedAt));
+        }
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        const auto now = std::chrono::steady_clock::now();
+        frameTimes.add(now - frameStart);
+        frameStart = now;
+        ++frames;
+    }
+    // everything queued has to finish for the total to mean anything
+    gl::Finish();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Replayed " << calls << " calls over " << frames << " frames in " << seconds * 1000.0 << "ms";
+    if (seconds > 0.0)
+    {
+        std::cout << ", " << double(frames) / seconds << " frames/s";
+    }
+    std::cout << (options.recordedTiming ? " at the recorded timing" : " as fast as possible") << std::endl;
+    frameTimes.report(std::cout, "Replay frame time");
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include "gpu_timer.h"
+#include "trace.h"
+
+GpuTimer createGpuTimer()
+{
+    GpuTimer timer;
+    gl::GenQueries(2 * GpuTimer::Slots, timer.queries);
+
+    // the GL_TIMESTAMP read is synchronous, so bracket it on the CPU
+    gl::GLint64 gpuNanoseconds = 0;
+    const uint64_t cpuBefore = traceNow();
+    gl::GetInteger64v(GL_TIMESTAMP, &gpuNanoseconds);
+    const uint64_t cpuAfter = traceNow();
+    timer.gpuToCpuNanoseconds = int64_t(cpuBefore + (cpuAfter - cpuBefore) / 2) - gpuNanoseconds;
+
+    return timer;
+}
+
+// true once the slot's frame has completed, after adding it to the trace
+static bool collectSlot(GpuTimer &timer, uint32_t slot)
+{
+    if (!timer.pending[slot])
+    {
+        return true;
+    }
+
+    GLint available = 0;
+    gl::GetQueryObjectiv(timer.queries[2 * slot + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (GL_TRUE != available)
+    {
+        return false;
+    }
+
+    gl::GLuint64 start = 0;
+    gl::GLuint64 end = 0;
+    gl::GetQueryObjectui64v(timer.queries[2 * slot], GL_QUERY_RESULT, &start);
+    gl::GetQueryObjectui64v(timer.queries[2 * slot + 1], GL_QUERY_RESULT, &end);
+    traceGpuZone("frame", uint64_t(int64_t(start) + timer.gpuToCpuNanoseconds), uint64_t(int64_t(end) + timer.gpuToCpuNanoseconds));
+    timer.pending[slot] = false;
+    return true;
+}
+
+void beginGpuFrame(GpuTimer &timer)
+{
+    timer.frameOpen = collectSlot(timer, timer.nextSlot);
+    if (timer.frameOpen)
+    {
+        gl::QueryCounter(timer.queries[2 * timer.nextSlot], GL_TIMESTAMP);
+    }
+}
+
+void endGpuFrame(GpuTimer &timer)
+{
+    if (timer.frameOpen)
+    {
+        gl::QueryCounter(timer.queries[2 * timer.nextSlot + 1], GL_TIMESTAMP);
+        timer.pending[timer.nextSlot] = true;
+        timer.nextSlot = (timer.nextSlot + 1) % GpuTimer::Slots;
+        timer.frameOpen = false;
+    }
+}
+
+void collectGpuTimer(GpuTimer &timer)
+{
+    for (uint32_t slot = 0; slot < GpuTimer::Slots; ++slot)
+    {
+        collectSlot(timer, slot);
+    }
+}
+
+void destroyGpuTimer(const GpuTimer &timer)
+{
+    gl::DeleteQueries(2 * GpuTimer::Slots, timer.queries);
+}
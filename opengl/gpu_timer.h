@@ -0,0 +1,31 @@
+#pragma once
+
+#include "gl_functions.h"
+
+#include <cstdint>
+
+// GL_TIMESTAMP queries either side of each frame, added to the trace as GPU zones
+// Results are read back only once available, so a frame is left untimed if every slot is still
+// in flight. GPU time is mapped onto traceNow's clock by reading GL_TIMESTAMP at creation.
+// Must be used on the thread the context is current on, after loadGlFunctions.
+struct GpuTimer
+{
+    static constexpr uint32_t Slots = 8;
+
+    GLuint queries[2 * Slots];
+    bool pending[Slots] = {};
+    uint32_t nextSlot = 0;
+    bool frameOpen = false;
+    int64_t gpuToCpuNanoseconds;
+};
+
+GpuTimer createGpuTimer();
+
+void beginGpuFrame(GpuTimer &timer);
+
+void endGpuFrame(GpuTimer &timer);
+
+// Moves every completed frame into the trace
+void collectGpuTimer(GpuTimer &timer);
+
+void destroyGpuTimer(const GpuTimer &timer);
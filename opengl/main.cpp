@@ -1,5 +1,28 @@
 #include "GLFW/glfw3.h"
+#include "cpu_usage.h"
+#include "ditty_options.h"
+#include "event_channel.h"
+#include "frame_scheduler.h"
+#include "frame_stats.h"
+#include "gl_capture.h"
+#include "gpu_timer.h"
+#include "job_system.h"
+#include "multi_window.h"
+#include "perf_overlay.h"
+#include "procedural_texture.h"
+#include "sprite_renderer.h"
+#include "texture_blit.h"
+#include "trace.h"
+#include "window_events.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 static int last_error = GLFW_NO_ERROR;
 
@@ -9,21 +32,263 @@ static void error_callback(int code, const char *description)
     std::cerr << "glfw error code: " << code << " (" << description << ")" << std::endl;
 }
 
+struct Options : DittyOptions
+{
+    MultiWindowSettings multiWindow;
+    uint32_t sprites = 0;
+    uint16_t spritePages = 8;
+    bool immediateSprites = false;
+};
+
+static Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (parseDittyOption(argc, argv, i, options))
+        {
+            continue;
+        }
+
+        if (0 == strcmp(argv[i], "--swap-interval") && i + 1 < argc)
+        {
+            // a comma separated list, cycled over the windows
+            options.multiWindow.swapIntervals.clear();
+            std::istringstream intervals(argv[++i]);
+            std::string interval;
+            while (std::getline(intervals, interval, ','))
+            {
+                options.multiWindow.swapIntervals.push_back(atoi(interval.c_str()));
+            }
+            if (options.multiWindow.swapIntervals.empty())
+            {
+                options.multiWindow.swapIntervals.push_back(1);
+            }
+        }
+        else if (0 == strcmp(argv[i], "--window-step-seconds") && i + 1 < argc)
+        {
+            options.multiWindow.stepSeconds = atof(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--sprites") && i + 1 < argc)
+        {
+            options.sprites = uint32_t(std::max(0, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--sprite-pages") && i + 1 < argc)
+        {
+            options.spritePages = uint16_t(std::min(int(spriteMaxPages), std::max(1, atoi(argv[++i]))));
+        }
+        else if (0 == strcmp(argv[i], "--sprite-submission") && i + 1 < argc)
+        {
+            // batched or immediate, one draw per sprite for comparison
+            options.immediateSprites = 0 == strcmp(argv[++i], "immediate");
+        }
+        else
+        {
+            std::cerr << "Ignoring unknown option " << argv[i] << std::endl;
+        }
+    }
+    options.multiWindow.windowCount = options.windowCount;
+    if (options.sprites > 0 && options.windowCount > 1)
+    {
+        std::cerr << "Ignoring --sprites, only the single window ditty draws sprites" << std::endl;
+        options.sprites = 0;
+    }
+    if (options.hud && options.windowCount > 1)
+    {
+        std::cerr << "Ignoring --hud, only the single window ditty draws the HUD" << std::endl;
+        options.hud = false;
+    }
+    return options;
+}
+
 static float randomNumber()
 {
     return float(rand()) / float(RAND_MAX);
 }
 
-static void render(GLFWwindow *window)
+// GL objects belong to whichever thread renders, so the texture is uploaded there on first use
+struct Scene
+{
+    std::unique_ptr<ProceduralTexture> pendingTexture;
+    std::unique_ptr<TextureBlit> textureBlit;
+    std::unique_ptr<GpuTimer> gpuTimer;
+    bool functionsLoaded = false;
+
+    uint32_t spriteCount = 0;
+    uint16_t spritePages = 0;
+    bool immediateSprites = false;
+    std::unique_ptr<SpriteRenderer> spriteRenderer;
+    std::vector<GLuint> spritePageTextures;
+    SpriteBatcher spriteBatcher;
+    std::chrono::steady_clock::time_point spriteStart;
+
+    bool hud = false;
+    std::unique_ptr<PerfOverlay> perfOverlay;
+};
+
+static void drawSpriteField(const FramebufferSize &framebufferSize, Scene &scene)
+{
+    if (!scene.spriteRenderer)
+    {
+        // a region of at most 64K sprites, larger fields are drawn a region at a time
+        scene.spriteRenderer = std::make_unique<SpriteRenderer>(createSpriteRenderer(std::min(scene.spriteCount, 65536u)));
+        scene.spritePageTextures = createSpritePages(scene.spritePages, 32);
+        scene.spriteStart = std::chrono::steady_clock::now();
+    }
+
+    const int width = framebufferSize.width;
+    const int height = framebufferSize.height;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scene.spriteStart).count();
+    clearSprites(scene.spriteBatcher);
+    addSpriteField(scene.spriteBatcher, scene.spriteCount, scene.spritePages, float(width), float(height), seconds);
+    if (scene.immediateSprites)
+    {
+        drawSpritesImmediate(*scene.spriteRenderer, scene.spriteBatcher, scene.spritePageTextures.data(), width, height);
+    }
+    else
+    {
+        drawSprites(*scene.spriteRenderer, scene.spriteBatcher, scene.spritePageTextures.data(), width, height);
+    }
+}
+
+static void render(GLFWwindow *window, const FramebufferSize &framebufferSize, Scene &scene)
 {
+    TRACE_FUNCTION();
     glfwMakeContextCurrent(window);
 
-    glClearColor(randomNumber(), randomNumber(), randomNumber(), 1);
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (!scene.functionsLoaded)
+    {
+        loadGlFunctions();
+        scene.functionsLoaded = true;
+    }
+    if (traceRecording() && !scene.gpuTimer)
+    {
+        scene.gpuTimer = std::make_unique<GpuTimer>(createGpuTimer());
+    }
+    if (scene.gpuTimer)
+    {
+        beginGpuFrame(*scene.gpuTimer);
+    }
+    if (scene.hud && !scene.perfOverlay)
+    {
+        scene.perfOverlay = std::make_unique<PerfOverlay>(createPerfOverlay());
+    }
+    if (scene.perfOverlay)
+    {
+        beginPerfOverlayFrame(*scene.perfOverlay);
+    }
+
+    if (scene.pendingTexture)
+    {
+        scene.textureBlit = std::make_unique<TextureBlit>(createTextureBlit(*scene.pendingTexture));
+        scene.pendingTexture.reset();
+    }
+
+    gl::ClearColor(randomNumber(), randomNumber(), randomNumber(), 1);
+    gl::Clear(GL_COLOR_BUFFER_BIT);
+
+    if (scene.textureBlit)
+    {
+        drawTextureBlit(*scene.textureBlit, framebufferSize.width, framebufferSize.height);
+    }
+
+    if (scene.spriteCount > 0)
+    {
+        drawSpriteField(framebufferSize, scene);
+    }
+
+    if (scene.perfOverlay)
+    {
+        drawPerfOverlay(*scene.perfOverlay, framebufferSize.width, framebufferSize.height);
+    }
+
+    if (scene.gpuTimer)
+    {
+        endGpuFrame(*scene.gpuTimer);
+    }
+}
+
+static void destroyScene(Scene &scene)
+{
+    if (scene.gpuTimer)
+    {
+        gl::Finish();
+        collectGpuTimer(*scene.gpuTimer);
+        destroyGpuTimer(*scene.gpuTimer);
+        scene.gpuTimer.reset();
+    }
+    if (scene.textureBlit)
+    {
+        destroyTextureBlit(*scene.textureBlit);
+        scene.textureBlit.reset();
+    }
+    if (scene.spriteRenderer)
+    {
+        reportSpriteRenderer(std::cout, *scene.spriteRenderer, scene.immediateSprites ? "Sprites (immediate)" : "Sprites (batched)");
+        destroySpriteRenderer(*scene.spriteRenderer);
+        scene.spriteRenderer.reset();
+        gl::DeleteTextures(GLsizei(scene.spritePageTextures.size()), scene.spritePageTextures.data());
+        scene.spritePageTextures.clear();
+    }
+    if (scene.perfOverlay)
+    {
+        reportPerfOverlay(std::cout, *scene.perfOverlay);
+        destroyPerfOverlay(*scene.perfOverlay);
+        scene.perfOverlay.reset();
+    }
+}
+
+static void present(GLFWwindow *window, const Options &options)
+{
+    TRACE_FUNCTION();
+    if (options.presentStallMs > 0)
+    {
+        // simulate a slow compositor or driver
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.presentStallMs));
+    }
+    glfwSwapBuffers(window);
+    if (nullptr != options.capturePath)
+    {
+        captureGlPresent();
+    }
+}
+
+// owns the GL context for as long as it runs; only returns once the channel is closed
+static void renderThreadLoop(GLFWwindow *window, FramebufferSize framebufferSize, Scene &scene, EventChannel &channel, FrameScheduler &scheduler, FrameStats &frameStats, CpuUsage &cpuUsage, const Options &options)
+{
+    TRACE_THREAD("render");
+    while (!channel.isClosed())
+    {
+        drainEvents(channel, scheduler, frameStats, &framebufferSize);
+
+        if (scheduler.shouldRender())
+        {
+            render(window, framebufferSize, scene);
+            present(window, options);
+
+            scheduler.frameRendered();
+            frameStats.framePresented();
+            cpuUsage.frameRendered();
+        }
+        else
+        {
+            channel.wait(scheduler.waitTimeout());
+        }
+    }
+
+    destroyScene(scene);
+    glfwMakeContextCurrent(nullptr);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    const Options options = parseOptions(argc, argv);
+    if (nullptr != options.tracePath && !startTrace())
+    {
+        std::cerr << "Built without DITTY_TRACE, ignoring --trace" << std::endl;
+    }
+    TRACE_THREAD("main");
+
     if (!glfwInit())
     {
         return -1;
@@ -40,6 +305,12 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    // with several windows this one is the hidden loader the others share objects with
+    const bool multiWindow = options.windowCount > 1;
+    if (multiWindow)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
     GLFWwindow *window = glfwCreateWindow(640, 480, "OpenGL ditty", NULL, NULL);
     if (nullptr == window && GLFW_VERSION_UNAVAILABLE == last_error)
     {
@@ -49,12 +320,105 @@ int main()
         window = glfwCreateWindow(640, 480, "OpenGL ditty", NULL, NULL);
     }
 
-    while (!glfwWindowShouldClose(window))
+    JobSystem jobs;
+    Scene scene;
+    scene.spriteCount = options.sprites;
+    scene.spritePages = options.spritePages;
+    scene.immediateSprites = options.immediateSprites;
+    scene.hud = options.hud;
+    if (nullptr != options.proceduralTexture)
     {
-        render(window);
+        scene.pendingTexture = std::make_unique<ProceduralTexture>(generateProceduralTexture(options.proceduralTextureSize, textureEncodingFromName(options.proceduralTexture), &jobs));
+    }
+
+    if (multiWindow)
+    {
+        if (nullptr != options.capturePath)
+        {
+            std::cerr << "Ignoring --capture, only a single window can be captured" << std::endl;
+        }
+        MultiWindowSettings settings = options.multiWindow;
+        settings.presentStallMs = options.presentStallMs;
+        runMultiWindow(window, settings, scene.pendingTexture.get(), std::cout);
+        if (traceRecording())
+        {
+            writeTrace(options.tracePath);
+            std::cout << "Wrote trace to " << options.tracePath << std::endl;
+        }
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    // GLFW only answers this on the main thread, from here on the renderer follows resize events
+    FramebufferSize framebufferSize;
+    glfwGetFramebufferSize(window, &framebufferSize.width, &framebufferSize.height);
+
+    if (nullptr != options.capturePath)
+    {
+        startGlCapture(options.capturePath, framebufferSize.width, framebufferSize.height);
+    }
+
+    EventChannel channel;
+    installEventCallbacks(window, channel);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    FrameScheduler scheduler(options.onDemand);
+    // the sprite field moves and the HUD's numbers change every frame, so on demand rendering
+    // can't wait for events
+    scheduler.setAnimating(scene.spriteCount > 0 || scene.hud);
+    FrameStats frameStats;
+    CpuUsage cpuUsage;
+
+    if (options.renderThread)
+    {
+        std::thread renderThread(renderThreadLoop, window, framebufferSize, std::ref(scene), std::ref(channel), std::ref(scheduler), std::ref(frameStats), std::ref(cpuUsage), std::cref(options));
+
+        // this thread only pumps events from here on
+        while (!glfwWindowShouldClose(window))
+        {
+            glfwWaitEvents();
+        }
+
+        channel.close();
+        renderThread.join();
+    }
+    else
+    {
+        while (!glfwWindowShouldClose(window))
+        {
+            drainEvents(channel, scheduler, frameStats, &framebufferSize);
+
+            if (scheduler.shouldRender())
+            {
+                render(window, framebufferSize, scene);
+                present(window, options);
+
+                scheduler.frameRendered();
+                frameStats.framePresented();
+                cpuUsage.frameRendered();
+            }
+
+            pumpEvents(scheduler);
+        }
+
+        destroyScene(scene);
+    }
+
+    if (nullptr != options.capturePath)
+    {
+        stopGlCapture(std::cout);
+    }
+
+    cpuUsage.report(std::cout, options.onDemand ? "OpenGL ditty (on-demand)" : "OpenGL ditty (continuous)");
+    frameStats.report(std::cout);
+    if (channel.droppedEvents() > 0)
+    {
+        std::cout << "Dropped " << channel.droppedEvents() << " window events" << std::endl;
+    }
+    if (traceRecording())
+    {
+        writeTrace(options.tracePath);
+        std::cout << "Wrote trace to " << options.tracePath << std::endl;
     }
 
     glfwDestroyWindow(window);
@@ -0,0 +1,242 @@
+#include "multi_window.h"
+
+#include "gl_functions.h"
+#include "texture_blit.h"
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // what the loader has uploaded, once its fence is in the command stream
+    struct SharedUploads
+    {
+        std::mutex mutex;
+        bool ready = false;
+        TextureBlit blit;
+        gl::GLsync fence = nullptr;
+    };
+
+    struct WindowRenderer
+    {
+        GLFWwindow *window;
+        int swapInterval;
+        float clearColor[3];
+        // kept by the main thread, as only it may ask GLFW for the size
+        std::atomic<int> framebufferWidth{ 0 };
+        std::atomic<int> framebufferHeight{ 0 };
+        std::atomic<uint64_t> frames{ 0 };
+        std::thread thread;
+    };
+
+    struct WindowCountRate
+    {
+        uint32_t windows;
+        double framesPerSecond;
+    };
+}
+
+static void loadShared(GLFWwindow *loader, const ProceduralTexture &texture, SharedUploads &uploads)
+{
+    TRACE_THREAD("loader");
+    glfwMakeContextCurrent(loader);
+    try
+    {
+        const TextureBlit blit = createTextureBlit(texture);
+        const gl::GLsync fence = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // the fence has to reach the GPU before another context can wait on it
+        gl::Flush();
+
+        std::lock_guard<std::mutex> lock(uploads.mutex);
+        uploads.blit = blit;
+        uploads.fence = fence;
+        uploads.ready = true;
+    }
+    catch (const std::exception &exception)
+    {
+        std::cerr << "Loader context failed, the windows render without the texture: " << exception.what() << std::endl;
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+static void renderWindow(WindowRenderer &renderer, SharedUploads &uploads, const std::atomic<bool> &stop, int presentStallMs)
+{
+    TRACE_THREAD("window render");
+    glfwMakeContextCurrent(renderer.window);
+    glfwSwapInterval(renderer.swapInterval);
+
+    std::unique_ptr<TextureBlit> blit;
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        TRACE_ZONE("window frame");
+        if (!blit)
+        {
+            std::lock_guard<std::mutex> lock(uploads.mutex);
+            if (uploads.ready)
+            {
+                // a GPU side wait, so this thread carries on queueing commands behind it
+                gl::WaitSync(uploads.fence, 0, GL_TIMEOUT_IGNORED);
+                blit = std::make_unique<TextureBlit>(shareTextureBlit(uploads.blit));
+            }
+        }
+
+        gl::ClearColor(renderer.clearColor[0], renderer.clearColor[1], renderer.clearColor[2], 1);
+        gl::Clear(GL_COLOR_BUFFER_BIT);
+        if (blit)
+        {
+            drawTextureBlit(*blit, renderer.framebufferWidth.load(std::memory_order_relaxed), renderer.framebufferHeight.load(std::memory_order_relaxed));
+        }
+
+        if (presentStallMs > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(presentStallMs));
+        }
+        glfwSwapBuffers(renderer.window);
+        renderer.frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (blit)
+    {
+        releaseSharedTextureBlit(*blit);
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void runMultiWindow(GLFWwindow *loader, const MultiWindowSettings &settings, const ProceduralTexture *texture, std::ostream &stream)
+{
+    // every window is created before the loader's context is made current on another thread, as
+    // some platforms can't share with a context that is current elsewhere
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    std::vector<std::unique_ptr<WindowRenderer>> renderers;
+    for (uint32_t i = 0; i < settings.windowCount; ++i)
+    {
+        const std::string title = "OpenGL ditty " + std::to_string(i + 1);
+        GLFWwindow *window = glfwCreateWindow(320, 240, title.c_str(), nullptr, loader);
+        if (nullptr == window)
+        {
+            break;
+        }
+        auto renderer = std::make_unique<WindowRenderer>();
+        renderer->window = window;
+        renderer->swapInterval = settings.swapIntervals[i % settings.swapIntervals.size()];
+        const float hue = float(i) / float(settings.windowCount);
+        renderer->clearColor[0] = 0.2f + 0.6f * hue;
+        renderer->clearColor[1] = 0.8f - 0.6f * hue;
+        renderer->clearColor[2] = 0.5f;
+        glfwSetWindowPos(window, 40 + 340 * int(i % 4), 40 + 280 * int(i / 4 % 3));
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        renderer->framebufferWidth = width;
+        renderer->framebufferHeight = height;
+        glfwSetWindowUserPointer(window, renderer.get());
+        glfwSetFramebufferSizeCallback(window, [](GLFWwindow *window, int width, int height)
+        {
+            WindowRenderer &renderer = *static_cast<WindowRenderer *>(glfwGetWindowUserPointer(window));
+            renderer.framebufferWidth.store(width, std::memory_order_relaxed);
+            renderer.framebufferHeight.store(height, std::memory_order_relaxed);
+        });
+        renderers.push_back(std::move(renderer));
+    }
+    if (renderers.empty())
+    {
+        throw std::runtime_error("Failed to create a window sharing the loader's context");
+    }
+
+    SharedUploads uploads;
+    std::thread loaderThread;
+    if (nullptr != texture)
+    {
+        loaderThread = std::thread(loadShared, loader, std::cref(*texture), std::ref(uploads));
+    }
+
+    std::atomic<bool> stop{ false };
+    uint32_t running = 0;
+    const auto startNextWindow = [&]()
+    {
+        WindowRenderer &renderer = *renderers[running++];
+        glfwShowWindow(renderer.window);
+        renderer.thread = std::thread(renderWindow, std::ref(renderer), std::ref(uploads), std::cref(stop), settings.presentStallMs);
+    };
+    const auto totalFrames = [&]()
+    {
+        uint64_t frames = 0;
+        for (const auto &renderer : renderers)
+        {
+            frames += renderer->frames.load(std::memory_order_relaxed);
+        }
+        return frames;
+    };
+    const auto anyWindowClosed = [&]()
+    {
+        for (uint32_t i = 0; i < running; ++i)
+        {
+            if (glfwWindowShouldClose(renderers[i]->window))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<WindowCountRate> rates;
+    startNextWindow();
+    auto stepStart = std::chrono::steady_clock::now();
+    uint64_t stepFrames = 0;
+    const auto endStep = [&]()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const uint64_t frames = totalFrames();
+        const double seconds = std::chrono::duration<double>(now - stepStart).count();
+        if (seconds > 0.0)
+        {
+            rates.push_back({ running, double(frames - stepFrames) / seconds });
+        }
+        stepStart = now;
+        stepFrames = frames;
+    };
+    while (!anyWindowClosed())
+    {
+        glfwWaitEventsTimeout(0.05);
+        if (running < renderers.size() && std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count() >= settings.stepSeconds)
+        {
+            endStep();
+            startNextWindow();
+        }
+    }
+    endStep();
+
+    stop.store(true, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < running; ++i)
+    {
+        renderers[i]->thread.join();
+    }
+    if (loaderThread.joinable())
+    {
+        loaderThread.join();
+    }
+
+    glfwMakeContextCurrent(loader);
+    if (uploads.ready)
+    {
+        destroyTextureBlit(uploads.blit);
+        gl::DeleteSync(uploads.fence);
+    }
+    glfwMakeContextCurrent(nullptr);
+    for (const auto &renderer : renderers)
+    {
+        glfwDestroyWindow(renderer->window);
+    }
+
+    for (const WindowCountRate &rate : rates)
+    {
+        stream << rate.windows << (1 == rate.windows ? " window: " : " windows: ") << rate.framesPerSecond << " frames/s aggregate, "
+               << rate.framesPerSecond / rate.windows << " per window" << std::endl;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "GLFW/glfw3.h"
+#include "procedural_texture.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+struct MultiWindowSettings
+{
+    uint32_t windowCount = 1;
+    std::vector<int> swapIntervals = { 1 }; // cycled over the windows
+    double stepSeconds = 2.0; // how long each window count runs before the next window opens
+    int presentStallMs = 0;
+};
+
+// Windows rendered continuously, each on its own thread with its own context and swap interval
+// Every context shares objects with the hidden loader window's, which uploads the texture on a
+// thread of its own and publishes it with a fence; a window thread waits on the fence before
+// first drawing the texture. The windows open one at a time, each count running stepSeconds,
+// and the aggregate frames per second of each count is reported once any window is closed.
+// Must be called on the main thread, with the window hints the loader was created with still set.
+void runMultiWindow(GLFWwindow *loader, const MultiWindowSettings &settings, const ProceduralTexture *texture, std::ostream &stream);
@@ -0,0 +1,273 @@
+#include "perf_overlay.h"
+
+#include "gl_program.h"
+#include "process_memory.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+static const char *vertexShaderSource = R"(#version 330 core
+uniform vec4 viewport; // pixels to clip space, scale in xy and offset in zw
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 tint;
+out vec2 uv;
+out vec4 hudColor;
+void main()
+{
+    uv = texCoord;
+    hudColor = tint;
+    gl_Position = vec4(position * viewport.xy + viewport.zw, 0.0, 1.0);
+}
+)";
+
+static const char *fragmentShaderSource = R"(#version 330 core
+uniform sampler2D atlas;
+in vec2 uv;
+in vec4 hudColor;
+out vec4 color;
+void main()
+{
+    color = vec4(hudColor.rgb, hudColor.a * texture(atlas, uv).r);
+}
+)";
+
+static constexpr size_t slotBytes = hudMaxQuads * 4 * sizeof(SpriteVertex);
+
+// resident memory is read from the OS, so only every this many frames
+static constexpr uint32_t residentInterval = 30;
+
+static void collectSlot(PerfOverlay &overlay, uint32_t slot)
+{
+    if (!overlay.pending[slot])
+    {
+        return;
+    }
+    GLint available = 0;
+    gl::GetQueryObjectiv(overlay.queries[3 * slot + 2], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (GL_TRUE != available)
+    {
+        return;
+    }
+
+    gl::GLuint64 timestamps[3];
+    for (uint32_t query = 0; query < 3; ++query)
+    {
+        gl::GetQueryObjectui64v(overlay.queries[3 * slot + query], GL_QUERY_RESULT, &timestamps[query]);
+    }
+    const auto hudGpu = std::chrono::nanoseconds(timestamps[2] - timestamps[1]);
+    const double hudMs = std::chrono::duration<double, std::milli>(hudGpu).count();
+    addHudGpuFrame(overlay.stats, float(double(timestamps[1] - timestamps[0]) * 1e-6), float(hudMs));
+    overlay.hudGpuTime.add(hudGpu);
+    overlay.hudGpuMilliseconds += hudMs;
+    ++overlay.hudGpuFrames;
+    overlay.pending[slot] = false;
+}
+
+static void waitForSlot(PerfOverlay &overlay, uint32_t slot)
+{
+    gl::GLsync &fence = overlay.fences[slot];
+    if (nullptr == fence)
+    {
+        return;
+    }
+    GLenum result = gl::ClientWaitSync(fence, 0, 0);
+    if (GL_ALREADY_SIGNALED != result && GL_CONDITION_SATISFIED != result)
+    {
+        ++overlay.fenceWaits;
+        do
+        {
+            result = gl::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (GL_TIMEOUT_EXPIRED == result);
+    }
+    gl::DeleteSync(fence);
+    fence = nullptr;
+    if (GL_WAIT_FAILED == result)
+    {
+        throw std::runtime_error("Failed to wait for a HUD vertex slot");
+    }
+}
+
+PerfOverlay createPerfOverlay()
+{
+    TRACE_FUNCTION();
+    PerfOverlay overlay;
+    overlay.program = createGlProgram(vertexShaderSource, fragmentShaderSource);
+    overlay.viewportLocation = gl::GetUniformLocation(overlay.program, "viewport");
+    overlay.stats.presentMode = "SWAP BUFFERS";
+    overlay.stats.swapChainImages = 2;
+
+    const std::vector<uint8_t> texels = bakeHudAtlas();
+    gl::GenTextures(1, &overlay.atlas);
+    gl::BindTexture(GL_TEXTURE_2D, overlay.atlas);
+    gl::PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl::TexImage2D(GL_TEXTURE_2D, 0, GL_R8, GLsizei(hudAtlasWidth), GLsizei(hudAtlasHeight), 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+
+    gl::GenVertexArrays(PerfOverlay::Slots, overlay.vertexArrays);
+    gl::BindVertexArray(overlay.vertexArrays[0]);
+
+    std::vector<uint16_t> indices(size_t(hudMaxQuads) * 6);
+    for (uint32_t i = 0; i < hudMaxQuads; ++i)
+    {
+        const uint16_t vertex = uint16_t(4 * i);
+        const uint16_t quad[6] = { vertex, uint16_t(vertex + 1), uint16_t(vertex + 2), vertex, uint16_t(vertex + 2), uint16_t(vertex + 3) };
+        std::copy(quad, quad + 6, indices.begin() + 6 * size_t(i));
+    }
+    gl::GenBuffers(1, &overlay.indexBuffer);
+    gl::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, overlay.indexBuffer);
+    gl::BufferData(GL_ELEMENT_ARRAY_BUFFER, gl::GLsizeiptr(indices.size() * sizeof(uint16_t)), indices.data(), GL_STATIC_DRAW);
+
+    const gl::GLsizeiptr bufferBytes = gl::GLsizeiptr(PerfOverlay::Slots * slotBytes);
+    gl::GenBuffers(1, &overlay.vertexBuffer);
+    gl::BindBuffer(GL_ARRAY_BUFFER, overlay.vertexBuffer);
+    if (nullptr != gl::BufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        gl::BufferStorage(GL_ARRAY_BUFFER, bufferBytes, nullptr, flags);
+        overlay.mapped = static_cast<SpriteVertex *>(gl::MapBufferRange(GL_ARRAY_BUFFER, 0, bufferBytes, flags));
+        if (nullptr == overlay.mapped)
+        {
+            throw std::runtime_error("Failed to map the HUD vertex buffer");
+        }
+    }
+    else
+    {
+        gl::BufferData(GL_ARRAY_BUFFER, bufferBytes, nullptr, GL_STREAM_DRAW);
+    }
+
+    // the element array binding is vertex array state, so each vertex array binds the index buffer too
+    for (uint32_t slot = 0; slot < PerfOverlay::Slots; ++slot)
+    {
+        const size_t offset = slot * slotBytes;
+        const auto at = [offset](size_t member)
+        {
+            return reinterpret_cast<const void *>(offset + member);
+        };
+        gl::BindVertexArray(overlay.vertexArrays[slot]);
+        gl::BindBuffer(GL_ARRAY_BUFFER, overlay.vertexBuffer);
+        gl::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, overlay.indexBuffer);
+        gl::VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), at(offsetof(SpriteVertex, x)));
+        gl::VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), at(offsetof(SpriteVertex, u)));
+        gl::VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), at(offsetof(SpriteVertex, color)));
+        for (GLuint attribute = 0; attribute < 3; ++attribute)
+        {
+            gl::EnableVertexAttribArray(attribute);
+        }
+    }
+    gl::BindVertexArray(0);
+
+    gl::GenQueries(3 * PerfOverlay::Slots, overlay.queries);
+    return overlay;
+}
+
+void beginPerfOverlayFrame(PerfOverlay &overlay)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (overlay.started)
+    {
+        addHudCpuFrame(overlay.stats, float(std::chrono::duration<double, std::milli>(now - overlay.frameStart).count()), overlay.lastCpuMs);
+    }
+    overlay.frameStart = now;
+    overlay.started = true;
+    if (0 == overlay.stats.cpuFrames % residentInterval)
+    {
+        overlay.stats.residentBytes = currentResidentBytes();
+    }
+
+    // the slot's last frame has to be done before its vertices are rewritten, so its timestamps are in
+    waitForSlot(overlay, overlay.slot);
+    collectSlot(overlay, overlay.slot);
+    overlay.pending[overlay.slot] = false;
+    gl::QueryCounter(overlay.queries[3 * overlay.slot], GL_TIMESTAMP);
+}
+
+void drawPerfOverlay(PerfOverlay &overlay, int framebufferWidth, int framebufferHeight)
+{
+    TRACE_FUNCTION();
+    const uint32_t slot = overlay.slot;
+
+    const auto layoutStart = std::chrono::steady_clock::now();
+    uint32_t quads;
+    if (nullptr != overlay.mapped)
+    {
+        quads = layoutPerfHud(overlay.stats, overlay.mapped + slot * hudMaxQuads * 4);
+    }
+    else
+    {
+        gl::BindBuffer(GL_ARRAY_BUFFER, overlay.vertexBuffer);
+        void *mapped = gl::MapBufferRange(GL_ARRAY_BUFFER, gl::GLintptr(slot * slotBytes), gl::GLsizeiptr(slotBytes),
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (nullptr == mapped)
+        {
+            throw std::runtime_error("Failed to map the HUD vertex buffer");
+        }
+        quads = layoutPerfHud(overlay.stats, static_cast<SpriteVertex *>(mapped));
+        gl::UnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    overlay.layoutTime.add(std::chrono::steady_clock::now() - layoutStart);
+
+    gl::QueryCounter(overlay.queries[3 * slot + 1], GL_TIMESTAMP);
+    gl::UseProgram(overlay.program);
+    gl::Uniform4f(overlay.viewportLocation, 2.0f / float(framebufferWidth), -2.0f / float(framebufferHeight), -1.0f, 1.0f);
+    gl::BindTexture(GL_TEXTURE_2D, overlay.atlas);
+    gl::Enable(GL_BLEND);
+    gl::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl::BindVertexArray(overlay.vertexArrays[slot]);
+    gl::DrawElements(GL_TRIANGLES, GLsizei(quads * 6), GL_UNSIGNED_SHORT, nullptr);
+    gl::BindVertexArray(0);
+    gl::Disable(GL_BLEND);
+    gl::QueryCounter(overlay.queries[3 * slot + 2], GL_TIMESTAMP);
+
+    overlay.fences[slot] = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    overlay.pending[slot] = true;
+    overlay.slot = (slot + 1) % PerfOverlay::Slots;
+    overlay.lastCpuMs = float(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - overlay.frameStart).count());
+}
+
+void reportPerfOverlay(std::ostream &stream, const PerfOverlay &overlay)
+{
+    stream << "Performance HUD: " << (nullptr != overlay.mapped ? "persistently mapped" : "unsynchronized map per frame") << ", " << overlay.fenceWaits
+           << " fence waits" << std::endl;
+    overlay.layoutTime.report(stream, "HUD layout CPU time");
+    if (0 == overlay.hudGpuFrames)
+    {
+        stream << "HUD GPU time: no frames timed" << std::endl;
+        return;
+    }
+    overlay.hudGpuTime.report(stream, "HUD GPU time");
+    const double meanMs = overlay.hudGpuMilliseconds / double(overlay.hudGpuFrames);
+    if (meanMs > 0.1)
+    {
+        stream << "HUD GPU time averages " << meanMs << " ms, over its 0.1 ms budget" << std::endl;
+    }
+}
+
+void destroyPerfOverlay(const PerfOverlay &overlay)
+{
+    for (gl::GLsync fence : overlay.fences)
+    {
+        if (nullptr != fence)
+        {
+            gl::DeleteSync(fence);
+        }
+    }
+    gl::DeleteQueries(3 * PerfOverlay::Slots, overlay.queries);
+    if (nullptr != overlay.mapped)
+    {
+        gl::BindBuffer(GL_ARRAY_BUFFER, overlay.vertexBuffer);
+        gl::UnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    gl::DeleteVertexArrays(PerfOverlay::Slots, overlay.vertexArrays);
+    const GLuint buffers[2] = { overlay.vertexBuffer, overlay.indexBuffer };
+    gl::DeleteBuffers(2, buffers);
+    gl::DeleteTextures(1, &overlay.atlas);
+    gl::DeleteProgram(overlay.program);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "frame_stats.h"
+#include "gl_functions.h"
+#include "perf_hud.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+// The performance HUD, drawn over the frame with one indexed draw from the baked font atlas
+// Vertices are written straight into a ring of fenced slots in a persistently mapped buffer where
+// the context has buffer storage, and through unsynchronized maps of the slot otherwise.
+// GL_TIMESTAMP queries bracket the frame and the HUD's draw; they are read once the slot's fence
+// has passed, so the HUD never stalls the pipeline. Must be used on the thread the context is
+// current on.
+struct PerfOverlay
+{
+    static constexpr uint32_t Slots = 3;
+
+    GLuint program;
+    GLint viewportLocation;
+    GLuint atlas;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint vertexArrays[Slots];
+    SpriteVertex *mapped = nullptr; // every slot, when persistently mapped
+    gl::GLsync fences[Slots] = {};
+    // frame begin, HUD begin and HUD end per slot
+    GLuint queries[3 * Slots];
+    bool pending[Slots] = {};
+    uint32_t slot = 0;
+    uint64_t fenceWaits = 0;
+
+    PerfHudStats stats;
+    std::chrono::steady_clock::time_point frameStart;
+    float lastCpuMs = 0.0f;
+    bool started = false;
+
+    DurationStats layoutTime;
+    DurationStats hudGpuTime;
+    double hudGpuMilliseconds = 0.0;
+    uint64_t hudGpuFrames = 0;
+};
+
+PerfOverlay createPerfOverlay();
+
+// At the start of the frame, before any of its GL calls
+void beginPerfOverlayFrame(PerfOverlay &overlay);
+
+// Draws the HUD over whatever the frame has drawn; the frame's CPU time runs from the begin to
+// the end of this call and shows from the next frame
+void drawPerfOverlay(PerfOverlay &overlay, int framebufferWidth, int framebufferHeight);
+
+// The HUD's own GPU and CPU cost, against the 0.1 ms it is allowed on the GPU
+void reportPerfOverlay(std::ostream &stream, const PerfOverlay &overlay);
+
+void destroyPerfOverlay(const PerfOverlay &overlay);
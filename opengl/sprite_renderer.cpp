@@ -0,0 +1,321 @@
+#include "sprite_renderer.h"
+
+#include "gl_program.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+static const char *vertexShaderSource = R"(#version 330 core
+uniform vec4 viewport; // pixels to clip space, scale in xy and offset in zw
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 tint;
+out vec2 uv;
+out vec4 spriteColor;
+void main()
+{
+    uv = texCoord;
+    spriteColor = tint;
+    gl_Position = vec4(position * viewport.xy + viewport.zw, 0.0, 1.0);
+}
+)";
+
+static const char *fragmentShaderSource = R"(#version 330 core
+uniform sampler2D page;
+in vec2 uv;
+in vec4 spriteColor;
+out vec4 color;
+void main()
+{
+    color = texture(page, uv) * spriteColor;
+}
+)";
+
+static constexpr size_t quadVertexBytes = 4 * sizeof(SpriteVertex);
+static constexpr size_t quadIndexBytes = 6 * sizeof(uint32_t);
+
+// the element array binding is vertex array state, so each vertex array binds the index buffer too
+static void setSpriteAttributes(GLuint vertexArray, GLuint vertexBuffer, GLuint indexBuffer, size_t offset)
+{
+    gl::BindVertexArray(vertexArray);
+    gl::BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    gl::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    const auto at = [offset](size_t member)
+    {
+        return reinterpret_cast<const void *>(offset + member);
+    };
+    gl::VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), at(offsetof(SpriteVertex, x)));
+    gl::VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), at(offsetof(SpriteVertex, u)));
+    gl::VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), at(offsetof(SpriteVertex, color)));
+    for (GLuint attribute = 0; attribute < 3; ++attribute)
+    {
+        gl::EnableVertexAttribArray(attribute);
+    }
+}
+
+static void applyBlend(SpriteBlend blend)
+{
+    switch (blend)
+    {
+    case SpriteBlend::Opaque:
+        gl::Disable(GL_BLEND);
+        break;
+    case SpriteBlend::Alpha:
+        gl::Enable(GL_BLEND);
+        gl::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    case SpriteBlend::Additive:
+        gl::Enable(GL_BLEND);
+        gl::BlendFunc(GL_ONE, GL_ONE);
+        break;
+    }
+}
+
+static void addSubmitTime(SpriteRenderer &renderer, std::chrono::steady_clock::duration elapsed)
+{
+    renderer.submitTime.add(elapsed);
+    renderer.submitMilliseconds += std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+static void beginSprites(const SpriteRenderer &renderer, int framebufferWidth, int framebufferHeight)
+{
+    gl::UseProgram(renderer.program);
+    gl::Uniform4f(renderer.viewportLocation, 2.0f / float(framebufferWidth), -2.0f / float(framebufferHeight), -1.0f, 1.0f);
+}
+
+// Waits for the GPU to finish drawing from the region the last time round the ring
+static void waitForRegion(SpriteRenderer &renderer, uint32_t region)
+{
+    gl::GLsync &fence = renderer.fences[region];
+    if (nullptr == fence)
+    {
+        return;
+    }
+    GLenum result = gl::ClientWaitSync(fence, 0, 0);
+    if (GL_ALREADY_SIGNALED != result && GL_CONDITION_SATISFIED != result)
+    {
+        ++renderer.fenceWaits;
+        do
+        {
+            result = gl::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (GL_TIMEOUT_EXPIRED == result);
+    }
+    gl::DeleteSync(fence);
+    fence = nullptr;
+    if (GL_WAIT_FAILED == result)
+    {
+        throw std::runtime_error("Failed to wait for a sprite buffer region");
+    }
+}
+
+SpriteRenderer createSpriteRenderer(uint32_t capacity)
+{
+    TRACE_FUNCTION();
+    if (0 == capacity || capacity > UINT32_MAX / 6)
+    {
+        throw std::runtime_error("Sprite renderer capacity out of range");
+    }
+
+    SpriteRenderer renderer;
+    renderer.capacity = capacity;
+    renderer.program = createGlProgram(vertexShaderSource, fragmentShaderSource);
+    renderer.viewportLocation = gl::GetUniformLocation(renderer.program, "viewport");
+
+    gl::GenVertexArrays(SpriteRenderer::Regions, renderer.vertexArrays);
+    gl::GenVertexArrays(1, &renderer.immediateVertexArray);
+    gl::BindVertexArray(renderer.vertexArrays[0]);
+
+    std::vector<uint32_t> indices(size_t(capacity) * 6);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        const uint32_t vertex = 4 * i;
+        const uint32_t quad[6] = { vertex, vertex + 1, vertex + 2, vertex, vertex + 2, vertex + 3 };
+        std::copy(quad, quad + 6, indices.begin() + 6 * size_t(i));
+    }
+    gl::GenBuffers(1, &renderer.indexBuffer);
+    gl::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.indexBuffer);
+    gl::BufferData(GL_ELEMENT_ARRAY_BUFFER, gl::GLsizeiptr(indices.size() * sizeof(uint32_t)), indices.data(), GL_STATIC_DRAW);
+
+    const size_t regionBytes = capacity * quadVertexBytes;
+    gl::GenBuffers(1, &renderer.vertexBuffer);
+    gl::BindBuffer(GL_ARRAY_BUFFER, renderer.vertexBuffer);
+    gl::BufferData(GL_ARRAY_BUFFER, gl::GLsizeiptr(SpriteRenderer::Regions * regionBytes), nullptr, GL_STREAM_DRAW);
+    for (uint32_t region = 0; region < SpriteRenderer::Regions; ++region)
+    {
+        setSpriteAttributes(renderer.vertexArrays[region], renderer.vertexBuffer, renderer.indexBuffer, region * regionBytes);
+    }
+
+    gl::GenBuffers(1, &renderer.immediateBuffer);
+    gl::BindBuffer(GL_ARRAY_BUFFER, renderer.immediateBuffer);
+    gl::BufferData(GL_ARRAY_BUFFER, gl::GLsizeiptr(quadVertexBytes), nullptr, GL_STREAM_DRAW);
+    setSpriteAttributes(renderer.immediateVertexArray, renderer.immediateBuffer, renderer.indexBuffer, 0);
+
+    gl::BindVertexArray(0);
+    return renderer;
+}
+
+void drawSprites(SpriteRenderer &renderer, SpriteBatcher &batcher, const GLuint *pageTextures, int framebufferWidth, int framebufferHeight)
+{
+    TRACE_FUNCTION();
+    const auto start = std::chrono::steady_clock::now();
+    {
+        TRACE_ZONE("sort sprites");
+        sortSprites(batcher);
+    }
+    beginSprites(renderer, framebufferWidth, framebufferHeight);
+
+    const size_t count = batcher.sprites.size();
+    const size_t regionBytes = renderer.capacity * quadVertexBytes;
+    size_t batchIndex = 0;
+    bool stateSet = false;
+    uint16_t page = 0;
+    SpriteBlend blend = SpriteBlend::Opaque;
+    for (size_t chunkBegin = 0; chunkBegin < count; chunkBegin += renderer.capacity)
+    {
+        const size_t chunkEnd = std::min(count, chunkBegin + renderer.capacity);
+        const uint32_t region = renderer.region;
+        waitForRegion(renderer, region);
+
+        gl::BindBuffer(GL_ARRAY_BUFFER, renderer.vertexBuffer);
+        void *mapped = gl::MapBufferRange(GL_ARRAY_BUFFER, gl::GLintptr(region * regionBytes), gl::GLsizeiptr((chunkEnd - chunkBegin) * quadVertexBytes),
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (nullptr == mapped)
+        {
+            throw std::runtime_error("Failed to map the sprite vertex buffer");
+        }
+        writeSpriteVertices(batcher, chunkBegin, chunkEnd, static_cast<SpriteVertex *>(mapped));
+        gl::UnmapBuffer(GL_ARRAY_BUFFER);
+
+        // a batch straddling the end of the chunk is finished from the next region
+        gl::BindVertexArray(renderer.vertexArrays[region]);
+        while (batchIndex < batcher.batches.size())
+        {
+            const SpriteBatch &batch = batcher.batches[batchIndex];
+            const size_t batchEnd = size_t(batch.firstSprite) + batch.spriteCount;
+            const size_t first = std::max<size_t>(batch.firstSprite, chunkBegin);
+            const size_t last = std::min(batchEnd, chunkEnd);
+            if (!stateSet || page != batch.page)
+            {
+                gl::BindTexture(GL_TEXTURE_2D, pageTextures[batch.page]);
+                page = batch.page;
+            }
+            if (!stateSet || blend != batch.blend)
+            {
+                applyBlend(batch.blend);
+                blend = batch.blend;
+            }
+            stateSet = true;
+            gl::DrawElements(GL_TRIANGLES, GLsizei((last - first) * 6), GL_UNSIGNED_INT, reinterpret_cast<const void *>((first - chunkBegin) * quadIndexBytes));
+            ++renderer.drawCalls;
+            if (batchEnd > chunkEnd)
+            {
+                break;
+            }
+            ++batchIndex;
+        }
+
+        renderer.fences[region] = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        renderer.region = (region + 1) % SpriteRenderer::Regions;
+    }
+
+    gl::BindVertexArray(0);
+    gl::Disable(GL_BLEND);
+    ++renderer.frames;
+    renderer.sprites += count;
+    addSubmitTime(renderer, std::chrono::steady_clock::now() - start);
+}
+
+void drawSpritesImmediate(SpriteRenderer &renderer, const SpriteBatcher &batcher, const GLuint *pageTextures, int framebufferWidth, int framebufferHeight)
+{
+    TRACE_FUNCTION();
+    const auto start = std::chrono::steady_clock::now();
+    beginSprites(renderer, framebufferWidth, framebufferHeight);
+
+    gl::BindVertexArray(renderer.immediateVertexArray);
+    gl::BindBuffer(GL_ARRAY_BUFFER, renderer.immediateBuffer);
+    for (const Sprite &sprite : batcher.sprites)
+    {
+        SpriteVertex quad[4];
+        writeSpriteQuad(sprite, quad);
+        gl::BindTexture(GL_TEXTURE_2D, pageTextures[sprite.page]);
+        applyBlend(sprite.blend);
+        gl::BufferSubData(GL_ARRAY_BUFFER, 0, gl::GLsizeiptr(sizeof(quad)), quad);
+        gl::DrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+    }
+
+    gl::BindVertexArray(0);
+    gl::Disable(GL_BLEND);
+    ++renderer.frames;
+    renderer.sprites += batcher.sprites.size();
+    renderer.drawCalls += batcher.sprites.size();
+    addSubmitTime(renderer, std::chrono::steady_clock::now() - start);
+}
+
+void reportSpriteRenderer(std::ostream &stream, const SpriteRenderer &renderer, const char *label)
+{
+    if (0 == renderer.frames)
+    {
+        stream << label << ": no frames" << std::endl;
+        return;
+    }
+    stream << label << ": " << renderer.sprites / renderer.frames << " sprites per frame, "
+           << (renderer.submitMilliseconds > 0.0 ? double(renderer.sprites) / renderer.submitMilliseconds : 0.0) << " sprites/ms submitted, "
+           << double(renderer.drawCalls) / double(renderer.frames) << " draw calls per frame, " << renderer.fenceWaits << " fence waits" << std::endl;
+    renderer.submitTime.report(stream, "Sprite submission CPU time");
+}
+
+std::vector<GLuint> createSpritePages(uint32_t count, uint32_t size)
+{
+    std::vector<GLuint> pages(count);
+    gl::GenTextures(GLsizei(count), pages.data());
+    gl::PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    std::vector<uint8_t> texels(size_t(size) * size * 4);
+    for (uint32_t page = 0; page < count; ++page)
+    {
+        const float tint[3] = { 0.5f + 0.5f * float(page & 1), 0.5f + 0.5f * float((page >> 1) & 1), 0.5f + 0.5f * float((page >> 2) & 1) };
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const float dx = (float(x) + 0.5f) / float(size) * 2.0f - 1.0f;
+                const float dy = (float(y) + 0.5f) / float(size) * 2.0f - 1.0f;
+                const float alpha = std::min(1.0f, std::max(0.0f, (1.0f - sqrtf(dx * dx + dy * dy)) * float(size) * 0.5f));
+                uint8_t *texel = &texels[(size_t(y) * size + x) * 4];
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    texel[channel] = uint8_t(255.0f * tint[channel] * alpha);
+                }
+                texel[3] = uint8_t(255.0f * alpha);
+            }
+        }
+        gl::BindTexture(GL_TEXTURE_2D, pages[page]);
+        gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl::TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, GLsizei(size), GLsizei(size), 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    }
+    return pages;
+}
+
+void destroySpriteRenderer(const SpriteRenderer &renderer)
+{
+    for (gl::GLsync fence : renderer.fences)
+    {
+        if (nullptr != fence)
+        {
+            gl::DeleteSync(fence);
+        }
+    }
+    gl::DeleteVertexArrays(1, &renderer.immediateVertexArray);
+    gl::DeleteVertexArrays(SpriteRenderer::Regions, renderer.vertexArrays);
+    const GLuint buffers[3] = { renderer.vertexBuffer, renderer.indexBuffer, renderer.immediateBuffer };
+    gl::DeleteBuffers(3, buffers);
+    gl::DeleteProgram(renderer.program);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "frame_stats.h"
+#include "gl_functions.h"
+#include "sprite_batch.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+// Draws a SpriteBatcher's sprites with one draw call per batch from a streamed vertex buffer
+// The buffer is a ring of regions, each holding capacity sprites and fenced once drawn from, and
+// is written through unsynchronized maps so the driver never stalls on or copies a region still
+// in use. A frame with more sprites than a region holds is drawn a region at a time. Quads share
+// a static index buffer. Page textures are the caller's; alpha blended sprites are premultiplied.
+// Must be created, drawn and destroyed on the thread the context is current on.
+struct SpriteRenderer
+{
+    static constexpr uint32_t Regions = 3;
+
+    GLuint program;
+    GLint viewportLocation;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint vertexArrays[Regions]; // attributes pointing at each region
+    gl::GLsync fences[Regions] = {};
+    uint32_t capacity;
+    uint32_t region = 0;
+
+    // the per-sprite path, a buffer of one quad rewritten before every draw
+    GLuint immediateBuffer;
+    GLuint immediateVertexArray;
+
+    uint64_t frames = 0;
+    uint64_t sprites = 0;
+    uint64_t drawCalls = 0;
+    uint64_t fenceWaits = 0;
+    // CPU time of each draw function call, sorting and writing vertices included
+    DurationStats submitTime;
+    double submitMilliseconds = 0.0;
+};
+
+SpriteRenderer createSpriteRenderer(uint32_t capacity);
+
+// Sorts the batcher's sprites and draws them; pageTextures is indexed by Sprite::page
+void drawSprites(SpriteRenderer &renderer, SpriteBatcher &batcher, const GLuint *pageTextures, int framebufferWidth, int framebufferHeight);
+
+// One buffer update, state change and draw per sprite in submission order, the baseline batching
+// is measured against
+void drawSpritesImmediate(SpriteRenderer &renderer, const SpriteBatcher &batcher, const GLuint *pageTextures, int framebufferWidth, int framebufferHeight);
+
+// Sprites submitted per millisecond of CPU time and draw calls per frame
+void reportSpriteRenderer(std::ostream &stream, const SpriteRenderer &renderer, const char *label);
+
+void destroySpriteRenderer(const SpriteRenderer &renderer);
+
+// count size by size textures of a premultiplied disc, one colour per page, for sprite fields;
+// delete them with gl::DeleteTextures
+std::vector<GLuint> createSpritePages(uint32_t count, uint32_t size);
@@ -0,0 +1,134 @@
+#include "texture_blit.h"
+
+#include "gl_program.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <iostream>
+
+static const char *vertexShaderSource = R"(#version 330 core
+out vec2 uv;
+void main()
+{
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    uv.y = 1.0 - uv.y;
+}
+)";
+
+static const char *fragmentShaderSource = R"(#version 330 core
+uniform sampler2D image;
+in vec2 uv;
+out vec4 color;
+void main()
+{
+    color = vec4(texture(image, uv).rgb, 1.0);
+}
+)";
+
+// GL internal format for a compressed encoding, or zero if the context can't sample it
+static GLenum compressedFormat(TextureEncoding encoding)
+{
+    switch (encoding)
+    {
+    case TextureEncoding::BC1:
+        return glfwExtensionSupported("GL_EXT_texture_compression_s3tc") ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : 0;
+    case TextureEncoding::BC3:
+        return glfwExtensionSupported("GL_EXT_texture_compression_s3tc") ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+    case TextureEncoding::BC7:
+        return glfwExtensionSupported("GL_ARB_texture_compression_bptc") ? GL_COMPRESSED_RGBA_BPTC_UNORM : 0;
+    default:
+        return 0;
+    }
+}
+
+static void uploadLevels(const ProceduralTexture &texture, GLenum internalFormat)
+{
+    const Ktx2Image &image = texture.image;
+    for (size_t i = 0; i < image.levels.size(); ++i)
+    {
+        const Ktx2Level &level = image.levels[i];
+        const uint8_t *data = texture.data.data() + level.byteOffset;
+        if (0 != internalFormat)
+        {
+            gl::CompressedTexImage2D(GL_TEXTURE_2D, GLint(i), internalFormat, GLsizei(level.width), GLsizei(level.height), 0, GLsizei(level.byteLength), data);
+        }
+        else
+        {
+            gl::TexImage2D(GL_TEXTURE_2D, GLint(i), GL_RGBA8, GLsizei(level.width), GLsizei(level.height), 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+    }
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(image.levels.size() - 1));
+}
+
+TextureBlit createTextureBlit(const ProceduralTexture &texture)
+{
+    TRACE_FUNCTION();
+    loadGlFunctions();
+
+    TextureBlit blit;
+    blit.width = texture.image.width;
+    blit.height = texture.image.height;
+
+    gl::GenTextures(1, &blit.texture);
+    gl::BindTexture(GL_TEXTURE_2D, blit.texture);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // rows of 4x4 blocks and odd-width RGBA8 levels are both tightly packed
+    gl::PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const bool uncompressed = TextureEncoding::RGBA8 == texture.encoding;
+    const GLenum internalFormat = compressedFormat(texture.encoding);
+    if (uncompressed || 0 != internalFormat)
+    {
+        uploadLevels(texture, internalFormat);
+    }
+    else
+    {
+        std::cout << "Compressed texture format not supported by the context, uploading uncompressed" << std::endl;
+        uploadLevels(generateProceduralTexture(texture.image.width, TextureEncoding::RGBA8), 0);
+    }
+
+    blit.program = createGlProgram(vertexShaderSource, fragmentShaderSource);
+    gl::GenVertexArrays(1, &blit.vertexArray);
+
+    return blit;
+}
+
+TextureBlit shareTextureBlit(const TextureBlit &loaded)
+{
+    TextureBlit blit = loaded;
+    gl::GenVertexArrays(1, &blit.vertexArray);
+    return blit;
+}
+
+void releaseSharedTextureBlit(const TextureBlit &blit)
+{
+    gl::DeleteVertexArrays(1, &blit.vertexArray);
+}
+
+void drawTextureBlit(const TextureBlit &blit, int framebufferWidth, int framebufferHeight)
+{
+    const float scale = std::min(float(framebufferWidth) / float(blit.width), float(framebufferHeight) / float(blit.height));
+    const int width = std::max(1, int(float(blit.width) * scale));
+    const int height = std::max(1, int(float(blit.height) * scale));
+    gl::Viewport((framebufferWidth - width) / 2, (framebufferHeight - height) / 2, width, height);
+
+    gl::BindTexture(GL_TEXTURE_2D, blit.texture);
+    gl::UseProgram(blit.program);
+    gl::BindVertexArray(blit.vertexArray);
+    gl::DrawArrays(GL_TRIANGLES, 0, 3);
+
+    gl::Viewport(0, 0, framebufferWidth, framebufferHeight);
+}
+
+void destroyTextureBlit(const TextureBlit &blit)
+{
+    gl::DeleteVertexArrays(1, &blit.vertexArray);
+    gl::DeleteProgram(blit.program);
+    gl::DeleteTextures(1, &blit.texture);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "gl_functions.h"
+#include "procedural_texture.h"
+
+#include <cstdint>
+
+// A texture drawn over the window with a fullscreen triangle, letterboxed to keep its aspect ratio
+// Must be created, drawn and destroyed on the thread the context is current on.
+struct TextureBlit
+{
+    GLuint texture;
+    GLuint program;
+    GLuint vertexArray;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Uploads every level with glCompressedTexImage2D when the context supports the encoding,
+// otherwise regenerates the texture uncompressed
+TextureBlit createTextureBlit(const ProceduralTexture &texture);
+
+// The texture and program of a blit loaded on a context this one shares objects with
+// Vertex arrays aren't shared between contexts, so each context drawing the blit makes its own.
+TextureBlit shareTextureBlit(const TextureBlit &loaded);
+
+void releaseSharedTextureBlit(const TextureBlit &blit);
+
+void drawTextureBlit(const TextureBlit &blit, int framebufferWidth, int framebufferHeight);
+
+void destroyTextureBlit(const TextureBlit &blit);
@@ -0,0 +1,63 @@
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// A 2D KTX2 container with levelCount level index entries, each level one 16 byte block
+// following the index; the parser reads the header in host order, as does this
+static std::vector<uint8_t> makeKtx2(uint32_t width, uint32_t height, uint32_t levelCount)
+{
+    const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const uint32_t fields[13] = { 131, 1, width, height, 0, 0, 1, levelCount, 0, 0, 0, 0, 0 };
+    const size_t indexBytes = size_t(std::max(1u, levelCount)) * 24;
+
+    std::vector<uint8_t> file(80 + indexBytes + 16 * std::max(1u, levelCount), 0);
+    memcpy(file.data(), identifier, sizeof(identifier));
+    memcpy(file.data() + sizeof(identifier), fields, sizeof(fields));
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        const uint64_t level[3] = { 80 + indexBytes + 16 * i, 16, 16 };
+        memcpy(file.data() + 80 + 24 * i, level, sizeof(level));
+    }
+    return file;
+}
+
+static bool parses(const std::vector<uint8_t> &file)
+{
+    try
+    {
+        parseKtx2(file.data(), file.size());
+        return true;
+    }
+    catch (const std::runtime_error &)
+    {
+        return false;
+    }
+}
+
+static bool check(bool condition, const char *description)
+{
+    std::cout << (condition ? "pass " : "FAIL ") << description << std::endl;
+    return condition;
+}
+
+int main()
+{
+    bool passed = true;
+
+    const std::vector<uint8_t> fullChain = makeKtx2(4, 4, 3);
+    const Ktx2Image image = parseKtx2(fullChain.data(), fullChain.size());
+    passed &= check(3 == image.levels.size() && 1 == image.levels[2].width && 1 == image.levels[2].height, "4x4 with a full chain of 3 levels");
+    passed &= check(parses(makeKtx2(5, 2, 3)), "5x2 with 3 levels, the largest dimension decides");
+    const std::vector<uint8_t> generated = makeKtx2(4, 4, 0);
+    passed &= check(1 == parseKtx2(generated.data(), generated.size()).levels.size(), "a level count of 0 gives the base level");
+    passed &= check(!parses(makeKtx2(4, 4, 4)), "4x4 with 4 levels is rejected");
+    passed &= check(!parses(makeKtx2(1, 1, 40)), "1x1 with 40 levels is rejected before any shift");
+    passed &= check(!parses(makeKtx2(65536, 65536, 33)), "65536x65536 with 33 levels is rejected");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,77 @@
+#include "mesh_format.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// a single triangle, encoded into the file format
+static std::vector<uint8_t> makeTriangle()
+{
+    MeshData mesh;
+    mesh.positions = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+    mesh.normals = { 0, 0, 1, 0, 0, 1, 0, 0, 1 };
+    mesh.uvs = { 0, 0, 1, 0, 0, 1 };
+    mesh.indices = { 0, 1, 2 };
+    return encodeMesh(mesh);
+}
+
+static MeshHeader header(const std::vector<uint8_t> &file)
+{
+    MeshHeader result;
+    memcpy(&result, file.data(), sizeof(result));
+    return result;
+}
+
+static void setHeader(std::vector<uint8_t> &file, const MeshHeader &value)
+{
+    memcpy(file.data(), &value, sizeof(value));
+}
+
+// views a copy, as the data has to be 16 byte aligned
+static bool views(const std::vector<uint8_t> &file)
+{
+    std::vector<uint64_t> aligned((file.size() + 7) / 8);
+    memcpy(aligned.data(), file.data(), file.size());
+    try
+    {
+        viewMesh(reinterpret_cast<const uint8_t *>(aligned.data()), file.size());
+        return true;
+    }
+    catch (const std::runtime_error &)
+    {
+        return false;
+    }
+}
+
+static bool check(bool condition, const char *description)
+{
+    std::cout << (condition ? "pass " : "FAIL ") << description << std::endl;
+    return condition;
+}
+
+int main()
+{
+    bool passed = true;
+
+    const std::vector<uint8_t> triangle = makeTriangle();
+    passed &= check(views(triangle), "a triangle is viewed");
+
+    std::vector<uint8_t> partial = triangle;
+    MeshHeader partialHeader = header(partial);
+    partialHeader.indexCount = 2;
+    setHeader(partial, partialHeader);
+    passed &= check(!views(partial), "two indices are rejected as a partial triangle");
+
+    std::vector<uint8_t> outOfRange = triangle;
+    const MeshHeader outOfRangeHeader = header(outOfRange);
+    const uint16_t pastTheEnd = uint16_t(outOfRangeHeader.vertexCount);
+    memcpy(outOfRange.data() + outOfRangeHeader.indexOffset + 2 * sizeof(uint16_t), &pastTheEnd, sizeof(pastTheEnd));
+    passed &= check(!views(outOfRange), "an index equal to the vertex count is rejected");
+
+    std::vector<uint8_t> truncated(triangle.begin(), triangle.end() - 2);
+    passed &= check(!views(truncated), "a truncated index array is rejected");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,67 @@
+#include "mesh_data.h"
+#include "mesh_format.h"
+#include "mesh_optimize.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+// Converts an OBJ file into the ditties' memory-mappable mesh format, optimising the
+// index order for the post-transform vertex cache and the vertex order for fetch locality
+int main(int argc, char *argv[])
+{
+    const char *inputPath = nullptr;
+    const char *outputPath = nullptr;
+    bool optimize = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "--no-optimize"))
+        {
+            optimize = false;
+        }
+        else if (nullptr == inputPath)
+        {
+            inputPath = argv[i];
+        }
+        else if (nullptr == outputPath)
+        {
+            outputPath = argv[i];
+        }
+        else
+        {
+            std::cerr << "Ignoring unknown option " << argv[i] << std::endl;
+        }
+    }
+    if (nullptr == inputPath || nullptr == outputPath)
+    {
+        std::cerr << "usage: mesh_ingest [--no-optimize] input.obj output.dmesh" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        MeshData mesh = parseObj(inputPath);
+        const uint32_t vertexCount = meshVertexCount(mesh);
+        std::cout << "Read " << vertexCount << " vertices and " << mesh.indices.size() / 3 << " triangles from " << inputPath << std::endl;
+        std::cout << "ACMR (16 entry FIFO) " << averageCacheMissRatio(mesh.indices, vertexCount, 16);
+
+        if (optimize)
+        {
+            optimizeVertexCache(mesh.indices, vertexCount);
+            optimizeVertexFetch(mesh);
+            std::cout << ", optimised " << averageCacheMissRatio(mesh.indices, meshVertexCount(mesh), 16);
+        }
+        std::cout << std::endl;
+
+        const size_t bytes = writeMeshFile(outputPath, mesh);
+        std::cout << "Wrote " << bytes << " bytes to " << outputPath << std::endl;
+    }
+    catch (const std::exception &error)
+    {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+#include "deletion_queue.h"
+#include "device_functions.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+bool timelineSemaphoreSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    return VK_TRUE == features12.timelineSemaphore;
+}
+
+std::unique_ptr<DeletionQueue> createDeletionQueue(VkDevice device, bool timelineSemaphores)
+{
+    auto queue = std::make_unique<DeletionQueue>();
+    if (timelineSemaphores && nullptr != vkd::GetSemaphoreCounterValue)
+    {
+        VkSemaphoreTypeCreateInfo typeInfo = {};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+        VkSemaphoreCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        createInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device, &createInfo, nullptr, &queue->timeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create the deletion queue's timeline semaphore");
+        }
+    }
+    return queue;
+}
+
+void retireObject(DeletionQueue &queue, VkObjectType type, uint64_t handle)
+{
+    if (0 == handle)
+    {
+        return;
+    }
+    queue.retired.push_back({ type, handle, queue.frame, std::chrono::steady_clock::now() });
+    queue.peakDepth = std::max(queue.peakDepth, queue.retired.size());
+}
+
+static void destroyObject(VkDevice device, VkObjectType type, uint64_t handle)
+{
+    switch (type)
+    {
+    case VK_OBJECT_TYPE_BUFFER:
+        vkDestroyBuffer(device, VkBuffer(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_BUFFER_VIEW:
+        vkDestroyBufferView(device, VkBufferView(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_COMMAND_POOL:
+        vkDestroyCommandPool(device, VkCommandPool(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+        vkDestroyDescriptorPool(device, VkDescriptorPool(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+        vkDestroyDescriptorSetLayout(device, VkDescriptorSetLayout(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_DEVICE_MEMORY:
+        vkFreeMemory(device, VkDeviceMemory(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_FENCE:
+        vkDestroyFence(device, VkFence(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_FRAMEBUFFER:
+        vkDestroyFramebuffer(device, VkFramebuffer(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_IMAGE:
+        vkDestroyImage(device, VkImage(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_IMAGE_VIEW:
+        vkDestroyImageView(device, VkImageView(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_PIPELINE:
+        vkDestroyPipeline(device, VkPipeline(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+        vkDestroyPipelineLayout(device, VkPipelineLayout(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_QUERY_POOL:
+        vkDestroyQueryPool(device, VkQueryPool(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_RENDER_PASS:
+        vkDestroyRenderPass(device, VkRenderPass(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_SAMPLER:
+        vkDestroySampler(device, VkSampler(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_SEMAPHORE:
+        vkDestroySemaphore(device, VkSemaphore(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_SHADER_MODULE:
+        vkDestroyShaderModule(device, VkShaderModule(handle), nullptr);
+        break;
+    case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+        vkDestroySwapchainKHR(device, VkSwapchainKHR(handle), nullptr);
+        break;
+    default:
+        throw std::runtime_error("Can't retire Vulkan objects of type " + std::to_string(type));
+    }
+}
+
+// objects are retired in frame order, so the front is always the oldest
+static void destroyRetired(VkDevice device, DeletionQueue &queue, uint64_t completedFrame)
+{
+    const auto now = std::chrono::steady_clock::now();
+    while (!queue.retired.empty() && queue.retired.front().frame <= completedFrame)
+    {
+        const DeletionQueue::Retired &retired = queue.retired.front();
+        destroyObject(device, retired.type, retired.handle);
+        ++queue.reclaimed;
+        queue.reclaimFrames += queue.frame - retired.frame;
+        queue.reclaimLatency.add(now - retired.retiredAt);
+        queue.retired.pop_front();
+    }
+}
+
+void signalDeletionQueue(VkDevice device, VkQueue queue, DeletionQueue &deletions)
+{
+    if (VK_NULL_HANDLE != deletions.timeline)
+    {
+        return;
+    }
+
+    VkFence fence;
+    if (!deletions.freeFences.empty())
+    {
+        fence = deletions.freeFences.back();
+        deletions.freeFences.pop_back();
+    }
+    else
+    {
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create a deletion queue fence");
+        }
+    }
+
+    // with no batches the fence signals once everything submitted before it has completed
+    if (vkd::QueueSubmit(queue, 0, nullptr, fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit a deletion queue fence");
+    }
+    deletions.frameFences.push_back({ fence, deletions.frame });
+}
+
+void collectDeletionQueue(VkDevice device, DeletionQueue &queue)
+{
+    if (VK_NULL_HANDLE != queue.timeline && !queue.retired.empty())
+    {
+        uint64_t completedFrame = 0;
+        if (vkd::GetSemaphoreCounterValue(device, queue.timeline, &completedFrame) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to read the deletion queue's timeline semaphore");
+        }
+        destroyRetired(device, queue, completedFrame);
+    }
+    else if (VK_NULL_HANDLE == queue.timeline)
+    {
+        // one queue completes in submission order, so the first unsignalled fence ends the scan
+        uint64_t completedFrame = 0;
+        while (!queue.frameFences.empty() && VK_SUCCESS == vkd::GetFenceStatus(device, queue.frameFences.front().fence))
+        {
+            VkFence fence = queue.frameFences.front().fence;
+            completedFrame = queue.frameFences.front().frame;
+            vkd::ResetFences(device, 1, &fence);
+            queue.freeFences.push_back(fence);
+            queue.frameFences.pop_front();
+        }
+        destroyRetired(device, queue, completedFrame);
+    }
+    ++queue.frame;
+}
+
+void reportDeletionQueue(std::ostream &stream, const DeletionQueue &queue)
+{
+    stream << "Deletion queue: " << queue.reclaimed << " objects reclaimed, " << queue.retired.size() << " still queued, peak depth " << queue.peakDepth;
+    if (queue.reclaimed > 0)
+    {
+        stream << ", " << double(queue.reclaimFrames) / double(queue.reclaimed) << " frames from retirement to reclaim on average";
+    }
+    if (VK_NULL_HANDLE == queue.timeline)
+    {
+        stream << " (no timeline semaphores, tracked with per frame fences)";
+    }
+    stream << std::endl;
+    if (queue.reclaimed > 0)
+    {
+        queue.reclaimLatency.report(stream, "Deletion queue reclaim latency");
+    }
+}
+
+void destroyDeletionQueue(VkDevice device, DeletionQueue &queue)
+{
+    destroyRetired(device, queue, UINT64_MAX);
+    vkDestroySemaphore(device, queue.timeline, nullptr);
+    queue.timeline = VK_NULL_HANDLE;
+    for (const DeletionQueue::FrameFence &frameFence : queue.frameFences)
+    {
+        vkDestroyFence(device, frameFence.fence, nullptr);
+    }
+    queue.frameFences.clear();
+    for (VkFence fence : queue.freeFences)
+    {
+        vkDestroyFence(device, fence, nullptr);
+    }
+    queue.freeFences.clear();
+}
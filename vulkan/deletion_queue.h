@@ -0,0 +1,76 @@
+#pragma once
+
+#include "frame_stats.h"
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+// Vulkan objects retired while the GPU may still be using them, destroyed once it has finished
+// Every frame's submission signals the queue's timeline semaphore with the frame's number, and an
+// object retired during a frame is tagged with that number, so collectDeletionQueue can destroy
+// it as soon as the semaphore has passed the tag without waiting for the device to go idle.
+// Without timeline semaphores an empty submission after each frame signals a fence instead,
+// which collectDeletionQueue polls in frame order.
+struct DeletionQueue
+{
+    struct Retired
+    {
+        VkObjectType type;
+        uint64_t handle;
+        uint64_t frame;
+        std::chrono::steady_clock::time_point retiredAt;
+    };
+
+    struct FrameFence
+    {
+        VkFence fence;
+        uint64_t frame;
+    };
+
+    VkSemaphore timeline = VK_NULL_HANDLE;
+    // what the current frame's submission signals
+    uint64_t frame = 1;
+    std::deque<Retired> retired;
+
+    // the fallback's fences, oldest frame first, and those signalled and reset for reuse
+    std::deque<FrameFence> frameFences;
+    std::vector<VkFence> freeFences;
+
+    size_t peakDepth = 0;
+    uint64_t reclaimed = 0;
+    uint64_t reclaimFrames = 0;
+    DurationStats reclaimLatency;
+};
+
+bool timelineSemaphoreSupported(VkPhysicalDevice physicalDevice);
+
+// timelineSemaphores must match whether the device was created with the feature enabled
+std::unique_ptr<DeletionQueue> createDeletionQueue(VkDevice device, bool timelineSemaphores);
+
+// handle is any non-dispatchable handle of the given type, cast with objectHandle
+void retireObject(DeletionQueue &queue, VkObjectType type, uint64_t handle);
+
+template <typename Handle>
+uint64_t objectHandle(Handle handle)
+{
+    // a pointer or a uint64_t depending on the platform, which only a C style cast covers
+    return (uint64_t)handle;
+}
+
+// After all of the frame's submissions to queue; only does anything without timeline semaphores,
+// submitting the fence that marks the frame done
+void signalDeletionQueue(VkDevice device, VkQueue queue, DeletionQueue &deletions);
+
+// After the frame's submission: destroys everything the GPU has finished with and moves on to
+// the next frame
+void collectDeletionQueue(VkDevice device, DeletionQueue &queue);
+
+void reportDeletionQueue(std::ostream &stream, const DeletionQueue &queue);
+
+// Destroys everything still queued; the device must be idle
+void destroyDeletionQueue(VkDevice device, DeletionQueue &queue);
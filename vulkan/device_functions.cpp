@@ -0,0 +1,32 @@
+#include "device_functions.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace vkd
+{
+#define DITTY_VK_DEFINE(name) PFN_vk##name name;
+    DITTY_VK_DEVICE_FUNCTIONS(DITTY_VK_DEFINE)
+    DITTY_VK_OPTIONAL_DEVICE_FUNCTIONS(DITTY_VK_DEFINE)
+#undef DITTY_VK_DEFINE
+}
+
+template <typename Function>
+static void load(VkDevice device, Function &function, const char *name, bool required)
+{
+    function = reinterpret_cast<Function>(vkGetDeviceProcAddr(device, name));
+    if (nullptr == function && required)
+    {
+        throw std::runtime_error(std::string("Missing Vulkan device entry point ") + name);
+    }
+}
+
+void loadDeviceFunctions(VkDevice device)
+{
+#define DITTY_VK_LOAD_REQUIRED(name) load(device, vkd::name, "vk" #name, true);
+#define DITTY_VK_LOAD_OPTIONAL(name) load(device, vkd::name, "vk" #name, false);
+    DITTY_VK_DEVICE_FUNCTIONS(DITTY_VK_LOAD_REQUIRED)
+    DITTY_VK_OPTIONAL_DEVICE_FUNCTIONS(DITTY_VK_LOAD_OPTIONAL)
+#undef DITTY_VK_LOAD_REQUIRED
+#undef DITTY_VK_LOAD_OPTIONAL
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// Device level entry points the render path calls every frame, fetched with vkGetDeviceProcAddr
+// so they go straight to the driver rather than through the loader's dispatch trampolines
+// Setup code keeps calling the loader exports. The table is generated from these lists; add a
+// function to the required list, or to the optional one if the device may not provide it.
+#define DITTY_VK_DEVICE_FUNCTIONS(X) \
+    X(AcquireNextImageKHR)           \
+    X(BeginCommandBuffer)            \
+    X(CmdBeginQuery)                 \
+    X(CmdBeginRenderPass)            \
+    X(CmdBindDescriptorSets)         \
+    X(CmdBindIndexBuffer)            \
+    X(CmdBindPipeline)               \
+    X(CmdBindVertexBuffers)          \
+    X(CmdBlitImage)                  \
+    X(CmdCopyBufferToImage)          \
+    X(CmdCopyImageToBuffer)          \
+    X(CmdDispatch)                   \
+    X(CmdDraw)                       \
+    X(CmdDrawIndexed)                \
+    X(CmdEndQuery)                   \
+    X(CmdEndRenderPass)              \
+    X(CmdFillBuffer)                 \
+    X(CmdPipelineBarrier)            \
+    X(CmdPushConstants)              \
+    X(CmdResetQueryPool)             \
+    X(CmdWriteTimestamp)             \
+    X(EndCommandBuffer)              \
+    X(GetFenceStatus)                \
+    X(GetQueryPoolResults)           \
+    X(InvalidateMappedMemoryRanges)  \
+    X(QueuePresentKHR)               \
+    X(QueueSubmit)                   \
+    X(ResetCommandBuffer)            \
+    X(ResetFences)                   \
+    X(WaitForFences)
+
+// Vulkan 1.2 core, absent on older devices; null when missing
+#define DITTY_VK_OPTIONAL_DEVICE_FUNCTIONS(X) \
+    X(CmdDrawIndexedIndirectCount)           \
+    X(GetSemaphoreCounterValue)
+
+namespace vkd
+{
+#define DITTY_VK_DECLARE(name) extern PFN_vk##name name;
+    DITTY_VK_DEVICE_FUNCTIONS(DITTY_VK_DECLARE)
+    DITTY_VK_OPTIONAL_DEVICE_FUNCTIONS(DITTY_VK_DECLARE)
+#undef DITTY_VK_DECLARE
+}
+
+// For the one device the process renders with, right after it is created; throws
+// std::runtime_error if a required entry point is missing
+void loadDeviceFunctions(VkDevice device);
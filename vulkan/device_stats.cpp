@@ -0,0 +1,148 @@
+#include "device_stats.h"
+#include "device_functions.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static double megabytes(VkDeviceSize bytes)
+{
+    return double(bytes) / (1024.0 * 1024.0);
+}
+
+bool memoryBudgetSupported(VkPhysicalDevice physicalDevice)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+    return std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties &extension)
+    {
+        return 0 == strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    });
+}
+
+MemoryBudget createMemoryBudget(VkPhysicalDevice physicalDevice, bool extensionEnabled)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    MemoryBudget budget;
+    budget.supported = extensionEnabled;
+    budget.heaps.resize(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        budget.heaps[i].size = memoryProperties.memoryHeaps[i].size;
+        budget.heaps[i].flags = memoryProperties.memoryHeaps[i].flags;
+    }
+    pollMemoryBudget(physicalDevice, budget);
+    return budget;
+}
+
+void pollMemoryBudget(VkPhysicalDevice physicalDevice, MemoryBudget &budget)
+{
+    if (!budget.supported)
+    {
+        return;
+    }
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties);
+
+    for (size_t i = 0; i < budget.heaps.size(); ++i)
+    {
+        HeapBudget &heap = budget.heaps[i];
+        heap.usage = budgetProperties.heapUsage[i];
+        heap.budget = budgetProperties.heapBudget[i];
+        heap.peakUsage = std::max(heap.peakUsage, heap.usage);
+    }
+}
+
+void memoryBudgetFrame(VkPhysicalDevice physicalDevice, MemoryBudget &budget)
+{
+    if (!budget.supported || 0 != budget.frames++ % MemoryBudget::PollInterval)
+    {
+        return;
+    }
+
+    pollMemoryBudget(physicalDevice, budget);
+    const bool overWarning = memoryBudgetPressure(budget) > MemoryBudget::WarningFraction;
+    if (overWarning && !budget.overWarning)
+    {
+        std::cerr << "Device memory at " << int(100.0 * memoryBudgetPressure(budget)) << "% of a heap's budget, the driver may start paging" << std::endl;
+    }
+    budget.overWarning = overWarning;
+    if (overWarning)
+    {
+        budget.framesOverWarning += MemoryBudget::PollInterval;
+    }
+}
+
+double memoryBudgetPressure(const MemoryBudget &budget)
+{
+    double pressure = 0.0;
+    for (const HeapBudget &heap : budget.heaps)
+    {
+        if (heap.budget > 0)
+        {
+            pressure = std::max(pressure, double(heap.usage) / double(heap.budget));
+        }
+    }
+    return pressure;
+}
+
+void reportMemoryBudget(std::ostream &stream, const MemoryBudget &budget)
+{
+    for (size_t i = 0; i < budget.heaps.size(); ++i)
+    {
+        const HeapBudget &heap = budget.heaps[i];
+        stream << "Memory heap " << i << ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "") << ": " << megabytes(heap.size) << "MB";
+        if (budget.supported)
+        {
+            stream << ", " << megabytes(heap.usage) << "MB used of " << megabytes(heap.budget) << "MB budget, peak " << megabytes(heap.peakUsage) << "MB";
+        }
+        stream << std::endl;
+    }
+    if (!budget.supported)
+    {
+        stream << "Memory budget unavailable without " << VK_EXT_MEMORY_BUDGET_EXTENSION_NAME << std::endl;
+    }
+    else if (budget.framesOverWarning > 0)
+    {
+        stream << "About " << budget.framesOverWarning << " frames rendered above " << int(100.0 * MemoryBudget::WarningFraction) << "% of a heap's budget" << std::endl;
+    }
+}
+
+bool collectPassStatistics(VkDevice device, VkQueryPool queryPool, uint32_t query, PassStatistics &pass)
+{
+    // the statistics in flag bit order, then availability
+    uint64_t results[4];
+    const VkResult result = vkd::GetQueryPoolResults(device, queryPool, query, 1, sizeof(results), results, sizeof(results), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS || 0 == results[3])
+    {
+        return false;
+    }
+
+    pass.last.vertexInvocations = results[0];
+    pass.last.fragmentInvocations = results[1];
+    pass.last.computeInvocations = results[2];
+    pass.total.vertexInvocations += results[0];
+    pass.total.fragmentInvocations += results[1];
+    pass.total.computeInvocations += results[2];
+    ++pass.samples;
+    return true;
+}
+
+void reportPassStatistics(std::ostream &stream, const PassStatistics &pass)
+{
+    if (0 == pass.samples)
+    {
+        return;
+    }
+    stream << "Pass " << pass.name << " invocations per frame: " << pass.total.vertexInvocations / pass.samples << " vertex, "
+           << pass.total.fragmentInvocations / pass.samples << " fragment, " << pass.total.computeInvocations / pass.samples << " compute" << std::endl;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+// Per heap device memory use against what the driver says the process can use without paging
+// The budget and usage come from VK_EXT_memory_budget, which also counts other processes'
+// pressure on the heap; without it only the heap sizes are known.
+struct HeapBudget
+{
+    VkDeviceSize size;
+    VkMemoryHeapFlags flags;
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+    VkDeviceSize peakUsage = 0;
+};
+
+struct MemoryBudget
+{
+    // the properties query isn't free, so it is polled every this many frames
+    static constexpr uint32_t PollInterval = 30;
+    // usage over this fraction of a heap's budget is warned about, before the driver starts paging
+    static constexpr double WarningFraction = 0.9;
+
+    bool supported;
+    std::vector<HeapBudget> heaps;
+    uint64_t frames = 0;
+    uint64_t framesOverWarning = 0;
+    bool overWarning = false;
+};
+
+// Whether the device offers VK_EXT_memory_budget, which must then be enabled on the device
+bool memoryBudgetSupported(VkPhysicalDevice physicalDevice);
+
+MemoryBudget createMemoryBudget(VkPhysicalDevice physicalDevice, bool extensionEnabled);
+
+// Re-reads usage and budgets now
+void pollMemoryBudget(VkPhysicalDevice physicalDevice, MemoryBudget &budget);
+
+// Polls every PollInterval frames, warning on std::cerr when a heap first nears its budget
+void memoryBudgetFrame(VkPhysicalDevice physicalDevice, MemoryBudget &budget);
+
+// The highest usage to budget ratio across the heaps, 0 if unknown
+double memoryBudgetPressure(const MemoryBudget &budget);
+
+void reportMemoryBudget(std::ostream &stream, const MemoryBudget &budget);
+
+// Shader invocation counts from a VK_QUERY_TYPE_PIPELINE_STATISTICS query created with
+// pipelineStatisticFlags, in the order the query returns them
+struct PipelineStatistics
+{
+    uint64_t vertexInvocations = 0;
+    uint64_t fragmentInvocations = 0;
+    uint64_t computeInvocations = 0;
+};
+
+constexpr VkQueryPipelineStatisticFlags pipelineStatisticFlags =
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+// The latest and accumulated statistics of one pass
+struct PassStatistics
+{
+    const char *name;
+    PipelineStatistics last;
+    PipelineStatistics total;
+    uint64_t samples = 0;
+};
+
+// Reads one query's results if available, without waiting; returns whether it was added
+bool collectPassStatistics(VkDevice device, VkQueryPool queryPool, uint32_t query, PassStatistics &pass);
+
+void reportPassStatistics(std::ostream &stream, const PassStatistics &pass);
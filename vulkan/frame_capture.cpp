@@ -0,0 +1,375 @@
+#include "frame_capture.h"
+#include "device_functions.h"
+#include "image_writer.h"
+#include "memory_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+static bool endsWith(const std::string &text, const char *suffix)
+{
+    const std::string end(suffix);
+    return text.size() >= end.size() && 0 == text.compare(text.size() - end.size(), end.size(), end);
+}
+
+static bool hostCachedMemoryAvailable(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((memoryProperties.memoryTypes[i].propertyFlags & cached) == cached)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void encodeSlot(FrameCapture &capture, FrameCapture::Slot &slot, std::vector<uint8_t> &y4mFrame)
+{
+    const PixelRows pixels = { slot.pixels, capture.extent.width, capture.extent.height, size_t(capture.extent.width) * 4, capture.bgra };
+    if (!capture.y4m)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(slot.frame + 1));
+        writePng((std::filesystem::path(capture.path) / name).string().c_str(), pixels);
+        return;
+    }
+
+    encodeY4mFrame(pixels, y4mFrame);
+    // frames are converted in parallel but have to reach the stream in order
+    std::unique_lock<std::mutex> lock(capture.mutex);
+    capture.changed.wait(lock, [&]() { return capture.nextFrameToWrite == slot.frame; });
+    capture.stream.write(reinterpret_cast<const char *>(y4mFrame.data()), std::streamsize(y4mFrame.size()));
+    if (!capture.stream)
+    {
+        throw std::runtime_error("Failed to write frame to " + capture.path);
+    }
+}
+
+// dedicated threads rather than jobs, as an encoder blocks on file writes and on its turn in the
+// stream, which would hold up the job system's workers in the middle of a frame
+static void runEncoder(FrameCapture &capture)
+{
+    TRACE_THREAD("frame encoder");
+    std::vector<uint8_t> y4mFrame;
+    std::unique_lock<std::mutex> lock(capture.mutex);
+    while (true)
+    {
+        capture.changed.wait(lock, [&]() { return capture.stopping || !capture.encodeQueue.empty(); });
+        if (capture.encodeQueue.empty())
+        {
+            return;
+        }
+        FrameCapture::Slot &slot = *capture.encodeQueue.front();
+        capture.encodeQueue.pop_front();
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        bool succeeded = true;
+        try
+        {
+            TRACE_ZONE("encode frame");
+            encodeSlot(capture, slot, y4mFrame);
+        }
+        catch (const std::exception &exception)
+        {
+            succeeded = false;
+            if (0 == capture.failed)
+            {
+                std::cerr << "Frame capture failed: " << exception.what() << std::endl;
+            }
+        }
+
+        lock.lock();
+        capture.encodeTime.add(std::chrono::steady_clock::now() - start);
+        if (succeeded)
+        {
+            ++capture.written;
+        }
+        else
+        {
+            ++capture.failed;
+        }
+        if (capture.y4m)
+        {
+            // a frame that failed before its turn still has to pass it on
+            capture.changed.wait(lock, [&]() { return capture.nextFrameToWrite == slot.frame; });
+            ++capture.nextFrameToWrite;
+        }
+        slot.state = FrameCapture::SlotState::Free;
+        capture.changed.notify_all();
+    }
+}
+
+// Queues every slot whose copy has finished, oldest first so frames reach the encoders in order
+static void collectFinishedSlots(VkDevice device, FrameCapture &capture)
+{
+    const uint32_t slotCount = uint32_t(capture.slots.size());
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    bool queued = false;
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        FrameCapture::Slot &slot = capture.slots[(capture.nextSlot + i) % slotCount];
+        if (FrameCapture::SlotState::InFlight != slot.state || vkd::GetFenceStatus(device, slot.fence) != VK_SUCCESS)
+        {
+            continue;
+        }
+        if (!capture.coherent)
+        {
+            VkMappedMemoryRange range = {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = slot.memory;
+            range.offset = 0;
+            range.size = VK_WHOLE_SIZE;
+            vkd::InvalidateMappedMemoryRanges(device, 1, &range);
+        }
+        slot.state = FrameCapture::SlotState::Encoding;
+        capture.encodeQueue.push_back(&slot);
+        queued = true;
+    }
+    if (queued)
+    {
+        capture.changed.notify_all();
+    }
+}
+
+std::unique_ptr<FrameCapture> createFrameCapture(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, const std::vector<VkImage> &images, VkExtent2D extent, VkFormat format,
+                                                 const char *path, uint32_t ringSize, uint32_t encoderThreads, uint32_t framesPerSecond)
+{
+    auto capture = std::make_unique<FrameCapture>();
+    capture->images = images;
+    capture->extent = extent;
+    switch (format)
+    {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        capture->bgra = true;
+        break;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        capture->bgra = false;
+        break;
+    default:
+        throw std::runtime_error("Frame capture needs an 8 bit RGBA or BGRA swap chain");
+    }
+
+    capture->path = path;
+    capture->y4m = endsWith(capture->path, ".y4m");
+    if (capture->y4m)
+    {
+        capture->stream.open(capture->path, std::ios::binary);
+        capture->stream << y4mHeader(extent.width, extent.height, framesPerSecond);
+    }
+    else
+    {
+        std::error_code error;
+        std::filesystem::create_directories(capture->path, error);
+    }
+    if ((capture->y4m && !capture->stream) || (!capture->y4m && !std::filesystem::is_directory(capture->path)))
+    {
+        throw std::runtime_error("Failed to open frame capture output " + capture->path);
+    }
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamily;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &capture->commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create frame capture command pool");
+    }
+
+    const bool cached = hostCachedMemoryAvailable(physicalDevice);
+    capture->coherent = !cached;
+    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | (cached ? VK_MEMORY_PROPERTY_HOST_CACHED_BIT : VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    const VkDeviceSize frameSize = VkDeviceSize(extent.width) * extent.height * 4;
+
+    capture->slots.resize(std::max(1u, ringSize));
+    for (FrameCapture::Slot &slot : capture->slots)
+    {
+        std::tie(slot.buffer, slot.memory) = createBuffer(physicalDevice, device, frameSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties);
+        void *mapping;
+        if (vkMapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, &mapping) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to map frame capture buffer");
+        }
+        slot.pixels = static_cast<const uint8_t *>(mapping);
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create frame capture fence");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = capture->commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &slot.commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate frame capture command buffer");
+        }
+    }
+
+    for (uint32_t i = 0; i < std::max(1u, encoderThreads); ++i)
+    {
+        capture->encoders.emplace_back(runEncoder, std::ref(*capture));
+    }
+
+    std::cout << "Capturing frames to " << capture->path << " through " << capture->slots.size() << (cached ? " host cached" : " host coherent") << " readback buffers, "
+              << capture->encoders.size() << " encoder threads" << std::endl;
+    return capture;
+}
+
+VkCommandBuffer recordFrameCapture(VkDevice device, FrameCapture &capture, uint32_t imageIndex)
+{
+    TRACE_FUNCTION();
+    collectFinishedSlots(device, capture);
+
+    FrameCapture::Slot &slot = capture.slots[capture.nextSlot];
+    if (FrameCapture::SlotState::Free != slot.state)
+    {
+        // the ring is full, the GPU copy or the encoder is behind
+        TRACE_ZONE("capture stall");
+        const auto start = std::chrono::steady_clock::now();
+        if (FrameCapture::SlotState::InFlight == slot.state)
+        {
+            vkd::WaitForFences(device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+            collectFinishedSlots(device, capture);
+        }
+        std::unique_lock<std::mutex> lock(capture.mutex);
+        capture.changed.wait(lock, [&]() { return FrameCapture::SlotState::Free == slot.state; });
+        ++capture.stalls;
+        capture.stallTime.add(std::chrono::steady_clock::now() - start);
+    }
+    capture.nextSlot = (capture.nextSlot + 1) % uint32_t(capture.slots.size());
+    slot.frame = capture.nextFrame++;
+    capture.recorded = &slot;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkd::BeginCommandBuffer(slot.commandBuffer, &beginInfo);
+
+    // after whatever rendered the frame, the render pass or the blit into the image
+    VkImageMemoryBarrier imageBarrier = {};
+    imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image = capture.images[imageIndex];
+    imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkd::CmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { capture.extent.width, capture.extent.height, 1 };
+    vkd::CmdCopyImageToBuffer(slot.commandBuffer, capture.images[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // back for presenting, and the copy made visible to the encoders once the fence has signalled
+    imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    imageBarrier.dstAccessMask = 0;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    VkBufferMemoryBarrier bufferBarrier = {};
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = slot.buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = VK_WHOLE_SIZE;
+    vkd::CmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+
+    vkd::EndCommandBuffer(slot.commandBuffer);
+    return slot.commandBuffer;
+}
+
+void submitFrameCapture(VkDevice device, VkQueue queue, FrameCapture &capture)
+{
+    if (nullptr == capture.recorded)
+    {
+        return;
+    }
+    // an empty submission's fence signals once everything submitted before it has completed
+    FrameCapture::Slot &slot = *capture.recorded;
+    capture.recorded = nullptr;
+    vkd::ResetFences(device, 1, &slot.fence);
+    if (vkd::QueueSubmit(queue, 0, nullptr, slot.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit frame capture fence");
+    }
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    slot.state = FrameCapture::SlotState::InFlight;
+}
+
+void flushFrameCapture(VkDevice device, FrameCapture &capture)
+{
+    for (FrameCapture::Slot &slot : capture.slots)
+    {
+        if (FrameCapture::SlotState::InFlight == slot.state)
+        {
+            vkd::WaitForFences(device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+        }
+    }
+    collectFinishedSlots(device, capture);
+
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        capture.stopping = true;
+        capture.changed.notify_all();
+    }
+    for (std::thread &encoder : capture.encoders)
+    {
+        encoder.join();
+    }
+    capture.encoders.clear();
+    if (capture.stream.is_open())
+    {
+        capture.stream.close();
+    }
+}
+
+void reportFrameCapture(std::ostream &stream, const FrameCapture &capture)
+{
+    stream << "Frame capture: " << capture.nextFrame << " frames captured, " << capture.written << " written to " << capture.path;
+    if (capture.failed > 0)
+    {
+        stream << ", " << capture.failed << " failed";
+    }
+    stream << ", " << capture.stalls << " frames stalled on a full ring" << std::endl;
+    if (capture.written + capture.failed > 0)
+    {
+        capture.encodeTime.report(stream, "Frame capture encode time");
+    }
+    if (capture.stalls > 0)
+    {
+        capture.stallTime.report(stream, "Frame capture stall time");
+    }
+}
+
+void destroyFrameCapture(VkDevice device, const FrameCapture &capture)
+{
+    for (const FrameCapture::Slot &slot : capture.slots)
+    {
+        vkDestroyFence(device, slot.fence, nullptr);
+        vkUnmapMemory(device, slot.memory);
+        vkDestroyBuffer(device, slot.buffer, nullptr);
+        vkFreeMemory(device, slot.memory, nullptr);
+    }
+    vkDestroyCommandPool(device, capture.commandPool, nullptr);
+}
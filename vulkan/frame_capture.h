@@ -0,0 +1,93 @@
+#pragma once
+
+#include "frame_stats.h"
+
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Presented frames copied into a ring of host readable buffers and written out by encoder threads
+// Each frame's submission copies its swap chain image into the next slot and a fence follows it,
+// which is polled a few frames later rather than waited on, so the render loop only stalls when
+// the whole ring is still in flight or encoding. Encoders read the slot's mapping in place and
+// write numbered PNGs into a directory, or one Y4M stream, in frame order, when the path ends
+// in .y4m; a named pipe there feeds an encoder such as ffmpeg while the ditty runs.
+struct FrameCapture
+{
+    enum class SlotState
+    {
+        Free,
+        InFlight,
+        Encoding
+    };
+
+    struct Slot
+    {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        const uint8_t *pixels;
+        VkFence fence;
+        VkCommandBuffer commandBuffer;
+        SlotState state = SlotState::Free;
+        uint64_t frame = 0;
+    };
+
+    std::vector<VkImage> images;
+    VkExtent2D extent;
+    bool bgra;
+    // cached memory is much faster for the encoders to read but needs invalidating
+    bool coherent;
+    VkCommandPool commandPool;
+    std::vector<Slot> slots;
+    uint32_t nextSlot = 0;
+    uint64_t nextFrame = 0;
+    // the slot recorded this frame, until its fence is submitted
+    Slot *recorded = nullptr;
+
+    std::string path;
+    bool y4m;
+    std::ofstream stream;
+
+    // slot states, the encode queue and everything the encoders update
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Slot *> encodeQueue;
+    uint64_t nextFrameToWrite = 0;
+    bool stopping = false;
+    std::vector<std::thread> encoders;
+
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    uint64_t stalls = 0;
+    DurationStats stallTime;
+    DurationStats encodeTime;
+};
+
+// images are the swap chain's, which must have been created with transfer source usage; throws
+// std::runtime_error if the format isn't 8 bit RGBA or BGRA or the output can't be opened
+std::unique_ptr<FrameCapture> createFrameCapture(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, const std::vector<VkImage> &images, VkExtent2D extent, VkFormat format,
+                                                 const char *path, uint32_t ringSize, uint32_t encoderThreads, uint32_t framesPerSecond);
+
+// Hands finished slots to the encoders and records the copy of the acquired image into the next
+// one, waiting for it if it's still busy; submit the command buffer after the frame's work,
+// in the same batch so the copy finishes before the image is presented
+VkCommandBuffer recordFrameCapture(VkDevice device, FrameCapture &capture, uint32_t imageIndex);
+
+// Right after the frame's submission, submits the recorded slot's fence
+void submitFrameCapture(VkDevice device, VkQueue queue, FrameCapture &capture);
+
+// Waits for every captured frame to be written and stops the encoders
+void flushFrameCapture(VkDevice device, FrameCapture &capture);
+
+void reportFrameCapture(std::ostream &stream, const FrameCapture &capture);
+
+// After flushFrameCapture
+void destroyFrameCapture(VkDevice device, const FrameCapture &capture);
@@ -0,0 +1,171 @@
+#include "gpu_timer.h"
+#include "device_functions.h"
+#include "trace.h"
+
+#include <stdexcept>
+
+static void beginCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+}
+
+static uint64_t gpuNanoseconds(const GpuTimer &timer, uint64_t ticks)
+{
+    return uint64_t(int64_t(double(ticks & timer.timestampMask) * timer.nanosecondsPerTick) + timer.gpuToCpuNanoseconds);
+}
+
+// the query after the slots' pairs is written once, by a submission timed on the CPU
+static void calibrate(VkDevice device, VkQueue queue, GpuTimer &timer)
+{
+    const uint32_t query = 2 * GpuTimer::Slots;
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = timer.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate GPU timer calibration command buffer");
+    }
+    beginCommandBuffer(commandBuffer);
+    vkCmdResetQueryPool(commandBuffer, timer.queryPool, query, 1);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer.queryPool, query);
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence;
+    vkCreateFence(device, &fenceInfo, nullptr, &fence);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    const uint64_t cpuBefore = traceNow();
+    vkQueueSubmit(queue, 1, &submitInfo, fence);
+    vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+    const uint64_t cpuAfter = traceNow();
+
+    uint64_t ticks = 0;
+    vkGetQueryPoolResults(device, timer.queryPool, query, 1, sizeof(ticks), &ticks, sizeof(ticks), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    timer.gpuToCpuNanoseconds = int64_t(cpuBefore + (cpuAfter - cpuBefore) / 2) - int64_t(double(ticks & timer.timestampMask) * timer.nanosecondsPerTick);
+
+    vkDestroyFence(device, fence, nullptr);
+    vkFreeCommandBuffers(device, timer.commandPool, 1, &commandBuffer);
+}
+
+std::unique_ptr<GpuTimer> createGpuTimer(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue)
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    const uint32_t validBits = families[queueFamily].timestampValidBits;
+    if (0 == validBits)
+    {
+        return nullptr;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    auto timer = std::make_unique<GpuTimer>();
+    timer->nanosecondsPerTick = properties.limits.timestampPeriod;
+    timer->timestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2 * GpuTimer::Slots + 1;
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &timer->queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create GPU timer query pool");
+    }
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &timer->commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create GPU timer command pool");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = timer->commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = GpuTimer::Slots;
+    if (vkAllocateCommandBuffers(device, &allocInfo, timer->beginCommandBuffers) != VK_SUCCESS ||
+        vkAllocateCommandBuffers(device, &allocInfo, timer->endCommandBuffers) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate GPU timer command buffers");
+    }
+
+    for (uint32_t slot = 0; slot < GpuTimer::Slots; ++slot)
+    {
+        beginCommandBuffer(timer->beginCommandBuffers[slot]);
+        vkCmdResetQueryPool(timer->beginCommandBuffers[slot], timer->queryPool, 2 * slot, 2);
+        vkCmdWriteTimestamp(timer->beginCommandBuffers[slot], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer->queryPool, 2 * slot);
+        vkEndCommandBuffer(timer->beginCommandBuffers[slot]);
+
+        beginCommandBuffer(timer->endCommandBuffers[slot]);
+        vkCmdWriteTimestamp(timer->endCommandBuffers[slot], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer->queryPool, 2 * slot + 1);
+        vkEndCommandBuffer(timer->endCommandBuffers[slot]);
+    }
+
+    calibrate(device, queue, *timer);
+
+    return timer;
+}
+
+// true once the slot's frame has completed, after adding it to the trace
+static bool collectSlot(VkDevice device, GpuTimer &timer, uint32_t slot)
+{
+    if (!timer.pending[slot])
+    {
+        return true;
+    }
+
+    // each query's value followed by its availability
+    uint64_t results[4];
+    vkd::GetQueryPoolResults(device, timer.queryPool, 2 * slot, 2, sizeof(results), results, 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (0 == results[1] || 0 == results[3])
+    {
+        return false;
+    }
+
+    traceGpuZone("frame", gpuNanoseconds(timer, results[0]), gpuNanoseconds(timer, results[2]));
+    timer.pending[slot] = false;
+    return true;
+}
+
+std::tuple<VkCommandBuffer, VkCommandBuffer> timeGpuFrame(VkDevice device, GpuTimer &timer)
+{
+    const uint32_t slot = timer.nextSlot;
+    if (!collectSlot(device, timer, slot))
+    {
+        return std::make_tuple(VkCommandBuffer(VK_NULL_HANDLE), VkCommandBuffer(VK_NULL_HANDLE));
+    }
+    timer.pending[slot] = true;
+    timer.nextSlot = (slot + 1) % GpuTimer::Slots;
+    return std::make_tuple(timer.beginCommandBuffers[slot], timer.endCommandBuffers[slot]);
+}
+
+void collectGpuTimer(VkDevice device, GpuTimer &timer)
+{
+    for (uint32_t slot = 0; slot < GpuTimer::Slots; ++slot)
+    {
+        collectSlot(device, timer, slot);
+    }
+}
+
+void destroyGpuTimer(VkDevice device, const GpuTimer &timer)
+{
+    vkDestroyCommandPool(device, timer.commandPool, nullptr);
+    vkDestroyQueryPool(device, timer.queryPool, nullptr);
+}
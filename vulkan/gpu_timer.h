@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// Timestamps either side of each frame's submission, added to the trace as GPU zones
+// The timestamps go in small command buffers of their own, so pre-recorded frames don't need
+// re-recording. Results are read back only once available, never stalling; a frame is left
+// untimed if every slot is still in flight. GPU ticks are mapped onto traceNow's clock by
+// timing a lone timestamp submission at creation, accurate to about the submission latency.
+struct GpuTimer
+{
+    static constexpr uint32_t Slots = 8;
+
+    VkQueryPool queryPool;
+    VkCommandPool commandPool;
+    // per slot: one resets the slot's queries and writes the start, the other writes the end
+    VkCommandBuffer beginCommandBuffers[Slots];
+    VkCommandBuffer endCommandBuffers[Slots];
+    bool pending[Slots] = {};
+    uint32_t nextSlot = 0;
+
+    double nanosecondsPerTick;
+    uint64_t timestampMask;
+    int64_t gpuToCpuNanoseconds;
+};
+
+// Null if the queue family can't write timestamps
+std::unique_ptr<GpuTimer> createGpuTimer(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue);
+
+// Command buffers to submit before and after the frame's work on the timer's queue, or null
+// handles if no slot is free
+std::tuple<VkCommandBuffer, VkCommandBuffer> timeGpuFrame(VkDevice device, GpuTimer &timer);
+
+// Moves every completed frame into the trace
+void collectGpuTimer(VkDevice device, GpuTimer &timer);
+
+void destroyGpuTimer(VkDevice device, const GpuTimer &timer);
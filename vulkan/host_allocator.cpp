@@ -0,0 +1,260 @@
+#include "host_allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+
+namespace
+{
+    // in front of every allocation, so frees and reallocations know where it came from
+    struct AllocationHeader
+    {
+        uint64_t size;
+        uint32_t offset; // from the start of the underlying block to the allocation
+        uint8_t scope;
+        uint8_t sizeClass;
+        uint8_t padding[2];
+    };
+    static_assert(sizeof(AllocationHeader) == 16, "AllocationHeader must keep allocations 16 byte aligned");
+
+    constexpr size_t headerSize = sizeof(AllocationHeader);
+    constexpr size_t poolAlignment = 16;
+    // blocks of 32 << sizeClass bytes, header included
+    constexpr uint8_t sizeClassCount = 7;
+    constexpr uint8_t heapAllocation = 0xFF;
+    constexpr size_t slabSize = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    // a block freed on another thread joins that thread's list
+    struct ThreadPools
+    {
+        FreeBlock *freeLists[sizeClassCount] = {};
+        uint8_t *slab = nullptr;
+        size_t slabRemaining = 0;
+    };
+
+    thread_local ThreadPools threadPools;
+}
+
+static size_t sizeClassBytes(uint8_t sizeClass)
+{
+    return size_t(32) << sizeClass;
+}
+
+static uint8_t sizeClassFor(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    if ((VK_SYSTEM_ALLOCATION_SCOPE_COMMAND != scope && VK_SYSTEM_ALLOCATION_SCOPE_OBJECT != scope) || alignment > poolAlignment)
+    {
+        return heapAllocation;
+    }
+    for (uint8_t sizeClass = 0; sizeClass < sizeClassCount; ++sizeClass)
+    {
+        if (size + headerSize <= sizeClassBytes(sizeClass))
+        {
+            return sizeClass;
+        }
+    }
+    return heapAllocation;
+}
+
+static uint8_t *takePoolBlock(uint8_t sizeClass)
+{
+    ThreadPools &pools = threadPools;
+    if (FreeBlock *block = pools.freeLists[sizeClass])
+    {
+        pools.freeLists[sizeClass] = block->next;
+        return reinterpret_cast<uint8_t *>(block);
+    }
+
+    const size_t bytes = sizeClassBytes(sizeClass);
+    if (pools.slabRemaining < bytes)
+    {
+        // the tail of the old slab is abandoned; malloc's alignment covers poolAlignment
+        pools.slab = static_cast<uint8_t *>(malloc(slabSize));
+        if (nullptr == pools.slab)
+        {
+            pools.slabRemaining = 0;
+            return nullptr;
+        }
+        pools.slabRemaining = slabSize;
+    }
+    uint8_t *block = pools.slab;
+    pools.slab += bytes;
+    pools.slabRemaining -= bytes;
+    return block;
+}
+
+static AllocationHeader *headerOf(void *memory)
+{
+    return reinterpret_cast<AllocationHeader *>(static_cast<uint8_t *>(memory) - headerSize);
+}
+
+static void addLiveBytes(HostAllocator::ScopeStats &stats, int64_t bytes)
+{
+    const int64_t live = stats.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    int64_t peak = stats.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !stats.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+}
+
+static void *allocate(HostAllocator::ScopeStats &stats, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    const uint8_t sizeClass = sizeClassFor(size, alignment, scope);
+    uint8_t *block;
+    uint8_t *memory;
+    if (heapAllocation != sizeClass)
+    {
+        block = takePoolBlock(sizeClass);
+        if (nullptr == block)
+        {
+            return nullptr;
+        }
+        memory = block + headerSize;
+        stats.pooledAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        alignment = std::max(alignment, poolAlignment);
+        block = static_cast<uint8_t *>(malloc(size + headerSize + alignment - 1));
+        if (nullptr == block)
+        {
+            return nullptr;
+        }
+        memory = reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(block) + headerSize + alignment - 1) & ~uintptr_t(alignment - 1));
+        stats.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    AllocationHeader *header = headerOf(memory);
+    header->size = size;
+    header->offset = uint32_t(memory - block);
+    header->scope = uint8_t(scope);
+    header->sizeClass = sizeClass;
+
+    addLiveBytes(stats, int64_t(size));
+    return memory;
+}
+
+static void release(HostAllocator &allocator, void *memory)
+{
+    AllocationHeader *header = headerOf(memory);
+    HostAllocator::ScopeStats &stats = allocator.scopes[header->scope];
+    stats.frees.fetch_add(1, std::memory_order_relaxed);
+    stats.liveBytes.fetch_sub(int64_t(header->size), std::memory_order_relaxed);
+
+    uint8_t *block = static_cast<uint8_t *>(memory) - header->offset;
+    if (heapAllocation != header->sizeClass)
+    {
+        FreeBlock *freeBlock = reinterpret_cast<FreeBlock *>(block);
+        freeBlock->next = threadPools.freeLists[header->sizeClass];
+        threadPools.freeLists[header->sizeClass] = freeBlock;
+    }
+    else
+    {
+        free(block);
+    }
+}
+
+static void *VKAPI_PTR allocationCallback(void *userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    HostAllocator &allocator = *static_cast<HostAllocator *>(userData);
+    return allocate(allocator.scopes[scope], size, alignment, scope);
+}
+
+static void *VKAPI_PTR reallocationCallback(void *userData, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    HostAllocator &allocator = *static_cast<HostAllocator *>(userData);
+    if (nullptr == original)
+    {
+        return allocate(allocator.scopes[scope], size, alignment, scope);
+    }
+    if (0 == size)
+    {
+        release(allocator, original);
+        return nullptr;
+    }
+
+    AllocationHeader *header = headerOf(original);
+    HostAllocator::ScopeStats &stats = allocator.scopes[scope];
+    stats.reallocations.fetch_add(1, std::memory_order_relaxed);
+
+    // a pool block often has room to grow in place; a change of scope moves it, as the scope
+    // decides both the stats it counts towards and whether it's pooled at all
+    if (header->scope == uint8_t(scope) && heapAllocation != header->sizeClass && alignment <= poolAlignment && size + headerSize <= sizeClassBytes(header->sizeClass))
+    {
+        addLiveBytes(stats, int64_t(size) - int64_t(header->size));
+        header->size = size;
+        return original;
+    }
+
+    void *memory = allocate(allocator.scopes[scope], size, alignment, scope);
+    if (nullptr != memory)
+    {
+        memcpy(memory, original, std::min(size_t(header->size), size));
+        release(allocator, original);
+    }
+    return memory;
+}
+
+static void VKAPI_PTR freeCallback(void *userData, void *memory)
+{
+    if (nullptr != memory)
+    {
+        release(*static_cast<HostAllocator *>(userData), memory);
+    }
+}
+
+static void VKAPI_PTR internalAllocationCallback(void *userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+    static_cast<HostAllocator *>(userData)->scopes[scope].internalBytes.fetch_add(int64_t(size), std::memory_order_relaxed);
+}
+
+static void VKAPI_PTR internalFreeCallback(void *userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+    static_cast<HostAllocator *>(userData)->scopes[scope].internalBytes.fetch_sub(int64_t(size), std::memory_order_relaxed);
+}
+
+HostAllocator::HostAllocator()
+{
+    allocationCallbacks = {};
+    allocationCallbacks.pUserData = this;
+    allocationCallbacks.pfnAllocation = allocationCallback;
+    allocationCallbacks.pfnReallocation = reallocationCallback;
+    allocationCallbacks.pfnFree = freeCallback;
+    allocationCallbacks.pfnInternalAllocation = internalAllocationCallback;
+    allocationCallbacks.pfnInternalFree = internalFreeCallback;
+}
+
+void HostAllocator::frameEnded()
+{
+    for (uint32_t scope = 0; scope < ScopeCount; ++scope)
+    {
+        const uint64_t allocations = scopes[scope].pooledAllocations.load(std::memory_order_relaxed) + scopes[scope].heapAllocations.load(std::memory_order_relaxed);
+        frameAllocations[scope] += allocations - allocationsBeforeFrame[scope];
+        maxFrameAllocations[scope] = std::max(maxFrameAllocations[scope], allocations - allocationsBeforeFrame[scope]);
+        allocationsBeforeFrame[scope] = allocations;
+    }
+    ++frames;
+}
+
+void HostAllocator::report(std::ostream &stream) const
+{
+    static const char *scopeNames[ScopeCount] = { "command", "object", "cache", "device", "instance" };
+    for (uint32_t scope = 0; scope < ScopeCount; ++scope)
+    {
+        const ScopeStats &stats = scopes[scope];
+        stream << "Host memory, " << scopeNames[scope] << " scope: " << stats.pooledAllocations.load() + stats.heapAllocations.load() << " allocations (" << stats.pooledAllocations.load() << " pooled), "
+               << stats.reallocations.load() << " reallocations, " << stats.frees.load() << " frees, " << stats.liveBytes.load() << " bytes live, "
+               << stats.peakBytes.load() << " peak, " << stats.internalBytes.load() << " internal";
+        if (frames > 0)
+        {
+            stream << ", " << double(frameAllocations[scope]) / double(frames) << " allocations per frame (max " << maxFrameAllocations[scope] << ")";
+        }
+        stream << std::endl;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+// VkAllocationCallbacks that account for the driver's host allocations per VkSystemAllocationScope
+// Command and object scope allocations of up to 2KB, the small and frequent ones, are served from
+// thread-local free lists carved out of 64KB slabs; the rest go to the C heap. Pool memory is
+// kept for reuse until the process exits, even after the HostAllocator is destroyed, so objects
+// created with it may outlive it. frameEnded records how many allocations each frame made.
+class HostAllocator
+{
+public:
+    static constexpr uint32_t ScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    HostAllocator();
+
+    HostAllocator(const HostAllocator &) = delete;
+    HostAllocator &operator=(const HostAllocator &) = delete;
+
+    const VkAllocationCallbacks *callbacks() const { return &allocationCallbacks; }
+
+    void frameEnded();
+
+    void report(std::ostream &stream) const;
+
+    struct ScopeStats
+    {
+        // each allocation counts once, as pooled or heap, to keep the locked operations down
+        std::atomic<uint64_t> pooledAllocations{0};
+        std::atomic<uint64_t> heapAllocations{0};
+        std::atomic<uint64_t> reallocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<int64_t> liveBytes{0};
+        std::atomic<int64_t> peakBytes{0};
+        // driver allocations made without the callbacks, reported through the notifications
+        std::atomic<int64_t> internalBytes{0};
+    };
+
+    ScopeStats scopes[ScopeCount];
+
+private:
+    VkAllocationCallbacks allocationCallbacks;
+    uint64_t allocationsBeforeFrame[ScopeCount] = {};
+    // per-frame counts as running totals, so a long run doesn't grow them
+    uint64_t frames = 0;
+    uint64_t frameAllocations[ScopeCount] = {};
+    uint64_t maxFrameAllocations[ScopeCount] = {};
+};
@@ -2,19 +2,174 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include "cpu_usage.h"
+#include "device_functions.h"
+#include "deletion_queue.h"
+#include "device_stats.h"
+#include "ditty_options.h"
+#include "event_channel.h"
+#include "frame_capture.h"
+#include "frame_scheduler.h"
+#include "frame_stats.h"
+#include "gpu_timer.h"
+#include "host_allocator.h"
+#include "job_system.h"
+#include "mapped_file.h"
+#include "mesh_data.h"
+#include "mesh_format.h"
+#include "perf_overlay.h"
+#include "process_memory.h"
+#include "scene_renderer.h"
+#include "shader_library.h"
+#include "startup_timeline.h"
+#include "texture_stream.h"
+#include "trace.h"
+#include "window_events.h"
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <string>
 #include <tuple>
 #include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <exception>
+#include <mutex>
 
 static void error_callback(int code, const char *description)
 {
     std::cerr << "glfw error code: " << code << " (" << description << ")" << std::endl;
 }
 
-static VkInstance createInstance()
+struct Options : DittyOptions
 {
+    const char *texturePath = nullptr;
+    VkDeviceSize textureBytesPerFrame = 256 * 1024;
+    uint32_t sceneObjects = 0;
+    CullMode cullMode = CullMode::Gpu;
+    PostProcessMode postMode = PostProcessMode::None;
+    uint32_t msaaSamples = 1;
+    bool transientAttachments = true;
+    const char *meshPath = nullptr;
+    uint32_t frameLimit = 0;
+    bool trackHostMemory = false;
+    const char *shaderDirectory = DITTY_SHADER_DIRECTORY;
+    const char *shaderCacheDirectory = nullptr;
+    bool separatePresents = false;
+    uint32_t captureRing = 4;
+    uint32_t captureThreads = 2;
+    uint32_t captureFps = 60;
+};
+
+static Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (parseDittyOption(argc, argv, i, options))
+        {
+            continue;
+        }
+
+        if (0 == strcmp(argv[i], "--texture") && i + 1 < argc)
+        {
+            options.texturePath = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--texture-budget-kb") && i + 1 < argc)
+        {
+            options.textureBytesPerFrame = VkDeviceSize(atoi(argv[++i])) * 1024;
+        }
+        else if (0 == strcmp(argv[i], "--objects") && i + 1 < argc)
+        {
+            options.sceneObjects = uint32_t(atoi(argv[++i]));
+        }
+        else if (0 == strcmp(argv[i], "--cull") && i + 1 < argc)
+        {
+            const char *mode = argv[++i];
+            if (0 == strcmp(mode, "cpu"))
+            {
+                options.cullMode = CullMode::Cpu;
+            }
+            else if (0 == strcmp(mode, "gpu"))
+            {
+                options.cullMode = CullMode::Gpu;
+            }
+            else
+            {
+                std::cerr << "Ignoring unknown cull mode " << mode << std::endl;
+            }
+        }
+        else if (0 == strcmp(argv[i], "--post") && i + 1 < argc)
+        {
+            const char *mode = argv[++i];
+            if (0 == strcmp(mode, "compute"))
+            {
+                options.postMode = PostProcessMode::Compute;
+            }
+            else if (0 == strcmp(mode, "fragment"))
+            {
+                options.postMode = PostProcessMode::Fragment;
+            }
+            else
+            {
+                std::cerr << "Ignoring unknown post-processing mode " << mode << std::endl;
+            }
+        }
+        else if (0 == strcmp(argv[i], "--mesh") && i + 1 < argc)
+        {
+            options.meshPath = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--frames") && i + 1 < argc)
+        {
+            options.frameLimit = uint32_t(atoi(argv[++i]));
+        }
+        else if (0 == strcmp(argv[i], "--track-host-memory"))
+        {
+            options.trackHostMemory = true;
+        }
+        else if (0 == strcmp(argv[i], "--separate-present"))
+        {
+            options.separatePresents = true;
+        }
+        else if (0 == strcmp(argv[i], "--capture-ring") && i + 1 < argc)
+        {
+            options.captureRing = uint32_t(std::max(1, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--capture-threads") && i + 1 < argc)
+        {
+            options.captureThreads = uint32_t(std::max(1, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--capture-fps") && i + 1 < argc)
+        {
+            options.captureFps = uint32_t(std::max(1, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--msaa") && i + 1 < argc)
+        {
+            options.msaaSamples = uint32_t(std::max(1, atoi(argv[++i])));
+        }
+        else if (0 == strcmp(argv[i], "--regular-attachments"))
+        {
+            options.transientAttachments = false;
+        }
+        else if (0 == strcmp(argv[i], "--shader-dir") && i + 1 < argc)
+        {
+            options.shaderDirectory = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--shader-cache") && i + 1 < argc)
+        {
+            options.shaderCacheDirectory = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Ignoring unknown option " << argv[i] << std::endl;
+        }
+    }
+    return options;
+}
+
+static VkInstance createInstance(const VkAllocationCallbacks *allocator)
+{
+    TRACE_FUNCTION();
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "Vulkan ditty";
@@ -39,7 +194,7 @@ static VkInstance createInstance()
 
     // set VK_LOADER_DEBUG=all to debug this
     VkInstance instance;
-    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+    if (vkCreateInstance(&createInfo, allocator, &instance) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create instance!");
     }
@@ -47,10 +202,11 @@ static VkInstance createInstance()
     return instance;
 }
 
-static VkSurfaceKHR createSurface(VkInstance instance, GLFWwindow *window)
+static VkSurfaceKHR createSurface(VkInstance instance, GLFWwindow *window, const VkAllocationCallbacks *allocator)
 {
+    TRACE_FUNCTION();
     VkSurfaceKHR surface;
-    VkResult err = glfwCreateWindowSurface(instance, window, NULL, &surface);
+    VkResult err = glfwCreateWindowSurface(instance, window, allocator, &surface);
     if (err)
     {
         throw std::runtime_error("failed to create surface!");
@@ -60,6 +216,7 @@ static VkSurfaceKHR createSurface(VkInstance instance, GLFWwindow *window)
 
 static VkPhysicalDevice getPhysicalDevice(VkInstance instance)
 {
+    TRACE_FUNCTION();
     VkPhysicalDevice physicalDevice;
     uint32_t deviceCount = 1;
     VkResult res = vkEnumeratePhysicalDevices(instance, &deviceCount, &physicalDevice);
@@ -90,6 +247,7 @@ static VkPhysicalDevice getPhysicalDevice(VkInstance instance)
 
 static void checkSwapChainSupport(VkPhysicalDevice physicalDevice)
 {
+    TRACE_FUNCTION();
     uint32_t extensionCount = 0;
     vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
 
@@ -105,7 +263,6 @@ static void checkSwapChainSupport(VkPhysicalDevice physicalDevice)
     {
         if (0 == strcmp(extension.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME))
         {
-            std::cout << "Physical device supports swap chains" << std::endl;
             return;
         }
     }
@@ -115,6 +272,7 @@ static void checkSwapChainSupport(VkPhysicalDevice physicalDevice)
 
 static std::tuple<uint32_t, uint32_t> getQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR windowSurface)
 {
+    TRACE_FUNCTION();
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
 
@@ -179,8 +337,9 @@ static std::tuple<uint32_t, uint32_t> getQueueFamilies(VkPhysicalDevice physical
     return std::make_tuple(graphicsQueueFamily, presentQueueFamily);
 }
 
-static std::tuple<VkDevice, VkQueue, VkQueue> createLogicalDevice(VkPhysicalDevice physicalDevice, const uint32_t graphicsQueueFamily, const uint32_t presentQueueFamily)
+static std::tuple<VkDevice, VkQueue, VkQueue> createLogicalDevice(VkPhysicalDevice physicalDevice, const uint32_t graphicsQueueFamily, const uint32_t presentQueueFamily, bool memoryBudget, const VkAllocationCallbacks *allocator)
 {
+    TRACE_FUNCTION();
     float queuePriority = 1.0f;
 
     VkDeviceQueueCreateInfo queueCreateInfo[2] = {};
@@ -208,25 +367,52 @@ static std::tuple<VkDevice, VkQueue, VkQueue> createLogicalDevice(VkPhysicalDevi
         deviceCreateInfo.queueCreateInfoCount = 2;
     }
 
-    const char* deviceExtensions = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
-    deviceCreateInfo.enabledExtensionCount = 1;
-    deviceCreateInfo.ppEnabledExtensionNames = &deviceExtensions;
+    const char* deviceExtensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME };
+    deviceCreateInfo.enabledExtensionCount = memoryBudget ? 2 : 1;
+    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
+
+    // for runtime generated textures encoded on the CPU
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+    VkPhysicalDeviceFeatures enabledFeatures = {};
+    enabledFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    // for GPU driven scene culling
+    enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    // for per pass shader invocation counts
+    enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    VkPhysicalDeviceVulkan12Features enabledFeatures12 = {};
+    enabledFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (properties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        VkPhysicalDeviceVulkan12Features supportedFeatures12 = {};
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &supportedFeatures12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+        enabledFeatures12.drawIndirectCount = supportedFeatures12.drawIndirectCount;
+        // for the deletion queue to know which frames the GPU has finished
+        enabledFeatures12.timelineSemaphore = supportedFeatures12.timelineSemaphore;
+        deviceCreateInfo.pNext = &enabledFeatures12;
+    }
 
     VkDevice device;
-    if (vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) != VK_SUCCESS)
+    if (vkCreateDevice(physicalDevice, &deviceCreateInfo, allocator, &device) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create logical device");
     }
 
-    std::cout << "Created logical device" << std::endl;
-
     VkQueue graphicsQueue;
     VkQueue presentQueue;
     vkGetDeviceQueue(device, graphicsQueueFamily, 0, &graphicsQueue);
     vkGetDeviceQueue(device, presentQueueFamily, 0, &presentQueue);
 
-    std::cout << "Acquired graphics and presentation queues" << std::endl;
-
     return std::make_tuple(device, graphicsQueue, presentQueue);
 }
 
@@ -278,8 +464,9 @@ VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR> presentMo
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-static std::tuple<VkSwapchainKHR, std::vector<VkImage>> createSwapChain(VkSurfaceKHR windowSurface, VkPhysicalDevice physicalDevice, VkDevice device)
+static std::tuple<VkSwapchainKHR, std::vector<VkImage>, VkExtent2D, VkFormat, VkPresentModeKHR> createSwapChain(VkSurfaceKHR windowSurface, VkPhysicalDevice physicalDevice, VkDevice device, bool transferSource, const VkAllocationCallbacks *allocator)
 {
+    TRACE_FUNCTION();
     VkSurfaceCapabilitiesKHR surfaceCapabilities;
     if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, windowSurface, &surfaceCapabilities) != VK_SUCCESS)
     {
@@ -329,6 +516,12 @@ static std::tuple<VkSwapchainKHR, std::vector<VkImage>> createSwapChain(VkSurfac
         //exit(1);
     }
 
+    // only when capturing, as some drivers can't keep a readable image compressed
+    if (transferSource && !(surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+    {
+        throw std::runtime_error("Swap chain images can't be copied from, frames can't be captured");
+    }
+
     // Determine transformation to use (preferring no transform)
     VkSurfaceTransformFlagBitsKHR surfaceTransform;
     if (surfaceCapabilities.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
@@ -350,7 +543,7 @@ static std::tuple<VkSwapchainKHR, std::vector<VkImage>> createSwapChain(VkSurfac
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = swapChainExtent;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (transferSource ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
     createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     createInfo.queueFamilyIndexCount = 0;
     createInfo.pQueueFamilyIndices = nullptr;
@@ -361,14 +554,10 @@ static std::tuple<VkSwapchainKHR, std::vector<VkImage>> createSwapChain(VkSurfac
     createInfo.oldSwapchain = VK_NULL_HANDLE;
 
     VkSwapchainKHR swapChain;
-    if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
+    if (vkCreateSwapchainKHR(device, &createInfo, allocator, &swapChain) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create swap chain");
     }
-    else
-    {
-        std::cout << "Created swap chain" << std::endl;
-    }
 
     uint32_t actualImageCount = 0;
     if (vkGetSwapchainImagesKHR(device, swapChain, &actualImageCount, nullptr) != VK_SUCCESS || 0 == actualImageCount)
@@ -384,26 +573,41 @@ static std::tuple<VkSwapchainKHR, std::vector<VkImage>> createSwapChain(VkSurfac
         throw std::runtime_error("Failed to acquire swap chain images");
     }
 
-    std::cout << "Acquired swap chain images" << std::endl;
+    return std::make_tuple(swapChain, swapChainImages, swapChainExtent, surfaceFormat.format, presentMode);
+}
 
-    return std::make_tuple(swapChain, swapChainImages);
+// blit destination that fits an image into the swap chain, centred and keeping its aspect ratio
+static VkImageBlit fitBlit(VkExtent2D imageExtent, VkExtent2D swapChainExtent)
+{
+    const float scale = std::min(float(swapChainExtent.width) / float(imageExtent.width), float(swapChainExtent.height) / float(imageExtent.height));
+    const int32_t width = std::max(1, int32_t(float(imageExtent.width) * scale));
+    const int32_t height = std::max(1, int32_t(float(imageExtent.height) * scale));
+    const int32_t x = (int32_t(swapChainExtent.width) - width) / 2;
+    const int32_t y = (int32_t(swapChainExtent.height) - height) / 2;
+
+    VkImageBlit blit = {};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1] = { int32_t(imageExtent.width), int32_t(imageExtent.height), 1 };
+    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.dstSubresource.layerCount = 1;
+    blit.dstOffsets[0] = { x, y, 0 };
+    blit.dstOffsets[1] = { x + width, y + height, 1 };
+    return blit;
 }
 
-static std::tuple<VkCommandPool, std::vector<VkCommandBuffer>> createCommandQueues(const uint32_t presentQueueFamily, VkDevice device, const std::vector<VkImage> &swapChainImages)
+static std::tuple<VkCommandPool, std::vector<VkCommandBuffer>> createCommandQueues(const uint32_t presentQueueFamily, VkDevice device, const std::vector<VkImage> &swapChainImages, VkExtent2D swapChainExtent, const TextureStream *texture, const VkAllocationCallbacks *allocator)
 {
+    TRACE_FUNCTION();
     VkCommandPoolCreateInfo poolCreateInfo = {};
     poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolCreateInfo.queueFamilyIndex = presentQueueFamily;
 
     VkCommandPool commandPool;
-    if (vkCreateCommandPool(device, &poolCreateInfo, nullptr, &commandPool) != VK_SUCCESS)
+    if (vkCreateCommandPool(device, &poolCreateInfo, allocator, &commandPool) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create command queue for presentation queue family");
     }
-    else
-    {
-        std::cout << "Created command pool for presentation queue family" << std::endl;
-    }
 
     std::vector<VkCommandBuffer> presentCommandBuffers;
     presentCommandBuffers.resize(swapChainImages.size());
@@ -420,10 +624,6 @@ static std::tuple<VkCommandPool, std::vector<VkCommandBuffer>> createCommandQueu
     {
         throw std::runtime_error("Failed to allocate presentation command buffers");
     }
-    else
-    {
-        std::cout << "Allocated presentation command buffers" << std::endl;
-    }
 
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -481,91 +681,406 @@ static std::tuple<VkCommandPool, std::vector<VkCommandBuffer>> createCommandQueu
 
         vkCmdClearColorImage(presentCommandBuffers[i], swapChainImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subResourceRange);
 
+        if (nullptr != texture)
+        {
+            // level 0 always holds the best data streamed so far, in TRANSFER_SRC_OPTIMAL
+            VkImageBlit blit = fitBlit(texture->extent, swapChainExtent);
+            vkCmdBlitImage(presentCommandBuffers[i], texture->displayImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapChainImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, texture->blitFilter);
+        }
+
         vkCmdPipelineBarrier(presentCommandBuffers[i], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &clearToPresentBarrier);
 
         if (vkEndCommandBuffer(presentCommandBuffers[i]) != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to record command buffer");
         }
-        else
-        {
-            std::cout << "Recorded command buffer for image " << i << std::endl;
-        }
     }
 
     return std::make_tuple(commandPool, presentCommandBuffers);
 }
 
-static std::tuple<VkSemaphore, VkSemaphore> createSemaphores(VkDevice device)
+static std::tuple<VkSemaphore, VkSemaphore> createSemaphores(VkDevice device, const VkAllocationCallbacks *allocator)
 {
+    TRACE_FUNCTION();
     VkSemaphoreCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
     VkSemaphore imageAvailableSemaphore;
     VkSemaphore renderingFinishedSemaphore;
-    if (vkCreateSemaphore(device, &createInfo, nullptr, &imageAvailableSemaphore) != VK_SUCCESS ||
-        vkCreateSemaphore(device, &createInfo, nullptr, &renderingFinishedSemaphore) != VK_SUCCESS)
+    if (vkCreateSemaphore(device, &createInfo, allocator, &imageAvailableSemaphore) != VK_SUCCESS ||
+        vkCreateSemaphore(device, &createInfo, allocator, &renderingFinishedSemaphore) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create semaphores");
     }
-    else
+
+    return std::make_tuple(imageAvailableSemaphore, renderingFinishedSemaphore);
+}
+
+// A window after the first, cleared each frame and presented along with it
+struct ExtraWindow
+{
+    GLFWwindow *window;
+    VkSurfaceKHR surface;
+    VkSwapchainKHR swapChain;
+    VkCommandPool commandPool;
+    std::vector<VkCommandBuffer> commandBuffers;
+    VkSemaphore imageAvailableSemaphore;
+    VkSemaphore renderingFinishedSemaphore;
+};
+
+// Every window's swap chain is acquired each frame, one submission renders them all, and they're
+// presented together in one vkQueuePresentKHR or, for comparison, with a call each
+struct Presentation
+{
+    std::vector<ExtraWindow> extraWindows;
+    bool separate = false;
+
+    // per window, the first included
+    std::vector<uint32_t> suboptimal;
+    std::vector<uint32_t> outOfDate;
+    DurationStats cpuTime;
+
+    // refilled every frame, kept to reuse their storage
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitDstStageMasks;
+    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<VkSemaphore> signalSemaphores;
+    std::vector<uint64_t> signalValues;
+    std::vector<uint32_t> windows;
+    std::vector<VkSwapchainKHR> swapChains;
+    std::vector<uint32_t> imageIndices;
+    std::vector<VkResult> results;
+};
+
+static ExtraWindow createExtraWindow(GLFWwindow *firstWindow, uint32_t index, VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t presentQueueFamily, const VkAllocationCallbacks *allocator)
+{
+    TRACE_FUNCTION();
+    ExtraWindow extra;
+    const std::string title = "Vulkan ditty " + std::to_string(index + 1);
+    extra.window = glfwCreateWindow(640, 480, title.c_str(), nullptr, nullptr);
+    if (nullptr == extra.window)
     {
-        std::cout << "Created semaphores" << std::endl;
+        throw std::runtime_error("Failed to create window " + std::to_string(index + 1));
     }
+    // closing any window closes the ditty
+    glfwSetWindowUserPointer(extra.window, firstWindow);
+    glfwSetWindowCloseCallback(extra.window, [](GLFWwindow *window)
+    {
+        glfwSetWindowShouldClose(static_cast<GLFWwindow *>(glfwGetWindowUserPointer(window)), GLFW_TRUE);
+    });
 
-    return std::make_tuple(imageAvailableSemaphore, renderingFinishedSemaphore);
+    extra.surface = createSurface(instance, extra.window, allocator);
+    VkBool32 presentSupport = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, presentQueueFamily, extra.surface, &presentSupport);
+    if (!presentSupport)
+    {
+        throw std::runtime_error("The present queue can't present to window " + std::to_string(index + 1));
+    }
+    std::vector<VkImage> images;
+    VkExtent2D extent;
+    std::tie(extra.swapChain, images, extent, std::ignore, std::ignore) = createSwapChain(extra.surface, physicalDevice, device, false, allocator);
+    std::tie(extra.commandPool, extra.commandBuffers) = createCommandQueues(presentQueueFamily, device, images, extent, nullptr, allocator);
+    std::tie(extra.imageAvailableSemaphore, extra.renderingFinishedSemaphore) = createSemaphores(device, allocator);
+    return extra;
+}
+
+static void destroyExtraWindow(VkInstance instance, VkDevice device, const ExtraWindow &extra, const VkAllocationCallbacks *allocator)
+{
+    vkDestroySemaphore(device, extra.renderingFinishedSemaphore, allocator);
+    vkDestroySemaphore(device, extra.imageAvailableSemaphore, allocator);
+    vkFreeCommandBuffers(device, extra.commandPool, uint32_t(extra.commandBuffers.size()), extra.commandBuffers.data());
+    vkDestroyCommandPool(device, extra.commandPool, allocator);
+    vkDestroySwapchainKHR(device, extra.swapChain, allocator);
+    vkDestroySurfaceKHR(instance, extra.surface, allocator);
+    glfwDestroyWindow(extra.window);
 }
 
-static void render(VkDevice device, VkSwapchainKHR swapChain, VkSemaphore imageAvailableSemaphore, VkSemaphore renderingFinishedSemaphore, const std::vector<VkCommandBuffer> &presentCommandBuffers, VkQueue presentQueue)
+// each swap chain's result on its own: an out of date one is skipped, as the windows can't be
+// resized there's nothing to recreate, and any other failure names the window
+static void presentResult(Presentation &presentation, uint32_t window, VkResult result, const char *operation)
 {
+    if (VK_SUBOPTIMAL_KHR == result)
+    {
+        ++presentation.suboptimal[window];
+    }
+    else if (VK_ERROR_OUT_OF_DATE_KHR == result)
+    {
+        ++presentation.outOfDate[window];
+    }
+    else if (VK_SUCCESS != result)
+    {
+        throw std::runtime_error(std::string("Failed to ") + operation + " window " + std::to_string(window + 1) + ": error " + std::to_string(result));
+    }
+}
+
+static void render(VkDevice device, VkSwapchainKHR swapChain, VkSemaphore imageAvailableSemaphore, VkSemaphore renderingFinishedSemaphore, const std::vector<VkCommandBuffer> &presentCommandBuffers, VkQueue presentQueue, VkCommandBuffer uploadCommandBuffer, VkFence frameFence, SceneRenderer *scene, GpuTimer *gpuTimer, FrameCapture *capture, PerfOverlay *overlay, Presentation &presentation, DeletionQueue &deletions, int presentStallMs)
+{
+    TRACE_FUNCTION();
+    const auto start = std::chrono::steady_clock::now();
+
     uint32_t imageIndex;
-    VkResult res = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+    VkResult res;
+    {
+        TRACE_ZONE("acquire");
+        res = vkd::AcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+    }
 
     if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR)
     {
         throw std::runtime_error("Failed to acquire image");
     }
 
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    // the scene is recorded per frame, once the image it renders into is known
+    VkCommandBuffer commandBuffer = presentCommandBuffers[imageIndex];
+    VkPipelineStageFlags waitDstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if (nullptr != scene)
+    {
+        std::tie(commandBuffer, frameFence) = recordSceneFrame(device, *scene, imageIndex);
+        // culling can run before the image is available, only the colour writes wait, or
+        // with post-processing the blit into it
+        waitDstStageMask = scene->post ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
 
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &imageAvailableSemaphore;
+    presentation.waitSemaphores.assign(1, imageAvailableSemaphore);
+    presentation.waitDstStageMasks.assign(1, waitDstStageMask);
+    presentation.commandBuffers.assign(1, commandBuffer);
+    // the HUD draws over the first window's image, and is captured with it
+    if (nullptr != overlay)
+    {
+        auto [hudBegin, hudDraw] = recordPerfOverlay(device, *overlay, imageIndex);
+        if (VK_NULL_HANDLE != hudBegin)
+        {
+            presentation.commandBuffers.insert(presentation.commandBuffers.begin(), hudBegin);
+        }
+        presentation.commandBuffers.push_back(hudDraw);
+    }
+    // the first window's image is copied out once it has been rendered
+    if (nullptr != capture)
+    {
+        presentation.commandBuffers.push_back(recordFrameCapture(device, *capture, imageIndex));
+    }
+    presentation.signalSemaphores.assign(1, renderingFinishedSemaphore);
+    presentation.windows.assign(1, 0);
+    presentation.swapChains.assign(1, swapChain);
+    presentation.imageIndices.assign(1, imageIndex);
+    presentResult(presentation, 0, res, "acquire an image for");
 
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &renderingFinishedSemaphore;
+    for (uint32_t i = 0; i < presentation.extraWindows.size(); ++i)
+    {
+        const ExtraWindow &extra = presentation.extraWindows[i];
+        uint32_t extraImageIndex;
+        {
+            TRACE_ZONE("acquire");
+            res = vkd::AcquireNextImageKHR(device, extra.swapChain, UINT64_MAX, extra.imageAvailableSemaphore, VK_NULL_HANDLE, &extraImageIndex);
+        }
+        presentResult(presentation, i + 1, res, "acquire an image for");
+        if (VK_ERROR_OUT_OF_DATE_KHR == res)
+        {
+            continue;
+        }
+        presentation.waitSemaphores.push_back(extra.imageAvailableSemaphore);
+        presentation.waitDstStageMasks.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+        presentation.commandBuffers.push_back(extra.commandBuffers[extraImageIndex]);
+        // a binary semaphore is waited on once, so separate presents need one each
+        if (presentation.separate)
+        {
+            presentation.signalSemaphores.push_back(extra.renderingFinishedSemaphore);
+        }
+        presentation.windows.push_back(i + 1);
+        presentation.swapChains.push_back(extra.swapChain);
+        presentation.imageIndices.push_back(extraImageIndex);
+    }
 
-    VkPipelineStageFlags waitDstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    submitInfo.pWaitDstStageMask = &waitDstStageMask;
+    // bracketed by the GPU timer's timestamps when tracing
+    if (nullptr != gpuTimer)
+    {
+        auto [timerBegin, timerEnd] = timeGpuFrame(device, *gpuTimer);
+        if (VK_NULL_HANDLE != timerBegin)
+        {
+            presentation.commandBuffers.insert(presentation.commandBuffers.begin(), timerBegin);
+            presentation.commandBuffers.push_back(timerEnd);
+        }
+    }
+
+    // uploads go in their own batch so they don't wait for the image to be acquired
+    VkSubmitInfo submitInfos[2] = {};
+    uint32_t submitCount = 0;
 
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &presentCommandBuffers[imageIndex];
+    if (VK_NULL_HANDLE != uploadCommandBuffer)
+    {
+        VkSubmitInfo &uploadInfo = submitInfos[submitCount++];
+        uploadInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        uploadInfo.commandBufferCount = 1;
+        uploadInfo.pCommandBuffers = &uploadCommandBuffer;
+    }
+
+    // one batch renders every window
+    VkSubmitInfo &submitInfo = submitInfos[submitCount++];
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = uint32_t(presentation.waitSemaphores.size());
+    submitInfo.pWaitSemaphores = presentation.waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = presentation.waitDstStageMasks.data();
+    submitInfo.commandBufferCount = uint32_t(presentation.commandBuffers.size());
+    submitInfo.pCommandBuffers = presentation.commandBuffers.data();
+
+    // and marks the frame as done for the deletion queue; binary semaphores ignore their values
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    if (VK_NULL_HANDLE != deletions.timeline)
+    {
+        presentation.signalSemaphores.push_back(deletions.timeline);
+        presentation.signalValues.assign(presentation.signalSemaphores.size(), 0);
+        presentation.signalValues.back() = deletions.frame;
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = uint32_t(presentation.signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = presentation.signalValues.data();
+        submitInfo.pNext = &timelineInfo;
+    }
+    submitInfo.signalSemaphoreCount = uint32_t(presentation.signalSemaphores.size());
+    submitInfo.pSignalSemaphores = presentation.signalSemaphores.data();
 
-    if (vkQueueSubmit(presentQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
     {
-        throw std::runtime_error("Failed to submit draw command buffer");
+        TRACE_ZONE("vkQueueSubmit");
+        if (vkd::QueueSubmit(presentQueue, submitCount, submitInfos, frameFence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit draw command buffer");
+        }
     }
+    if (nullptr != capture)
+    {
+        submitFrameCapture(device, presentQueue, *capture);
+    }
+    if (nullptr != overlay)
+    {
+        submitPerfOverlay(presentQueue, *overlay);
+    }
+    signalDeletionQueue(device, presentQueue, deletions);
 
+    if (presentStallMs > 0)
+    {
+        // simulate a slow compositor or driver
+        std::this_thread::sleep_for(std::chrono::milliseconds(presentStallMs));
+    }
+
+    const uint32_t swapChainCount = uint32_t(presentation.swapChains.size());
+    presentation.results.assign(swapChainCount, VK_SUCCESS);
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = &renderingFinishedSemaphore;
+    if (presentation.separate)
+    {
+        TRACE_ZONE("vkQueuePresentKHR");
+        for (uint32_t i = 0; i < swapChainCount; ++i)
+        {
+            presentInfo.waitSemaphoreCount = 1;
+            presentInfo.pWaitSemaphores = &presentation.signalSemaphores[i];
+            presentInfo.swapchainCount = 1;
+            presentInfo.pSwapchains = &presentation.swapChains[i];
+            presentInfo.pImageIndices = &presentation.imageIndices[i];
+            presentInfo.pResults = &presentation.results[i];
+            vkd::QueuePresentKHR(presentQueue, &presentInfo);
+        }
+    }
+    else
+    {
+        TRACE_ZONE("vkQueuePresentKHR");
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &renderingFinishedSemaphore;
+        presentInfo.swapchainCount = swapChainCount;
+        presentInfo.pSwapchains = presentation.swapChains.data();
+        presentInfo.pImageIndices = presentation.imageIndices.data();
+        presentInfo.pResults = presentation.results.data();
+        vkd::QueuePresentKHR(presentQueue, &presentInfo);
+    }
 
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = &swapChain;
-    presentInfo.pImageIndices = &imageIndex;
+    for (uint32_t i = 0; i < swapChainCount; ++i)
+    {
+        presentResult(presentation, presentation.windows[i], presentation.results[i], "present");
+    }
+
+    // the presentation stall is simulated driver time, not the cost being measured
+    const auto cpuTime = std::chrono::steady_clock::now() - start - std::chrono::milliseconds(presentStallMs);
+    presentation.cpuTime.add(cpuTime);
+    if (nullptr != overlay)
+    {
+        overlay->cpuMs = float(std::chrono::duration<double, std::milli>(cpuTime).count());
+    }
+}
 
-    res = vkQueuePresentKHR(presentQueue, &presentInfo);
+// What the startup jobs produce, for the main thread to pick up once it has waited on them
+struct StartupWork
+{
+    StartupTimeline *timeline;
+    JobSystem *jobs;
+    const Options *options;
+    const VkAllocationCallbacks *allocator;
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    std::unique_ptr<ShaderLibrary> shaders;
+    std::unique_ptr<MappedFile> meshFile;
+    std::vector<uint8_t> meshData;
+    MeshView mesh = {};
+    ProceduralTexture generatedTexture;
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+// Runs a phase on a job, keeping the first exception for waitStartupJobs as jobs must not throw
+template <typename Function>
+static void startupJob(StartupWork &work, const char *name, const Function &function)
+{
+    try
+    {
+        StartupPhase phase(*work.timeline, name);
+        function();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(work.errorMutex);
+        if (!work.error)
+        {
+            work.error = std::current_exception();
+        }
+    }
+}
 
-    if (res != VK_SUCCESS)
+static void waitStartupJobs(JobSystem &jobs, JobCounter &counter, StartupWork &work)
+{
+    jobs.wait(counter);
+    std::lock_guard<std::mutex> lock(work.errorMutex);
+    if (work.error)
     {
-        throw std::runtime_error("Failed to submit present command buffer");
+        std::rethrow_exception(work.error);
     }
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    if (!glfwInit())
+    const auto startTime = std::chrono::steady_clock::now();
+    const Options options = parseOptions(argc, argv);
+    if (nullptr != options.tracePath && !startTrace())
+    {
+        std::cerr << "Built without DITTY_TRACE, ignoring --trace" << std::endl;
+    }
+    TRACE_THREAD("main");
+    StartupTimeline startup(startTime);
+
+    if (options.sceneObjects > 0 && (nullptr != options.texturePath || nullptr != options.proceduralTexture))
+    {
+        throw std::runtime_error("--objects can't be combined with the texture options");
+    }
+    if (PostProcessMode::None != options.postMode && 0 == options.sceneObjects)
+    {
+        throw std::runtime_error("--post post-processes the scene, it needs --objects");
+    }
+    if (options.msaaSamples > 1 && 0 == options.sceneObjects)
+    {
+        throw std::runtime_error("--msaa multisamples the scene, it needs --objects");
+    }
+
+    JobSystem jobs;
+
+    if (!timePhase(startup, "glfw init", glfwInit))
     {
         return -1;
     }
@@ -583,35 +1098,351 @@ int main()
         return -1;
     }
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    GLFWwindow *window = glfwCreateWindow(640, 480, "Vulkan ditty", nullptr, nullptr);
+    // the driver's host allocations, for the objects created here
+    std::unique_ptr<HostAllocator> hostAllocator;
+    if (options.trackHostMemory)
+    {
+        hostAllocator = std::make_unique<HostAllocator>();
+    }
+    const VkAllocationCallbacks *allocator = hostAllocator ? hostAllocator->callbacks() : nullptr;
+
+    // Startup as a dependency graph: the instance, shaders, mesh and generated texture don't
+    // depend on the window or the device, so they run on the job system while the main thread,
+    // which GLFW requires for windows, creates the window and then the device once the instance
+    // is ready
+    StartupWork work;
+    work.timeline = &startup;
+    work.jobs = &jobs;
+    work.options = &options;
+    work.allocator = allocator;
+    JobCounter instanceReady;
+    JobCounter sceneInputsReady;
+    JobCounter textureReady;
+    jobs.run(instanceReady, [work = &work]()
+    {
+        startupJob(*work, "instance", [work]()
+        {
+            work->instance = createInstance(work->allocator);
+            work->physicalDevice = getPhysicalDevice(work->instance);
+            checkSwapChainSupport(work->physicalDevice);
+        });
+    });
+    if (options.sceneObjects > 0 || options.hud)
+    {
+        // the pipeline cache is read with the shaders, ready for the scene's and HUD's pipelines
+        jobs.run(sceneInputsReady, [work = &work]()
+        {
+            startupJob(*work, "shaders", [work]()
+            {
+                const Options &options = *work->options;
+                work->shaders = std::make_unique<ShaderLibrary>(options.shaderDirectory, nullptr != options.shaderCacheDirectory ? std::filesystem::path(options.shaderCacheDirectory) : defaultShaderCacheDirectory());
+                work->shaders->build(dittyShaderVariants(), work->jobs);
+            });
+        });
+    }
+    if (options.sceneObjects > 0)
+    {
+        // the mesh only needs to outlive the upload, a generated one is encoded in memory
+        jobs.run(sceneInputsReady, [work = &work]()
+        {
+            startupJob(*work, "mesh", [work]()
+            {
+                if (nullptr != work->options->meshPath)
+                {
+                    work->meshFile = std::make_unique<MappedFile>(work->options->meshPath);
+                    work->mesh = viewMesh(work->meshFile->data(), work->meshFile->size());
+                }
+                else
+                {
+                    work->meshData = encodeMesh(generateSphere(12, 6));
+                    work->mesh = viewMesh(work->meshData.data(), work->meshData.size());
+                }
+            });
+        });
+    }
+    if (nullptr != options.proceduralTexture)
+    {
+        jobs.run(textureReady, [work = &work]()
+        {
+            startupJob(*work, "procedural texture", [work]()
+            {
+                const Options &options = *work->options;
+                work->generatedTexture = generateProceduralTexture(options.proceduralTextureSize, textureEncodingFromName(options.proceduralTexture), work->jobs);
+            });
+        });
+    }
 
-    VkInstance instance = createInstance();
-    VkSurfaceKHR surface = createSurface(instance, window);
-    VkPhysicalDevice physicalDevice = getPhysicalDevice(instance);
-    checkSwapChainSupport(physicalDevice);
+    GLFWwindow *window;
+    {
+        StartupPhase phase(startup, "window");
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        window = glfwCreateWindow(640, 480, "Vulkan ditty", nullptr, nullptr);
+    }
+
+    waitStartupJobs(jobs, instanceReady, work);
+    VkInstance instance = work.instance;
+    VkPhysicalDevice physicalDevice = work.physicalDevice;
+    VkSurfaceKHR surface = timePhase(startup, "surface", createSurface, instance, window, allocator);
     auto [graphicsQueueFamily, presentQueueFamily] = getQueueFamilies(physicalDevice, surface);
-    auto [device, graphicsQueue, presentQueue] = createLogicalDevice(physicalDevice, graphicsQueueFamily, presentQueueFamily);
-    auto [swapChain, swapChainImages] = createSwapChain(surface, physicalDevice, device);
-    auto [commandPool, presentCommandBuffers] = createCommandQueues(presentQueueFamily, device, swapChainImages);
-    auto [imageAvailableSemaphore, renderingFinishedSemaphore] = createSemaphores(device);
+    const bool memoryBudgetEnabled = memoryBudgetSupported(physicalDevice);
+    auto [device, graphicsQueue, presentQueue] = timePhase(startup, "device", createLogicalDevice, physicalDevice, graphicsQueueFamily, presentQueueFamily, memoryBudgetEnabled, allocator);
+    loadDeviceFunctions(device);
+    MemoryBudget memoryBudget = createMemoryBudget(physicalDevice, memoryBudgetEnabled);
+    std::unique_ptr<DeletionQueue> deletions = createDeletionQueue(device, timelineSemaphoreSupported(physicalDevice));
+    auto [swapChain, swapChainImages, swapChainExtent, swapChainFormat, swapChainPresentMode] = timePhase(startup, "swap chain", createSwapChain, surface, physicalDevice, device, nullptr != options.capturePath, allocator);
+    std::unique_ptr<TextureStream> texture;
+    if (nullptr != options.texturePath)
+    {
+        StartupPhase phase(startup, "texture stream");
+        texture = createTextureStream(physicalDevice, device, presentQueueFamily, options.texturePath, options.textureBytesPerFrame);
+    }
+    else if (nullptr != options.proceduralTexture)
+    {
+        waitStartupJobs(jobs, textureReady, work);
+        StartupPhase phase(startup, "texture stream");
+        texture = createTextureStream(physicalDevice, device, presentQueueFamily, std::move(work.generatedTexture), options.textureBytesPerFrame);
+    }
+    std::unique_ptr<ShaderLibrary> shaders;
+    std::unique_ptr<SceneRenderer> scene;
+    if (options.sceneObjects > 0 || options.hud)
+    {
+        waitStartupJobs(jobs, sceneInputsReady, work);
+        shaders = std::move(work.shaders);
+    }
+    if (options.sceneObjects > 0)
+    {
+        {
+            StartupPhase phase(startup, "scene renderer");
+            scene = createSceneRenderer(physicalDevice, device, presentQueueFamily, presentQueue, swapChainImages, swapChainFormat, swapChainExtent, work.mesh, options.sceneObjects, options.cullMode, options.postMode, options.msaaSamples, options.transientAttachments, *shaders, &jobs);
+        }
+        // the scene has uploaded the mesh
+        work.meshFile.reset();
+        work.meshData = {};
+    }
+    auto [commandPool, presentCommandBuffers] = timePhase(startup, "command buffers", createCommandQueues, presentQueueFamily, device, swapChainImages, swapChainExtent, texture.get(), allocator);
+    auto [imageAvailableSemaphore, renderingFinishedSemaphore] = createSemaphores(device, allocator);
+    Presentation presentation;
+    presentation.separate = options.separatePresents;
+    for (uint32_t i = 1; i < options.windowCount; ++i)
+    {
+        presentation.extraWindows.push_back(createExtraWindow(window, i, instance, physicalDevice, device, presentQueueFamily, allocator));
+    }
+    presentation.suboptimal.assign(options.windowCount, 0);
+    presentation.outOfDate.assign(options.windowCount, 0);
+    std::unique_ptr<FrameCapture> capture;
+    if (nullptr != options.capturePath)
+    {
+        capture = createFrameCapture(physicalDevice, device, presentQueueFamily, swapChainImages, swapChainExtent, swapChainFormat, options.capturePath, options.captureRing, options.captureThreads, options.captureFps);
+    }
+    std::unique_ptr<PerfOverlay> overlay;
+    if (options.hud)
+    {
+        StartupPhase phase(startup, "HUD");
+        overlay = createPerfOverlay(physicalDevice, device, presentQueueFamily, presentQueue, swapChainImages, swapChainFormat, swapChainExtent, swapChainPresentMode, *shaders);
+    }
+    std::unique_ptr<GpuTimer> gpuTimer;
+    if (traceRecording())
+    {
+        gpuTimer = createGpuTimer(physicalDevice, device, presentQueueFamily, presentQueue);
+    }
+
+    EventChannel channel;
+    installEventCallbacks(window, channel);
+
+    FrameScheduler scheduler(options.onDemand);
+    scheduler.setAnimating(texture != nullptr || scene != nullptr || overlay != nullptr);
+    FrameStats frameStats;
+    CpuUsage cpuUsage;
+    uint32_t framesRendered = 0;
 
-    while (!glfwWindowShouldClose(window))
+    // structured bindings cannot be captured directly in C++17
+    auto renderFrame = [&, device = device, swapChain = swapChain, imageAvailableSemaphore = imageAvailableSemaphore, renderingFinishedSemaphore = renderingFinishedSemaphore, &presentCommandBuffers = presentCommandBuffers, presentQueue = presentQueue]()
     {
-        render(device, swapChain, imageAvailableSemaphore, renderingFinishedSemaphore, presentCommandBuffers, presentQueue);
+        TRACE_ZONE("frame");
+        VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+        VkFence frameFence = VK_NULL_HANDLE;
+        if (texture)
+        {
+            std::tie(uploadCommandBuffer, frameFence) = recordTextureUploads(device, *texture);
+        }
+
+        render(device, swapChain, imageAvailableSemaphore, renderingFinishedSemaphore, presentCommandBuffers, presentQueue, uploadCommandBuffer, frameFence, scene.get(), gpuTimer.get(), capture.get(), overlay.get(), presentation, *deletions, options.presentStallMs);
+        startup.firstFramePresented();
+
+        if (texture)
+        {
+            textureFramePresented(*texture, *deletions);
+            // keep drawing until streaming has finished, even in on-demand mode, and after it for
+            // the scene and HUD
+            scheduler.setAnimating(!texture->resident || scene != nullptr || overlay != nullptr);
+        }
+        collectDeletionQueue(device, *deletions);
+
+        scheduler.frameRendered();
+        frameStats.framePresented();
+        cpuUsage.frameRendered();
+        memoryBudgetFrame(physicalDevice, memoryBudget);
+        if (overlay)
+        {
+            perfOverlayMemory(*overlay, memoryBudget);
+        }
+        if (hostAllocator)
+        {
+            hostAllocator->frameEnded();
+        }
+
+        // fixed length runs for benchmarking
+        if (options.frameLimit > 0 && ++framesRendered == options.frameLimit)
+        {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            glfwPostEmptyEvent();
+        }
+    };
+
+    if (options.renderThread)
+    {
+        // the render thread owns the device and queues from here on, this thread only pumps events
+        std::thread renderThread([&]()
+        {
+            TRACE_THREAD("render");
+            while (!channel.isClosed())
+            {
+                drainEvents(channel, scheduler, frameStats);
+
+                if (scheduler.shouldRender())
+                {
+                    renderFrame();
+                }
+                else
+                {
+                    channel.wait(scheduler.waitTimeout());
+                }
+            }
+        });
+
+        while (!glfwWindowShouldClose(window))
+        {
+            glfwWaitEvents();
+        }
+
+        channel.close();
+        renderThread.join();
+    }
+    else
+    {
+        while (!glfwWindowShouldClose(window))
+        {
+            drainEvents(channel, scheduler, frameStats);
+
+            if (scheduler.shouldRender())
+            {
+                renderFrame();
+            }
+
+            pumpEvents(scheduler);
+        }
+    }
+
+    if (capture)
+    {
+        flushFrameCapture(device, *capture);
+    }
 
-        glfwPollEvents();
+    startup.report(std::cout);
+    cpuUsage.report(std::cout, options.onDemand ? "Vulkan ditty (on-demand)" : "Vulkan ditty (continuous)");
+    frameStats.report(std::cout);
+    if (channel.droppedEvents() > 0)
+    {
+        std::cout << "Dropped " << channel.droppedEvents() << " window events" << std::endl;
+    }
+    if (texture)
+    {
+        reportTextureStream(std::cout, *texture, startTime);
+    }
+    if (scene)
+    {
+        reportSceneRenderer(std::cout, device, *scene);
+    }
+    if (shaders)
+    {
+        shaders->report(std::cout);
+    }
+    std::cout << "Peak resident memory " << (peakResidentBytes() / (1024 * 1024)) << "MB" << std::endl;
+    pollMemoryBudget(physicalDevice, memoryBudget);
+    reportMemoryBudget(std::cout, memoryBudget);
+    const std::string presentLabel = std::string("Acquire to present CPU time, ") + std::to_string(options.windowCount) + (1 == options.windowCount ? " window" : " windows")
+                                     + (presentation.separate ? " presented separately" : " presented together");
+    presentation.cpuTime.report(std::cout, presentLabel.c_str());
+    reportDeletionQueue(std::cout, *deletions);
+    if (capture)
+    {
+        reportFrameCapture(std::cout, *capture);
+    }
+    if (overlay)
+    {
+        reportPerfOverlay(std::cout, *overlay);
+    }
+    for (uint32_t i = 0; i < options.windowCount; ++i)
+    {
+        if (presentation.suboptimal[i] > 0 || presentation.outOfDate[i] > 0)
+        {
+            std::cout << "Window " << i + 1 << ": " << presentation.suboptimal[i] << " suboptimal, " << presentation.outOfDate[i] << " out of date" << std::endl;
+        }
     }
 
-    vkDestroySemaphore(device, renderingFinishedSemaphore, nullptr);
-    vkDestroySemaphore(device, imageAvailableSemaphore, nullptr);
+    vkDeviceWaitIdle(device);
+
+    if (gpuTimer)
+    {
+        collectGpuTimer(device, *gpuTimer);
+        destroyGpuTimer(device, *gpuTimer);
+    }
+    if (traceRecording())
+    {
+        writeTrace(options.tracePath);
+        std::cout << "Wrote trace to " << options.tracePath << std::endl;
+    }
+
+    if (texture)
+    {
+        destroyTextureStream(device, *texture);
+    }
+    if (scene)
+    {
+        destroySceneRenderer(device, *scene);
+    }
+    if (overlay)
+    {
+        destroyPerfOverlay(device, *overlay);
+    }
+    if (shaders)
+    {
+        shaders->destroyModules(device);
+    }
+    if (capture)
+    {
+        destroyFrameCapture(device, *capture);
+    }
+
+    vkDestroySemaphore(device, renderingFinishedSemaphore, allocator);
+    vkDestroySemaphore(device, imageAvailableSemaphore, allocator);
     vkFreeCommandBuffers(device, commandPool, presentCommandBuffers.size(), presentCommandBuffers.data());
-    vkDestroyCommandPool(device, commandPool, nullptr);
-    vkDestroySwapchainKHR(device, swapChain, nullptr);
-    vkDestroyDevice(device, nullptr);
-    vkDestroySurfaceKHR(instance, surface, nullptr);
-    vkDestroyInstance(instance, nullptr);
+    vkDestroyCommandPool(device, commandPool, allocator);
+    vkDestroySwapchainKHR(device, swapChain, allocator);
+    for (const ExtraWindow &extra : presentation.extraWindows)
+    {
+        destroyExtraWindow(instance, device, extra, allocator);
+    }
+    destroyDeletionQueue(device, *deletions);
+    vkDestroyDevice(device, allocator);
+    vkDestroySurfaceKHR(instance, surface, allocator);
+    vkDestroyInstance(instance, allocator);
+
+    if (hostAllocator)
+    {
+        hostAllocator->report(std::cout);
+    }
 
     glfwDestroyWindow(window);
 
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <tuple>
+
+// index of a memory type allowed by typeBits that has all the required properties
+// throws std::runtime_error if there is none
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeBits, VkMemoryPropertyFlags required);
+
+std::tuple<VkBuffer, VkDeviceMemory> createBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+
+// Device local buffer filled through a temporary staging buffer; blocks until the copy has completed
+std::tuple<VkBuffer, VkDeviceMemory> createDeviceLocalBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, VkBufferUsageFlags usage, const void *data, VkDeviceSize size);
@@ -0,0 +1,713 @@
+#include "perf_overlay.h"
+#include "device_functions.h"
+#include "memory_util.h"
+#include "process_memory.h"
+#include "trace.h"
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+static constexpr VkDeviceSize indexBytes = hudMaxQuads * 6 * sizeof(uint16_t);
+// the indirect arguments get a block of their own so the vertices start well aligned
+static constexpr VkDeviceSize argumentBytes = 256;
+static constexpr VkDeviceSize slotBytes = argumentBytes + hudMaxQuads * 4 * sizeof(SpriteVertex);
+
+// resident memory is read from the OS, so only every this many frames
+static constexpr uint32_t residentInterval = 30;
+
+static VkDeviceSize slotOffset(uint32_t slot)
+{
+    return indexBytes + slot * slotBytes;
+}
+
+static const char *presentModeName(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR:
+        return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "FIFO RELAXED";
+    default:
+        return "OTHER";
+    }
+}
+
+// Draws over the frame, so the image is loaded and stays ready to present; the dependencies wait
+// for every earlier write to it, and order the HUD's writes before a capture's copy
+static VkRenderPass createRenderPass(VkDevice device, VkFormat format)
+{
+    VkAttachmentDescription attachment = {};
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+
+    VkSubpassDependency dependencies[2] = {};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.attachmentCount = 1;
+    createInfo.pAttachments = &attachment;
+    createInfo.subpassCount = 1;
+    createInfo.pSubpasses = &subpass;
+    createInfo.dependencyCount = 2;
+    createInfo.pDependencies = dependencies;
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(device, &createInfo, nullptr, &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD render pass");
+    }
+    return renderPass;
+}
+
+static VkImageView createImageView(VkDevice device, VkImage image, VkFormat format)
+{
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD image view");
+    }
+    return view;
+}
+
+// The atlas through a staging buffer, left ready to sample
+static void createAtlas(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue queue, PerfOverlay &overlay)
+{
+    const std::vector<uint8_t> texels = bakeHudAtlas();
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8_UNORM;
+    imageInfo.extent = { hudAtlasWidth, hudAtlasHeight, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device, &imageInfo, nullptr, &overlay.atlas) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD atlas image");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, overlay.atlas, &requirements);
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &overlay.atlasMemory) != VK_SUCCESS || vkBindImageMemory(device, overlay.atlas, overlay.atlasMemory, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate HUD atlas memory");
+    }
+    overlay.atlasView = createImageView(device, overlay.atlas, VK_FORMAT_R8_UNORM);
+
+    auto [stagingBuffer, stagingMemory] = createBuffer(physicalDevice, device, texels.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    void *mapping;
+    if (vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapping) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to map HUD atlas staging buffer");
+    }
+    memcpy(mapping, texels.data(), texels.size());
+    vkUnmapMemory(device, stagingMemory);
+
+    VkCommandBufferAllocateInfo commandInfo = {};
+    commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandInfo.commandPool = commandPool;
+    commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate HUD atlas upload command buffer");
+    }
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = overlay.atlas;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { hudAtlasWidth, hudAtlasHeight, 1 };
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, overlay.atlas, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit HUD atlas upload");
+    }
+    vkQueueWaitIdle(queue);
+
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    vkDestroyBuffer(device, stagingBuffer, nullptr);
+    vkFreeMemory(device, stagingMemory, nullptr);
+}
+
+// Host visible and coherent, and device local as well where the device offers it, so the GPU
+// reads the few hundred quads without crossing the bus
+static void createHudBuffer(VkPhysicalDevice physicalDevice, VkDevice device, PerfOverlay &overlay)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = slotOffset(PerfOverlay::Slots);
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &overlay.buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD buffer");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, overlay.buffer, &requirements);
+    const VkMemoryPropertyFlags hostFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t memoryType;
+    try
+    {
+        memoryType = findMemoryType(physicalDevice, requirements.memoryTypeBits, hostFlags | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        overlay.deviceLocal = true;
+    }
+    catch (const std::runtime_error &)
+    {
+        memoryType = findMemoryType(physicalDevice, requirements.memoryTypeBits, hostFlags);
+        overlay.deviceLocal = false;
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = memoryType;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &overlay.memory) != VK_SUCCESS || vkBindBufferMemory(device, overlay.buffer, overlay.memory, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate HUD buffer memory");
+    }
+    void *mapping;
+    if (vkMapMemory(device, overlay.memory, 0, VK_WHOLE_SIZE, 0, &mapping) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to map HUD buffer");
+    }
+    overlay.mapped = static_cast<uint8_t *>(mapping);
+
+    uint16_t *indices = reinterpret_cast<uint16_t *>(overlay.mapped);
+    for (uint32_t i = 0; i < hudMaxQuads; ++i)
+    {
+        const uint16_t vertex = uint16_t(4 * i);
+        const uint16_t quad[6] = { vertex, uint16_t(vertex + 1), uint16_t(vertex + 2), vertex, uint16_t(vertex + 2), uint16_t(vertex + 3) };
+        memcpy(indices + 6 * size_t(i), quad, sizeof(quad));
+    }
+}
+
+static void createPipeline(VkDevice device, VkExtent2D extent, ShaderLibrary &shaders, PerfOverlay &overlay)
+{
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 1;
+    setLayoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &overlay.descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD descriptor set layout");
+    }
+
+    VkPushConstantRange pushConstants = { VK_SHADER_STAGE_VERTEX_BIT, 0, 4 * sizeof(float) };
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &overlay.descriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &overlay.pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD pipeline layout");
+    }
+
+    VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 };
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &overlay.descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD descriptor pool");
+    }
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool = overlay.descriptorPool;
+    setInfo.descriptorSetCount = 1;
+    setInfo.pSetLayouts = &overlay.descriptorSetLayout;
+    if (vkAllocateDescriptorSets(device, &setInfo, &overlay.descriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate HUD descriptor set");
+    }
+    const VkDescriptorImageInfo imageInfo = { overlay.sampler, overlay.atlasView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = overlay.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = shaders.module(device, "hud.vert");
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = shaders.module(device, "hud.frag");
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription vertexBinding = { 0, sizeof(SpriteVertex), VK_VERTEX_INPUT_RATE_VERTEX };
+    const VkVertexInputAttributeDescription attributes[3] = {
+        { 0, 0, VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(SpriteVertex, x)) },
+        { 1, 0, VK_FORMAT_R32G32_SFLOAT, uint32_t(offsetof(SpriteVertex, u)) },
+        { 2, 0, VK_FORMAT_R8G8B8A8_UNORM, uint32_t(offsetof(SpriteVertex, color)) },
+    };
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &vertexBinding;
+    vertexInput.vertexAttributeDescriptionCount = 3;
+    vertexInput.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkViewport viewport = { 0.0f, 0.0f, float(extent.width), float(extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, extent };
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.blendEnable = VK_TRUE;
+    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+
+    VkGraphicsPipelineCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    createInfo.stageCount = 2;
+    createInfo.pStages = stages;
+    createInfo.pVertexInputState = &vertexInput;
+    createInfo.pInputAssemblyState = &inputAssembly;
+    createInfo.pViewportState = &viewportState;
+    createInfo.pRasterizationState = &rasterization;
+    createInfo.pMultisampleState = &multisample;
+    createInfo.pColorBlendState = &colorBlend;
+    createInfo.layout = overlay.pipelineLayout;
+    createInfo.renderPass = overlay.renderPass;
+    createInfo.subpass = 0;
+    if (vkCreateGraphicsPipelines(device, shaders.pipelineCache(device), 1, &createInfo, nullptr, &overlay.pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD pipeline");
+    }
+}
+
+// Neither kind of command buffer changes between frames: the draw's arguments are read from the
+// slot's memory when it executes
+static void recordCommandBuffers(VkDevice device, VkExtent2D extent, PerfOverlay &overlay)
+{
+    const uint32_t imageCount = uint32_t(overlay.framebuffers.size());
+    const float transform[4] = { 2.0f / float(extent.width), 2.0f / float(extent.height), -1.0f, -1.0f };
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    for (uint32_t slotIndex = 0; slotIndex < PerfOverlay::Slots; ++slotIndex)
+    {
+        PerfOverlay::Slot &slot = overlay.slots[slotIndex];
+        const uint32_t firstQuery = 3 * slotIndex;
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = overlay.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = imageCount;
+        slot.drawCommandBuffers.resize(imageCount);
+        if (vkAllocateCommandBuffers(device, &allocInfo, slot.drawCommandBuffers.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate HUD command buffers");
+        }
+        if (VK_NULL_HANDLE != overlay.queryPool)
+        {
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device, &allocInfo, &slot.beginCommandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to allocate HUD command buffers");
+            }
+            vkBeginCommandBuffer(slot.beginCommandBuffer, &beginInfo);
+            vkCmdResetQueryPool(slot.beginCommandBuffer, overlay.queryPool, firstQuery, 3);
+            vkCmdWriteTimestamp(slot.beginCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, overlay.queryPool, firstQuery);
+            vkEndCommandBuffer(slot.beginCommandBuffer);
+        }
+
+        for (uint32_t image = 0; image < imageCount; ++image)
+        {
+            VkCommandBuffer commandBuffer = slot.drawCommandBuffers[image];
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            // the frame's work has finished once this one is written
+            if (VK_NULL_HANDLE != overlay.queryPool)
+            {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, overlay.queryPool, firstQuery + 1);
+            }
+
+            VkRenderPassBeginInfo renderPassInfo = {};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = overlay.renderPass;
+            renderPassInfo.framebuffer = overlay.framebuffers[image];
+            renderPassInfo.renderArea = { { 0, 0 }, extent };
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, overlay.pipeline);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, overlay.pipelineLayout, 0, 1, &overlay.descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, overlay.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform);
+            const VkDeviceSize vertexOffset = slotOffset(slotIndex) + argumentBytes;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &overlay.buffer, &vertexOffset);
+            vkCmdBindIndexBuffer(commandBuffer, overlay.buffer, 0, VK_INDEX_TYPE_UINT16);
+            vkCmdDrawIndexedIndirect(commandBuffer, overlay.buffer, slotOffset(slotIndex), 1, sizeof(VkDrawIndexedIndirectCommand));
+            vkCmdEndRenderPass(commandBuffer);
+
+            if (VK_NULL_HANDLE != overlay.queryPool)
+            {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, overlay.queryPool, firstQuery + 2);
+            }
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to record HUD command buffer");
+            }
+        }
+    }
+}
+
+std::unique_ptr<PerfOverlay> createPerfOverlay(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue, const std::vector<VkImage> &images, VkFormat format,
+                                               VkExtent2D extent, VkPresentModeKHR presentMode, ShaderLibrary &shaders)
+{
+    TRACE_FUNCTION();
+    auto overlay = std::make_unique<PerfOverlay>();
+    overlay->stats.presentMode = presentModeName(presentMode);
+    overlay->stats.swapChainImages = uint32_t(images.size());
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &overlay->commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD command pool");
+    }
+
+    createAtlas(physicalDevice, device, overlay->commandPool, queue, *overlay);
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &overlay->sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create HUD sampler");
+    }
+    createHudBuffer(physicalDevice, device, *overlay);
+
+    overlay->renderPass = createRenderPass(device, format);
+    for (VkImage image : images)
+    {
+        overlay->imageViews.push_back(createImageView(device, image, format));
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = overlay->renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &overlay->imageViews.back();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create HUD framebuffer");
+        }
+        overlay->framebuffers.push_back(framebuffer);
+    }
+    createPipeline(device, extent, shaders, *overlay);
+
+    // without timestamps on the queue the HUD still draws, its GPU times just stay at zero
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    const uint32_t validBits = families[queueFamily].timestampValidBits;
+    if (validBits > 0)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        overlay->nanosecondsPerTick = properties.limits.timestampPeriod;
+        overlay->timestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+
+        VkQueryPoolCreateInfo queryPoolInfo = {};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = 3 * PerfOverlay::Slots;
+        if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &overlay->queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create HUD query pool");
+        }
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    for (PerfOverlay::Slot &slot : overlay->slots)
+    {
+        if (vkCreateFence(device, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create HUD fence");
+        }
+    }
+    recordCommandBuffers(device, extent, *overlay);
+    return overlay;
+}
+
+static double tickMilliseconds(const PerfOverlay &overlay, uint64_t begin, uint64_t end)
+{
+    return double((end - begin) & overlay.timestampMask) * overlay.nanosecondsPerTick * 1e-6;
+}
+
+// Once the slot's fence has passed its timestamps are written, but they're checked regardless
+static void collectSlot(VkDevice device, PerfOverlay &overlay, uint32_t slotIndex)
+{
+    PerfOverlay::Slot &slot = overlay.slots[slotIndex];
+    if (!slot.pending || VK_NULL_HANDLE == overlay.queryPool)
+    {
+        slot.pending = false;
+        return;
+    }
+    slot.pending = false;
+
+    // each query's value followed by its availability
+    uint64_t results[6];
+    vkd::GetQueryPoolResults(device, overlay.queryPool, 3 * slotIndex, 3, sizeof(results), results, 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (0 == results[1] || 0 == results[3] || 0 == results[5])
+    {
+        return;
+    }
+    const double hudMs = tickMilliseconds(overlay, results[2], results[4]);
+    addHudGpuFrame(overlay.stats, float(tickMilliseconds(overlay, results[0], results[2])), float(hudMs));
+    overlay.hudGpuTime.add(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(hudMs)));
+    overlay.hudGpuMilliseconds += hudMs;
+    ++overlay.hudGpuFrames;
+}
+
+std::tuple<VkCommandBuffer, VkCommandBuffer> recordPerfOverlay(VkDevice device, PerfOverlay &overlay, uint32_t imageIndex)
+{
+    TRACE_FUNCTION();
+    const auto now = std::chrono::steady_clock::now();
+    if (overlay.started)
+    {
+        addHudCpuFrame(overlay.stats, float(std::chrono::duration<double, std::milli>(now - overlay.lastFrame).count()), overlay.cpuMs);
+    }
+    overlay.lastFrame = now;
+    overlay.started = true;
+    if (0 == overlay.stats.cpuFrames % residentInterval)
+    {
+        overlay.stats.residentBytes = currentResidentBytes();
+    }
+
+    const uint32_t slotIndex = overlay.slot;
+    PerfOverlay::Slot &slot = overlay.slots[slotIndex];
+    if (vkd::GetFenceStatus(device, slot.fence) != VK_SUCCESS)
+    {
+        TRACE_ZONE("wait for HUD slot");
+        ++overlay.fenceWaits;
+        vkd::WaitForFences(device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+    }
+    collectSlot(device, overlay, slotIndex);
+    vkd::ResetFences(device, 1, &slot.fence);
+
+    const auto layoutStart = std::chrono::steady_clock::now();
+    uint8_t *slotMemory = overlay.mapped + slotOffset(slotIndex);
+    const uint32_t quads = layoutPerfHud(overlay.stats, reinterpret_cast<SpriteVertex *>(slotMemory + argumentBytes));
+    const VkDrawIndexedIndirectCommand draw = { quads * 6, 1, 0, 0, 0 };
+    memcpy(slotMemory, &draw, sizeof(draw));
+    overlay.layoutTime.add(std::chrono::steady_clock::now() - layoutStart);
+
+    slot.pending = true;
+    overlay.recorded = &slot;
+    overlay.slot = (slotIndex + 1) % PerfOverlay::Slots;
+    return std::make_tuple(slot.beginCommandBuffer, slot.drawCommandBuffers[imageIndex]);
+}
+
+void submitPerfOverlay(VkQueue queue, PerfOverlay &overlay)
+{
+    if (nullptr == overlay.recorded)
+    {
+        return;
+    }
+    // an empty submission's fence signals once everything submitted before it has completed
+    if (vkd::QueueSubmit(queue, 0, nullptr, overlay.recorded->fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit HUD fence");
+    }
+    overlay.recorded = nullptr;
+}
+
+void perfOverlayMemory(PerfOverlay &overlay, const MemoryBudget &budget)
+{
+    if (!budget.supported)
+    {
+        return;
+    }
+    VkDeviceSize usage = 0;
+    VkDeviceSize total = 0;
+    for (const HeapBudget &heap : budget.heaps)
+    {
+        if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            usage += heap.usage;
+            total += heap.budget;
+        }
+    }
+    overlay.stats.gpuMemoryBytes = usage;
+    overlay.stats.gpuBudgetBytes = total;
+}
+
+void reportPerfOverlay(std::ostream &stream, const PerfOverlay &overlay)
+{
+    stream << "Performance HUD: persistently mapped " << (overlay.deviceLocal ? "device local" : "host") << " memory, " << overlay.fenceWaits << " slot waits" << std::endl;
+    overlay.layoutTime.report(stream, "HUD layout CPU time");
+    if (0 == overlay.hudGpuFrames)
+    {
+        stream << "HUD GPU time: no frames timed" << std::endl;
+        return;
+    }
+    overlay.hudGpuTime.report(stream, "HUD GPU time");
+    const double meanMs = overlay.hudGpuMilliseconds / double(overlay.hudGpuFrames);
+    if (meanMs > 0.1)
+    {
+        stream << "HUD GPU time averages " << meanMs << " ms, over its 0.1 ms budget" << std::endl;
+    }
+}
+
+void destroyPerfOverlay(VkDevice device, const PerfOverlay &overlay)
+{
+    for (const PerfOverlay::Slot &slot : overlay.slots)
+    {
+        vkDestroyFence(device, slot.fence, nullptr);
+    }
+    vkDestroyCommandPool(device, overlay.commandPool, nullptr);
+    if (VK_NULL_HANDLE != overlay.queryPool)
+    {
+        vkDestroyQueryPool(device, overlay.queryPool, nullptr);
+    }
+    vkDestroyPipeline(device, overlay.pipeline, nullptr);
+    vkDestroyPipelineLayout(device, overlay.pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(device, overlay.descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, overlay.descriptorSetLayout, nullptr);
+    for (VkFramebuffer framebuffer : overlay.framebuffers)
+    {
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+    for (VkImageView view : overlay.imageViews)
+    {
+        vkDestroyImageView(device, view, nullptr);
+    }
+    vkDestroyRenderPass(device, overlay.renderPass, nullptr);
+    vkDestroyBuffer(device, overlay.buffer, nullptr);
+    vkFreeMemory(device, overlay.memory, nullptr);
+    vkDestroySampler(device, overlay.sampler, nullptr);
+    vkDestroyImageView(device, overlay.atlasView, nullptr);
+    vkDestroyImage(device, overlay.atlas, nullptr);
+    vkFreeMemory(device, overlay.atlasMemory, nullptr);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "device_stats.h"
+#include "frame_stats.h"
+#include "perf_hud.h"
+#include "shader_library.h"
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// The performance HUD, drawn over the first window's swap chain image after the frame's work
+// Each slot's vertices and indirect draw arguments live in one persistently mapped, coherent
+// buffer, so the HUD's command buffers are recorded once per slot and image and a frame only
+// writes memory: one indexed indirect draw from the baked font atlas. A fence submitted after
+// the frame guards the slot's memory; timestamps bracket the frame and the HUD's draw and are
+// read once that fence has passed, so the HUD never stalls the GPU.
+struct PerfOverlay
+{
+    static constexpr uint32_t Slots = 3;
+
+    struct Slot
+    {
+        VkFence fence;
+        // resets the slot's queries and writes the frame's start, null without timestamps
+        VkCommandBuffer beginCommandBuffer = VK_NULL_HANDLE;
+        // per swap chain image
+        std::vector<VkCommandBuffer> drawCommandBuffers;
+        bool pending = false;
+    };
+
+    VkRenderPass renderPass;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkFramebuffer> framebuffers;
+    VkImage atlas;
+    VkDeviceMemory atlasMemory;
+    VkImageView atlasView;
+    VkSampler sampler;
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline pipeline;
+
+    // indices, then per slot the indirect arguments followed by the vertices
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    uint8_t *mapped;
+    bool deviceLocal;
+
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    double nanosecondsPerTick = 1.0;
+    uint64_t timestampMask = 0;
+
+    VkCommandPool commandPool;
+    Slot slots[Slots];
+    uint32_t slot = 0;
+    // the slot recorded this frame, until its fence is submitted
+    Slot *recorded = nullptr;
+    uint64_t fenceWaits = 0;
+
+    PerfHudStats stats;
+    std::chrono::steady_clock::time_point lastFrame;
+    bool started = false;
+    // the last frame's acquire to present CPU time, set by the ditty
+    float cpuMs = 0.0f;
+
+    DurationStats layoutTime;
+    DurationStats hudGpuTime;
+    double hudGpuMilliseconds = 0.0;
+    uint64_t hudGpuFrames = 0;
+};
+
+// images are the swap chain's, which is left in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR by the frame's
+// work; the atlas upload waits for the queue to go idle
+std::unique_ptr<PerfOverlay> createPerfOverlay(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue, const std::vector<VkImage> &images, VkFormat format,
+                                               VkExtent2D extent, VkPresentModeKHR presentMode, ShaderLibrary &shaders);
+
+// Lays out the HUD for the acquired image; submit the first command buffer, if not null, before
+// the frame's work and the second after it, in the same batch
+std::tuple<VkCommandBuffer, VkCommandBuffer> recordPerfOverlay(VkDevice device, PerfOverlay &overlay, uint32_t imageIndex);
+
+// Right after the frame's submission, submits the recorded slot's fence
+void submitPerfOverlay(VkQueue queue, PerfOverlay &overlay);
+
+// The device local heaps' usage and budget, when the driver reports them
+void perfOverlayMemory(PerfOverlay &overlay, const MemoryBudget &budget);
+
+// The HUD's own GPU and CPU cost, against the 0.1 ms it is allowed on the GPU
+void reportPerfOverlay(std::ostream &stream, const PerfOverlay &overlay);
+
+// Once the device is idle
+void destroyPerfOverlay(VkDevice device, const PerfOverlay &overlay);
@@ -0,0 +1,588 @@
+#include "post_process.h"
+#include "device_functions.h"
+#include "memory_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // mirror of the shaders' push constant block
+    struct PostParameters
+    {
+        int32_t direction[2];
+        float threshold;
+        float exposure;
+    };
+
+    // as in post_common.glsl and post_blur.comp, for the byte counts
+    constexpr uint64_t BlurRadius = 8;
+    constexpr uint64_t BlurTileSize = 16;
+
+    struct PassImages
+    {
+        VkImageView source;
+        VkImageView bloom;
+        const PostImage *destination;
+        VkExtent2D extent;
+    };
+}
+
+const char *const postProcessPassNames[PostProcess::PassCount] = { "threshold", "blur_h", "blur_v", "tonemap" };
+
+const char *postProcessModeName(PostProcessMode mode)
+{
+    switch (mode)
+    {
+    case PostProcessMode::Compute:
+        return "compute";
+    case PostProcessMode::Fragment:
+        return "fragment";
+    default:
+        return "none";
+    }
+}
+
+static PassImages passImages(const PostProcess &post, uint32_t pass)
+{
+    switch (pass)
+    {
+    case 0:
+        return { post.hdr.view, VK_NULL_HANDLE, &post.bloom[0], post.bloomExtent };
+    case 1:
+        return { post.bloom[0].view, VK_NULL_HANDLE, &post.bloom[1], post.bloomExtent };
+    case 2:
+        return { post.bloom[1].view, VK_NULL_HANDLE, &post.bloom[0], post.bloomExtent };
+    default:
+        return { post.hdr.view, post.bloom[0].view, &post.ldr, post.extent };
+    }
+}
+
+static PostParameters passParameters(uint32_t pass)
+{
+    PostParameters parameters = {};
+    parameters.direction[0] = (2 == pass) ? 0 : 1;
+    parameters.direction[1] = (2 == pass) ? 1 : 0;
+    parameters.threshold = 0.7f;
+    parameters.exposure = 1.5f;
+    return parameters;
+}
+
+static PostImage createPostImage(VkPhysicalDevice physicalDevice, VkDevice device, VkFormat format, VkExtent2D extent, VkImageUsageFlags usage)
+{
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    PostImage image;
+    if (vkCreateImage(device, &imageInfo, nullptr, &image.image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing image");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image.image, &requirements);
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &image.memory) != VK_SUCCESS || vkBindImageMemory(device, image.image, image.memory, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate post-processing image memory");
+    }
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device, &viewInfo, nullptr, &image.view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing image view");
+    }
+    return image;
+}
+
+static void destroyPostImage(VkDevice device, const PostImage &image)
+{
+    vkDestroyImageView(device, image.view, nullptr);
+    vkDestroyImage(device, image.image, nullptr);
+    vkFreeMemory(device, image.memory, nullptr);
+}
+
+static VkDescriptorSetLayout createDescriptorSetLayout(VkDevice device)
+{
+    // source, bloom (tonemap only) and, for the compute passes, the destination
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = (2 == i) ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = (2 == i) ? VK_SHADER_STAGE_COMPUTE_BIT : (VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+    }
+
+    VkDescriptorSetLayoutCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = 3;
+    createInfo.pBindings = bindings;
+
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing descriptor set layout");
+    }
+    return layout;
+}
+
+// Writes every pixel, so nothing is loaded; the dependencies order it after the previous pass or
+// frame's reads of the image, and its writes before the next pass samples or the blit copies them
+static VkRenderPass createRenderPass(VkDevice device, VkFormat format, VkImageLayout finalLayout)
+{
+    VkAttachmentDescription attachment = {};
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = finalLayout;
+
+    VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+
+    VkSubpassDependency dependencies[2] = {};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.attachmentCount = 1;
+    createInfo.pAttachments = &attachment;
+    createInfo.subpassCount = 1;
+    createInfo.pSubpasses = &subpass;
+    createInfo.dependencyCount = 2;
+    createInfo.pDependencies = dependencies;
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(device, &createInfo, nullptr, &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing render pass");
+    }
+    return renderPass;
+}
+
+static VkPipeline createComputePipeline(VkDevice device, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout, VkShaderModule shader)
+{
+    VkComputePipelineCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    createInfo.stage.module = shader;
+    createInfo.stage.pName = "main";
+    createInfo.layout = pipelineLayout;
+
+    VkPipeline pipeline;
+    const VkResult result = vkCreateComputePipelines(device, pipelineCache, 1, &createInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing compute pipeline");
+    }
+    return pipeline;
+}
+
+static VkPipeline createFullscreenPipeline(VkDevice device, VkPipelineCache pipelineCache, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, VkExtent2D extent, VkShaderModule vertexShader, VkShaderModule fragmentShader)
+{
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexShader;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentShader;
+    stages[1].pName = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkViewport viewport = { 0.0f, 0.0f, float(extent.width), float(extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, extent };
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+
+    VkGraphicsPipelineCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    createInfo.stageCount = 2;
+    createInfo.pStages = stages;
+    createInfo.pVertexInputState = &vertexInput;
+    createInfo.pInputAssemblyState = &inputAssembly;
+    createInfo.pViewportState = &viewportState;
+    createInfo.pRasterizationState = &rasterization;
+    createInfo.pMultisampleState = &multisample;
+    createInfo.pColorBlendState = &colorBlend;
+    createInfo.layout = pipelineLayout;
+    createInfo.renderPass = renderPass;
+    createInfo.subpass = 0;
+
+    VkPipeline pipeline;
+    const VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &createInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing graphics pipeline");
+    }
+    return pipeline;
+}
+
+std::unique_ptr<PostProcess> createPostProcess(VkPhysicalDevice physicalDevice, VkDevice device, VkExtent2D extent, PostProcessMode mode, ShaderLibrary &shaders)
+{
+    TRACE_FUNCTION();
+    auto post = std::make_unique<PostProcess>();
+    post->mode = mode;
+    post->extent = extent;
+    post->bloomExtent = { std::max(1u, extent.width / 2), std::max(1u, extent.height / 2) };
+
+    const bool compute = PostProcessMode::Compute == mode;
+    const VkImageUsageFlags targetUsage = compute ? VK_IMAGE_USAGE_STORAGE_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    post->hdr = createPostImage(physicalDevice, device, PostProcess::HdrFormat, extent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    for (PostImage &bloom : post->bloom)
+    {
+        bloom = createPostImage(physicalDevice, device, PostProcess::HdrFormat, post->bloomExtent, targetUsage | VK_IMAGE_USAGE_SAMPLED_BIT);
+    }
+    post->ldr = createPostImage(physicalDevice, device, PostProcess::LdrFormat, extent, targetUsage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &post->sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing sampler");
+    }
+
+    post->descriptorSetLayout = createDescriptorSetLayout(device);
+    VkPushConstantRange pushConstants = { VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PostParameters) };
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &post->descriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &post->pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing pipeline layout");
+    }
+
+    const VkDescriptorPoolSize poolSizes[2] = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, PostProcess::PassCount + 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, PostProcess::PassCount },
+    };
+    VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+    descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolInfo.maxSets = PostProcess::PassCount;
+    descriptorPoolInfo.poolSizeCount = 2;
+    descriptorPoolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &post->descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create post-processing descriptor pool");
+    }
+
+    VkDescriptorSetLayout setLayouts[PostProcess::PassCount];
+    std::fill_n(setLayouts, PostProcess::PassCount, post->descriptorSetLayout);
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool = post->descriptorPool;
+    setInfo.descriptorSetCount = PostProcess::PassCount;
+    setInfo.pSetLayouts = setLayouts;
+    if (vkAllocateDescriptorSets(device, &setInfo, post->descriptorSets) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate post-processing descriptor sets");
+    }
+
+    for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+    {
+        const PassImages images = passImages(*post, pass);
+        const VkDescriptorImageInfo imageInfos[3] = {
+            { post->sampler, images.source, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+            { post->sampler, images.bloom, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+            { VK_NULL_HANDLE, images.destination->view, VK_IMAGE_LAYOUT_GENERAL },
+        };
+        VkWriteDescriptorSet writes[3] = {};
+        uint32_t writeCount = 0;
+        for (uint32_t binding = 0; binding < 3; ++binding)
+        {
+            if ((1 == binding && VK_NULL_HANDLE == images.bloom) || (2 == binding && !compute))
+            {
+                continue;
+            }
+            VkWriteDescriptorSet &write = writes[writeCount++];
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = post->descriptorSets[pass];
+            write.dstBinding = binding;
+            write.descriptorCount = 1;
+            write.descriptorType = (2 == binding) ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo = &imageInfos[binding];
+        }
+        vkUpdateDescriptorSets(device, writeCount, writes, 0, nullptr);
+    }
+
+    const VkPipelineCache pipelineCache = shaders.pipelineCache(device);
+    if (compute)
+    {
+        post->pipelines[0] = createComputePipeline(device, pipelineCache, post->pipelineLayout, shaders.module(device, "post_threshold.comp"));
+        post->pipelines[1] = createComputePipeline(device, pipelineCache, post->pipelineLayout, shaders.module(device, "post_blur.comp"));
+        post->pipelines[2] = createComputePipeline(device, pipelineCache, post->pipelineLayout, shaders.module(device, "post_blur.comp"));
+        post->pipelines[3] = createComputePipeline(device, pipelineCache, post->pipelineLayout, shaders.module(device, "post_tonemap.comp"));
+        return post;
+    }
+
+    post->bloomRenderPass = createRenderPass(device, PostProcess::HdrFormat, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    post->tonemapRenderPass = createRenderPass(device, PostProcess::LdrFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+    {
+        const PassImages images = passImages(*post, pass);
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = (3 == pass) ? post->tonemapRenderPass : post->bloomRenderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &images.destination->view;
+        framebufferInfo.width = images.extent.width;
+        framebufferInfo.height = images.extent.height;
+        framebufferInfo.layers = 1;
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &post->framebuffers[pass]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create post-processing framebuffer");
+        }
+    }
+    VkShaderModule vertexShader = shaders.module(device, "post_fullscreen.vert");
+    post->pipelines[0] = createFullscreenPipeline(device, pipelineCache, post->pipelineLayout, post->bloomRenderPass, post->bloomExtent, vertexShader, shaders.module(device, "post_threshold.frag"));
+    post->pipelines[1] = createFullscreenPipeline(device, pipelineCache, post->pipelineLayout, post->bloomRenderPass, post->bloomExtent, vertexShader, shaders.module(device, "post_blur.frag"));
+    post->pipelines[2] = createFullscreenPipeline(device, pipelineCache, post->pipelineLayout, post->bloomRenderPass, post->bloomExtent, vertexShader, shaders.module(device, "post_blur.frag"));
+    post->pipelines[3] = createFullscreenPipeline(device, pipelineCache, post->pipelineLayout, post->tonemapRenderPass, extent, vertexShader, shaders.module(device, "post_tonemap.frag"));
+    return post;
+}
+
+static VkImageMemoryBarrier imageBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    return barrier;
+}
+
+static void recordComputePass(VkCommandBuffer commandBuffer, const PostProcess &post, uint32_t pass)
+{
+    // the previous pass's output becomes readable, this pass's output is discarded and written
+    const PassImages images = passImages(post, pass);
+    VkImageMemoryBarrier barriers[2];
+    uint32_t barrierCount = 0;
+    VkPipelineStageFlags srcStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    if (0 == pass)
+    {
+        barriers[barrierCount++] = imageBarrier(post.hdr.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+        srcStages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    else
+    {
+        const PostImage *previous = passImages(post, pass - 1).destination;
+        barriers[barrierCount++] = imageBarrier(previous->image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+    barriers[barrierCount++] = imageBarrier(images.destination->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT);
+    if (3 == pass)
+    {
+        // the previous frame's blit reads the ldr image
+        srcStages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    vkd::CmdPipelineBarrier(commandBuffer, srcStages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, barrierCount, barriers);
+
+    const PostParameters parameters = passParameters(pass);
+    vkd::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, post.pipelines[pass]);
+    vkd::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, post.pipelineLayout, 0, 1, &post.descriptorSets[pass], 0, nullptr);
+    vkd::CmdPushConstants(commandBuffer, post.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(parameters), &parameters);
+    const uint32_t groupSize = (1 == pass || 2 == pass) ? uint32_t(BlurTileSize) : 8;
+    vkd::CmdDispatch(commandBuffer, (images.extent.width + groupSize - 1) / groupSize, (images.extent.height + groupSize - 1) / groupSize, 1);
+}
+
+static void recordFragmentPass(VkCommandBuffer commandBuffer, const PostProcess &post, uint32_t pass)
+{
+    const PassImages images = passImages(post, pass);
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = (3 == pass) ? post.tonemapRenderPass : post.bloomRenderPass;
+    renderPassInfo.framebuffer = post.framebuffers[pass];
+    renderPassInfo.renderArea = { { 0, 0 }, images.extent };
+    vkd::CmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    const PostParameters parameters = passParameters(pass);
+    vkd::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post.pipelines[pass]);
+    vkd::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post.pipelineLayout, 0, 1, &post.descriptorSets[pass], 0, nullptr);
+    vkd::CmdPushConstants(commandBuffer, post.pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(parameters), &parameters);
+    vkd::CmdDraw(commandBuffer, 3, 1, 0, 0);
+
+    vkd::CmdEndRenderPass(commandBuffer);
+}
+
+void recordPostProcess(VkCommandBuffer commandBuffer, const PostProcess &post, VkQueryPool timestampPool, uint32_t firstQuery)
+{
+    const bool compute = PostProcessMode::Compute == post.mode;
+    if (!compute)
+    {
+        // the render passes' own dependencies cover the rest
+        const VkImageMemoryBarrier hdrBarrier = imageBarrier(post.hdr.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+        vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &hdrBarrier);
+    }
+
+    if (VK_NULL_HANDLE != timestampPool)
+    {
+        vkd::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, firstQuery);
+    }
+    for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+    {
+        if (compute)
+        {
+            recordComputePass(commandBuffer, post, pass);
+        }
+        else
+        {
+            recordFragmentPass(commandBuffer, post, pass);
+        }
+        if (VK_NULL_HANDLE != timestampPool)
+        {
+            vkd::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, firstQuery + 1 + pass);
+        }
+    }
+
+    if (compute)
+    {
+        const VkImageMemoryBarrier ldrBarrier = imageBarrier(post.ldr.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ldrBarrier);
+    }
+}
+
+void recordPostProcessBlit(VkCommandBuffer commandBuffer, const PostProcess &post, VkImage swapChainImage, VkExtent2D swapChainExtent)
+{
+    const VkImageMemoryBarrier toTransfer = imageBarrier(swapChainImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkImageBlit region = {};
+    region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.srcOffsets[1] = { int32_t(post.extent.width), int32_t(post.extent.height), 1 };
+    region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.dstOffsets[1] = { int32_t(swapChainExtent.width), int32_t(swapChainExtent.height), 1 };
+    vkd::CmdBlitImage(commandBuffer, post.ldr.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_NEAREST);
+
+    const VkImageMemoryBarrier toPresent = imageBarrier(swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+    vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &toPresent);
+}
+
+uint64_t postProcessPassBytes(const PostProcess &post, uint32_t pass)
+{
+    const uint64_t hdrBytes = uint64_t(post.extent.width) * post.extent.height * 8;
+    const uint64_t bloomBytes = uint64_t(post.bloomExtent.width) * post.bloomExtent.height * 8;
+    switch (pass)
+    {
+    case 0:
+        return hdrBytes + bloomBytes;
+    case 1:
+    case 2:
+        // the compute blur fetches its tile and apron once, the fragment blur every tap
+        if (PostProcessMode::Compute == post.mode)
+        {
+            return bloomBytes * (BlurTileSize + 2 * BlurRadius) / BlurTileSize + bloomBytes;
+        }
+        return bloomBytes * (2 * BlurRadius + 1) + bloomBytes;
+    default:
+        return hdrBytes + bloomBytes + uint64_t(post.extent.width) * post.extent.height * 4;
+    }
+}
+
+void destroyPostProcess(VkDevice device, const PostProcess &post)
+{
+    for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+    {
+        vkDestroyPipeline(device, post.pipelines[pass], nullptr);
+        if (VK_NULL_HANDLE != post.framebuffers[pass])
+        {
+            vkDestroyFramebuffer(device, post.framebuffers[pass], nullptr);
+        }
+    }
+    if (VK_NULL_HANDLE != post.bloomRenderPass)
+    {
+        vkDestroyRenderPass(device, post.bloomRenderPass, nullptr);
+        vkDestroyRenderPass(device, post.tonemapRenderPass, nullptr);
+    }
+    vkDestroyDescriptorPool(device, post.descriptorPool, nullptr);
+    vkDestroyPipelineLayout(device, post.pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, post.descriptorSetLayout, nullptr);
+    vkDestroySampler(device, post.sampler, nullptr);
+    destroyPostImage(device, post.ldr);
+    destroyPostImage(device, post.bloom[1]);
+    destroyPostImage(device, post.bloom[0]);
+    destroyPostImage(device, post.hdr);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "shader_library.h"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+
+// How the bloom and tonemapping chain runs: compute shaders, with the blur tiled through shared
+// memory, or the fragment shader baseline with a texture fetch per blur tap
+enum class PostProcessMode
+{
+    None,
+    Compute,
+    Fragment
+};
+
+struct PostImage
+{
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView view;
+};
+
+// Bloom and tonemapping from an HDR colour image to an 8 bit one of the same size
+// The passes are a half resolution bright pass, a horizontal and a vertical Gaussian blur at
+// half resolution, and the tonemap that adds the bloom back in. The images are shared by the
+// frames in flight; each frame's barriers order it after the previous frame's passes.
+struct PostProcess
+{
+    static constexpr uint32_t PassCount = 4;
+    static constexpr VkFormat HdrFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr VkFormat LdrFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+    PostProcessMode mode;
+    VkExtent2D extent;
+    VkExtent2D bloomExtent;
+
+    // the scene renders into hdr, the chain ping-pongs between the bloom images into ldr
+    PostImage hdr;
+    PostImage bloom[2];
+    PostImage ldr;
+    VkSampler sampler;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkPipelineLayout pipelineLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSets[PassCount];
+    VkPipeline pipelines[PassCount];
+
+    // fragment mode only
+    VkRenderPass bloomRenderPass = VK_NULL_HANDLE;
+    VkRenderPass tonemapRenderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffers[PassCount] = {};
+};
+
+extern const char *const postProcessPassNames[PostProcess::PassCount];
+
+const char *postProcessModeName(PostProcessMode mode);
+
+std::unique_ptr<PostProcess> createPostProcess(VkPhysicalDevice physicalDevice, VkDevice device, VkExtent2D extent, PostProcessMode mode, ShaderLibrary &shaders);
+
+// Records the chain from the hdr image, written as a colour attachment or by a transfer and left in
+// SHADER_READ_ONLY_OPTIMAL, to the ldr image in TRANSFER_SRC_OPTIMAL. With a timestamp pool,
+// writes firstQuery before the first pass and the following queries after each pass.
+void recordPostProcess(VkCommandBuffer commandBuffer, const PostProcess &post, VkQueryPool timestampPool, uint32_t firstQuery);
+
+// Copies the ldr image into a swap chain image and leaves that ready to present; the frame's
+// acquire semaphore must be waited on at the transfer stage
+void recordPostProcessBlit(VkCommandBuffer commandBuffer, const PostProcess &post, VkImage swapChainImage, VkExtent2D swapChainExtent);
+
+// Bytes a pass fetches from and writes to its images, before any caching
+uint64_t postProcessPassBytes(const PostProcess &post, uint32_t pass);
+
+void destroyPostProcess(VkDevice device, const PostProcess &post);
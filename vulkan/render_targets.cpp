@@ -0,0 +1,163 @@
+#include "render_targets.h"
+#include "memory_util.h"
+
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+
+VkFormat chooseDepthFormat(VkPhysicalDevice physicalDevice)
+{
+    for (VkFormat format : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM })
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+        {
+            return format;
+        }
+    }
+    throw std::runtime_error("No supported depth format");
+}
+
+VkSampleCountFlagBits chooseSampleCount(VkPhysicalDevice physicalDevice, uint32_t requested)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    const VkSampleCountFlags supported = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+    for (uint32_t samples = VK_SAMPLE_COUNT_64_BIT; samples > VK_SAMPLE_COUNT_1_BIT; samples >>= 1)
+    {
+        if (samples <= requested && (supported & samples))
+        {
+            return VkSampleCountFlagBits(samples);
+        }
+    }
+    return VK_SAMPLE_COUNT_1_BIT;
+}
+
+static VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect)
+{
+    VkImageViewCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = image;
+    createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    createInfo.format = format;
+    createInfo.subresourceRange.aspectMask = aspect;
+    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    if (vkCreateImageView(device, &createInfo, nullptr, &view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render target view");
+    }
+    return view;
+}
+
+// The image, its memory and size, and whether that memory is lazily allocated
+static std::tuple<VkImage, VkDeviceMemory, VkDeviceSize, bool> createAttachment(VkPhysicalDevice physicalDevice, VkDevice device, VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, const RenderTargets &targets)
+{
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = targets.samples;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage | (targets.transient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image;
+    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render target image");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image, &requirements);
+
+    // desktop GPUs generally have no lazily allocated type, and a transient image in ordinary memory is fine
+    uint32_t memoryType;
+    bool lazy = false;
+    if (targets.transient)
+    {
+        try
+        {
+            memoryType = findMemoryType(physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+            lazy = true;
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+    if (!lazy)
+    {
+        memoryType = findMemoryType(physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS || vkBindImageMemory(device, image, memory, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate render target memory");
+    }
+    return std::make_tuple(image, memory, requirements.size, lazy);
+}
+
+RenderTargets createRenderTargets(VkPhysicalDevice physicalDevice, VkDevice device, VkFormat colorFormat, VkExtent2D extent, VkSampleCountFlagBits samples, bool transient)
+{
+    RenderTargets targets;
+    targets.samples = samples;
+    targets.transient = transient;
+    targets.depthFormat = chooseDepthFormat(physicalDevice);
+    if (VK_SAMPLE_COUNT_1_BIT != samples)
+    {
+        std::tie(targets.colorImage, targets.colorMemory, targets.colorBytes, targets.colorLazilyAllocated) = createAttachment(physicalDevice, device, colorFormat, extent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, targets);
+        targets.colorView = createImageView(device, targets.colorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+    std::tie(targets.depthImage, targets.depthMemory, targets.depthBytes, targets.depthLazilyAllocated) = createAttachment(physicalDevice, device, targets.depthFormat, extent, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, targets);
+    targets.depthView = createImageView(device, targets.depthImage, targets.depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+    return targets;
+}
+
+VkDeviceSize renderTargetsCommittedBytes(VkDevice device, const RenderTargets &targets)
+{
+    // only lazily allocated memory may be queried, anything else is committed in full
+    auto committed = [device](VkDeviceMemory memory, VkDeviceSize bytes, bool lazy)
+    {
+        if (lazy)
+        {
+            vkGetDeviceMemoryCommitment(device, memory, &bytes);
+        }
+        return bytes;
+    };
+    return committed(targets.colorMemory, targets.colorBytes, targets.colorLazilyAllocated) + committed(targets.depthMemory, targets.depthBytes, targets.depthLazilyAllocated);
+}
+
+void reportRenderTargets(std::ostream &stream, VkDevice device, const RenderTargets &targets)
+{
+    // a single sampled pass has no colour attachment of its own, only depth decides
+    const bool lazy = targets.depthLazilyAllocated && (VK_NULL_HANDLE == targets.colorImage || targets.colorLazilyAllocated);
+    stream << "Attachments: " << targets.samples << "x MSAA, " << (targets.transient ? "transient" : "regular") << " in "
+           << (lazy ? "lazily allocated" : "device local") << " memory, " << (targets.colorBytes + targets.depthBytes) / 1024 << "KB allocated, "
+           << renderTargetsCommittedBytes(device, targets) / 1024 << "KB committed" << std::endl;
+}
+
+void destroyRenderTargets(VkDevice device, const RenderTargets &targets)
+{
+    if (VK_NULL_HANDLE != targets.colorImage)
+    {
+        vkDestroyImageView(device, targets.colorView, nullptr);
+        vkDestroyImage(device, targets.colorImage, nullptr);
+        vkFreeMemory(device, targets.colorMemory, nullptr);
+    }
+    vkDestroyImageView(device, targets.depthView, nullptr);
+    vkDestroyImage(device, targets.depthImage, nullptr);
+    vkFreeMemory(device, targets.depthMemory, nullptr);
+}
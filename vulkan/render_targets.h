@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <iosfwd>
+
+// The depth attachment and, when multisampled, the colour attachment a render pass resolves from
+// Neither is ever loaded other than by a clear or stored, so with transient requested they're
+// created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and bound to lazily allocated memory where
+// a heap offers it; on a tiling GPU they then stay in tile memory and are never backed by pages.
+// Without lazily allocated memory they fall back to ordinary device local memory.
+struct RenderTargets
+{
+    VkSampleCountFlagBits samples;
+    bool transient;
+    VkFormat depthFormat;
+
+    // null when single sampled, the pass then renders into its target directly
+    VkImage colorImage = VK_NULL_HANDLE;
+    VkDeviceMemory colorMemory = VK_NULL_HANDLE;
+    VkImageView colorView = VK_NULL_HANDLE;
+    VkImage depthImage;
+    VkDeviceMemory depthMemory;
+    VkImageView depthView;
+
+    VkDeviceSize colorBytes = 0;
+    VkDeviceSize depthBytes = 0;
+    bool colorLazilyAllocated = false;
+    bool depthLazilyAllocated = false;
+};
+
+VkFormat chooseDepthFormat(VkPhysicalDevice physicalDevice);
+
+// The highest count no greater than requested that colour and depth framebuffers both support
+VkSampleCountFlagBits chooseSampleCount(VkPhysicalDevice physicalDevice, uint32_t requested);
+
+RenderTargets createRenderTargets(VkPhysicalDevice physicalDevice, VkDevice device, VkFormat colorFormat, VkExtent2D extent, VkSampleCountFlagBits samples, bool transient);
+
+// What the driver has actually backed so far; lazily allocated memory that stays in tile memory
+// commits none of its allocation
+VkDeviceSize renderTargetsCommittedBytes(VkDevice device, const RenderTargets &targets);
+
+void reportRenderTargets(std::ostream &stream, VkDevice device, const RenderTargets &targets);
+
+void destroyRenderTargets(VkDevice device, const RenderTargets &targets);
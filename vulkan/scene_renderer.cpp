@@ -0,0 +1,836 @@
+#include "scene_renderer.h"
+#include "device_functions.h"
+#include "memory_util.h"
+#include "render_targets.h"
+#include "scene_graph.h"
+#include "transform_math.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    // std140 mirror of the shaders' Frame block
+    struct SceneFrameUniforms
+    {
+        Mat4 viewProjection;
+        float planes[6][4];
+        float positionMin[4];
+        float positionExtent[4];
+        uint32_t objectCount;
+        uint32_t indexCount;
+        uint32_t padding[2];
+    };
+    static_assert(sizeof(SceneFrameUniforms) == 208, "SceneFrameUniforms must match the std140 layout");
+}
+
+static const float objectSpacing = 4.0f;
+
+// objects on a jittered grid filling a cube centred on the origin, where the camera sits
+// The grid is a three level hierarchy: a root the whole grid turns with, a node per row and the
+// row's objects as the row's children.
+static void buildSceneGraph(SceneRenderer &scene, uint32_t objectCount, const MeshHeader &mesh)
+{
+    scene.localRadius = 0.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+        scene.localCentre[c] = mesh.positionMin[c] + 0.5f * mesh.positionExtent[c];
+        scene.localRadius += 0.25f * mesh.positionExtent[c] * mesh.positionExtent[c];
+    }
+    scene.localRadius = std::sqrt(scene.localRadius);
+
+    const uint32_t side = uint32_t(std::ceil(std::cbrt(double(objectCount))));
+    const float half = 0.5f * float(side) * objectSpacing;
+    auto cellCentre = [half](uint32_t cell)
+    {
+        return (float(cell) + 0.5f) * objectSpacing - half;
+    };
+
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<float> jitter(-0.25f * objectSpacing, 0.25f * objectSpacing);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+    // rows and then the root come after the objects, so object i is node i
+    const uint32_t rowCount = (objectCount + side - 1) / side;
+    scene.rootNode = objectCount + rowCount;
+    std::vector<uint32_t> parents(objectCount + rowCount + 1);
+    std::vector<Mat4> locals(objectCount + rowCount + 1);
+    parents[scene.rootNode] = sceneNoParent;
+    locals[scene.rootNode] = identityMatrix();
+    for (uint32_t row = 0; row < rowCount; ++row)
+    {
+        parents[objectCount + row] = scene.rootNode;
+        locals[objectCount + row] = translation(0.0f, cellCentre(row % side), cellCentre(row / side));
+    }
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        const float objectScale = scale(engine);
+        float offset[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            offset[c] = jitter(engine);
+        }
+        parents[i] = objectCount + i / side;
+        locals[i] = multiply(translation(cellCentre(i % side) + offset[0], offset[1], offset[2]), uniformScale(objectScale));
+    }
+    scene.objectCount = objectCount;
+    scene.graph = createSceneGraph(parents, locals);
+}
+
+// instance data for objects [begin, end) from their world transforms, and the CPU path's spheres
+static void writeSceneObjects(SceneRenderer &scene, SceneObject *objects, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const Mat4 &world = worldTransform(scene.graph, uint32_t(i));
+        SceneObject &object = objects[i];
+        object.world = world;
+        // the scale is uniform, so any column's length will do
+        const float objectScale = std::sqrt(world.m[0] * world.m[0] + world.m[1] * world.m[1] + world.m[2] * world.m[2]);
+        for (int row = 0; row < 3; ++row)
+        {
+            object.sphere[row] = world.m[12 + row];
+            for (int c = 0; c < 3; ++c)
+            {
+                object.sphere[row] += world.m[c * 4 + row] * scene.localCentre[c];
+            }
+        }
+        object.sphere[3] = scene.localRadius * objectScale;
+        if (CullMode::Cpu == scene.cullMode)
+        {
+            setSphereBounds(scene.bounds, i, object.sphere);
+        }
+    }
+}
+
+// Turns the grid for this frame and writes every object's world transform and sphere
+static void updateSceneObjects(SceneRenderer &scene, SceneObject *objects, uint64_t frameIndex)
+{
+    TRACE_FUNCTION();
+    const auto start = std::chrono::steady_clock::now();
+
+    // against the camera's turn, a fixed step each frame so runs are repeatable
+    setLocalTransform(scene.graph, scene.rootNode, rotationY(float(frameIndex) * -0.004f));
+    updateWorldTransforms(scene.graph, detectSimdLevel(), scene.jobs);
+
+    constexpr size_t objectsPerJob = 4096;
+    if (nullptr != scene.jobs && scene.objectCount > objectsPerJob)
+    {
+        scene.jobs->parallelFor(0, scene.objectCount, objectsPerJob, [&](size_t begin, size_t end)
+        {
+            writeSceneObjects(scene, objects, begin, end);
+        });
+    }
+    else
+    {
+        writeSceneObjects(scene, objects, 0, scene.objectCount);
+    }
+
+    scene.transformTimes.add(std::chrono::steady_clock::now() - start);
+}
+
+static bool supportsGpuCulling(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return features12.drawIndirectCount && features.features.multiDrawIndirect && features.features.drawIndirectFirstInstance;
+}
+
+static VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect)
+{
+    VkImageViewCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = image;
+    createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    createInfo.format = format;
+    createInfo.subresourceRange.aspectMask = aspect;
+    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    if (vkCreateImageView(device, &createInfo, nullptr, &view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create image view");
+    }
+    return view;
+}
+
+// Multisampled, colour is cleared into the transient attachment and resolved into the target at
+// the end of the subpass, and neither the samples nor depth are ever written back to memory
+static VkRenderPass createRenderPass(VkDevice device, VkFormat colorFormat, const RenderTargets &targets, bool postProcessed)
+{
+    const bool multisampled = VK_SAMPLE_COUNT_1_BIT != targets.samples;
+    VkAttachmentDescription attachments[3] = {};
+    attachments[0].format = colorFormat;
+    attachments[0].samples = targets.samples;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = postProcessed ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    attachments[1].format = targets.depthFormat;
+    attachments[1].samples = targets.samples;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    if (multisampled)
+    {
+        attachments[2] = attachments[0];
+        attachments[2].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
+
+    VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference resolveReference = { 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    subpass.pResolveAttachments = multisampled ? &resolveReference : nullptr;
+    subpass.pDepthStencilAttachment = &depthReference;
+
+    // the colour transition waits for the acquire semaphore's stage, and the shared depth
+    // image for the previous frame's depth tests; a shared hdr image also for the previous
+    // frame's post-processing reads, and a shared multisampled image for its colour writes
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    if (postProcessed)
+    {
+        dependency.srcStageMask |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    if (multisampled)
+    {
+        dependency.srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    createInfo.attachmentCount = multisampled ? 3 : 2;
+    createInfo.pAttachments = attachments;
+    createInfo.subpassCount = 1;
+    createInfo.pSubpasses = &subpass;
+    createInfo.dependencyCount = 1;
+    createInfo.pDependencies = &dependency;
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(device, &createInfo, nullptr, &renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create render pass");
+    }
+    return renderPass;
+}
+
+static VkDescriptorSetLayout createDescriptorSetLayout(VkDevice device)
+{
+    VkDescriptorSetLayoutBinding bindings[4] = {};
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = (0 == i) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = (i < 2) ? (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT) : VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = 4;
+    createInfo.pBindings = bindings;
+
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create descriptor set layout");
+    }
+    return layout;
+}
+
+static VkPipeline createGraphicsPipeline(VkDevice device, const SceneRenderer &scene, ShaderLibrary &shaders)
+{
+    VkShaderModule vertexShader = shaders.module(device, "mesh.vert");
+    VkShaderModule fragmentShader = shaders.module(device, "mesh.frag");
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexShader;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentShader;
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription binding = { 0, sizeof(MeshVertex), VK_VERTEX_INPUT_RATE_VERTEX };
+    VkVertexInputAttributeDescription attributes[2] = {
+        { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(MeshVertex, position) },
+        { 1, 0, VK_FORMAT_R16G16_SNORM, offsetof(MeshVertex, normal) },
+    };
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &binding;
+    vertexInput.vertexAttributeDescriptionCount = 2;
+    vertexInput.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkViewport viewport = { 0.0f, 0.0f, float(scene.extent.width), float(scene.extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, scene.extent };
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = scene.targets.samples;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+
+    VkGraphicsPipelineCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    createInfo.stageCount = 2;
+    createInfo.pStages = stages;
+    createInfo.pVertexInputState = &vertexInput;
+    createInfo.pInputAssemblyState = &inputAssembly;
+    createInfo.pViewportState = &viewportState;
+    createInfo.pRasterizationState = &rasterization;
+    createInfo.pMultisampleState = &multisample;
+    createInfo.pDepthStencilState = &depthStencil;
+    createInfo.pColorBlendState = &colorBlend;
+    createInfo.layout = scene.pipelineLayout;
+    createInfo.renderPass = scene.renderPass;
+    createInfo.subpass = 0;
+
+    VkPipeline pipeline;
+    const VkResult result = vkCreateGraphicsPipelines(device, shaders.pipelineCache(device), 1, &createInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create scene graphics pipeline");
+    }
+    return pipeline;
+}
+
+static VkPipeline createCullPipeline(VkDevice device, VkPipelineLayout pipelineLayout, ShaderLibrary &shaders)
+{
+    VkShaderModule shader = shaders.module(device, "cull.comp");
+
+    VkComputePipelineCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    createInfo.stage.module = shader;
+    createInfo.stage.pName = "main";
+    createInfo.layout = pipelineLayout;
+
+    VkPipeline pipeline;
+    const VkResult result = vkCreateComputePipelines(device, shaders.pipelineCache(device), 1, &createInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create culling pipeline");
+    }
+    return pipeline;
+}
+
+std::unique_ptr<SceneRenderer> createSceneRenderer(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue, const std::vector<VkImage> &swapChainImages, VkFormat swapChainFormat, VkExtent2D extent, const MeshView &mesh, uint32_t objectCount, CullMode cullMode, PostProcessMode postMode, uint32_t msaaSamples, bool transientAttachments, ShaderLibrary &shaders, JobSystem *jobs)
+{
+    TRACE_FUNCTION();
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (CullMode::Gpu == cullMode)
+    {
+        if (!supportsGpuCulling(physicalDevice))
+        {
+            throw std::runtime_error("GPU culling needs drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance");
+        }
+        if (objectCount > properties.limits.maxDrawIndirectCount)
+        {
+            throw std::runtime_error("Object count exceeds maxDrawIndirectCount");
+        }
+    }
+
+    auto scene = std::make_unique<SceneRenderer>();
+    scene->cullMode = cullMode;
+    scene->jobs = jobs;
+    buildSceneGraph(*scene, objectCount, *mesh.header);
+    if (CullMode::Cpu == cullMode)
+    {
+        // the spheres are set with each frame's transforms
+        resizeSphereBounds(scene->bounds, objectCount);
+        scene->visible.resize(scene->bounds.x.size());
+    }
+    scene->indexCount = mesh.header->indexCount;
+    scene->indexType = (2 == mesh.header->indexSize) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    std::copy_n(mesh.header->positionMin, 3, scene->positionMin);
+    std::copy_n(mesh.header->positionExtent, 3, scene->positionExtent);
+    scene->extent = extent;
+    scene->swapChainImages = swapChainImages;
+    scene->timestampPeriod = properties.limits.timestampPeriod;
+
+    VkCommandPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolCreateInfo.queueFamilyIndex = queueFamily;
+    if (vkCreateCommandPool(device, &poolCreateInfo, nullptr, &scene->commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create scene command pool");
+    }
+
+    std::tie(scene->vertexBuffer, scene->vertexMemory) = createDeviceLocalBuffer(physicalDevice, device, scene->commandPool, queue, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mesh.vertices, VkDeviceSize(mesh.header->vertexCount) * sizeof(MeshVertex));
+    std::tie(scene->indexBuffer, scene->indexMemory) = createDeviceLocalBuffer(physicalDevice, device, scene->commandPool, queue, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh.indices, VkDeviceSize(mesh.header->indexCount) * mesh.header->indexSize);
+
+    if (PostProcessMode::None != postMode)
+    {
+        scene->post = createPostProcess(physicalDevice, device, extent, postMode, shaders);
+    }
+    const VkFormat colorFormat = scene->post ? PostProcess::HdrFormat : swapChainFormat;
+    scene->targets = createRenderTargets(physicalDevice, device, colorFormat, extent, chooseSampleCount(physicalDevice, msaaSamples), transientAttachments);
+    scene->renderPass = createRenderPass(device, colorFormat, scene->targets, scene->post != nullptr);
+    std::vector<VkImageView> targetViews;
+    if (scene->post)
+    {
+        targetViews.push_back(scene->post->hdr.view);
+    }
+    else
+    {
+        for (VkImage image : swapChainImages)
+        {
+            scene->colorViews.push_back(createImageView(device, image, swapChainFormat, VK_IMAGE_ASPECT_COLOR_BIT));
+        }
+        targetViews = scene->colorViews;
+    }
+    for (VkImageView targetView : targetViews)
+    {
+        // multisampled, the target is the resolve attachment
+        const bool multisampled = VK_NULL_HANDLE != scene->targets.colorView;
+        const VkImageView attachments[3] = { multisampled ? scene->targets.colorView : targetView, scene->targets.depthView, targetView };
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = scene->renderPass;
+        framebufferInfo.attachmentCount = multisampled ? 3 : 2;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create framebuffer");
+        }
+        scene->framebuffers.push_back(framebuffer);
+    }
+
+    scene->descriptorSetLayout = createDescriptorSetLayout(device);
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &scene->descriptorSetLayout;
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &scene->pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create scene pipeline layout");
+    }
+    scene->graphicsPipeline = createGraphicsPipeline(device, *scene, shaders);
+    scene->cullPipeline = createCullPipeline(device, scene->pipelineLayout, shaders);
+
+    const VkDescriptorPoolSize poolSizes[2] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SceneRenderer::FramesInFlight },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * SceneRenderer::FramesInFlight },
+    };
+    VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+    descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolInfo.maxSets = SceneRenderer::FramesInFlight;
+    descriptorPoolInfo.poolSizeCount = 2;
+    descriptorPoolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &scene->descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create scene descriptor pool");
+    }
+
+    for (SceneRenderer::Frame &frame : scene->frames)
+    {
+        std::tie(frame.uniformBuffer, frame.uniformMemory) = createBuffer(physicalDevice, device, sizeof(SceneFrameUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (vkMapMemory(device, frame.uniformMemory, 0, VK_WHOLE_SIZE, 0, &frame.uniformData) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to map scene uniforms");
+        }
+        // rewritten every frame, so read by the GPU straight from host memory
+        std::tie(frame.objectBuffer, frame.objectMemory) = createBuffer(physicalDevice, device, VkDeviceSize(std::max(1u, objectCount)) * sizeof(SceneObject), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (vkMapMemory(device, frame.objectMemory, 0, VK_WHOLE_SIZE, 0, &frame.objectData) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to map scene objects");
+        }
+        std::tie(frame.drawBuffer, frame.drawMemory) = createBuffer(physicalDevice, device, VkDeviceSize(std::max(1u, objectCount)) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        std::tie(frame.countBuffer, frame.countMemory) = createBuffer(physicalDevice, device, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkDescriptorSetAllocateInfo setInfo = {};
+        setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setInfo.descriptorPool = scene->descriptorPool;
+        setInfo.descriptorSetCount = 1;
+        setInfo.pSetLayouts = &scene->descriptorSetLayout;
+        if (vkAllocateDescriptorSets(device, &setInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate scene descriptor set");
+        }
+
+        const VkDescriptorBufferInfo bufferInfos[4] = {
+            { frame.uniformBuffer, 0, VK_WHOLE_SIZE },
+            { frame.objectBuffer, 0, VK_WHOLE_SIZE },
+            { frame.drawBuffer, 0, VK_WHOLE_SIZE },
+            { frame.countBuffer, 0, VK_WHOLE_SIZE },
+        };
+        VkWriteDescriptorSet writes[4] = {};
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = (0 == i) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(device, 4, writes, 0, nullptr);
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = scene->commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &frame.commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate scene command buffer");
+        }
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create scene fence");
+        }
+    }
+
+    // a begin and end timestamp per frame in flight
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2 * SceneRenderer::FramesInFlight;
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &scene->queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timestamp query pool");
+    }
+
+    // the device enables pipelineStatisticsQuery whenever it is supported
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    if (features.pipelineStatisticsQuery)
+    {
+        VkQueryPoolCreateInfo statisticsPoolInfo = {};
+        statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsPoolInfo.queryCount = 2 * SceneRenderer::FramesInFlight;
+        statisticsPoolInfo.pipelineStatistics = pipelineStatisticFlags;
+        if (vkCreateQueryPool(device, &statisticsPoolInfo, nullptr, &scene->statisticsPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create pipeline statistics query pool");
+        }
+    }
+
+    std::cout << "Drawing " << objectCount << " objects of " << scene->indexCount / 3 << " triangles with " << (CullMode::Gpu == cullMode ? "GPU" : "CPU") << " culling" << std::endl;
+
+    return scene;
+}
+
+std::tuple<VkCommandBuffer, VkFence> recordSceneFrame(VkDevice device, SceneRenderer &scene, uint32_t imageIndex)
+{
+    TRACE_FUNCTION();
+    const uint32_t slot = scene.frameSlot;
+    scene.frameSlot = (scene.frameSlot + 1) % SceneRenderer::FramesInFlight;
+    SceneRenderer::Frame &frame = scene.frames[slot];
+
+    vkd::WaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+    vkd::ResetFences(device, 1, &frame.fence);
+
+    if (frame.timestampsPending)
+    {
+        uint64_t timestamps[2];
+        if (vkd::GetQueryPoolResults(device, scene.queryPool, 2 * slot, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+        {
+            const double nanoseconds = double(timestamps[1] - timestamps[0]) * scene.timestampPeriod;
+            scene.gpuTimes.add(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::nano>(nanoseconds)));
+        }
+        frame.timestampsPending = false;
+    }
+    if (frame.statisticsPending)
+    {
+        if (CullMode::Gpu == scene.cullMode)
+        {
+            collectPassStatistics(device, scene.statisticsPool, 2 * slot, scene.cullStatistics);
+        }
+        collectPassStatistics(device, scene.statisticsPool, 2 * slot + 1, scene.drawStatistics);
+        frame.statisticsPending = false;
+    }
+
+    const auto cpuStart = std::chrono::steady_clock::now();
+
+    // the frame's fence has been waited on, so the GPU is done with its objects
+    updateSceneObjects(scene, static_cast<SceneObject *>(frame.objectData), scene.frameIndex);
+
+    // the camera turns a fixed step each frame, so runs are repeatable
+    const float angle = float(scene.frameIndex++) * 0.01f;
+    const float eye[3] = { 0.0f, 0.0f, 0.0f };
+    const float target[3] = { std::cos(angle), 0.2f * std::sin(0.5f * angle), std::sin(angle) };
+    const float up[3] = { 0.0f, 1.0f, 0.0f };
+    const float farPlane = 2.0f * std::cbrt(float(scene.objectCount)) * objectSpacing;
+
+    SceneFrameUniforms uniforms = {};
+    uniforms.viewProjection = multiply(perspectiveVulkan(1.0f, float(scene.extent.width) / float(scene.extent.height), 0.1f, farPlane), lookAt(eye, target, up));
+    frustumPlanes(uniforms.viewProjection, uniforms.planes);
+    std::copy_n(scene.positionMin, 3, uniforms.positionMin);
+    std::copy_n(scene.positionExtent, 3, uniforms.positionExtent);
+    uniforms.objectCount = scene.objectCount;
+    uniforms.indexCount = scene.indexCount;
+    memcpy(frame.uniformData, &uniforms, sizeof(uniforms));
+
+    VkCommandBuffer commandBuffer = frame.commandBuffer;
+    vkd::ResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkd::BeginCommandBuffer(commandBuffer, &beginInfo);
+
+    vkd::CmdResetQueryPool(commandBuffer, scene.queryPool, 2 * slot, 2);
+    vkd::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, scene.queryPool, 2 * slot);
+    const bool statistics = VK_NULL_HANDLE != scene.statisticsPool;
+    if (statistics)
+    {
+        vkd::CmdResetQueryPool(commandBuffer, scene.statisticsPool, 2 * slot, 2);
+    }
+
+    if (CullMode::Gpu == scene.cullMode)
+    {
+        vkd::CmdFillBuffer(commandBuffer, frame.countBuffer, 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier clearBarrier = {};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+        if (statistics)
+        {
+            vkd::CmdBeginQuery(commandBuffer, scene.statisticsPool, 2 * slot, 0);
+        }
+        vkd::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, scene.cullPipeline);
+        vkd::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, scene.pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+        vkd::CmdDispatch(commandBuffer, (scene.objectCount + 63) / 64, 1, 1);
+        if (statistics)
+        {
+            vkd::CmdEndQuery(commandBuffer, scene.statisticsPool, 2 * slot);
+        }
+
+        VkMemoryBarrier cullBarrier = {};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.05f, 0.05f, 0.08f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = scene.renderPass;
+    renderPassInfo.framebuffer = scene.framebuffers[scene.post ? 0 : imageIndex];
+    renderPassInfo.renderArea = { { 0, 0 }, scene.extent };
+    renderPassInfo.clearValueCount = 2;
+    renderPassInfo.pClearValues = clearValues;
+    if (statistics)
+    {
+        vkd::CmdBeginQuery(commandBuffer, scene.statisticsPool, 2 * slot + 1, 0);
+    }
+    vkd::CmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    vkd::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scene.graphicsPipeline);
+    vkd::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, scene.pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+    const VkDeviceSize vertexOffset = 0;
+    vkd::CmdBindVertexBuffers(commandBuffer, 0, 1, &scene.vertexBuffer, &vertexOffset);
+    vkd::CmdBindIndexBuffer(commandBuffer, scene.indexBuffer, 0, scene.indexType);
+
+    if (CullMode::Gpu == scene.cullMode)
+    {
+        vkd::CmdDrawIndexedIndirectCount(commandBuffer, frame.drawBuffer, 0, frame.countBuffer, 0, scene.objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+    else
+    {
+        scene.cpuVisibleObjects += cullSpheres(scene.bounds, uniforms.planes, scene.visible.data(), detectSimdLevel(), scene.jobs);
+
+        // the object index is passed as the first instance, for the vertex shader to find its transform
+        for (uint32_t i = 0; i < scene.objectCount; ++i)
+        {
+            if (scene.visible[i])
+            {
+                vkd::CmdDrawIndexed(commandBuffer, scene.indexCount, 1, 0, 0, i);
+            }
+        }
+    }
+
+    vkd::CmdEndRenderPass(commandBuffer);
+    if (statistics)
+    {
+        vkd::CmdEndQuery(commandBuffer, scene.statisticsPool, 2 * slot + 1);
+        frame.statisticsPending = true;
+    }
+
+    if (scene.post)
+    {
+        recordPostProcess(commandBuffer, *scene.post, VK_NULL_HANDLE, 0);
+        recordPostProcessBlit(commandBuffer, *scene.post, scene.swapChainImages[imageIndex], scene.extent);
+    }
+
+    vkd::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, scene.queryPool, 2 * slot + 1);
+    frame.timestampsPending = true;
+
+    if (vkd::EndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record scene command buffer");
+    }
+
+    scene.cpuSubmitTimes.add(std::chrono::steady_clock::now() - cpuStart);
+
+    return std::make_tuple(commandBuffer, frame.fence);
+}
+
+void reportSceneRenderer(std::ostream &stream, VkDevice device, const SceneRenderer &scene)
+{
+    stream << "Scene: " << scene.objectCount << " objects, " << (CullMode::Gpu == scene.cullMode ? "GPU" : "CPU") << " culling";
+    if (CullMode::Cpu == scene.cullMode && scene.frameIndex > 0)
+    {
+        stream << ", " << scene.cpuVisibleObjects / scene.frameIndex << " visible per frame";
+    }
+    stream << std::endl;
+    reportRenderTargets(stream, device, scene.targets);
+    if (scene.post)
+    {
+        uint64_t bytes = 0;
+        for (uint32_t pass = 0; pass < PostProcess::PassCount; ++pass)
+        {
+            bytes += postProcessPassBytes(*scene.post, pass);
+        }
+        stream << "Post-processing: " << postProcessModeName(scene.post->mode) << ", " << bytes / (1024 * 1024) << "MB fetched and written per frame" << std::endl;
+    }
+    scene.transformTimes.report(stream, "Scene graph update");
+    scene.cpuSubmitTimes.report(stream, "CPU update, cull and record");
+    scene.gpuTimes.report(stream, "GPU frame time");
+    reportPassStatistics(stream, scene.cullStatistics);
+    reportPassStatistics(stream, scene.drawStatistics);
+}
+
+void destroySceneRenderer(VkDevice device, SceneRenderer &scene)
+{
+    vkDestroyQueryPool(device, scene.queryPool, nullptr);
+    if (VK_NULL_HANDLE != scene.statisticsPool)
+    {
+        vkDestroyQueryPool(device, scene.statisticsPool, nullptr);
+    }
+    for (SceneRenderer::Frame &frame : scene.frames)
+    {
+        vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+        vkDestroyFence(device, frame.fence, nullptr);
+        vkFreeCommandBuffers(device, scene.commandPool, 1, &frame.commandBuffer);
+        vkUnmapMemory(device, frame.uniformMemory);
+        vkDestroyBuffer(device, frame.uniformBuffer, nullptr);
+        vkFreeMemory(device, frame.uniformMemory, nullptr);
+        vkUnmapMemory(device, frame.objectMemory);
+        vkDestroyBuffer(device, frame.objectBuffer, nullptr);
+        vkFreeMemory(device, frame.objectMemory, nullptr);
+        vkDestroyBuffer(device, frame.drawBuffer, nullptr);
+        vkFreeMemory(device, frame.drawMemory, nullptr);
+        vkDestroyBuffer(device, frame.countBuffer, nullptr);
+        vkFreeMemory(device, frame.countMemory, nullptr);
+    }
+    vkDestroyDescriptorPool(device, scene.descriptorPool, nullptr);
+    vkDestroyPipeline(device, scene.cullPipeline, nullptr);
+    vkDestroyPipeline(device, scene.graphicsPipeline, nullptr);
+    vkDestroyPipelineLayout(device, scene.pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, scene.descriptorSetLayout, nullptr);
+    for (VkFramebuffer framebuffer : scene.framebuffers)
+    {
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+    for (VkImageView view : scene.colorViews)
+    {
+        vkDestroyImageView(device, view, nullptr);
+    }
+    vkDestroyRenderPass(device, scene.renderPass, nullptr);
+    if (scene.post)
+    {
+        destroyPostProcess(device, *scene.post);
+    }
+    destroyRenderTargets(device, scene.targets);
+    vkDestroyBuffer(device, scene.indexBuffer, nullptr);
+    vkFreeMemory(device, scene.indexMemory, nullptr);
+    vkDestroyBuffer(device, scene.vertexBuffer, nullptr);
+    vkFreeMemory(device, scene.vertexMemory, nullptr);
+    vkDestroyCommandPool(device, scene.commandPool, nullptr);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "device_stats.h"
+#include "frame_stats.h"
+#include "frustum_cull.h"
+#include "job_system.h"
+#include "mesh_format.h"
+#include "post_process.h"
+#include "render_targets.h"
+#include "scene_graph.h"
+#include "shader_library.h"
+#include "transform_math.h"
+
+#include <vulkan/vulkan.h>
+#include <iosfwd>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// Where per-object visibility is decided
+enum class CullMode
+{
+    Cpu,
+    Gpu
+};
+
+// Object bounds and placement, laid out as the shaders' Object struct
+struct SceneObject
+{
+    float sphere[4]; // world space bounding sphere: centre, radius
+    Mat4 world;
+};
+static_assert(sizeof(SceneObject) == 80, "SceneObject must match the std430 layout");
+
+// Draws many instances of one mesh, culled against the view frustum either on the CPU, which
+// issues a vkCmdDrawIndexed per visible object, or by a compute pass that writes compacted
+// VkDrawIndexedIndirectCommands and a count for a single vkCmdDrawIndexedIndirectCount
+struct SceneRenderer
+{
+    static constexpr uint32_t FramesInFlight = 2;
+
+    CullMode cullMode;
+    uint32_t objectCount;
+    // the objects are nodes 0 to objectCount - 1, under a root that turns a fixed step each frame
+    SceneGraph graph;
+    uint32_t rootNode;
+    // the mesh's bounding sphere
+    float localCentre[3];
+    float localRadius;
+    // the CPU path's copy of the object spheres, its per-object results, and the jobs it culls with
+    SphereBounds bounds;
+    std::vector<uint8_t> visible;
+    JobSystem *jobs;
+    uint32_t indexCount;
+    VkIndexType indexType;
+    float positionMin[3];
+    float positionExtent[3];
+    VkExtent2D extent;
+    std::vector<VkImage> swapChainImages;
+
+    VkCommandPool commandPool;
+    VkBuffer vertexBuffer;
+    VkDeviceMemory vertexMemory;
+    VkBuffer indexBuffer;
+    VkDeviceMemory indexMemory;
+
+    // depth, and the multisampled colour resolved into the swap chain or hdr image
+    RenderTargets targets;
+    std::vector<VkImageView> colorViews;
+    // one per swap chain image, or a single one into the post-processing hdr image
+    std::vector<VkFramebuffer> framebuffers;
+    VkRenderPass renderPass;
+    std::unique_ptr<PostProcess> post;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkPipelineLayout pipelineLayout;
+    VkPipeline graphicsPipeline;
+    VkPipeline cullPipeline;
+    VkDescriptorPool descriptorPool;
+
+    struct Frame
+    {
+        VkBuffer uniformBuffer;
+        VkDeviceMemory uniformMemory;
+        void *uniformData;
+        // the objects as of this frame's transform update
+        VkBuffer objectBuffer;
+        VkDeviceMemory objectMemory;
+        void *objectData;
+        VkBuffer drawBuffer;
+        VkDeviceMemory drawMemory;
+        VkBuffer countBuffer;
+        VkDeviceMemory countMemory;
+        VkDescriptorSet descriptorSet;
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        bool timestampsPending = false;
+        bool statisticsPending = false;
+    };
+    Frame frames[FramesInFlight];
+    uint32_t frameSlot = 0;
+    uint64_t frameIndex = 0;
+
+    VkQueryPool queryPool;
+    float timestampPeriod;
+    // cull and draw pass queries per frame in flight, null without pipelineStatisticsQuery
+    VkQueryPool statisticsPool = VK_NULL_HANDLE;
+    PassStatistics cullStatistics = { "cull" };
+    PassStatistics drawStatistics = { "draw" };
+
+    DurationStats transformTimes;
+    DurationStats cpuSubmitTimes;
+    DurationStats gpuTimes;
+    uint64_t cpuVisibleObjects = 0;
+};
+
+std::unique_ptr<SceneRenderer> createSceneRenderer(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue, const std::vector<VkImage> &swapChainImages, VkFormat swapChainFormat, VkExtent2D extent, const MeshView &mesh, uint32_t objectCount, CullMode cullMode, PostProcessMode postMode, uint32_t msaaSamples, bool transientAttachments, ShaderLibrary &shaders, JobSystem *jobs);
+
+// Updates the object transforms, then culls and records the next frame into the given swap chain
+// image, to be submitted with the returned fence
+// With post-processing the image is written by a transfer rather than as a colour attachment
+std::tuple<VkCommandBuffer, VkFence> recordSceneFrame(VkDevice device, SceneRenderer &scene, uint32_t imageIndex);
+
+void reportSceneRenderer(std::ostream &stream, VkDevice device, const SceneRenderer &scene);
+
+void destroySceneRenderer(VkDevice device, SceneRenderer &scene);
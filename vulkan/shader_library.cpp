@@ -0,0 +1,428 @@
+#include "shader_library.h"
+#include "trace.h"
+
+#include <glslang/Public/ShaderLang.h>
+#include <SPIRV/GlslangToSpv.h>
+#include <StandAlone/ResourceLimits.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // changing anything that affects the output must change this, so old cache entries miss
+    const char *const CompilerSettings = "glslang sdk-1.2.182.0, vulkan 1.2, spir-v 1.5";
+
+    const char *const PipelineCacheFile = "pipelines.bin";
+
+    using IncludeMap = std::map<std::string, std::string>;
+
+    // serves #include "name" from the files read while hashing
+    class IncludeMapIncluder : public glslang::TShader::Includer
+    {
+    public:
+        explicit IncludeMapIncluder(const IncludeMap &includes) : includes(includes)
+        {
+        }
+
+        IncludeResult *includeLocal(const char *headerName, const char *, size_t) override
+        {
+            const auto found = includes.find(headerName);
+            if (found == includes.end())
+            {
+                return nullptr;
+            }
+            return new IncludeResult(found->first, found->second.data(), found->second.size(), nullptr);
+        }
+
+        void releaseInclude(IncludeResult *result) override
+        {
+            delete result;
+        }
+
+    private:
+        const IncludeMap &includes;
+    };
+}
+
+std::vector<ShaderVariant> dittyShaderVariants()
+{
+    std::vector<ShaderVariant> variants;
+    for (const char *file : { "cull.comp", "hud.frag", "hud.vert", "mesh.frag", "mesh.vert", "post_blur.comp", "post_blur.frag", "post_fullscreen.vert", "post_threshold.comp", "post_threshold.frag", "post_tonemap.comp", "post_tonemap.frag" })
+    {
+        variants.push_back({ file, file, {} });
+    }
+    return variants;
+}
+
+std::filesystem::path defaultShaderCacheDirectory()
+{
+    return std::filesystem::temp_directory_path() / "graphics_ditties_shader_cache";
+}
+
+static std::string readFile(const std::filesystem::path &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+    {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+    std::ostringstream contents;
+    contents << stream.rdbuf();
+    return contents.str();
+}
+
+// the quoted names of the #include lines, which is all the ditty's shaders use
+static void gatherIncludes(const std::filesystem::path &directory, const std::string &source, IncludeMap &includes)
+{
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const size_t directive = line.find_first_not_of(" \t");
+        if (std::string::npos == directive || 0 != line.compare(directive, 8, "#include"))
+        {
+            continue;
+        }
+        const size_t open = line.find('"', directive);
+        const size_t close = line.find('"', open + 1);
+        if (std::string::npos == open || std::string::npos == close)
+        {
+            continue;
+        }
+        const std::string name = line.substr(open + 1, close - open - 1);
+        if (0 == includes.count(name))
+        {
+            includes[name] = readFile(directory / name);
+            gatherIncludes(directory, includes[name], includes);
+        }
+    }
+}
+
+static uint64_t fnv1a(uint64_t hash, const std::string &text)
+{
+    for (char c : text)
+    {
+        hash = (hash ^ uint8_t(c)) * 0x100000001b3ull;
+    }
+    // a separator, so adjacent strings can't run into each other
+    return (hash ^ 0xff) * 0x100000001b3ull;
+}
+
+static EShLanguage stageForFile(const std::string &file)
+{
+    const std::string extension = std::filesystem::path(file).extension().string();
+    if (".vert" == extension)
+    {
+        return EShLangVertex;
+    }
+    if (".frag" == extension)
+    {
+        return EShLangFragment;
+    }
+    if (".comp" == extension)
+    {
+        return EShLangCompute;
+    }
+    throw std::runtime_error("No shader stage for " + file);
+}
+
+static std::vector<uint32_t> compileGlsl(const std::string &file, const std::string &source, const std::string &preamble, const IncludeMap &includes)
+{
+    TRACE_ZONE("compile shader");
+    const EShLanguage stage = stageForFile(file);
+    const EShMessages messages = EShMessages(EShMsgSpvRules | EShMsgVulkanRules);
+
+    glslang::TShader shader(stage);
+    const char *text = source.c_str();
+    const int length = int(source.size());
+    const char *name = file.c_str();
+    shader.setStringsWithLengthsAndNames(&text, &length, &name, 1);
+    shader.setPreamble(preamble.c_str());
+    shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
+    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
+
+    IncludeMapIncluder includer(includes);
+    if (!shader.parse(&glslang::DefaultTBuiltInResource, 450, false, messages, includer))
+    {
+        throw std::runtime_error(file + ": " + shader.getInfoLog());
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+    if (!program.link(messages))
+    {
+        throw std::runtime_error(file + ": " + program.getInfoLog());
+    }
+
+    std::vector<uint32_t> spirv;
+    glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
+    return spirv;
+}
+
+static bool readCachedSpirv(const std::filesystem::path &path, std::vector<uint32_t> &spirv)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        return false;
+    }
+    const std::streamoff size = stream.tellg();
+    if (size < 4 || 0 != size % 4)
+    {
+        return false;
+    }
+    spirv.resize(size_t(size) / 4);
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char *>(spirv.data()), size);
+    return stream && 0x07230203 == spirv[0];
+}
+
+// written under a temporary name and renamed, so a concurrent run never reads half a file
+static void writeCacheFile(const std::filesystem::path &path, const void *data, size_t size)
+{
+    std::filesystem::path temporary = path;
+    temporary += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream stream(temporary, std::ios::binary);
+        stream.write(static_cast<const char *>(data), std::streamsize(size));
+        if (!stream)
+        {
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+ShaderLibrary::ShaderLibrary(std::filesystem::path sourceDirectory, std::filesystem::path cacheDirectory)
+    : sourceDirectory(std::move(sourceDirectory)), cacheDirectory(std::move(cacheDirectory))
+{
+    glslang::InitializeProcess();
+    std::error_code error;
+    std::filesystem::create_directories(this->cacheDirectory, error);
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    glslang::FinalizeProcess();
+}
+
+void ShaderLibrary::buildVariant(const ShaderVariant &variant, Entry &entry) const
+{
+    try
+    {
+        const std::string source = readFile(sourceDirectory / variant.file);
+        IncludeMap includes;
+        gatherIncludes(sourceDirectory, source, includes);
+
+        std::string preamble;
+        for (const std::string &define : variant.defines)
+        {
+            std::string line = define;
+            const size_t equals = line.find('=');
+            if (std::string::npos != equals)
+            {
+                line[equals] = ' ';
+            }
+            preamble += "#define " + line + "\n";
+        }
+
+        uint64_t hash = 0xcbf29ce484222325ull;
+        hash = fnv1a(hash, CompilerSettings);
+        hash = fnv1a(hash, variant.file);
+        hash = fnv1a(hash, preamble);
+        hash = fnv1a(hash, source);
+        for (const auto &[name, contents] : includes)
+        {
+            hash = fnv1a(fnv1a(hash, name), contents);
+        }
+        std::ostringstream cacheName;
+        cacheName << std::hex << std::setw(16) << std::setfill('0') << hash << ".spv";
+        const std::filesystem::path cachePath = cacheDirectory / cacheName.str();
+
+        entry.cached = readCachedSpirv(cachePath, entry.spirv);
+        if (!entry.cached)
+        {
+            entry.spirv = compileGlsl(variant.file, source, preamble, includes);
+            writeCacheFile(cachePath, entry.spirv.data(), entry.spirv.size() * sizeof(uint32_t));
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        entry.error = exception.what();
+    }
+}
+
+void ShaderLibrary::build(const std::vector<ShaderVariant> &variants, JobSystem *jobs)
+{
+    TRACE_FUNCTION();
+    const auto start = std::chrono::steady_clock::now();
+
+    // every entry exists before the jobs start, so they never insert into the map concurrently
+    std::vector<Entry *> variantEntries;
+    for (const ShaderVariant &variant : variants)
+    {
+        Entry &entry = entries[variant.name];
+        entry = Entry();
+        variantEntries.push_back(&entry);
+    }
+
+    const auto buildRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            buildVariant(variants[i], *variantEntries[i]);
+        }
+    };
+    {
+        std::ifstream stream(cacheDirectory / PipelineCacheFile, std::ios::binary);
+        pipelineCacheData.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        pipelineCacheBytesLoaded = pipelineCacheData.size();
+    }
+
+    if (nullptr != jobs)
+    {
+        jobs->parallelFor(0, variants.size(), 1, buildRange);
+        buildThreads = jobs->threadCount();
+    }
+    else
+    {
+        buildRange(0, variants.size());
+        buildThreads = 1;
+    }
+
+    std::string errors;
+    for (size_t i = 0; i < variants.size(); ++i)
+    {
+        const Entry &entry = *variantEntries[i];
+        if (!entry.error.empty())
+        {
+            errors += "\n" + entry.error;
+        }
+        else if (entry.cached)
+        {
+            ++cacheHits;
+        }
+        else
+        {
+            ++compiled;
+        }
+    }
+    buildMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!errors.empty())
+    {
+        throw std::runtime_error("Failed to build shaders:" + errors);
+    }
+}
+
+const std::vector<uint32_t> &ShaderLibrary::spirv(const std::string &name) const
+{
+    const auto found = entries.find(name);
+    if (found == entries.end() || found->second.spirv.empty())
+    {
+        throw std::runtime_error("Shader " + name + " wasn't built");
+    }
+    return found->second.spirv;
+}
+
+VkShaderModule ShaderLibrary::module(VkDevice device, const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(moduleMutex);
+    const auto found = entries.find(name);
+    if (found == entries.end() || found->second.spirv.empty())
+    {
+        throw std::runtime_error("Shader " + name + " wasn't built");
+    }
+    Entry &entry = found->second;
+    if (VK_NULL_HANDLE == entry.module)
+    {
+        VkShaderModuleCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = entry.spirv.size() * sizeof(uint32_t);
+        createInfo.pCode = entry.spirv.data();
+        if (vkCreateShaderModule(device, &createInfo, nullptr, &entry.module) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create shader module " + name);
+        }
+    }
+    return entry.module;
+}
+
+VkPipelineCache ShaderLibrary::pipelineCache(VkDevice device)
+{
+    std::lock_guard<std::mutex> lock(moduleMutex);
+    if (VK_NULL_HANDLE == driverPipelineCache)
+    {
+        VkPipelineCacheCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = pipelineCacheData.size();
+        createInfo.pInitialData = pipelineCacheData.data();
+        if (vkCreatePipelineCache(device, &createInfo, nullptr, &driverPipelineCache) != VK_SUCCESS)
+        {
+            // a cache the driver rejects outright is dropped rather than failing startup
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(device, &createInfo, nullptr, &driverPipelineCache) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create pipeline cache");
+            }
+        }
+        pipelineCacheData.clear();
+    }
+    return driverPipelineCache;
+}
+
+void ShaderLibrary::destroyModules(VkDevice device)
+{
+    std::lock_guard<std::mutex> lock(moduleMutex);
+    if (VK_NULL_HANDLE != driverPipelineCache)
+    {
+        size_t size = 0;
+        std::vector<char> data;
+        if (vkGetPipelineCacheData(device, driverPipelineCache, &size, nullptr) == VK_SUCCESS && size > 0)
+        {
+            data.resize(size);
+            if (vkGetPipelineCacheData(device, driverPipelineCache, &size, data.data()) == VK_SUCCESS)
+            {
+                writeCacheFile(cacheDirectory / PipelineCacheFile, data.data(), size);
+                pipelineCacheBytesSaved = size;
+            }
+        }
+        vkDestroyPipelineCache(device, driverPipelineCache, nullptr);
+        driverPipelineCache = VK_NULL_HANDLE;
+    }
+    for (auto &[name, entry] : entries)
+    {
+        if (VK_NULL_HANDLE != entry.module)
+        {
+            vkDestroyShaderModule(device, entry.module, nullptr);
+            entry.module = VK_NULL_HANDLE;
+        }
+    }
+}
+
+void ShaderLibrary::report(std::ostream &stream) const
+{
+    uint32_t modules = 0;
+    for (const auto &[name, entry] : entries)
+    {
+        modules += (VK_NULL_HANDLE != entry.module) ? 1 : 0;
+    }
+    stream << "Shaders: " << cacheHits + compiled << " variants, " << cacheHits << " from the cache, " << compiled << " compiled, in " << buildMilliseconds << "ms on "
+           << buildThreads << " threads; " << modules << " modules created; " << pipelineCacheBytesLoaded / 1024 << "KB pipeline cache loaded" << std::endl;
+}
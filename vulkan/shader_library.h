@@ -0,0 +1,83 @@
+#pragma once
+
+#include "job_system.h"
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One compilation of a GLSL file, its stage taken from the extension (.vert, .frag or .comp)
+struct ShaderVariant
+{
+    std::string name; // what the variant is looked up by
+    std::string file; // relative to the library's source directory
+    std::vector<std::string> defines; // NAME or NAME=VALUE
+};
+
+// The shaders vulkan_ditty renders with, each named after its file
+std::vector<ShaderVariant> dittyShaderVariants();
+
+// Where built SPIR-V is kept between runs unless told otherwise
+std::filesystem::path defaultShaderCacheDirectory();
+
+// GLSL compiled to SPIR-V at startup with glslang, spread over the job system
+// Each variant's SPIR-V is cached on disk under a 64 bit FNV-1a hash of its source, the files it
+// includes, its defines and the compiler settings, so a warm start only reads the sources and
+// the cached binaries. VkShaderModules are created on first use and kept until destroyModules.
+// The driver's pipeline cache is kept in the same directory: build reads it, so it loads before
+// there is a device, and destroyModules writes it back.
+class ShaderLibrary
+{
+public:
+    ShaderLibrary(std::filesystem::path sourceDirectory, std::filesystem::path cacheDirectory);
+    ~ShaderLibrary();
+
+    ShaderLibrary(const ShaderLibrary &) = delete;
+    ShaderLibrary &operator=(const ShaderLibrary &) = delete;
+
+    // Builds every variant, on the calling thread if jobs is null; throws std::runtime_error
+    // with every variant's errors if any fail
+    void build(const std::vector<ShaderVariant> &variants, JobSystem *jobs);
+
+    const std::vector<uint32_t> &spirv(const std::string &name) const;
+
+    // thread safe; throws std::runtime_error for a variant that wasn't built
+    VkShaderModule module(VkDevice device, const std::string &name);
+
+    // thread safe; seeded with what build read, the driver ignores data from another device
+    VkPipelineCache pipelineCache(VkDevice device);
+
+    void destroyModules(VkDevice device);
+
+    void report(std::ostream &stream) const;
+
+    uint32_t cacheHits = 0;
+    uint32_t compiled = 0;
+    double buildMilliseconds = 0.0;
+    unsigned buildThreads = 1;
+    size_t pipelineCacheBytesLoaded = 0;
+    size_t pipelineCacheBytesSaved = 0;
+
+private:
+    struct Entry
+    {
+        std::vector<uint32_t> spirv;
+        VkShaderModule module = VK_NULL_HANDLE;
+        bool cached = false;
+        std::string error;
+    };
+
+    void buildVariant(const ShaderVariant &variant, Entry &entry) const;
+
+    std::filesystem::path sourceDirectory;
+    std::filesystem::path cacheDirectory;
+    std::unordered_map<std::string, Entry> entries;
+    std::vector<char> pipelineCacheData;
+    VkPipelineCache driverPipelineCache = VK_NULL_HANDLE;
+    std::mutex moduleMutex;
+};
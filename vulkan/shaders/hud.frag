@@ -0,0 +1,14 @@
+#version 450
+
+layout(location = 0) in vec2 uv;
+layout(location = 1) in vec4 hudColor;
+
+// the font atlas's coverage, the solid cell for panels and bars
+layout(set = 0, binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    color = vec4(hudColor.rgb, hudColor.a * textureLod(atlas, uv, 0.0).r);
+}
@@ -0,0 +1,21 @@
+#version 450
+
+// must match the push constants perf_overlay.cpp records
+layout(push_constant) uniform Viewport
+{
+    vec4 transform; // pixels to clip space, scale in xy and offset in zw
+} viewport;
+
+layout(location = 0) in vec2 position; // pixels, y down
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 tint;
+
+layout(location = 0) out vec2 uv;
+layout(location = 1) out vec4 hudColor;
+
+void main()
+{
+    uv = texCoord;
+    hudColor = tint;
+    gl_Position = vec4(position * viewport.transform.xy + viewport.transform.zw, 0.0, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec3 worldNormal;
+layout(location = 1) in vec3 tint;
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    float light = max(dot(normalize(worldNormal), normalize(vec3(0.4, -0.8, 0.3))), 0.0);
+    color = vec4(tint * (0.2 + 0.8 * light), 1.0);
+}
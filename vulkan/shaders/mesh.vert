@@ -0,0 +1,32 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "scene_common.glsl"
+
+layout(location = 0) in vec4 position; // unorm within the mesh bounds
+layout(location = 1) in vec2 normal;   // octahedral
+
+layout(location = 0) out vec3 worldNormal;
+layout(location = 1) out vec3 tint;
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    Object object = objects[gl_InstanceIndex];
+    vec3 local = frame.positionMin.xyz + position.xyz * frame.positionExtent.xyz;
+    gl_Position = frame.viewProjection * (object.world * vec4(local, 1.0));
+
+    // the scale is uniform, so the normal only needs renormalising
+    worldNormal = normalize(mat3(object.world) * decodeOctahedral(normal));
+    uint hash = uint(gl_InstanceIndex) * 2654435761u;
+    tint = vec3((hash >> 8) & 255u, (hash >> 16) & 255u, (hash >> 24) & 255u) / 255.0 * 0.6 + 0.4;
+}
@@ -0,0 +1,23 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "post_common.glsl"
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+
+layout(location = 0) out vec4 color;
+
+// the baseline the compute blur is measured against: a fetch per tap
+void main()
+{
+    ivec2 size = textureSize(source, 0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 sum = BlurWeights[0] * texelFetch(source, pixel, 0).rgb;
+    for (int i = 1; i <= BlurRadius; ++i)
+    {
+        ivec2 offset = parameters.direction * i;
+        sum += BlurWeights[i] * (texelFetch(source, clamp(pixel - offset, ivec2(0), size - 1), 0).rgb +
+                                 texelFetch(source, clamp(pixel + offset, ivec2(0), size - 1), 0).rgb);
+    }
+    color = vec4(sum, 1.0);
+}
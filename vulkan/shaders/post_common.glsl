@@ -0,0 +1,27 @@
+// shared between the post-processing shaders; the block must match PostParameters
+
+layout(push_constant) uniform Parameters
+{
+    ivec2 direction; // blur axis, (1, 0) or (0, 1)
+    float threshold; // luminance above which colour blooms
+    float exposure;
+} parameters;
+
+// a separable Gaussian with sigma 4, weights from the centre outwards
+const int BlurRadius = 8;
+const float BlurWeights[BlurRadius + 1] = float[](0.1031526, 0.0999789, 0.0910319, 0.0778637, 0.0625652, 0.0472267, 0.0334888, 0.0223083, 0.0139602);
+
+const float BloomStrength = 0.6;
+
+vec3 brightPass(vec3 color)
+{
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    return color * (max(luminance - parameters.threshold, 0.0) / max(luminance, 1e-4));
+}
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 tonemap(vec3 color, vec3 bloom)
+{
+    vec3 x = (color + BloomStrength * bloom) * parameters.exposure;
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "post_common.glsl"
+
+layout(location = 0) in vec2 uv;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    color = vec4(brightPass(textureLod(source, uv, 0.0).rgb), 1.0);
+}
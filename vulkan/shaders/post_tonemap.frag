@@ -0,0 +1,17 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "post_common.glsl"
+
+layout(location = 0) in vec2 uv;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+layout(set = 0, binding = 1) uniform sampler2D bloom;
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    vec3 hdr = texelFetch(source, ivec2(gl_FragCoord.xy), 0).rgb;
+    color = vec4(tonemap(hdr, textureLod(bloom, uv, 0.0).rgb), 1.0);
+}
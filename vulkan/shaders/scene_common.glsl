@@ -0,0 +1,22 @@
+// shared between the scene shaders; layouts must match SceneFrameUniforms and SceneObject
+
+struct Object
+{
+    vec4 sphere; // world space bounding sphere: centre, radius
+    mat4 world;
+};
+
+layout(std140, set = 0, binding = 0) uniform Frame
+{
+    mat4 viewProjection;
+    vec4 planes[6];
+    vec4 positionMin;
+    vec4 positionExtent;
+    uint objectCount;
+    uint indexCount;
+} frame;
+
+layout(std430, set = 0, binding = 1) readonly buffer Objects
+{
+    Object objects[];
+};
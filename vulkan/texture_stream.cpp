@@ -0,0 +1,468 @@
+#include "texture_stream.h"
+#include "device_functions.h"
+#include "memory_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+static VkAccessFlags accessForLayout(VkImageLayout layout)
+{
+    switch (layout)
+    {
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+        return VK_ACCESS_TRANSFER_WRITE_BIT;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        return VK_ACCESS_TRANSFER_READ_BIT;
+    default:
+        return 0;
+    }
+}
+
+static void transitionImage(VkCommandBuffer commandBuffer, VkImage image, uint32_t level, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = accessForLayout(oldLayout);
+    barrier.dstAccessMask = accessForLayout(newLayout);
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = level;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkd::CmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+static void setLevelLayout(VkCommandBuffer commandBuffer, TextureStream &stream, uint32_t level, VkImageLayout newLayout)
+{
+    if (stream.levelLayouts[level] != newLayout)
+    {
+        transitionImage(commandBuffer, stream.image, level, stream.levelLayouts[level], newLayout);
+        stream.levelLayouts[level] = newLayout;
+    }
+}
+
+static void setDisplayLayout(VkCommandBuffer commandBuffer, TextureStream &stream, VkImageLayout newLayout)
+{
+    if (stream.displayLayout != newLayout)
+    {
+        transitionImage(commandBuffer, stream.displayImage, 0, stream.displayLayout, newLayout);
+        stream.displayLayout = newLayout;
+    }
+}
+
+static VkImageBlit levelBlit(const Ktx2Level &src, uint32_t srcLevel, const Ktx2Level &dst, uint32_t dstLevel)
+{
+    VkImageBlit blit = {};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = srcLevel;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1] = { int32_t(src.width), int32_t(src.height), 1 };
+    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.dstSubresource.mipLevel = dstLevel;
+    blit.dstSubresource.layerCount = 1;
+    blit.dstOffsets[1] = { int32_t(dst.width), int32_t(dst.height), 1 };
+    return blit;
+}
+
+// replace every level finer than a just completed level with an upsampled copy of it
+static void upsampleIntoFinerLevels(VkCommandBuffer commandBuffer, TextureStream &stream, uint32_t completedLevel)
+{
+    if (stream.displayImage != stream.image)
+    {
+        setLevelLayout(commandBuffer, stream, completedLevel, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        setDisplayLayout(commandBuffer, stream, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        const VkImageBlit blit = levelBlit(stream.ktx.levels[completedLevel], completedLevel, stream.ktx.levels[0], 0);
+        vkd::CmdBlitImage(commandBuffer, stream.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stream.displayImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, stream.blitFilter);
+        return;
+    }
+
+    for (uint32_t level = completedLevel; level > 0; --level)
+    {
+        setLevelLayout(commandBuffer, stream, level, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        setLevelLayout(commandBuffer, stream, level - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        const VkImageBlit blit = levelBlit(stream.ktx.levels[level], level, stream.ktx.levels[level - 1], level - 1);
+        vkd::CmdBlitImage(commandBuffer, stream.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stream.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, stream.blitFilter);
+    }
+}
+
+static std::tuple<VkImage, VkDeviceMemory> createTextureImage(VkPhysicalDevice physicalDevice, VkDevice device, VkFormat format, VkExtent2D extent, uint32_t mipLevels)
+{
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image;
+    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create texture image");
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image, &requirements);
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate texture memory");
+    }
+    if (vkBindImageMemory(device, image, memory, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to bind texture memory");
+    }
+
+    return std::make_tuple(image, memory);
+}
+
+static uint32_t blockExtentForFormat(VkFormat format)
+{
+    return (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK) ? 4 : 1;
+}
+
+// rows of texels, or of blocks for block compressed formats
+static uint32_t levelRows(const TextureStream &stream, const Ktx2Level &level)
+{
+    return (level.height + stream.blockExtent - 1) / stream.blockExtent;
+}
+
+static void initTextureStream(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, TextureStream &stream, VkDeviceSize bytesPerFrame)
+{
+    TRACE_FUNCTION();
+    stream.format = VkFormat(stream.ktx.vkFormat);
+    stream.extent = { stream.ktx.width, stream.ktx.height };
+    stream.blockExtent = blockExtentForFormat(stream.format);
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, stream.format, &formatProperties);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT))
+    {
+        throw std::runtime_error("Texture format is not supported by the device");
+    }
+    const bool upsampleInPlace = formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    stream.blitFilter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    // levels are streamed a row at a time, so every row must have the same size
+    VkDeviceSize largestRow = 0;
+    for (const Ktx2Level &level : stream.ktx.levels)
+    {
+        const uint32_t rows = levelRows(stream, level);
+        const uint32_t columns = (level.width + stream.blockExtent - 1) / stream.blockExtent;
+        if (0 != level.byteLength % rows || 0 != (level.byteLength / rows) % columns)
+        {
+            throw std::runtime_error("Texture levels must be tightly packed");
+        }
+        largestRow = std::max<VkDeviceSize>(largestRow, level.byteLength / rows);
+    }
+    const Ktx2Level &baseLevel = stream.ktx.levels[0];
+    stream.texelSize = baseLevel.byteLength / levelRows(stream, baseLevel) / ((baseLevel.width + stream.blockExtent - 1) / stream.blockExtent);
+    stream.copyAlignment = stream.texelSize * 4;
+
+    auto [image, imageMemory] = createTextureImage(physicalDevice, device, stream.format, stream.extent, uint32_t(stream.ktx.levels.size()));
+    stream.image = image;
+    stream.imageMemory = imageMemory;
+    stream.levelLayouts.assign(stream.ktx.levels.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+
+    if (upsampleInPlace)
+    {
+        stream.displayImage = image;
+    }
+    else
+    {
+        auto [displayImage, displayMemory] = createTextureImage(physicalDevice, device, VK_FORMAT_R8G8B8A8_UNORM, stream.extent, 1);
+        stream.displayImage = displayImage;
+        stream.displayMemory = displayMemory;
+    }
+
+    // a single row always has to fit, even if it exceeds the budget, and every slot has to start
+    // at a valid copy offset
+    stream.slotSize = std::max(bytesPerFrame, largestRow);
+    stream.slotSize = (stream.slotSize + stream.copyAlignment - 1) / stream.copyAlignment * stream.copyAlignment;
+    auto [stagingBuffer, stagingMemory] = createBuffer(physicalDevice, device, stream.slotSize * TextureStream::FramesInFlight, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    stream.stagingBuffer = stagingBuffer;
+    stream.stagingMemory = stagingMemory;
+
+    void *mapping;
+    if (vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapping) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to map texture staging buffer");
+    }
+    stream.stagingData = static_cast<uint8_t *>(mapping);
+
+    VkCommandPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolCreateInfo.queueFamilyIndex = queueFamily;
+    if (vkCreateCommandPool(device, &poolCreateInfo, nullptr, &stream.commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create texture upload command pool");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = stream.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = TextureStream::FramesInFlight;
+    if (vkAllocateCommandBuffers(device, &allocInfo, stream.commandBuffers) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate texture upload command buffers");
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    for (VkFence &fence : stream.fences)
+    {
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create texture upload fence");
+        }
+    }
+
+    stream.uploadLevel = uint32_t(stream.ktx.levels.size() - 1);
+}
+
+std::unique_ptr<TextureStream> createTextureStream(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, const char *path, VkDeviceSize bytesPerFrame)
+{
+    auto stream = std::make_unique<TextureStream>();
+    stream->file = std::make_unique<MappedFile>(path);
+    stream->sourceData = stream->file->data();
+    stream->ktx = parseKtx2(stream->file->data(), stream->file->size());
+    initTextureStream(physicalDevice, device, queueFamily, *stream, bytesPerFrame);
+
+    std::cout << "Streaming " << stream->extent.width << "x" << stream->extent.height << " texture with " << stream->ktx.levels.size()
+              << " levels from " << path << ", " << (stream->slotSize / 1024) << "KB per frame" << std::endl;
+
+    return stream;
+}
+
+std::unique_ptr<TextureStream> createTextureStream(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, ProceduralTexture &&texture, VkDeviceSize bytesPerFrame)
+{
+    auto stream = std::make_unique<TextureStream>();
+    stream->ownedData = std::move(texture.data);
+    stream->sourceData = stream->ownedData.data();
+    stream->ktx = std::move(texture.image);
+    initTextureStream(physicalDevice, device, queueFamily, *stream, bytesPerFrame);
+
+    std::cout << "Streaming " << stream->extent.width << "x" << stream->extent.height << " generated texture with " << stream->ktx.levels.size()
+              << " levels, " << (stream->slotSize / 1024) << "KB per frame" << (stream->displayImage != stream->image ? ", through an RGBA8 display image" : "") << std::endl;
+
+    return stream;
+}
+
+std::tuple<VkCommandBuffer, VkFence> recordTextureUploads(VkDevice device, TextureStream &stream)
+{
+    TRACE_FUNCTION();
+    if (stream.resident)
+    {
+        return std::make_tuple(VkCommandBuffer(VK_NULL_HANDLE), VkFence(VK_NULL_HANDLE));
+    }
+
+    const uint32_t slot = stream.frameSlot;
+    stream.frameSlot = (stream.frameSlot + 1) % TextureStream::FramesInFlight;
+
+    // the slot's staging memory and command buffer are free once its previous upload has executed
+    VkFence fence = stream.fences[slot];
+    vkd::WaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+    vkd::ResetFences(device, 1, &fence);
+
+    VkCommandBuffer commandBuffer = stream.commandBuffers[slot];
+    vkd::ResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkd::BeginCommandBuffer(commandBuffer, &beginInfo);
+
+    const VkDeviceSize slotBase = slot * stream.slotSize;
+    const VkDeviceSize copyAlignment = stream.copyAlignment;
+    VkDeviceSize used = 0;
+
+    while (!stream.resident)
+    {
+        const Ktx2Level &level = stream.ktx.levels[stream.uploadLevel];
+        const uint32_t levelRowCount = levelRows(stream, level);
+        const VkDeviceSize rowBytes = level.byteLength / levelRowCount;
+        const uint32_t rowsFitting = uint32_t(std::min<VkDeviceSize>((stream.slotSize - used) / rowBytes, levelRowCount));
+        const uint32_t rows = std::min(levelRowCount - stream.uploadRow, rowsFitting);
+        if (0 == rows)
+        {
+            break;
+        }
+
+        const size_t fileOffset = size_t(level.byteOffset + stream.uploadRow * rowBytes);
+        const size_t bytes = size_t(rows * rowBytes);
+        memcpy(stream.stagingData + slotBase + used, stream.sourceData + fileOffset, bytes);
+        if (stream.file)
+        {
+            stream.file->discard(fileOffset, bytes);
+        }
+
+        setLevelLayout(commandBuffer, stream, stream.uploadLevel, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = slotBase + used;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = stream.uploadLevel;
+        region.imageSubresource.layerCount = 1;
+        // the copy extent may stop short of a whole block only at the edge of the level
+        const uint32_t firstTexelRow = stream.uploadRow * stream.blockExtent;
+        region.imageOffset = { 0, int32_t(firstTexelRow), 0 };
+        region.imageExtent = { level.width, std::min(rows * stream.blockExtent, level.height - firstTexelRow), 1 };
+        vkd::CmdCopyBufferToImage(commandBuffer, stream.stagingBuffer, stream.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        used += (bytes + copyAlignment - 1) / copyAlignment * copyAlignment;
+        stream.bytesStreamed += bytes;
+        stream.uploadRow += rows;
+
+        if (stream.uploadRow == levelRowCount)
+        {
+            if (stream.uploadLevel == stream.ktx.levels.size() - 1)
+            {
+                stream.firstLevelPending = true;
+            }
+            upsampleIntoFinerLevels(commandBuffer, stream, stream.uploadLevel);
+
+            if (0 == stream.uploadLevel)
+            {
+                stream.resident = true;
+                stream.residentPending = true;
+            }
+            else
+            {
+                --stream.uploadLevel;
+                stream.uploadRow = 0;
+            }
+        }
+
+        if (used >= stream.slotSize)
+        {
+            break;
+        }
+    }
+
+    if (!stream.resident && stream.file)
+    {
+        // start paging in what the next frame will copy
+        const Ktx2Level &level = stream.ktx.levels[stream.uploadLevel];
+        const VkDeviceSize rowBytes = level.byteLength / levelRows(stream, level);
+        stream.file->prefetch(size_t(level.byteOffset + stream.uploadRow * rowBytes), size_t(stream.slotSize));
+    }
+
+    // everything is read by blits from here on, in this frame's and later command buffers
+    for (uint32_t level = 0; level < stream.levelLayouts.size(); ++level)
+    {
+        setLevelLayout(commandBuffer, stream, level, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    }
+    if (stream.displayImage != stream.image)
+    {
+        setDisplayLayout(commandBuffer, stream, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    }
+
+    if (vkd::EndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record texture upload command buffer");
+    }
+
+    ++stream.framesStreamed;
+
+    return std::make_tuple(commandBuffer, fence);
+}
+
+void textureFramePresented(TextureStream &stream, DeletionQueue &deletions)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (stream.firstLevelPending)
+    {
+        stream.firstTexturedFrame = now;
+        stream.firstLevelPending = false;
+    }
+    if (stream.residentPending)
+    {
+        stream.fullyResident = now;
+        stream.residentPending = false;
+    }
+
+    // the last upload is in this frame's submission, which the deletion queue waits for
+    if (stream.resident && VK_NULL_HANDLE != stream.commandPool)
+    {
+        for (VkFence fence : stream.fences)
+        {
+            retireObject(deletions, VK_OBJECT_TYPE_FENCE, objectHandle(fence));
+        }
+        // destroying the pool frees its command buffers, and freeing memory unmaps it
+        retireObject(deletions, VK_OBJECT_TYPE_COMMAND_POOL, objectHandle(stream.commandPool));
+        retireObject(deletions, VK_OBJECT_TYPE_BUFFER, objectHandle(stream.stagingBuffer));
+        retireObject(deletions, VK_OBJECT_TYPE_DEVICE_MEMORY, objectHandle(stream.stagingMemory));
+        stream.commandPool = VK_NULL_HANDLE;
+        stream.stagingBuffer = VK_NULL_HANDLE;
+        stream.stagingMemory = VK_NULL_HANDLE;
+        stream.stagingData = nullptr;
+    }
+}
+
+void reportTextureStream(std::ostream &stream, const TextureStream &texture, std::chrono::steady_clock::time_point startTime)
+{
+    auto sinceStart = [startTime](std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration<double, std::milli>(time - startTime).count();
+    };
+
+    stream << "Texture: first textured frame after " << sinceStart(texture.firstTexturedFrame) << "ms";
+    if (texture.resident)
+    {
+        stream << ", fully resident after " << sinceStart(texture.fullyResident) << "ms";
+    }
+    else
+    {
+        stream << ", not fully resident";
+    }
+    stream << " (" << texture.bytesStreamed << " bytes over " << texture.framesStreamed << " frames)" << std::endl;
+}
+
+void destroyTextureStream(VkDevice device, TextureStream &stream)
+{
+    // unless already retired
+    if (VK_NULL_HANDLE != stream.commandPool)
+    {
+        vkWaitForFences(device, TextureStream::FramesInFlight, stream.fences, VK_TRUE, UINT64_MAX);
+        for (VkFence fence : stream.fences)
+        {
+            vkDestroyFence(device, fence, nullptr);
+        }
+        vkFreeCommandBuffers(device, stream.commandPool, TextureStream::FramesInFlight, stream.commandBuffers);
+        vkDestroyCommandPool(device, stream.commandPool, nullptr);
+        vkUnmapMemory(device, stream.stagingMemory);
+        vkDestroyBuffer(device, stream.stagingBuffer, nullptr);
+        vkFreeMemory(device, stream.stagingMemory, nullptr);
+    }
+    if (stream.displayImage != stream.image)
+    {
+        vkDestroyImage(device, stream.displayImage, nullptr);
+        vkFreeMemory(device, stream.displayMemory, nullptr);
+    }
+    vkDestroyImage(device, stream.image, nullptr);
+    vkFreeMemory(device, stream.imageMemory, nullptr);
+}
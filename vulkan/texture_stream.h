@@ -0,0 +1,86 @@
+#pragma once
+
+#include "deletion_queue.h"
+#include "ktx2.h"
+#include "mapped_file.h"
+#include "procedural_texture.h"
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// Streams a mip chain, from a memory-mapped KTX2 file or generated at runtime, into a device local image
+// Levels are uploaded smallest first, copying straight from the source into a ring of
+// per-frame staging slots, with at most bytesPerFrame copied each frame. Whenever a level
+// completes, it is upsampled into all the finer levels, so level 0 always holds the best
+// image available and can be shown from the very first frame.
+// Block compressed formats can't be blit destinations, so for those each completed level is
+// instead blit into an RGBA8 display image the size of level 0.
+struct TextureStream
+{
+    static constexpr uint32_t FramesInFlight = 2;
+
+    // source; file is null for generated textures, which keep their data in ownedData
+    std::unique_ptr<MappedFile> file;
+    std::vector<uint8_t> ownedData;
+    const uint8_t *sourceData;
+    Ktx2Image ktx;
+    VkFormat format;
+    VkFilter blitFilter;
+    VkExtent2D extent;
+    // 4 for block compressed formats, where a streamed row is a row of 4x4 blocks
+    uint32_t blockExtent;
+
+    VkImage image;
+    VkDeviceMemory imageMemory;
+    std::vector<VkImageLayout> levelLayouts;
+
+    // what gets presented: image itself, or the RGBA8 proxy for block compressed formats
+    VkImage displayImage;
+    VkDeviceMemory displayMemory = VK_NULL_HANDLE;
+    VkImageLayout displayLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+    uint8_t *stagingData;
+    VkDeviceSize slotSize;
+    VkDeviceSize texelSize;
+    // copy offsets must be a multiple of the texel size, and 4 keeps them word aligned
+    VkDeviceSize copyAlignment;
+
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffers[FramesInFlight];
+    VkFence fences[FramesInFlight];
+    uint32_t frameSlot = 0;
+
+    // upload progress; levels are uploaded from the back of ktx.levels to the front
+    uint32_t uploadLevel;
+    uint32_t uploadRow = 0;
+    bool resident = false;
+
+    // milestones, stamped when the frame that reached them has been presented
+    bool firstLevelPending = false;
+    bool residentPending = false;
+    std::chrono::steady_clock::time_point firstTexturedFrame;
+    std::chrono::steady_clock::time_point fullyResident;
+    uint32_t framesStreamed = 0;
+    uint64_t bytesStreamed = 0;
+};
+
+std::unique_ptr<TextureStream> createTextureStream(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, const char *path, VkDeviceSize bytesPerFrame);
+
+std::unique_ptr<TextureStream> createTextureStream(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, ProceduralTexture &&texture, VkDeviceSize bytesPerFrame);
+
+// Records this frame's uploads, to be submitted ahead of the frame's other work and signal the fence
+// Returns null handles once the texture is fully resident.
+std::tuple<VkCommandBuffer, VkFence> recordTextureUploads(VkDevice device, TextureStream &stream);
+
+// Once the texture is resident, retires the staging buffer and the upload command buffers and fences
+void textureFramePresented(TextureStream &stream, DeletionQueue &deletions);
+
+void reportTextureStream(std::ostream &stream, const TextureStream &texture, std::chrono::steady_clock::time_point startTime);
+
+void destroyTextureStream(VkDevice device, TextureStream &stream);